@@ -6,10 +6,14 @@
 #include <linux/module.h>
 #include <linux/firmware.h>
 #include <linux/etherdevice.h>
+#include <linux/bitfield.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
 #include "../supported_devices.h"
 #include "mt7921_fw.h"
 #include "rtl8852_fw.h"
 #include "firmware_loader.h"
+#include "fw_common.h"
 
 /* TODO: Add Intel firmware support */
 /* TODO: Add Qualcomm firmware support */
@@ -153,6 +157,16 @@ EXPORT_SYMBOL_GPL(managh_get_fw_features);
 /* Firmware chunk size for USB transfers */
 #define FW_CHUNK_SIZE       4096
 
+/* Adaptive chunk sizing bounds */
+#define FW_CHUNK_MIN        4096
+#define FW_CHUNK_MAX        65536
+
+/* Chunk round-trip window used to grow or shrink the chunk size */
+#define FW_CHUNK_TARGET_US  1000
+
+/* Chunks kept in flight; the next is prepared while the previous transfers */
+#define FW_PIPELINE_DEPTH   2
+
 /* Firmware load timeout (in milliseconds) */
 #define FW_LOAD_TIMEOUT     5000
 
@@ -163,6 +177,13 @@ EXPORT_SYMBOL_GPL(managh_get_fw_features);
 #define FW_STATUS_INVALID   0x03
 #define FW_STATUS_TIMEOUT   0x04
 
+/*
+ * Header flags: low bits carry the enum fw_compress_type of the body.
+ * The header checksum always covers the body as sent to the device,
+ * i.e. after decompression.
+ */
+#define FW_HDR_COMPRESS_MASK GENMASK(3, 0)
+
 /* Firmware header magic */
 #define FW_MAGIC           0x57494637  /* "WIF7" */
 
@@ -179,6 +200,13 @@ struct fw_header {
     u8 reserved[16];       /* Reserved */
 };
 
+/* Chunk buffer owned by the transfer pipeline */
+struct fw_chunk_slot {
+    void *buf;              /* Bounce buffer handed to the bus */
+    u32 len;               /* Bytes in this chunk */
+    ktime_t submitted;     /* Submission time */
+};
+
 /* Internal firmware context */
 struct fw_context {
     struct wifi7_dev *dev;
@@ -189,29 +217,47 @@ struct fw_context {
     bool config_loaded;
     struct completion completion;
     int status;
+
+    /* Transfer pipeline, completed in submission order */
+    struct fw_chunk_slot slots[FW_PIPELINE_DEPTH];
+    unsigned int head;     /* Next slot to submit */
+    unsigned int tail;     /* Oldest in-flight slot */
+    unsigned int inflight;
+    struct wifi7_fw_load_stats stats;
+
+    /* CRC32 and SHA-256 accumulated as chunks are submitted */
+    struct fw_verify_ctx verify;
 };
 
 /* Forward declarations */
 static int fw_validate_header(struct fw_context *ctx);
 static int fw_load_config(struct fw_context *ctx);
 static int fw_transfer_chunk(struct fw_context *ctx);
+static int fw_transfer_stream(struct fw_context *ctx);
+static int fw_complete_chunk(struct fw_context *ctx);
 static void fw_cleanup(struct fw_context *ctx);
 
 /**
- * wifi7_load_firmware - Load firmware for WiFi 7 device
+ * wifi7_load_firmware_ext - Load firmware and report transfer statistics
  * @dev: Device structure
+ * @stats: Optional transfer statistics, filled in on success
  *
- * This function loads the firmware for the WiFi 7 device.
- * It first loads the firmware configuration file, then
- * transfers the firmware in chunks to the device.
+ * This function loads the firmware configuration file, then transfers
+ * the firmware in chunks with up to FW_PIPELINE_DEPTH chunks in flight:
+ * the next chunk is copied into its bounce buffer and submitted while
+ * the previous one is still on the bus. The chunk size adapts to the
+ * measured round-trip time.
  *
  * Return: 0 on success, negative error code on failure
  */
-int wifi7_load_firmware(struct wifi7_dev *dev)
+int wifi7_load_firmware_ext(struct wifi7_dev *dev,
+                            struct wifi7_fw_load_stats *stats)
 {
     struct fw_context *ctx;
     char fw_path[64];
-    int ret;
+    ktime_t start;
+    u32 crc;
+    int i, ret;
 
     /* Allocate firmware context */
     ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
@@ -221,8 +267,17 @@ int wifi7_load_firmware(struct wifi7_dev *dev)
     /* Initialize context */
     ctx->dev = dev;
     ctx->chunk_size = FW_CHUNK_SIZE;
+    ctx->stats.min_chunk_us = U32_MAX;
     init_completion(&ctx->completion);
 
+    for (i = 0; i < FW_PIPELINE_DEPTH; i++) {
+        ctx->slots[i].buf = kmalloc(FW_CHUNK_MAX, GFP_KERNEL);
+        if (!ctx->slots[i].buf) {
+            ret = -ENOMEM;
+            goto err_free;
+        }
+    }
+
     /* Build firmware path */
     snprintf(fw_path, sizeof(fw_path), "%s%s%s",
              FW_PATH_PREFIX, dev->hw_info.fw_name, FW_PATH_SUFFIX);
@@ -244,53 +299,112 @@ int wifi7_load_firmware(struct wifi7_dev *dev)
     if (ret)
         goto err_release;
 
-    /* Transfer firmware in chunks */
-    while (ctx->offset < ctx->fw->size) {
-        ret = fw_transfer_chunk(ctx);
+    ret = fw_verify_begin(&ctx->verify, FW_VERIFY_CRC | FW_VERIFY_SHA256);
+    if (ret) {
+        dev_err(dev->dev, "Failed to set up firmware verification\n");
+        ret = -ENOMEM;
+        goto err_release;
+    }
+
+    dev->fw_context = ctx;
+    start = ktime_get();
+
+    /* Compressed bodies are decompressed straight into the pipeline */
+    if (FIELD_GET(FW_HDR_COMPRESS_MASK, ctx->header.flags)) {
+        ret = fw_transfer_stream(ctx);
         if (ret)
-            goto err_release;
+            goto err_drain;
+    }
 
-        /* Wait for chunk transfer completion */
-        if (!wait_for_completion_timeout(&ctx->completion,
-                                       msecs_to_jiffies(FW_LOAD_TIMEOUT))) {
-            ret = -ETIMEDOUT;
-            goto err_release;
+    /* Keep the pipeline full until the image is consumed, then drain */
+    while (ctx->offset < ctx->fw->size || ctx->inflight) {
+        while (ctx->inflight < FW_PIPELINE_DEPTH &&
+               ctx->offset < ctx->fw->size) {
+            ret = fw_transfer_chunk(ctx);
+            if (ret)
+                goto err_drain;
         }
 
-        /* Check transfer status */
-        if (ctx->status != FW_STATUS_SUCCESS) {
-            ret = -EIO;
-            goto err_release;
-        }
+        ret = fw_complete_chunk(ctx);
+        if (ret)
+            goto err_drain;
+    }
 
-        /* Reset completion for next chunk */
-        reinit_completion(&ctx->completion);
+    ctx->stats.total_us = ktime_us_delta(ktime_get(), start);
+    ctx->stats.final_chunk_size = ctx->chunk_size;
+    dev->fw_context = NULL;
+
+    /*
+     * Final verdict from the digests accumulated during transfer. The
+     * image has not been started yet, so a mismatch fails the load
+     * before the device runs anything.
+     */
+    if (fw_verify_final(&ctx->verify, &crc, ctx->stats.sha256)) {
+        ret = -EIO;
+        goto err_release;
+    }
+
+    if (crc != ctx->header.checksum) {
+        dev_err(dev->dev, "Firmware checksum mismatch\n");
+        ret = -EINVAL;
+        goto err_release;
     }
 
+    dev_dbg(dev->dev, "Firmware loaded: %llu bytes, %u chunks, %llu us (chunk %u-%u us, final size %u)\n",
+            ctx->stats.bytes, ctx->stats.chunks, ctx->stats.total_us,
+            ctx->stats.min_chunk_us, ctx->stats.max_chunk_us,
+            ctx->stats.final_chunk_size);
+
+    if (stats)
+        *stats = ctx->stats;
+
     /* Cleanup and return */
     fw_cleanup(ctx);
     return 0;
 
+err_drain:
+    /* Chunks still on the bus reference our buffers; wait them out */
+    while (ctx->inflight) {
+        if (!wait_for_completion_timeout(&ctx->completion,
+                                       msecs_to_jiffies(FW_LOAD_TIMEOUT)))
+            break;
+        ctx->inflight--;
+    }
+    dev->fw_context = NULL;
+    fw_verify_abort(&ctx->verify);
 err_release:
     release_firmware(ctx->fw);
 err_free:
+    for (i = 0; i < FW_PIPELINE_DEPTH; i++)
+        kfree(ctx->slots[i].buf);
     kfree(ctx);
     return ret;
 }
 
+/**
+ * wifi7_load_firmware - Load firmware for WiFi 7 device
+ * @dev: Device structure
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int wifi7_load_firmware(struct wifi7_dev *dev)
+{
+    return wifi7_load_firmware_ext(dev, NULL);
+}
+
 /**
  * fw_validate_header - Validate firmware header
  * @ctx: Firmware context
  *
  * This function validates the firmware header by checking
- * the magic number, version, size, and checksum.
+ * the magic number, version and size. The checksum is computed
+ * incrementally during transfer rather than in a separate pass.
  *
  * Return: 0 on success, negative error code on failure
  */
 static int fw_validate_header(struct fw_context *ctx)
 {
     struct fw_header *hdr = (struct fw_header *)ctx->fw->data;
-    u32 checksum;
 
     /* Check firmware size */
     if (ctx->fw->size < sizeof(*hdr)) {
@@ -313,14 +427,6 @@ static int fw_validate_header(struct fw_context *ctx)
         return -EINVAL;
     }
 
-    /* Verify checksum */
-    checksum = crc32(0, ctx->fw->data + sizeof(*hdr),
-                    ctx->fw->size - sizeof(*hdr));
-    if (checksum != ctx->header.checksum) {
-        dev_err(ctx->dev->dev, "Firmware checksum mismatch\n");
-        return -EINVAL;
-    }
-
     /* Set initial offset */
     ctx->offset = sizeof(*hdr);
 
@@ -365,34 +471,173 @@ static int fw_load_config(struct fw_context *ctx)
 }
 
 /**
- * fw_transfer_chunk - Transfer firmware chunk
+ * fw_submit_chunk - Stage data into a free pipeline slot and submit it
  * @ctx: Firmware context
- *
- * This function transfers a chunk of firmware to the device.
+ * @src: Chunk data
+ * @len: Chunk length, at most FW_CHUNK_MAX
  *
  * Return: 0 on success, negative error code on failure
  */
-static int fw_transfer_chunk(struct fw_context *ctx)
+static int fw_submit_chunk(struct fw_context *ctx, const void *src,
+                           size_t len)
 {
-    size_t remaining = ctx->fw->size - ctx->offset;
-    size_t chunk_size = min(remaining, (size_t)ctx->chunk_size);
+    struct fw_chunk_slot *slot = &ctx->slots[ctx->head];
     int ret;
 
+    /* Prepare chunk; verification rides on the same pass over the data */
+    memcpy(slot->buf, src, len);
+    fw_verify_update(&ctx->verify, slot->buf, len);
+    slot->len = len;
+    slot->submitted = ktime_get();
+
     /* Transfer chunk */
-    ret = wifi7_write_firmware(ctx->dev,
-                             ctx->fw->data + ctx->offset,
-                             chunk_size);
+    ret = wifi7_write_firmware(ctx->dev, slot->buf, len);
     if (ret) {
         dev_err(ctx->dev->dev, "Failed to transfer chunk: %d\n", ret);
         return ret;
     }
 
+    ctx->head = (ctx->head + 1) % FW_PIPELINE_DEPTH;
+    ctx->inflight++;
+
+    return 0;
+}
+
+/**
+ * fw_transfer_chunk - Prepare and submit the next firmware chunk
+ * @ctx: Firmware context
+ *
+ * This function copies the next chunk into a free pipeline slot and
+ * submits it to the device without waiting for completion.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int fw_transfer_chunk(struct fw_context *ctx)
+{
+    size_t remaining = ctx->fw->size - ctx->offset;
+    size_t chunk_size = min(remaining, (size_t)ctx->chunk_size);
+    int ret;
+
+    ret = fw_submit_chunk(ctx, ctx->fw->data + ctx->offset, chunk_size);
+    if (ret)
+        return ret;
+
     /* Update offset */
     ctx->offset += chunk_size;
 
     return 0;
 }
 
+/* Decompression sink: split each window into chunks and feed the pipeline */
+static int fw_stream_sink(void *priv, const void *data, size_t len)
+{
+    struct fw_context *ctx = priv;
+    size_t n;
+    int ret;
+
+    while (len) {
+        if (ctx->inflight == FW_PIPELINE_DEPTH) {
+            ret = fw_complete_chunk(ctx);
+            if (ret)
+                return ret;
+        }
+
+        n = min(len, (size_t)ctx->chunk_size);
+        ret = fw_submit_chunk(ctx, data, n);
+        if (ret)
+            return ret;
+
+        data += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+/**
+ * fw_transfer_stream - Decompress and transfer a compressed body
+ * @ctx: Firmware context
+ *
+ * The body is decompressed through a FW_CHUNK_MAX window; each window is
+ * submitted as it fills, so the bus transfers one chunk while the next is
+ * being decompressed. The whole decompressed image is never held.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int fw_transfer_stream(struct fw_context *ctx)
+{
+    enum fw_compress_type type;
+    size_t total;
+    int ret;
+
+    type = FIELD_GET(FW_HDR_COMPRESS_MASK, ctx->header.flags);
+
+    ret = fw_decompress_stream(type, ctx->fw->data + ctx->offset,
+                               ctx->fw->size - ctx->offset, FW_CHUNK_MAX,
+                               fw_stream_sink, ctx, &total);
+    if (ret) {
+        dev_err(ctx->dev->dev, "Firmware decompression failed: %d\n", ret);
+        return ret == FW_ERR_COMPRESS ? -EINVAL : ret;
+    }
+
+    dev_dbg(ctx->dev->dev, "Decompressed %zu bytes from %zu\n",
+            total, (size_t)(ctx->fw->size - ctx->offset));
+
+    /* Body consumed; the caller drains the remaining in-flight chunks */
+    ctx->offset = ctx->fw->size;
+
+    return 0;
+}
+
+/**
+ * fw_complete_chunk - Wait for the oldest in-flight chunk
+ * @ctx: Firmware context
+ *
+ * This function waits for the oldest chunk to complete, records its
+ * round-trip time and adapts the chunk size for the next submission:
+ * fast round trips double it, slow ones halve it.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int fw_complete_chunk(struct fw_context *ctx)
+{
+    struct fw_chunk_slot *slot = &ctx->slots[ctx->tail];
+    u32 us;
+
+    /* Wait for chunk transfer completion */
+    if (!wait_for_completion_timeout(&ctx->completion,
+                                   msecs_to_jiffies(FW_LOAD_TIMEOUT)))
+        return -ETIMEDOUT;
+
+    ctx->tail = (ctx->tail + 1) % FW_PIPELINE_DEPTH;
+    ctx->inflight--;
+
+    /* Check transfer status */
+    if (READ_ONCE(ctx->status) != FW_STATUS_SUCCESS)
+        return -EIO;
+
+    us = ktime_us_delta(ktime_get(), slot->submitted);
+    ctx->stats.chunks++;
+    ctx->stats.bytes += slot->len;
+    ctx->stats.sum_chunk_us += us;
+    ctx->stats.min_chunk_us = min(ctx->stats.min_chunk_us, us);
+    ctx->stats.max_chunk_us = max(ctx->stats.max_chunk_us, us);
+
+    /* Only full-size chunks say anything about the bus */
+    if (slot->len != ctx->chunk_size)
+        return 0;
+
+    if (us < FW_CHUNK_TARGET_US / 2 && ctx->chunk_size < FW_CHUNK_MAX) {
+        ctx->chunk_size *= 2;
+        ctx->stats.resizes++;
+    } else if (us > FW_CHUNK_TARGET_US * 2 && ctx->chunk_size > FW_CHUNK_MIN) {
+        ctx->chunk_size /= 2;
+        ctx->stats.resizes++;
+    }
+
+    return 0;
+}
+
 /**
  * fw_cleanup - Clean up firmware context
  * @ctx: Firmware context
@@ -402,7 +647,11 @@ static int fw_transfer_chunk(struct fw_context *ctx)
  */
 static void fw_cleanup(struct fw_context *ctx)
 {
+    int i;
+
     release_firmware(ctx->fw);
+    for (i = 0; i < FW_PIPELINE_DEPTH; i++)
+        kfree(ctx->slots[i].buf);
     kfree(ctx);
 }
 
@@ -412,7 +661,8 @@ static void fw_cleanup(struct fw_context *ctx)
  * @status: Transfer status
  *
  * This function is called by the device to complete
- * a firmware transfer operation.
+ * a firmware transfer operation. Chunks complete in submission
+ * order; the first error is sticky for the rest of the load.
  */
 void wifi7_firmware_complete(struct wifi7_dev *dev, int status)
 {
@@ -422,9 +672,11 @@ void wifi7_firmware_complete(struct wifi7_dev *dev, int status)
         return;
 
     /* Set status and complete */
-    ctx->status = status;
+    if (status != FW_STATUS_SUCCESS)
+        WRITE_ONCE(ctx->status, status);
     complete(&ctx->completion);
 }
 
 EXPORT_SYMBOL(wifi7_load_firmware);
+EXPORT_SYMBOL(wifi7_load_firmware_ext);
 EXPORT_SYMBOL(wifi7_firmware_complete); 
\ No newline at end of file
@@ -54,8 +54,23 @@ struct wifi7_fw_config {
     u32 flags;            /* Configuration flags */
 };
 
+/* Firmware download statistics */
+struct wifi7_fw_load_stats {
+    u64 bytes;            /* Bytes transferred */
+    u64 total_us;         /* Wall time of the transfer */
+    u64 sum_chunk_us;     /* Sum of chunk round trips */
+    u32 chunks;           /* Chunks transferred */
+    u32 min_chunk_us;     /* Fastest chunk round trip */
+    u32 max_chunk_us;     /* Slowest chunk round trip */
+    u32 resizes;          /* Adaptive chunk size changes */
+    u32 final_chunk_size; /* Chunk size at end of load */
+    u8 sha256[32];        /* Digest of the transferred image */
+};
+
 /* Function prototypes */
 int wifi7_load_firmware(struct wifi7_dev *dev);
+int wifi7_load_firmware_ext(struct wifi7_dev *dev,
+                            struct wifi7_fw_load_stats *stats);
 void wifi7_firmware_complete(struct wifi7_dev *dev, int status);
 
 int wifi7_get_fw_version(struct wifi7_dev *dev,
@@ -3,6 +3,12 @@
 #include <linux/random.h>
 #include <linux/crypto.h>
 #include <linux/scatterlist.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/rculist.h>
+#include <linux/refcount.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
 #include <crypto/hash.h>
 #include <crypto/aead.h>
 #include "fw_keys.h"
@@ -11,73 +17,271 @@
 
 /* Attestation session structure */
 struct attest_session {
+    struct hlist_node node;         /* session_table, under session_lock */
+    struct list_head reap;          /* Sweep and exit teardown */
+    struct rcu_head rcu;
+    refcount_t refs;
+    struct mutex lock;              /* Serialises use of the crypto state */
     u8 session_id[16];
     u8 nonce[32];
     u8 key[32];
     u8 iv[16];
     struct crypto_aead *tfm;
     u64 timestamp;
-    bool active;
+    unsigned long last_used;        /* jiffies */
+    struct attest_source *source;
 };
 
-#define MAX_SESSIONS 16
-static struct attest_session sessions[MAX_SESSIONS];
+/* Concurrent sessions opened by one requester */
+struct attest_source {
+    struct hlist_node node;
+    u32 id;
+    u32 sessions;
+};
+
+static DEFINE_HASHTABLE(session_table, FW_ATTEST_HASH_BITS);
+static DEFINE_HASHTABLE(source_table, FW_ATTEST_SOURCE_HASH_BITS);
 static DEFINE_SPINLOCK(session_lock);
+static struct attest_stats session_stats;
+static unsigned int session_timeout = FW_ATTEST_SESSION_TIMEOUT;
+static bool sweep_running;          /* Under session_lock */
 
-/* Initialize attestation service */
-int fw_attest_init(void)
+static void sweep_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(sweep_work, sweep_work_fn);
+
+/* Sweep at least once per timeout so a short timeout is honoured */
+static unsigned long sweep_interval(void)
 {
-    memset(sessions, 0, sizeof(sessions));
-    return 0;
+    unsigned int secs = min_t(unsigned int, READ_ONCE(session_timeout),
+                              FW_ATTEST_SWEEP_INTERVAL);
+
+    return max(secs, 1U) * HZ;
 }
 
-/* Clean up attestation resources */
-void fw_attest_exit(void)
+static u32 session_hash(const u8 *session_id)
+{
+    return jhash(session_id, 16, 0);
+}
+
+static void put_session(struct attest_session *session)
 {
-    int i;
-    
-    for (i = 0; i < MAX_SESSIONS; i++) {
-        if (sessions[i].tfm)
-            crypto_free_aead(sessions[i].tfm);
+    if (!refcount_dec_and_test(&session->refs))
+        return;
+
+    /* Lookups only touch the struct under RCU, never the tfm */
+    if (session->tfm)
+        crypto_free_aead(session->tfm);
+    memzero_explicit(session->key, sizeof(session->key));
+    kfree_rcu(session, rcu);
+}
+
+/* Caller holds session_lock */
+static void unhash_session(struct attest_session *session)
+{
+    hash_del_rcu(&session->node);
+
+    if (!--session->source->sessions) {
+        hash_del(&session->source->node);
+        kfree(session->source);
     }
+    session->source = NULL;
+    session_stats.active--;
 }
 
-/* Find or create session */
-static struct attest_session *get_session(const u8 *session_id)
+/* Look up a live session; returns it with a reference held */
+static struct attest_session *find_session(const u8 *session_id)
 {
-    int i;
+    struct attest_session *session;
+
+    rcu_read_lock();
+    hash_for_each_possible_rcu(session_table, session, node,
+                               session_hash(session_id)) {
+        if (!memcmp(session->session_id, session_id, 16) &&
+            refcount_inc_not_zero(&session->refs)) {
+            WRITE_ONCE(session->last_used, jiffies);
+            rcu_read_unlock();
+            return session;
+        }
+    }
+    rcu_read_unlock();
+
+    return NULL;
+}
+
+static struct attest_source *find_source(u32 source)
+{
+    struct attest_source *src;
+
+    hash_for_each_possible(source_table, src, node, source) {
+        if (src->id == source)
+            return src;
+    }
+
+    return NULL;
+}
+
+/*
+ * Find or create a session. New sessions are refused once @source holds
+ * FW_ATTEST_MAX_PER_SOURCE of them, or the table is full.
+ */
+static struct attest_session *get_session(const u8 *session_id, u32 source)
+{
+    struct attest_session *session, *new;
+    struct attest_source *src, *new_src;
     unsigned long flags;
-    struct attest_session *session = NULL;
+
+    session = find_session(session_id);
+    if (session)
+        return session;
+
+    new = kzalloc(sizeof(*new), GFP_KERNEL);
+    new_src = kzalloc(sizeof(*new_src), GFP_KERNEL);
+    if (!new || !new_src) {
+        kfree(new);
+        kfree(new_src);
+        return ERR_PTR(-ENOMEM);
+    }
+
+    memcpy(new->session_id, session_id, 16);
+    mutex_init(&new->lock);
+    refcount_set(&new->refs, 2);    /* Table + caller */
+    new->last_used = jiffies;
 
     spin_lock_irqsave(&session_lock, flags);
 
-    /* Look for existing session */
-    for (i = 0; i < MAX_SESSIONS; i++) {
-        if (sessions[i].active &&
-            memcmp(sessions[i].session_id, session_id, 16) == 0) {
-            session = &sessions[i];
-            goto out;
+    /* Lost a race with another creator */
+    hash_for_each_possible(session_table, session, node,
+                           session_hash(session_id)) {
+        if (!memcmp(session->session_id, session_id, 16) &&
+            refcount_inc_not_zero(&session->refs)) {
+            spin_unlock_irqrestore(&session_lock, flags);
+            kfree(new);
+            kfree(new_src);
+            return session;
         }
     }
 
-    /* Find free slot */
-    for (i = 0; i < MAX_SESSIONS; i++) {
-        if (!sessions[i].active) {
-            session = &sessions[i];
-            memcpy(session->session_id, session_id, 16);
-            session->active = true;
-            goto out;
-        }
+    src = find_source(source);
+    if ((src && src->sessions >= FW_ATTEST_MAX_PER_SOURCE) ||
+        session_stats.active >= FW_ATTEST_MAX_SESSIONS) {
+        session_stats.rejected++;
+        spin_unlock_irqrestore(&session_lock, flags);
+        kfree(new);
+        kfree(new_src);
+        return ERR_PTR(-EBUSY);
     }
 
-out:
+    if (!src) {
+        src = new_src;
+        src->id = source;
+        hash_add(source_table, &src->node, source);
+        new_src = NULL;
+    }
+    src->sessions++;
+
+    new->source = src;
+    hash_add_rcu(session_table, &new->node, session_hash(session_id));
+    session_stats.active++;
+    session_stats.created++;
+
     spin_unlock_irqrestore(&session_lock, flags);
-    return session;
+
+    kfree(new_src);
+    return new;
 }
 
-/* Generate new attestation challenge */
-int fw_attest_challenge(const u8 *session_id,
-                       struct attest_challenge *challenge)
+/* Drop sessions idle for longer than the timeout (0 = all) */
+static void expire_sessions(bool all)
+{
+    struct attest_session *session, *tmp;
+    unsigned long flags, timeout;
+    struct hlist_node *n;
+    LIST_HEAD(reap);
+    int bkt;
+
+    timeout = (unsigned long)READ_ONCE(session_timeout) * HZ;
+
+    spin_lock_irqsave(&session_lock, flags);
+    hash_for_each_safe(session_table, bkt, n, session, node) {
+        if (!all && time_before(jiffies,
+                                READ_ONCE(session->last_used) + timeout))
+            continue;
+
+        unhash_session(session);
+        list_add(&session->reap, &reap);
+        if (!all)
+            session_stats.expired++;
+    }
+    spin_unlock_irqrestore(&session_lock, flags);
+
+    /* Drop the table references outside the lock; tfm free may sleep */
+    list_for_each_entry_safe(session, tmp, &reap, reap)
+        put_session(session);
+}
+
+static void sweep_work_fn(struct work_struct *work)
+{
+    expire_sessions(false);
+    schedule_delayed_work(&sweep_work, sweep_interval());
+}
+
+/* Initialize attestation service; called from wifi67 module init */
+int fw_attest_init(void)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&session_lock, flags);
+    sweep_running = true;
+    schedule_delayed_work(&sweep_work, sweep_interval());
+    spin_unlock_irqrestore(&session_lock, flags);
+    return 0;
+}
+
+/* Clean up attestation resources; called from wifi67 module exit */
+void fw_attest_exit(void)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&session_lock, flags);
+    sweep_running = false;
+    spin_unlock_irqrestore(&session_lock, flags);
+
+    cancel_delayed_work_sync(&sweep_work);
+    expire_sessions(true);
+    rcu_barrier();
+}
+
+/* Set the idle timeout after which sessions are expired */
+void fw_attest_set_timeout(unsigned int seconds)
+{
+    unsigned long flags;
+
+    WRITE_ONCE(session_timeout, seconds);
+
+    /* Pull the next sweep in if the new interval is shorter */
+    spin_lock_irqsave(&session_lock, flags);
+    if (sweep_running)
+        mod_delayed_work(system_wq, &sweep_work, sweep_interval());
+    spin_unlock_irqrestore(&session_lock, flags);
+}
+
+int fw_attest_get_stats(struct attest_stats *stats)
+{
+    unsigned long flags;
+
+    if (!stats)
+        return -EINVAL;
+
+    spin_lock_irqsave(&session_lock, flags);
+    *stats = session_stats;
+    spin_unlock_irqrestore(&session_lock, flags);
+
+    return 0;
+}
+
+/* Generate new attestation challenge for a session opened by @source */
+int fw_attest_challenge_from(const u8 *session_id, u32 source,
+                            struct attest_challenge *challenge)
 {
     struct attest_session *session;
     struct crypto_aead *tfm;
@@ -86,9 +290,18 @@ int fw_attest_challenge(const u8 *session_id,
     if (!session_id || !challenge)
         return -EINVAL;
 
-    session = get_session(session_id);
-    if (!session)
-        return -ENOMEM;
+    session = get_session(session_id, source);
+    if (IS_ERR(session))
+        return PTR_ERR(session);
+
+    /* Initialize AEAD cipher */
+    tfm = crypto_alloc_aead("gcm(aes)", 0, 0);
+    if (IS_ERR(tfm)) {
+        ret = PTR_ERR(tfm);
+        goto out_put;
+    }
+
+    mutex_lock(&session->lock);
 
     /* Generate random nonce */
     get_random_bytes(session->nonce, sizeof(session->nonce));
@@ -98,31 +311,34 @@ int fw_attest_challenge(const u8 *session_id,
     get_random_bytes(session->key, sizeof(session->key));
     get_random_bytes(session->iv, sizeof(session->iv));
 
-    /* Initialize AEAD cipher */
-    tfm = crypto_alloc_aead("gcm(aes)", 0, 0);
-    if (IS_ERR(tfm))
-        return PTR_ERR(tfm);
-
     ret = crypto_aead_setkey(tfm, session->key, sizeof(session->key));
-    if (ret < 0) {
-        crypto_free_aead(tfm);
-        return ret;
-    }
+    if (ret < 0)
+        goto out_free;
 
     ret = crypto_aead_setauthsize(tfm, 16);
-    if (ret < 0) {
-        crypto_free_aead(tfm);
-        return ret;
-    }
+    if (ret < 0)
+        goto out_free;
 
-    if (session->tfm)
-        crypto_free_aead(session->tfm);
-    session->tfm = tfm;
+    swap(session->tfm, tfm);
 
     session->timestamp = ktime_get_real_seconds();
     challenge->timestamp = session->timestamp;
 
-    return 0;
+out_free:
+    mutex_unlock(&session->lock);
+    if (tfm)
+        crypto_free_aead(tfm);
+out_put:
+    put_session(session);
+    return ret;
+}
+
+/* Generate new attestation challenge */
+int fw_attest_challenge(const u8 *session_id,
+                       struct attest_challenge *challenge)
+{
+    return fw_attest_challenge_from(session_id, FW_ATTEST_SOURCE_LOCAL,
+                                   challenge);
 }
 
 /* Verify attestation response */
@@ -139,22 +355,26 @@ int fw_attest_verify(const u8 *session_id,
     if (!session_id || !response)
         return -EINVAL;
 
-    session = get_session(session_id);
-    if (!session || !session->active)
+    session = find_session(session_id);
+    if (!session)
         return -EINVAL;
 
-    /* Verify nonce */
-    if (memcmp(response->nonce, session->nonce, sizeof(session->nonce)))
-        return -EINVAL;
+    mutex_lock(&session->lock);
 
-    /* Verify timestamp */
-    if (response->timestamp != session->timestamp)
-        return -EINVAL;
+    /* Verify nonce and timestamp */
+    if (!session->tfm ||
+        memcmp(response->nonce, session->nonce, sizeof(session->nonce)) ||
+        response->timestamp != session->timestamp) {
+        ret = -EINVAL;
+        goto out;
+    }
 
     /* Allocate buffer for decrypted data */
     plaintext = kmalloc(response->data_len, GFP_KERNEL);
-    if (!plaintext)
-        return -ENOMEM;
+    if (!plaintext) {
+        ret = -ENOMEM;
+        goto out;
+    }
 
     tfm = session->tfm;
     req = aead_request_alloc(tfm, GFP_KERNEL);
@@ -192,6 +412,8 @@ int fw_attest_verify(const u8 *session_id,
                                  response->pcr_values + 64);
 
 out:
+    mutex_unlock(&session->lock);
+    put_session(session);
     kfree(plaintext);
     return ret;
 }
@@ -209,14 +431,23 @@ int fw_attest_export(const u8 *session_id,
     if (!session_id || !export || !export->data || !export->data_len)
         return -EINVAL;
 
-    session = get_session(session_id);
-    if (!session || !session->active)
+    session = find_session(session_id);
+    if (!session)
         return -EINVAL;
 
+    mutex_lock(&session->lock);
+
     tfm = session->tfm;
+    if (!tfm) {
+        ret = -EINVAL;
+        goto out;
+    }
+
     req = aead_request_alloc(tfm, GFP_KERNEL);
-    if (!req)
-        return -ENOMEM;
+    if (!req) {
+        ret = -ENOMEM;
+        goto out;
+    }
 
     sg_init_table(sg, 3);
     sg_set_buf(&sg[0], session->iv, sizeof(session->iv));
@@ -229,11 +460,17 @@ int fw_attest_export(const u8 *session_id,
     ret = crypto_aead_encrypt(req);
     aead_request_free(req);
 
+out:
+    mutex_unlock(&session->lock);
+    put_session(session);
     return ret;
 }
 
 EXPORT_SYMBOL_GPL(fw_attest_init);
 EXPORT_SYMBOL_GPL(fw_attest_exit);
 EXPORT_SYMBOL_GPL(fw_attest_challenge);
+EXPORT_SYMBOL_GPL(fw_attest_challenge_from);
 EXPORT_SYMBOL_GPL(fw_attest_verify);
-EXPORT_SYMBOL_GPL(fw_attest_export); 
\ No newline at end of file
+EXPORT_SYMBOL_GPL(fw_attest_export);
+EXPORT_SYMBOL_GPL(fw_attest_set_timeout);
+EXPORT_SYMBOL_GPL(fw_attest_get_stats);
@@ -6,6 +6,19 @@
 /* Maximum size of attestation data */
 #define MAX_ATTEST_DATA_SIZE 4096
 
+/*
+ * Sessions live in an RCU hash table keyed by session ID. Each source
+ * (requester) may hold a bounded number at once, and sessions idle for
+ * longer than the timeout are expired by a periodic sweep.
+ */
+#define FW_ATTEST_HASH_BITS         10
+#define FW_ATTEST_SOURCE_HASH_BITS  6
+#define FW_ATTEST_MAX_SESSIONS      8192
+#define FW_ATTEST_MAX_PER_SOURCE    64
+#define FW_ATTEST_SESSION_TIMEOUT   300     /* Seconds idle before expiry */
+#define FW_ATTEST_SWEEP_INTERVAL    30      /* Seconds between sweeps */
+#define FW_ATTEST_SOURCE_LOCAL      0
+
 /* Attestation challenge structure */
 struct attest_challenge {
     u8 nonce[32];
@@ -29,14 +42,26 @@ struct attest_export {
     u8 tag[16];
 };
 
+/* Session table statistics */
+struct attest_stats {
+    u32 active;
+    u64 created;
+    u64 expired;
+    u64 rejected;       /* Refused by the per-source or global cap */
+};
+
 /* Attestation functions */
 int fw_attest_init(void);
 void fw_attest_exit(void);
 int fw_attest_challenge(const u8 *session_id,
                        struct attest_challenge *challenge);
+int fw_attest_challenge_from(const u8 *session_id, u32 source,
+                            struct attest_challenge *challenge);
 int fw_attest_verify(const u8 *session_id,
                     const struct attest_response *response);
 int fw_attest_export(const u8 *session_id,
                     struct attest_export *export);
+void fw_attest_set_timeout(unsigned int seconds);
+int fw_attest_get_stats(struct attest_stats *stats);
 
 #endif /* _FW_ATTEST_H_ */ 
\ No newline at end of file
@@ -1,7 +1,13 @@
 #include <linux/kernel.h>
 #include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
 #include <linux/zlib.h>
 #include <linux/xz.h>
+#if IS_ENABLED(CONFIG_ZSTD_DECOMPRESS)
+#include <linux/zstd.h>
+#endif
 #include "fw_common.h"
 
 /* CRC32 table for checksum calculation */
@@ -25,10 +31,14 @@ static void init_crc32_table(void)
     crc32_initialized = true;
 }
 
-int fw_verify_checksum(const void *data, size_t len, u32 expected)
+/* Shared SHA-256 transform, allocated on first use */
+static struct crypto_shash *fw_sha256_tfm;
+static DEFINE_MUTEX(fw_hash_lock);
+
+/* Raw CRC32 update, no pre or post inversion (same as crc32_le()) */
+u32 fw_crc32_update(u32 crc, const void *data, size_t len)
 {
     const u8 *buf = data;
-    u32 crc = 0xFFFFFFFF;
     size_t i;
 
     if (!crc32_initialized)
@@ -37,19 +47,119 @@ int fw_verify_checksum(const void *data, size_t len, u32 expected)
     for (i = 0; i < len; i++)
         crc = (crc >> 8) ^ crc32_table[(crc & 0xFF) ^ buf[i]];
 
-    crc = ~crc;
+    return crc;
+}
+
+int fw_verify_checksum(const void *data, size_t len, u32 expected)
+{
+    u32 crc = ~fw_crc32_update(0xFFFFFFFF, data, len);
+
     return (crc == expected) ? FW_ERR_NONE : FW_ERR_VERIFY;
 }
 
+static struct crypto_shash *fw_hash_tfm(void)
+{
+    struct crypto_shash *tfm;
+
+    mutex_lock(&fw_hash_lock);
+    if (!fw_sha256_tfm) {
+        tfm = crypto_alloc_shash("sha256", 0, 0);
+        if (!IS_ERR(tfm))
+            fw_sha256_tfm = tfm;
+    }
+    tfm = fw_sha256_tfm;
+    mutex_unlock(&fw_hash_lock);
+
+    return tfm;
+}
+
+/* Release the shared transform; call from module exit */
+void fw_hash_exit(void)
+{
+    mutex_lock(&fw_hash_lock);
+    crypto_free_shash(fw_sha256_tfm);
+    fw_sha256_tfm = NULL;
+    mutex_unlock(&fw_hash_lock);
+}
+
+int fw_verify_begin(struct fw_verify_ctx *ctx, u32 flags)
+{
+    struct crypto_shash *tfm;
+
+    /* Header checksums are crc32(0, body): seed 0, no final inversion */
+    ctx->crc = 0;
+    ctx->len = 0;
+    ctx->flags = flags;
+
+    if (!(flags & FW_VERIFY_SHA256))
+        return FW_ERR_NONE;
+
+    tfm = fw_hash_tfm();
+    if (!tfm || crypto_shash_descsize(tfm) > HASH_MAX_DESCSIZE) {
+        ctx->flags &= ~FW_VERIFY_SHA256;
+        return FW_ERR_VERIFY;
+    }
+
+    ctx->desc.tfm = tfm;
+    return crypto_shash_init(&ctx->desc) ? FW_ERR_VERIFY : FW_ERR_NONE;
+}
+
+int fw_verify_update(struct fw_verify_ctx *ctx, const void *data, size_t len)
+{
+    if (ctx->flags & FW_VERIFY_CRC)
+        ctx->crc = fw_crc32_update(ctx->crc, data, len);
+    ctx->len += len;
+
+    if ((ctx->flags & FW_VERIFY_SHA256) &&
+        crypto_shash_update(&ctx->desc, data, len))
+        return FW_ERR_VERIFY;
+
+    return FW_ERR_NONE;
+}
+
+int fw_verify_final(struct fw_verify_ctx *ctx, u32 *crc, u8 *digest)
+{
+    int ret = FW_ERR_NONE;
+
+    if (crc)
+        *crc = ctx->crc;
+
+    if (ctx->flags & FW_VERIFY_SHA256) {
+        u8 out[SHA256_DIGEST_SIZE];
+
+        if (crypto_shash_final(&ctx->desc, out))
+            ret = FW_ERR_VERIFY;
+        else if (digest)
+            memcpy(digest, out, sizeof(out));
+        shash_desc_zero(&ctx->desc);
+        ctx->flags &= ~FW_VERIFY_SHA256;
+    }
+
+    return ret;
+}
+
+void fw_verify_abort(struct fw_verify_ctx *ctx)
+{
+    if (ctx->flags & FW_VERIFY_SHA256)
+        shash_desc_zero(&ctx->desc);
+    ctx->flags = 0;
+}
+
 int fw_decompress_zlib(const void *src, size_t src_len,
                       void *dst, size_t *dst_len)
 {
     z_stream strm = {};
     int ret;
 
+    strm.workspace = kvmalloc(zlib_inflate_workspacesize(), GFP_KERNEL);
+    if (!strm.workspace)
+        return FW_ERR_COMPRESS;
+
     ret = zlib_inflateInit(&strm);
-    if (ret != Z_OK)
+    if (ret != Z_OK) {
+        kvfree(strm.workspace);
         return FW_ERR_COMPRESS;
+    }
 
     strm.avail_in = src_len;
     strm.next_in = src;
@@ -57,13 +167,13 @@ int fw_decompress_zlib(const void *src, size_t src_len,
     strm.next_out = dst;
 
     ret = zlib_inflate(&strm, Z_FINISH);
-    if (ret != Z_STREAM_END) {
-        zlib_inflateEnd(&strm);
+    zlib_inflateEnd(&strm);
+    kvfree(strm.workspace);
+
+    if (ret != Z_STREAM_END)
         return FW_ERR_COMPRESS;
-    }
 
     *dst_len = strm.total_out;
-    zlib_inflateEnd(&strm);
     return FW_ERR_NONE;
 }
 
@@ -95,6 +205,251 @@ int fw_decompress_xz(const void *src, size_t src_len,
     return FW_ERR_NONE;
 }
 
+int fw_decompress_zstd(const void *src, size_t src_len,
+                      void *dst, size_t *dst_len)
+{
+#if IS_ENABLED(CONFIG_ZSTD_DECOMPRESS)
+    zstd_dctx *dctx;
+    void *wksp;
+    size_t wksp_size, ret;
+
+    wksp_size = zstd_dctx_workspace_bound();
+    wksp = kvmalloc(wksp_size, GFP_KERNEL);
+    if (!wksp)
+        return FW_ERR_COMPRESS;
+
+    dctx = zstd_init_dctx(wksp, wksp_size);
+    if (!dctx) {
+        kvfree(wksp);
+        return FW_ERR_COMPRESS;
+    }
+
+    ret = zstd_decompress_dctx(dctx, dst, *dst_len, src, src_len);
+    kvfree(wksp);
+
+    if (zstd_is_error(ret))
+        return FW_ERR_COMPRESS;
+
+    *dst_len = ret;
+    return FW_ERR_NONE;
+#else
+    return FW_ERR_COMPRESS;
+#endif
+}
+
+/* Streaming decompression */
+
+static int fw_stream_zlib(const void *src, size_t src_len,
+                          u8 *window, size_t window_size,
+                          fw_stream_sink_t sink, void *priv,
+                          size_t *total_out)
+{
+    z_stream strm = {};
+    int ret, zret;
+
+    strm.workspace = kvmalloc(zlib_inflate_workspacesize(), GFP_KERNEL);
+    if (!strm.workspace)
+        return FW_ERR_COMPRESS;
+
+    if (zlib_inflateInit(&strm) != Z_OK) {
+        kvfree(strm.workspace);
+        return FW_ERR_COMPRESS;
+    }
+
+    strm.next_in = src;
+    strm.avail_in = src_len;
+
+    do {
+        strm.next_out = window;
+        strm.avail_out = window_size;
+
+        zret = zlib_inflate(&strm, Z_SYNC_FLUSH);
+        if (zret != Z_OK && zret != Z_STREAM_END) {
+            ret = FW_ERR_COMPRESS;
+            goto out;
+        }
+
+        /* No progress with input left means a truncated stream */
+        if (strm.avail_out == window_size && zret != Z_STREAM_END) {
+            ret = FW_ERR_COMPRESS;
+            goto out;
+        }
+
+        if (strm.avail_out != window_size) {
+            ret = sink(priv, window, window_size - strm.avail_out);
+            if (ret)
+                goto out;
+        }
+    } while (zret != Z_STREAM_END);
+
+    *total_out = strm.total_out;
+    ret = FW_ERR_NONE;
+out:
+    zlib_inflateEnd(&strm);
+    kvfree(strm.workspace);
+    return ret;
+}
+
+static int fw_stream_xz(const void *src, size_t src_len,
+                        u8 *window, size_t window_size,
+                        fw_stream_sink_t sink, void *priv,
+                        size_t *total_out)
+{
+    struct xz_dec *dec;
+    struct xz_buf buf;
+    enum xz_ret xret;
+    int ret = FW_ERR_NONE;
+
+    /* Dictionary bounded so peak memory stays independent of image size */
+    dec = xz_dec_init(XZ_DYNALLOC, FW_XZ_DICT_MAX);
+    if (!dec)
+        return FW_ERR_COMPRESS;
+
+    buf.in = src;
+    buf.in_pos = 0;
+    buf.in_size = src_len;
+    *total_out = 0;
+
+    do {
+        buf.out = window;
+        buf.out_pos = 0;
+        buf.out_size = window_size;
+
+        xret = xz_dec_run(dec, &buf);
+        if (xret != XZ_OK && xret != XZ_STREAM_END) {
+            ret = FW_ERR_COMPRESS;
+            break;
+        }
+
+        if (buf.out_pos) {
+            *total_out += buf.out_pos;
+            ret = sink(priv, window, buf.out_pos);
+            if (ret)
+                break;
+        } else if (xret != XZ_STREAM_END && buf.in_pos == buf.in_size) {
+            ret = FW_ERR_COMPRESS;
+            break;
+        }
+    } while (xret != XZ_STREAM_END);
+
+    xz_dec_end(dec);
+    return ret;
+}
+
+#if IS_ENABLED(CONFIG_ZSTD_DECOMPRESS)
+static int fw_stream_zstd(const void *src, size_t src_len,
+                          u8 *window, size_t window_size,
+                          fw_stream_sink_t sink, void *priv,
+                          size_t *total_out)
+{
+    zstd_dstream *dstream;
+    zstd_in_buffer in = { .src = src, .size = src_len, .pos = 0 };
+    zstd_out_buffer out;
+    size_t wksp_size, zret;
+    void *wksp;
+    int ret = FW_ERR_NONE;
+
+    wksp_size = zstd_dstream_workspace_bound(FW_ZSTD_WINDOW_MAX);
+    wksp = kvmalloc(wksp_size, GFP_KERNEL);
+    if (!wksp)
+        return FW_ERR_COMPRESS;
+
+    dstream = zstd_init_dstream(FW_ZSTD_WINDOW_MAX, wksp, wksp_size);
+    if (!dstream) {
+        kvfree(wksp);
+        return FW_ERR_COMPRESS;
+    }
+
+    *total_out = 0;
+
+    do {
+        out.dst = window;
+        out.size = window_size;
+        out.pos = 0;
+
+        zret = zstd_decompress_stream(dstream, &out, &in);
+        if (zstd_is_error(zret)) {
+            ret = FW_ERR_COMPRESS;
+            break;
+        }
+
+        if (out.pos) {
+            *total_out += out.pos;
+            ret = sink(priv, window, out.pos);
+            if (ret)
+                break;
+        } else if (zret && in.pos == in.size) {
+            ret = FW_ERR_COMPRESS;
+            break;
+        }
+    } while (zret);
+
+    kvfree(wksp);
+    return ret;
+}
+#endif
+
+/*
+ * Decompress @src through a bounded window of @window_size bytes, handing
+ * each filled window to @sink as it is produced. Peak memory is the
+ * window plus the decoder state, not the decompressed image, and the
+ * sink can start transferring before decompression finishes.
+ */
+int fw_decompress_stream(enum fw_compress_type type,
+                        const void *src, size_t src_len,
+                        size_t window_size,
+                        fw_stream_sink_t sink, void *priv,
+                        size_t *total_out)
+{
+    size_t out = 0;
+    u8 *window;
+    int ret;
+
+    if (!src || !sink)
+        return FW_ERR_COMPRESS;
+
+    window_size = clamp_t(size_t, window_size, FW_STREAM_WINDOW_MIN,
+                          FW_STREAM_WINDOW_MAX);
+
+    /* Uncompressed images go straight to the sink */
+    if (type == FW_COMPRESS_NONE) {
+        ret = sink(priv, src, src_len);
+        if (!ret && total_out)
+            *total_out = src_len;
+        return ret;
+    }
+
+    window = kvmalloc(window_size, GFP_KERNEL);
+    if (!window)
+        return FW_ERR_COMPRESS;
+
+    switch (type) {
+    case FW_COMPRESS_ZLIB:
+        ret = fw_stream_zlib(src, src_len, window, window_size,
+                             sink, priv, &out);
+        break;
+    case FW_COMPRESS_XZ:
+        ret = fw_stream_xz(src, src_len, window, window_size,
+                           sink, priv, &out);
+        break;
+#if IS_ENABLED(CONFIG_ZSTD_DECOMPRESS)
+    case FW_COMPRESS_ZSTD:
+        ret = fw_stream_zstd(src, src_len, window, window_size,
+                             sink, priv, &out);
+        break;
+#endif
+    default:
+        ret = FW_ERR_COMPRESS;
+        break;
+    }
+
+    kvfree(window);
+
+    if (!ret && total_out)
+        *total_out = out;
+    return ret;
+}
+
 int fw_version_compare(const struct fw_version *v1,
                       const struct fw_version *v2)
 {
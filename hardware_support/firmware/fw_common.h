@@ -3,6 +3,8 @@
 
 #include <linux/types.h>
 #include <linux/firmware.h>
+#include <crypto/hash.h>
+#include <crypto/sha2.h>
 
 /* Common firmware error codes */
 #define FW_ERR_NONE            0
@@ -21,6 +23,44 @@
 #define FW_FLAG_VERIFY         BIT(2)
 #define FW_FLAG_FORCE          BIT(3)
 
+/* Compression formats */
+enum fw_compress_type {
+    FW_COMPRESS_NONE = 0,
+    FW_COMPRESS_ZLIB,
+    FW_COMPRESS_XZ,
+    FW_COMPRESS_ZSTD,
+};
+
+/* Streaming decompression limits */
+#define FW_STREAM_WINDOW_MIN   256
+#define FW_STREAM_WINDOW_MAX   (1024 * 1024)
+#define FW_XZ_DICT_MAX         (1024 * 1024)
+#define FW_ZSTD_WINDOW_MAX     (1024 * 1024)
+
+/*
+ * Streaming sink: receives each filled window of decompressed output in
+ * order. A non-zero return aborts decompression and is passed back.
+ */
+typedef int (*fw_stream_sink_t)(void *priv, const void *data, size_t len);
+
+/*
+ * Incremental image verifier: CRC32 and SHA-256 fed chunk by chunk as the
+ * image is transferred, so the image is read once. The descriptor lives
+ * inline and the sha256 transform is shared and long-lived.
+ */
+#define FW_VERIFY_CRC          BIT(0)
+#define FW_VERIFY_SHA256       BIT(1)
+
+struct fw_verify_ctx {
+    u32 crc;
+    size_t len;
+    u32 flags;
+    union {
+        struct shash_desc desc;
+        u8 desc_buf[sizeof(struct shash_desc) + HASH_MAX_DESCSIZE];
+    } __aligned(ARCH_SLAB_MINALIGN);
+};
+
 /* Firmware version structure */
 struct fw_version {
     u8 major;
@@ -56,10 +96,23 @@ struct fw_ops {
 
 /* Helper functions */
 int fw_verify_checksum(const void *data, size_t len, u32 expected);
+u32 fw_crc32_update(u32 crc, const void *data, size_t len);
+int fw_verify_begin(struct fw_verify_ctx *ctx, u32 flags);
+int fw_verify_update(struct fw_verify_ctx *ctx, const void *data, size_t len);
+int fw_verify_final(struct fw_verify_ctx *ctx, u32 *crc, u8 *digest);
+void fw_verify_abort(struct fw_verify_ctx *ctx);
+void fw_hash_exit(void);
 int fw_decompress_zlib(const void *src, size_t src_len,
                       void *dst, size_t *dst_len);
 int fw_decompress_xz(const void *src, size_t src_len,
                     void *dst, size_t *dst_len);
+int fw_decompress_zstd(const void *src, size_t src_len,
+                      void *dst, size_t *dst_len);
+int fw_decompress_stream(enum fw_compress_type type,
+                        const void *src, size_t src_len,
+                        size_t window_size,
+                        fw_stream_sink_t sink, void *priv,
+                        size_t *total_out);
 int fw_version_compare(const struct fw_version *v1,
                       const struct fw_version *v2);
 void fw_version_to_string(const struct fw_version *ver,
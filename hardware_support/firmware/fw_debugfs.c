@@ -22,6 +22,7 @@ static int eventlog_status_show(struct seq_file *m, void *v)
 
     seq_printf(m, "Event Count: %u\n", stats.event_count);
     seq_printf(m, "Last Update: %llu\n", stats.last_update);
+    seq_printf(m, "Parsed Bytes: %llu\n", stats.parsed_bytes);
     return 0;
 }
 
@@ -62,6 +63,7 @@ out:
 static int attest_status_show(struct seq_file *m, void *v)
 {
     struct attest_challenge challenge;
+    struct attest_stats stats;
     const u8 test_id[16] = {0};
     int ret;
 
@@ -72,6 +74,13 @@ static int attest_status_show(struct seq_file *m, void *v)
     seq_puts(m, "Attestation Service Status:\n");
     seq_printf(m, "Time: %llu\n", challenge.timestamp);
     seq_puts(m, "State: Active\n");
+
+    if (!fw_attest_get_stats(&stats)) {
+        seq_printf(m, "Sessions: %u\n", stats.active);
+        seq_printf(m, "Created: %llu\n", stats.created);
+        seq_printf(m, "Expired: %llu\n", stats.expired);
+        seq_printf(m, "Rejected: %llu\n", stats.rejected);
+    }
     return 0;
 }
 
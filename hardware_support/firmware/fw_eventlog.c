@@ -3,258 +3,412 @@
 #include <linux/tpm_eventlog.h>
 #include <linux/mutex.h>
 #include <linux/slab.h>
-#include <linux/rbtree.h>
+#include <linux/mm.h>
+#include <crypto/hash.h>
+#include <crypto/sha2.h>
+#include <asm/unaligned.h>
 #include "fw_keys.h"
 #include "fw_eventlog.h"
 
-/* Event log cache structure */
-struct eventlog_cache {
-    struct rb_root events;
-    struct mutex lock;
-    u32 count;
-    u64 last_update;
-};
+#define EVENTLOG_INITIAL_CAPACITY  16
+#define EVENTLOG_MAX_DIGESTS       8    /* PCR banks per event */
 
 /* Event entry in cache */
 struct event_entry {
-    struct rb_node node;
     u32 pcr_index;
     u32 event_type;
-    u8 digest[TPM2_SHA256_DIGEST_SIZE];
+    u8 digest[SHA256_DIGEST_SIZE];
     void *data;
     size_t data_len;
     u64 timestamp;
 };
 
+/* Events and running digest for one PCR */
+struct pcr_log {
+    struct event_entry **entries;
+    u32 count;
+    u32 capacity;
+    u8 digest[SHA256_DIGEST_SIZE];  /* Replay of every event so far */
+};
+
+/* Event log cache structure */
+struct eventlog_cache {
+    struct mutex lock;
+    struct kmem_cache *entry_cache;
+    struct crypto_shash *tfm;
+    fw_eventlog_reader_t reader;
+
+    /* All events in log order; per-PCR arrays point into these */
+    struct event_entry **events;
+    u32 count;
+    u32 capacity;
+    struct pcr_log pcrs[FW_EVENTLOG_MAX_PCRS];
+
+    size_t offset;                  /* Log bytes already parsed */
+    u64 last_update;
+};
+
 static struct eventlog_cache log_cache;
 
+/* Default source: the TPM's own event log */
+static int read_tpm_log(size_t offset, u8 *buf, size_t size, size_t *len)
+{
+    struct tpm_chip *chip;
+    u8 *log;
+    size_t total;
+    int ret;
+
+    chip = tpm_default_chip();
+    if (!chip)
+        return -ENODEV;
+
+    ret = tpm_get_event_log(chip, NULL, 0, &total);
+    if (ret < 0)
+        return ret;
+
+    *len = total;
+    if (!buf || offset >= total)
+        return 0;
+
+    log = kvmalloc(total, GFP_KERNEL);
+    if (!log)
+        return -ENOMEM;
+
+    ret = tpm_get_event_log(chip, log, total, &total);
+    if (ret >= 0 && offset < total) {
+        memcpy(buf, log + offset, min(size, total - offset));
+        *len = total;
+        ret = 0;
+    }
+
+    kvfree(log);
+    return ret;
+}
+
 /* Initialize event log handling */
 int fw_eventlog_init(void)
 {
+    memset(&log_cache, 0, sizeof(log_cache));
     mutex_init(&log_cache.lock);
-    log_cache.events = RB_ROOT;
-    log_cache.count = 0;
-    log_cache.last_update = 0;
+
+    log_cache.entry_cache = kmem_cache_create("fw_eventlog_entry",
+                                              sizeof(struct event_entry),
+                                              0, 0, NULL);
+    if (!log_cache.entry_cache)
+        return -ENOMEM;
+
+    log_cache.tfm = crypto_alloc_shash("sha256", 0, 0);
+    if (IS_ERR(log_cache.tfm)) {
+        int ret = PTR_ERR(log_cache.tfm);
+
+        log_cache.tfm = NULL;
+        kmem_cache_destroy(log_cache.entry_cache);
+        log_cache.entry_cache = NULL;
+        return ret;
+    }
+
     return 0;
 }
 
+/* Drop every cached event; caller holds the lock */
+static void clear_cache(void)
+{
+    u32 i;
+
+    for (i = 0; i < log_cache.count; i++) {
+        kfree(log_cache.events[i]->data);
+        kmem_cache_free(log_cache.entry_cache, log_cache.events[i]);
+    }
+
+    kvfree(log_cache.events);
+    log_cache.events = NULL;
+    log_cache.count = 0;
+    log_cache.capacity = 0;
+
+    for (i = 0; i < FW_EVENTLOG_MAX_PCRS; i++) {
+        kvfree(log_cache.pcrs[i].entries);
+        memset(&log_cache.pcrs[i], 0, sizeof(log_cache.pcrs[i]));
+    }
+
+    log_cache.offset = 0;
+}
+
 /* Clean up event log resources */
 void fw_eventlog_exit(void)
 {
-    struct rb_node *node;
-    struct event_entry *entry;
-
     mutex_lock(&log_cache.lock);
-    while ((node = rb_first(&log_cache.events))) {
-        entry = rb_entry(node, struct event_entry, node);
-        rb_erase(node, &log_cache.events);
-        kfree(entry->data);
-        kfree(entry);
-    }
+    if (log_cache.entry_cache)
+        clear_cache();
     mutex_unlock(&log_cache.lock);
+
+    kmem_cache_destroy(log_cache.entry_cache);
+    log_cache.entry_cache = NULL;
+
+    if (log_cache.tfm)
+        crypto_free_shash(log_cache.tfm);
+    log_cache.tfm = NULL;
+}
+
+static int grow_array(struct event_entry ***array, u32 *capacity, u32 count)
+{
+    struct event_entry **new;
+    u32 new_cap;
+
+    if (count < *capacity)
+        return 0;
+
+    new_cap = *capacity ? *capacity * 2 : EVENTLOG_INITIAL_CAPACITY;
+    new = kvmalloc_array(new_cap, sizeof(*new), GFP_KERNEL);
+    if (!new)
+        return -ENOMEM;
+
+    if (*array)
+        memcpy(new, *array, count * sizeof(*new));
+    kvfree(*array);
+
+    *array = new;
+    *capacity = new_cap;
+    return 0;
 }
 
-/* Add event to cache */
+/* Add event to cache and fold it into its PCR's running digest */
 static int cache_event(struct event_entry *event)
 {
-    struct rb_node **new = &log_cache.events.rb_node;
-    struct rb_node *parent = NULL;
-    struct event_entry *entry;
+    struct pcr_log *pcr = &log_cache.pcrs[event->pcr_index];
+    int ret;
 
-    while (*new) {
-        parent = *new;
-        entry = rb_entry(parent, struct event_entry, node);
+    ret = grow_array(&log_cache.events, &log_cache.capacity,
+                     log_cache.count);
+    if (ret)
+        return ret;
+
+    ret = grow_array(&pcr->entries, &pcr->capacity, pcr->count);
+    if (ret)
+        return ret;
 
-        if (event->timestamp < entry->timestamp)
-            new = &parent->rb_left;
-        else if (event->timestamp > entry->timestamp)
-            new = &parent->rb_right;
-        else
-            return -EEXIST;
+    /* NO_ACTION events are informational and never extended */
+    if (event->event_type != NO_ACTION) {
+        SHASH_DESC_ON_STACK(desc, log_cache.tfm);
+
+        desc->tfm = log_cache.tfm;
+        ret = crypto_shash_init(desc) ?:
+              crypto_shash_update(desc, pcr->digest, sizeof(pcr->digest)) ?:
+              crypto_shash_update(desc, event->digest,
+                                  sizeof(event->digest)) ?:
+              crypto_shash_final(desc, pcr->digest);
+        shash_desc_zero(desc);
+        if (ret)
+            return ret;
     }
 
-    rb_link_node(&event->node, parent, new);
-    rb_insert_color(&event->node, &log_cache.events);
-    log_cache.count++;
+    log_cache.events[log_cache.count++] = event;
+    pcr->entries[pcr->count++] = event;
     return 0;
 }
 
-/* Parse and validate event data */
-static int parse_event(const struct tpm_event_header *header,
-                      const u8 *data, size_t len,
-                      struct event_entry *entry)
+static size_t digest_size(u16 alg_id)
+{
+    switch (alg_id) {
+    case TPM_ALG_SHA1:
+        return SHA1_DIGEST_SIZE;
+    case TPM_ALG_SHA256:
+    case TPM_ALG_SM3_256:
+        return SHA256_DIGEST_SIZE;
+    case TPM_ALG_SHA384:
+        return SHA384_DIGEST_SIZE;
+    case TPM_ALG_SHA512:
+        return SHA512_DIGEST_SIZE;
+    default:
+        return 0;
+    }
+}
+
+/* Size of the TCG 1.2 format Spec ID header at the start of the log */
+static size_t spec_id_header_size(const u8 *data, size_t len)
 {
-    const struct tcg_pcr_event2 *event2;
-    const struct tcg_digest *digest;
+    const struct tcg_pcr_event *event = (const struct tcg_pcr_event *)data;
     size_t size;
 
-    if (len < sizeof(*header))
-        return -EINVAL;
+    if (len < sizeof(*event))
+        return 0;
+
+    size = sizeof(*event) + get_unaligned_le32(&event->event_size);
+    if (get_unaligned_le32(&event->event_type) != NO_ACTION || len < size ||
+        size < sizeof(*event) + sizeof(TCG_SPECID_SIG) ||
+        memcmp(event->event, TCG_SPECID_SIG, sizeof(TCG_SPECID_SIG)))
+        return 0;
+
+    return size;
+}
+
+/*
+ * Parse one crypto-agile (TCG2) event. Returns the number of bytes
+ * consumed, -EAGAIN if the log ends inside this event, or -EINVAL.
+ */
+static int parse_event(const u8 *data, size_t len, struct event_entry *entry)
+{
+    size_t pos, size;
+    u32 i, count, event_size;
+    bool have_sha256 = false;
+    u16 alg_id;
 
-    event2 = (const struct tcg_pcr_event2 *)data;
-    size = sizeof(*event2) + event2->count * sizeof(*digest);
-    if (len < size)
+    if (len < sizeof(struct tcg_pcr_event2_head))
+        return -EAGAIN;
+
+    entry->pcr_index = get_unaligned_le32(data);
+    entry->event_type = get_unaligned_le32(data + 4);
+    count = get_unaligned_le32(data + 8);
+    pos = sizeof(struct tcg_pcr_event2_head);
+
+    if (entry->pcr_index >= FW_EVENTLOG_MAX_PCRS || count > EVENTLOG_MAX_DIGESTS)
         return -EINVAL;
 
-    entry->pcr_index = header->pcr_index;
-    entry->event_type = header->event_type;
-    entry->timestamp = ktime_get_real_seconds();
+    for (i = 0; i < count; i++) {
+        if (len < pos + sizeof(u16))
+            return -EAGAIN;
 
-    /* Copy first SHA256 digest */
-    digest = (const struct tcg_digest *)(data + sizeof(*event2));
-    memcpy(entry->digest, digest->digest, TPM2_SHA256_DIGEST_SIZE);
+        alg_id = get_unaligned_le16(data + pos);
+        size = digest_size(alg_id);
+        if (!size)
+            return -EINVAL;
+        pos += sizeof(u16);
 
-    /* Copy event data */
-    size = event2->event_size;
-    entry->data = kmalloc(size, GFP_KERNEL);
-    if (!entry->data)
-        return -ENOMEM;
-    
-    memcpy(entry->data, data + size - event2->event_size, size);
-    entry->data_len = size;
+        if (len < pos + size)
+            return -EAGAIN;
 
-    return 0;
+        if (alg_id == TPM_ALG_SHA256) {
+            memcpy(entry->digest, data + pos, SHA256_DIGEST_SIZE);
+            have_sha256 = true;
+        }
+        pos += size;
+    }
+
+    if (len < pos + sizeof(u32))
+        return -EAGAIN;
+
+    event_size = get_unaligned_le32(data + pos);
+    pos += sizeof(u32);
+    if (len < pos + event_size)
+        return -EAGAIN;
+
+    if (!have_sha256)
+        return -EINVAL;
+
+    entry->timestamp = ktime_get_real_seconds();
+    entry->data_len = event_size;
+    entry->data = NULL;
+    if (event_size) {
+        entry->data = kmemdup(data + pos, event_size, GFP_KERNEL);
+        if (!entry->data)
+            return -ENOMEM;
+    }
+
+    return pos + event_size;
 }
 
-/* Process new events from TPM */
+/*
+ * Process events appended to the log since the last call. Only the new
+ * tail is read and parsed; a trailing partial event is left for the
+ * next update. A log shorter than what was already parsed means it was
+ * reset and is parsed again from the start.
+ */
 int fw_eventlog_update(void)
 {
-    struct tpm_chip *chip;
-    struct tpm_event_header header;
+    fw_eventlog_reader_t reader;
+    size_t len, pos = 0, size, total;
     u8 *data = NULL;
-    size_t len, pos = 0;
-    int ret = 0;
+    int ret;
 
-    chip = tpm_default_chip();
-    if (!chip)
-        return -ENODEV;
+    mutex_lock(&log_cache.lock);
 
-    /* Read event log */
-    ret = tpm_get_event_log(chip, NULL, 0, &len);
-    if (ret < 0 || !len)
-        return ret;
+    if (!log_cache.tfm) {
+        ret = -ENODEV;
+        goto out;
+    }
 
-    data = kmalloc(len, GFP_KERNEL);
-    if (!data)
-        return -ENOMEM;
+    reader = log_cache.reader ?: read_tpm_log;
 
-    ret = tpm_get_event_log(chip, data, len, &len);
+    ret = reader(log_cache.offset, NULL, 0, &total);
     if (ret < 0)
         goto out;
 
-    mutex_lock(&log_cache.lock);
+    if (total < log_cache.offset)
+        clear_cache();
+
+    if (total == log_cache.offset) {
+        log_cache.last_update = ktime_get_real_seconds();
+        goto out;
+    }
+
+    len = total - log_cache.offset;
+    data = kvmalloc(len, GFP_KERNEL);
+    if (!data) {
+        ret = -ENOMEM;
+        goto out;
+    }
 
-    /* Process each event */
+    ret = reader(log_cache.offset, data, len, &total);
+    if (ret < 0)
+        goto out;
+
+    if (!log_cache.offset)
+        pos = spec_id_header_size(data, len);
+
+    /* Process each new event */
     while (pos < len) {
         struct event_entry *entry;
 
-        if (pos + sizeof(header) > len) {
-            ret = -EINVAL;
-            break;
-        }
-
-        memcpy(&header, data + pos, sizeof(header));
-        
-        entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+        entry = kmem_cache_zalloc(log_cache.entry_cache, GFP_KERNEL);
         if (!entry) {
             ret = -ENOMEM;
             break;
         }
 
-        ret = parse_event(&header, data + pos, len - pos, entry);
+        ret = parse_event(data + pos, len - pos, entry);
         if (ret < 0) {
-            kfree(entry);
+            kmem_cache_free(log_cache.entry_cache, entry);
+            if (ret == -EAGAIN)
+                ret = 0;
             break;
         }
+        size = ret;
 
         ret = cache_event(entry);
         if (ret < 0) {
             kfree(entry->data);
-            kfree(entry);
+            kmem_cache_free(log_cache.entry_cache, entry);
             break;
         }
-
-        pos += sizeof(header) + header.event_size;
+        pos += size;
     }
 
+    /* Resume after the last event that made it into the cache */
+    log_cache.offset += pos;
+
     if (!ret)
         log_cache.last_update = ktime_get_real_seconds();
 
-    mutex_unlock(&log_cache.lock);
-
 out:
-    kfree(data);
+    mutex_unlock(&log_cache.lock);
+    kvfree(data);
     return ret;
 }
 
 /* Validate PCR values against event log */
 int fw_eventlog_validate_pcr(u32 pcr_index, const u8 *pcr_value)
 {
-    struct rb_node *node;
-    struct event_entry *entry;
-    u8 calculated[TPM2_SHA256_DIGEST_SIZE];
-    struct shash_desc *desc;
-    struct crypto_shash *tfm;
     int ret;
 
-    if (!pcr_value)
+    if (!pcr_value || pcr_index >= FW_EVENTLOG_MAX_PCRS)
         return -EINVAL;
 
-    /* Initialize hash context */
-    tfm = crypto_alloc_shash("sha256", 0, 0);
-    if (IS_ERR(tfm))
-        return PTR_ERR(tfm);
-
-    desc = kzalloc(sizeof(*desc) + crypto_shash_descsize(tfm),
-                   GFP_KERNEL);
-    if (!desc) {
-        crypto_free_shash(tfm);
-        return -ENOMEM;
-    }
-
-    desc->tfm = tfm;
-
-    /* Start with zero */
-    memset(calculated, 0, sizeof(calculated));
-
+    /* The running digest already holds the replay of every event */
     mutex_lock(&log_cache.lock);
-
-    /* Replay events for PCR */
-    for (node = rb_first(&log_cache.events); node; node = rb_next(node)) {
-        entry = rb_entry(node, struct event_entry, node);
-        
-        if (entry->pcr_index != pcr_index)
-            continue;
-
-        /* Hash previous value */
-        ret = crypto_shash_init(desc);
-        if (ret < 0)
-            break;
-
-        ret = crypto_shash_update(desc, calculated, sizeof(calculated));
-        if (ret < 0)
-            break;
-
-        /* Hash event digest */
-        ret = crypto_shash_update(desc, entry->digest, sizeof(entry->digest));
-        if (ret < 0)
-            break;
-
-        ret = crypto_shash_final(desc, calculated);
-        if (ret < 0)
-            break;
-    }
-
+    ret = memcmp(log_cache.pcrs[pcr_index].digest, pcr_value,
+                 SHA256_DIGEST_SIZE) ? -EINVAL : 0;
     mutex_unlock(&log_cache.lock);
 
-    crypto_free_shash(tfm);
-    kfree(desc);
-
-    if (ret < 0)
-        return ret;
-
-    /* Compare calculated value with provided PCR value */
-    return memcmp(calculated, pcr_value, TPM2_SHA256_DIGEST_SIZE) ? -EINVAL : 0;
+    return ret;
 }
 
 /* Get event log statistics */
@@ -266,18 +420,43 @@ int fw_eventlog_get_stats(struct eventlog_stats *stats)
     mutex_lock(&log_cache.lock);
     stats->event_count = log_cache.count;
     stats->last_update = log_cache.last_update;
+    stats->parsed_bytes = log_cache.offset;
     mutex_unlock(&log_cache.lock);
 
     return 0;
 }
 
+static void export_entries(struct event_export *export,
+                           struct event_entry **entries, u32 count)
+{
+    struct event_entry *entry;
+    u32 idx;
+
+    for (idx = 0; idx < count; idx++) {
+        entry = entries[idx];
+
+        export->events[idx].pcr_index = entry->pcr_index;
+        export->events[idx].event_type = entry->event_type;
+        memcpy(export->events[idx].digest, entry->digest,
+               sizeof(entry->digest));
+        export->events[idx].timestamp = entry->timestamp;
+
+        if (entry->data && entry->data_len <= MAX_EVENT_DATA_SIZE) {
+            export->events[idx].data_len = entry->data_len;
+            memcpy(export->events[idx].data, entry->data,
+                   entry->data_len);
+        } else {
+            export->events[idx].data_len = 0;
+        }
+    }
+
+    export->count = count;
+}
+
 /* Export event log entries */
 int fw_eventlog_export(struct event_export *export,
                       u32 start_idx, u32 count)
 {
-    struct rb_node *node;
-    struct event_entry *entry;
-    u32 idx = 0;
     int ret = 0;
 
     if (!export || !export->events || !count)
@@ -290,41 +469,56 @@ int fw_eventlog_export(struct event_export *export,
         goto out;
     }
 
-    /* Find starting entry */
-    for (node = rb_first(&log_cache.events);
-         node && idx < start_idx;
-         node = rb_next(node), idx++)
-        ;
+    export_entries(export, log_cache.events + start_idx,
+                   min(count, log_cache.count - start_idx));
 
-    /* Export requested entries */
-    for (idx = 0; node && idx < count; node = rb_next(node), idx++) {
-        entry = rb_entry(node, struct event_entry, node);
-        
-        export->events[idx].pcr_index = entry->pcr_index;
-        export->events[idx].event_type = entry->event_type;
-        memcpy(export->events[idx].digest, entry->digest,
-               sizeof(entry->digest));
-        export->events[idx].timestamp = entry->timestamp;
+out:
+    mutex_unlock(&log_cache.lock);
+    return ret;
+}
 
-        if (entry->data && entry->data_len <= MAX_EVENT_DATA_SIZE) {
-            export->events[idx].data_len = entry->data_len;
-            memcpy(export->events[idx].data, entry->data,
-                   entry->data_len);
-        } else {
-            export->events[idx].data_len = 0;
-        }
+/* Export the events measured into a single PCR */
+int fw_eventlog_export_pcr(u32 pcr_index, struct event_export *export,
+                          u32 start_idx, u32 count)
+{
+    struct pcr_log *pcr;
+    int ret = 0;
+
+    if (!export || !export->events || !count ||
+        pcr_index >= FW_EVENTLOG_MAX_PCRS)
+        return -EINVAL;
+
+    mutex_lock(&log_cache.lock);
+
+    pcr = &log_cache.pcrs[pcr_index];
+    if (start_idx >= pcr->count) {
+        ret = -EINVAL;
+        goto out;
     }
 
-    export->count = idx;
+    export_entries(export, pcr->entries + start_idx,
+                   min(count, pcr->count - start_idx));
 
 out:
     mutex_unlock(&log_cache.lock);
     return ret;
 }
 
+/* Switch the log source; NULL restores the TPM. Drops cached events. */
+void fw_eventlog_set_reader(fw_eventlog_reader_t reader)
+{
+    mutex_lock(&log_cache.lock);
+    if (log_cache.reader != reader && log_cache.entry_cache)
+        clear_cache();
+    log_cache.reader = reader;
+    mutex_unlock(&log_cache.lock);
+}
+
 EXPORT_SYMBOL_GPL(fw_eventlog_init);
 EXPORT_SYMBOL_GPL(fw_eventlog_exit);
 EXPORT_SYMBOL_GPL(fw_eventlog_update);
 EXPORT_SYMBOL_GPL(fw_eventlog_validate_pcr);
 EXPORT_SYMBOL_GPL(fw_eventlog_get_stats);
-EXPORT_SYMBOL_GPL(fw_eventlog_export); 
\ No newline at end of file
+EXPORT_SYMBOL_GPL(fw_eventlog_export);
+EXPORT_SYMBOL_GPL(fw_eventlog_export_pcr);
+EXPORT_SYMBOL_GPL(fw_eventlog_set_reader);
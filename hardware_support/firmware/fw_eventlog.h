@@ -6,12 +6,24 @@
 /* Maximum size of event data that can be exported */
 #define MAX_EVENT_DATA_SIZE 1024
 
+/* PCRs tracked by the event log cache (TPM 2.0 platform PCRs) */
+#define FW_EVENTLOG_MAX_PCRS 24
+
 /* Event log statistics */
 struct eventlog_stats {
     u32 event_count;
     u64 last_update;
+    u64 parsed_bytes;
 };
 
+/*
+ * Event log source. Copies up to @size bytes of the log starting at
+ * @offset into @buf and sets @len to the total log length; with a NULL
+ * @buf only the length is returned.
+ */
+typedef int (*fw_eventlog_reader_t)(size_t offset, u8 *buf, size_t size,
+                                    size_t *len);
+
 /* Exported event entry */
 struct event_entry_export {
     u32 pcr_index;
@@ -36,5 +48,8 @@ int fw_eventlog_validate_pcr(u32 pcr_index, const u8 *pcr_value);
 int fw_eventlog_get_stats(struct eventlog_stats *stats);
 int fw_eventlog_export(struct event_export *export,
                       u32 start_idx, u32 count);
+int fw_eventlog_export_pcr(u32 pcr_index, struct event_export *export,
+                          u32 start_idx, u32 count);
+void fw_eventlog_set_reader(fw_eventlog_reader_t reader);
 
 #endif /* _FW_EVENTLOG_H_ */ 
\ No newline at end of file
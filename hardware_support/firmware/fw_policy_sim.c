@@ -2,7 +2,11 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/crypto.h>
+#include <linux/mm.h>
+#include <linux/tpm.h>
+#include <linux/tpm_eventlog.h>
 #include <crypto/hash.h>
+#include <asm/unaligned.h>
 #include "fw_keys.h"
 #include "fw_policy_sim.h"
 
@@ -10,6 +14,11 @@
 static u8 sim_pcr_values[TPM2_MAX_PCRS][TPM2_SHA256_DIGEST_SIZE];
 static DEFINE_MUTEX(sim_lock);
 
+/* Simulated TCG2 event log, SHA-256 bank only */
+static u8 *sim_log;
+static size_t sim_log_len;
+static size_t sim_log_size;
+
 /* Initialize policy simulator */
 int fw_policy_sim_init(void)
 {
@@ -97,6 +106,127 @@ out:
     return ret;
 }
 
+static int sim_log_reserve(size_t len)
+{
+    size_t size = sim_log_size ? sim_log_size : PAGE_SIZE;
+    u8 *log;
+
+    if (sim_log_len + len <= sim_log_size)
+        return 0;
+
+    while (size < sim_log_len + len)
+        size *= 2;
+
+    log = kvmalloc(size, GFP_KERNEL);
+    if (!log)
+        return -ENOMEM;
+
+    if (sim_log)
+        memcpy(log, sim_log, sim_log_len);
+    kvfree(sim_log);
+
+    sim_log = log;
+    sim_log_size = size;
+    return 0;
+}
+
+/* Emit the TCG 1.2 format Spec ID header that starts a crypto-agile log */
+static int sim_log_header(void)
+{
+    struct tcg_pcr_event *event;
+    int ret;
+
+    ret = sim_log_reserve(sizeof(*event) + sizeof(TCG_SPECID_SIG));
+    if (ret)
+        return ret;
+
+    event = (struct tcg_pcr_event *)sim_log;
+    memset(event, 0, sizeof(*event));
+    put_unaligned_le32(NO_ACTION, &event->event_type);
+    put_unaligned_le32(sizeof(TCG_SPECID_SIG), &event->event_size);
+    memcpy(event->event, TCG_SPECID_SIG, sizeof(TCG_SPECID_SIG));
+
+    sim_log_len = sizeof(*event) + sizeof(TCG_SPECID_SIG);
+    return 0;
+}
+
+/*
+ * Measure @data into a simulated PCR the way firmware would: append a
+ * TCG2 event carrying SHA256(@data) and extend the PCR with that digest.
+ */
+int fw_policy_sim_log_event(u32 pcr_index, u32 event_type,
+                           const void *data, size_t len)
+{
+    u8 digest[TPM2_SHA256_DIGEST_SIZE];
+    struct crypto_shash *tfm;
+    size_t rec_len;
+    u8 *rec;
+    int ret;
+
+    if (pcr_index >= TPM2_MAX_PCRS || (len && !data))
+        return -EINVAL;
+
+    tfm = crypto_alloc_shash("sha256", 0, 0);
+    if (IS_ERR(tfm))
+        return PTR_ERR(tfm);
+
+    ret = crypto_shash_tfm_digest(tfm, data, len, digest);
+    crypto_free_shash(tfm);
+    if (ret < 0)
+        return ret;
+
+    /* pcr, type, count, alg, digest, event size, event */
+    rec_len = 3 * sizeof(u32) + sizeof(u16) + sizeof(digest) +
+              sizeof(u32) + len;
+
+    mutex_lock(&sim_lock);
+
+    if (!sim_log_len) {
+        ret = sim_log_header();
+        if (ret)
+            goto out;
+    }
+
+    ret = sim_log_reserve(rec_len);
+    if (ret)
+        goto out;
+
+    rec = sim_log + sim_log_len;
+    put_unaligned_le32(pcr_index, rec);
+    put_unaligned_le32(event_type, rec + 4);
+    put_unaligned_le32(1, rec + 8);
+    put_unaligned_le16(TPM_ALG_SHA256, rec + 12);
+    memcpy(rec + 14, digest, sizeof(digest));
+    put_unaligned_le32(len, rec + 14 + sizeof(digest));
+    if (len)
+        memcpy(rec + 18 + sizeof(digest), data, len);
+    sim_log_len += rec_len;
+
+out:
+    mutex_unlock(&sim_lock);
+
+    if (ret || event_type == NO_ACTION)
+        return ret;
+
+    return fw_policy_sim_extend_pcr(pcr_index, digest, sizeof(digest));
+}
+
+/* Event log reader for fw_eventlog_set_reader() */
+int fw_policy_sim_read_event_log(size_t offset, u8 *buf, size_t size,
+                                size_t *len)
+{
+    if (!len)
+        return -EINVAL;
+
+    mutex_lock(&sim_lock);
+    *len = sim_log_len;
+    if (buf && offset < sim_log_len)
+        memcpy(buf, sim_log + offset, min(size, sim_log_len - offset));
+    mutex_unlock(&sim_lock);
+
+    return 0;
+}
+
 /* Simulate policy evaluation */
 int fw_policy_sim_evaluate(const struct tpm_policy_info *policy,
                           u8 *policy_digest)
@@ -162,6 +292,10 @@ void fw_policy_sim_reset(void)
 {
     mutex_lock(&sim_lock);
     memset(sim_pcr_values, 0, sizeof(sim_pcr_values));
+    kvfree(sim_log);
+    sim_log = NULL;
+    sim_log_len = 0;
+    sim_log_size = 0;
     mutex_unlock(&sim_lock);
 }
 
@@ -170,4 +304,6 @@ EXPORT_SYMBOL_GPL(fw_policy_sim_set_pcr);
 EXPORT_SYMBOL_GPL(fw_policy_sim_get_pcr);
 EXPORT_SYMBOL_GPL(fw_policy_sim_extend_pcr);
 EXPORT_SYMBOL_GPL(fw_policy_sim_evaluate);
-EXPORT_SYMBOL_GPL(fw_policy_sim_reset); 
\ No newline at end of file
+EXPORT_SYMBOL_GPL(fw_policy_sim_reset);
+EXPORT_SYMBOL_GPL(fw_policy_sim_log_event);
+EXPORT_SYMBOL_GPL(fw_policy_sim_read_event_log); 
\ No newline at end of file
@@ -11,5 +11,9 @@ int fw_policy_sim_extend_pcr(u32 pcr_index, const u8 *data, size_t len);
 int fw_policy_sim_evaluate(const struct tpm_policy_info *policy,
                           u8 *policy_digest);
 void fw_policy_sim_reset(void);
+int fw_policy_sim_log_event(u32 pcr_index, u32 event_type,
+                           const void *data, size_t len);
+int fw_policy_sim_read_event_log(size_t offset, u8 *buf, size_t size,
+                                size_t *len);
 
 #endif /* _FW_POLICY_SIM_H_ */ 
\ No newline at end of file
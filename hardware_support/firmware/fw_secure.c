@@ -33,45 +33,22 @@ struct secure_header {
 static int verify_hash(const void *data, size_t len,
                       const u8 *expected_hash)
 {
-    struct crypto_shash *tfm;
-    struct shash_desc *desc;
+    struct fw_verify_ctx ctx;
     u8 hash[SHA256_DIGEST_SIZE];
-    int ret;
 
-    tfm = crypto_alloc_shash("sha256", 0, 0);
-    if (IS_ERR(tfm))
+    /* Shared long-lived transform, descriptor on the stack */
+    if (fw_verify_begin(&ctx, FW_VERIFY_SHA256) != FW_ERR_NONE)
         return SECURE_ERR_HASH;
 
-    desc = kmalloc(sizeof(*desc) + crypto_shash_descsize(tfm),
-                  GFP_KERNEL);
-    if (!desc) {
-        crypto_free_shash(tfm);
-        return SECURE_ERR_ALLOC;
-    }
-
-    desc->tfm = tfm;
-
-    ret = crypto_shash_init(desc);
-    if (ret < 0)
-        goto out;
+    fw_verify_update(&ctx, data, len);
 
-    ret = crypto_shash_update(desc, data, len);
-    if (ret < 0)
-        goto out;
-
-    ret = crypto_shash_final(desc, hash);
-    if (ret < 0)
-        goto out;
+    if (fw_verify_final(&ctx, NULL, hash) != FW_ERR_NONE)
+        return SECURE_ERR_HASH;
 
     if (memcmp(hash, expected_hash, SHA256_DIGEST_SIZE) != 0)
-        ret = SECURE_ERR_HASH;
-    else
-        ret = SECURE_ERR_NONE;
-
-out:
-    kfree(desc);
-    crypto_free_shash(tfm);
-    return ret;
+        return SECURE_ERR_HASH;
+
+    return SECURE_ERR_NONE;
 }
 
 static int verify_signature(const void *data, size_t data_len,
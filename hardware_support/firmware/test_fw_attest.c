@@ -2,6 +2,9 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/slab.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/delay.h>
 #include "fw_attest.h"
 
 /* Test session ID */
@@ -13,6 +16,19 @@ static const u8 test_session_id[16] = {
 /* Test data */
 static const u8 test_data[] = "Hello, Attestation!";
 
+/* Stress test: sessions per thread, sessions sharing one source */
+#define STRESS_THREADS          8
+#define STRESS_SESSIONS         512
+#define STRESS_PER_SOURCE       32
+#define STRESS_CAP_SOURCE       0x80000000
+#define STRESS_SWEEP_WAIT_MS    5000
+
+struct stress_worker {
+    unsigned int index;
+    int ret;
+    struct completion done;
+};
+
 /* Test challenge generation */
 static int test_challenge_gen(void)
 {
@@ -139,6 +155,134 @@ out:
     return ret;
 }
 
+static void stress_session_id(u8 *id, u32 n)
+{
+    memset(id, 0, 16);
+    id[0] = 0x5a;
+    memcpy(id + 4, &n, sizeof(n));
+}
+
+/* Open and use a batch of sessions concurrently with the other workers */
+static int stress_worker_fn(void *data)
+{
+    struct stress_worker *w = data;
+    struct attest_challenge challenge;
+    struct attest_export export;
+    u8 buf[sizeof(test_data)];
+    u8 id[16];
+    u32 i, n;
+    int ret = 0;
+
+    for (i = 0; i < STRESS_SESSIONS && !ret; i++) {
+        n = w->index * STRESS_SESSIONS + i;
+        stress_session_id(id, n);
+
+        ret = fw_attest_challenge_from(id, 1 + n / STRESS_PER_SOURCE,
+                                       &challenge);
+        if (ret < 0)
+            break;
+
+        /* Look up a session opened by another worker too */
+        stress_session_id(id, (n + STRESS_SESSIONS) %
+                              (STRESS_THREADS * STRESS_SESSIONS));
+        memcpy(buf, test_data, sizeof(buf));
+        export.data = buf;
+        export.data_len = sizeof(buf);
+        ret = fw_attest_export(id, &export);
+        if (ret == -EINVAL)
+            ret = 0;    /* Not created yet */
+    }
+
+    w->ret = ret;
+    complete(&w->done);
+    return 0;
+}
+
+/* Test thousands of concurrent sessions, the source cap and expiry */
+static int test_session_stress(void)
+{
+    struct stress_worker *workers;
+    struct attest_challenge challenge;
+    struct attest_stats before, stats;
+    struct task_struct *task;
+    u8 id[16];
+    int i, ret = 0;
+
+    pr_info("Testing session table under concurrent load...\n");
+
+    workers = kcalloc(STRESS_THREADS, sizeof(*workers), GFP_KERNEL);
+    if (!workers)
+        return -ENOMEM;
+
+    fw_attest_get_stats(&before);
+
+    for (i = 0; i < STRESS_THREADS; i++) {
+        workers[i].index = i;
+        init_completion(&workers[i].done);
+        task = kthread_run(stress_worker_fn, &workers[i],
+                           "attest_stress/%d", i);
+        if (IS_ERR(task)) {
+            workers[i].ret = PTR_ERR(task);
+            complete(&workers[i].done);
+        }
+    }
+
+    for (i = 0; i < STRESS_THREADS; i++) {
+        wait_for_completion(&workers[i].done);
+        if (workers[i].ret < 0 && !ret)
+            ret = workers[i].ret;
+    }
+    kfree(workers);
+
+    if (ret < 0) {
+        pr_err("Concurrent session creation failed: %d\n", ret);
+        return ret;
+    }
+
+    fw_attest_get_stats(&stats);
+    if (stats.active < before.active + STRESS_THREADS * STRESS_SESSIONS) {
+        pr_err("Expected %u sessions, have %u\n",
+               before.active + STRESS_THREADS * STRESS_SESSIONS, stats.active);
+        return -EINVAL;
+    }
+
+    /* One source may not exceed its cap */
+    for (i = 0; i <= FW_ATTEST_MAX_PER_SOURCE; i++) {
+        stress_session_id(id, STRESS_THREADS * STRESS_SESSIONS + i);
+        ret = fw_attest_challenge_from(id, STRESS_CAP_SOURCE, &challenge);
+        if (i < FW_ATTEST_MAX_PER_SOURCE && ret < 0) {
+            pr_err("Session %d under the source cap failed: %d\n", i, ret);
+            return ret;
+        }
+    }
+    if (ret != -EBUSY) {
+        pr_err("Source cap not enforced: %d\n", ret);
+        return -EINVAL;
+    }
+
+    /*
+     * Every idle session goes on a scheduled sweep; with a 1 s timeout the
+     * sweep runs every second, so allow a few intervals.
+     */
+    fw_attest_set_timeout(1);
+    for (i = 0; i < STRESS_SWEEP_WAIT_MS / 100; i++) {
+        msleep(100);
+        fw_attest_get_stats(&stats);
+        if (!stats.active)
+            break;
+    }
+    fw_attest_set_timeout(FW_ATTEST_SESSION_TIMEOUT);
+
+    if (stats.active) {
+        pr_err("%u sessions survived expiry\n", stats.active);
+        return -EINVAL;
+    }
+
+    pr_info("Session stress test passed (%llu created, %llu expired, %llu rejected)\n",
+            stats.created, stats.expired, stats.rejected);
+    return 0;
+}
+
 static int __init test_fw_attest_init(void)
 {
     int ret;
@@ -161,6 +305,10 @@ static int __init test_fw_attest_init(void)
     if (ret)
         return ret;
 
+    ret = test_session_stress();
+    if (ret)
+        return ret;
+
     pr_info("All firmware attestation tests passed!\n");
     return 0;
 }
@@ -19,6 +19,123 @@ static const u8 test_decompressed[] = {
     0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08
 };
 
+/*
+ * Streaming test image: 1 KiB, four windows at FW_STREAM_WINDOW_MIN, so
+ * each decoder has to hand over and resume across window boundaries.
+ * Byte i is (i & 0x0f) | ((i >> 8) << 4).
+ */
+#define TEST_STREAM_LEN 1024
+
+static const u8 test_stream_zlib[] = {
+    0x78, 0xDA, 0x63, 0x60, 0x64, 0x62, 0x66, 0x61,
+    0x65, 0x63, 0xE7, 0xE0, 0xE4, 0xE2, 0xE6, 0xE1,
+    0xE5, 0xE3, 0x67, 0x18, 0x61, 0x7C, 0x01, 0x41,
+    0x21, 0x61, 0x11, 0x51, 0x31, 0x71, 0x09, 0x49,
+    0x29, 0x69, 0x19, 0x59, 0x39, 0xF9, 0x91, 0xC6,
+    0x57, 0x50, 0x54, 0x52, 0x56, 0x51, 0x55, 0x53,
+    0xD7, 0xD0, 0xD4, 0xD2, 0xD6, 0xD1, 0xD5, 0xD3,
+    0x1F, 0x69, 0x7C, 0x03, 0x43, 0x23, 0x63, 0x13,
+    0x53, 0x33, 0x73, 0x0B, 0x4B, 0x2B, 0x6B, 0x1B,
+    0x5B, 0x3B, 0xFB, 0x91, 0xC6, 0x07, 0x00, 0xF8,
+    0x05, 0x7E, 0x01
+};
+
+/* xz, CRC32 check, LZMA2 with a 64 KiB dictionary */
+static const u8 test_stream_xz[] = {
+    0xFD, 0x37, 0x7A, 0x58, 0x5A, 0x00, 0x00, 0x01,
+    0x69, 0x22, 0xDE, 0x36, 0x03, 0xC0, 0x51, 0x80,
+    0x08, 0x21, 0x01, 0x08, 0x00, 0x00, 0x00, 0x00,
+    0x2F, 0x64, 0x62, 0xDC, 0xE0, 0x03, 0xFF, 0x00,
+    0x49, 0x5D, 0x00, 0x00, 0x00, 0x52, 0x50, 0x0A,
+    0x84, 0xF9, 0x9B, 0xB2, 0x80, 0x21, 0xA9, 0x69,
+    0xD6, 0x27, 0xE1, 0x11, 0xCD, 0x03, 0x3B, 0xD4,
+    0x37, 0x87, 0xE7, 0x38, 0xD7, 0xAE, 0xAD, 0xF2,
+    0x3F, 0x91, 0xA3, 0x95, 0x34, 0x33, 0x3D, 0x25,
+    0x57, 0x41, 0x01, 0x57, 0x36, 0xB5, 0x0B, 0x88,
+    0x3B, 0xC6, 0x1A, 0x61, 0x32, 0xC4, 0x7D, 0xAD,
+    0xBE, 0xDE, 0xBD, 0x96, 0x5F, 0x9A, 0x99, 0x4C,
+    0x6F, 0x0E, 0xDB, 0xD5, 0xD9, 0xB6, 0xD9, 0x51,
+    0x9D, 0x3C, 0xCA, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x7A, 0x03, 0x2F, 0x69, 0x00, 0x01, 0x65, 0x80,
+    0x08, 0x00, 0x00, 0x00, 0x49, 0xD2, 0x3E, 0xEF,
+    0x3E, 0x30, 0x0D, 0x8B, 0x02, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x59, 0x5A
+};
+
+static const u8 test_stream_zstd[] = {
+    0x28, 0xB5, 0x2F, 0xFD, 0x64, 0x00, 0x03, 0x7D,
+    0x02, 0x00, 0x14, 0x04, 0x00, 0x01, 0x02, 0x03,
+    0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+    0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13,
+    0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B,
+    0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23,
+    0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B,
+    0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B,
+    0x3C, 0x3D, 0x3E, 0x3F, 0x30, 0x04, 0x44, 0x10,
+    0x2B, 0xD9, 0x40, 0x1B, 0x68, 0x03, 0xED, 0x99,
+    0x01, 0x7D, 0x35, 0x25, 0xB7
+};
+
+/* Streaming sink collecting output into a flat buffer */
+struct test_stream_buf {
+    u8 data[TEST_STREAM_LEN];
+    size_t len;
+    int calls;
+};
+
+static struct test_stream_buf test_sbuf;
+
+static int test_stream_sink(void *priv, const void *data, size_t len)
+{
+    struct test_stream_buf *buf = priv;
+
+    if (buf->len + len > sizeof(buf->data))
+        return -ENOSPC;
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    buf->calls++;
+    return 0;
+}
+
+static int test_stream_one(enum fw_compress_type type, const char *name,
+                           const u8 *src, size_t src_len)
+{
+    struct test_stream_buf *sbuf = &test_sbuf;
+    size_t total = 0, i;
+    int ret;
+
+    memset(sbuf, 0, sizeof(*sbuf));
+
+    ret = fw_decompress_stream(type, src, src_len, FW_STREAM_WINDOW_MIN,
+                               test_stream_sink, sbuf, &total);
+    if (ret != FW_ERR_NONE || total != TEST_STREAM_LEN ||
+        sbuf->len != total) {
+        pr_err("Streaming %s decompression failed: %d, %zu bytes\n",
+               name, ret, total);
+        return -EINVAL;
+    }
+
+    /* One window cannot hold the image, so the sink must run repeatedly */
+    if (sbuf->calls < TEST_STREAM_LEN / FW_STREAM_WINDOW_MIN) {
+        pr_err("Streaming %s decompression used %d windows\n",
+               name, sbuf->calls);
+        return -EINVAL;
+    }
+
+    for (i = 0; i < TEST_STREAM_LEN; i++) {
+        if (sbuf->data[i] != ((i & 0x0f) | ((i >> 8) << 4))) {
+            pr_err("Streaming %s decompression mismatch at %zu\n",
+                   name, i);
+            return -EINVAL;
+        }
+    }
+
+    pr_info("Streaming %s decompression passed\n", name);
+    return 0;
+}
+
 static int __init test_fw_common_init(void)
 {
     int ret;
@@ -62,6 +179,26 @@ static int __init test_fw_common_init(void)
     pr_info("Zlib decompression passed\n");
     kfree(decomp_buf);
 
+    /* Test streaming decompression across window boundaries */
+    ret = test_stream_one(FW_COMPRESS_ZLIB, "zlib", test_stream_zlib,
+                          sizeof(test_stream_zlib));
+    if (ret)
+        return ret;
+
+    ret = test_stream_one(FW_COMPRESS_XZ, "xz", test_stream_xz,
+                          sizeof(test_stream_xz));
+    if (ret)
+        return ret;
+
+    if (IS_ENABLED(CONFIG_ZSTD_DECOMPRESS)) {
+        ret = test_stream_one(FW_COMPRESS_ZSTD, "zstd", test_stream_zstd,
+                              sizeof(test_stream_zstd));
+        if (ret)
+            return ret;
+    } else {
+        pr_info("Streaming zstd decompression skipped, no ZSTD_DECOMPRESS\n");
+    }
+
     /* Test version comparison */
     if (fw_version_compare(&v1, &v2) >= 0) {
         pr_err("Version comparison failed\n");
@@ -3,6 +3,11 @@
 #include <linux/init.h>
 #include <linux/slab.h>
 #include "fw_eventlog.h"
+#include "fw_policy_sim.h"
+
+#define TEST_PCR_FW     8
+#define TEST_PCR_CFG    9
+#define TEST_EV_FW      0x80000008  /* Vendor event type for firmware blobs */
 
 /* Test PCR values */
 static const u8 test_pcr_values[] = {
@@ -12,19 +17,66 @@ static const u8 test_pcr_values[] = {
     0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20
 };
 
+/* Measure @count synthetic firmware blobs into the simulated TPM */
+static int measure_events(u32 pcr_index, int first, int count)
+{
+    char blob[32];
+    int i, ret;
+
+    for (i = first; i < first + count; i++) {
+        snprintf(blob, sizeof(blob), "wifi67 fw blob %d", i);
+        ret = fw_policy_sim_log_event(pcr_index, TEST_EV_FW, blob,
+                                      strlen(blob));
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static int check_pcr(u32 pcr_index)
+{
+    u8 value[32];
+    int ret;
+
+    ret = fw_policy_sim_get_pcr(pcr_index, value);
+    if (ret < 0)
+        return ret;
+
+    return fw_eventlog_validate_pcr(pcr_index, value);
+}
+
 /* Test event log update */
 static int test_eventlog_update(void)
 {
+    struct eventlog_stats stats;
     int ret;
 
     pr_info("Testing event log update...\n");
 
+    ret = measure_events(TEST_PCR_FW, 0, 3);
+    if (!ret)
+        ret = measure_events(TEST_PCR_CFG, 0, 1);
+    if (ret < 0) {
+        pr_err("Failed to measure events: %d\n", ret);
+        return ret;
+    }
+
     ret = fw_eventlog_update();
     if (ret < 0) {
         pr_err("Event log update failed: %d\n", ret);
         return ret;
     }
 
+    ret = fw_eventlog_get_stats(&stats);
+    if (ret < 0)
+        return ret;
+
+    if (stats.event_count != 4) {
+        pr_err("Expected 4 events, got %u\n", stats.event_count);
+        return -EINVAL;
+    }
+
     pr_info("Event log update test passed!\n");
     return 0;
 }
@@ -36,16 +88,75 @@ static int test_pcr_validation(void)
 
     pr_info("Testing PCR validation...\n");
 
-    ret = fw_eventlog_validate_pcr(8, test_pcr_values);
+    ret = check_pcr(TEST_PCR_FW);
+    if (!ret)
+        ret = check_pcr(TEST_PCR_CFG);
     if (ret < 0) {
         pr_err("PCR validation failed: %d\n", ret);
         return ret;
     }
 
+    /* A value the log does not replay to must be rejected */
+    ret = fw_eventlog_validate_pcr(TEST_PCR_FW, test_pcr_values);
+    if (ret != -EINVAL) {
+        pr_err("Bogus PCR value accepted: %d\n", ret);
+        return -EINVAL;
+    }
+
     pr_info("PCR validation test passed!\n");
     return 0;
 }
 
+/* Test that only appended events are parsed */
+static int test_incremental_update(void)
+{
+    struct eventlog_stats before, after;
+    int ret;
+
+    pr_info("Testing incremental event log update...\n");
+
+    ret = fw_eventlog_get_stats(&before);
+    if (ret < 0)
+        return ret;
+
+    /* No new events: nothing parsed, nothing added */
+    ret = fw_eventlog_update();
+    if (!ret)
+        ret = fw_eventlog_get_stats(&after);
+    if (ret < 0)
+        return ret;
+
+    if (after.event_count != before.event_count ||
+        after.parsed_bytes != before.parsed_bytes) {
+        pr_err("Idle update changed the cache\n");
+        return -EINVAL;
+    }
+
+    ret = measure_events(TEST_PCR_FW, 3, 2);
+    if (!ret)
+        ret = fw_eventlog_update();
+    if (!ret)
+        ret = fw_eventlog_get_stats(&after);
+    if (ret < 0)
+        return ret;
+
+    if (after.event_count != before.event_count + 2 ||
+        after.parsed_bytes <= before.parsed_bytes) {
+        pr_err("Expected 2 new events, got %u -> %u\n",
+               before.event_count, after.event_count);
+        return -EINVAL;
+    }
+
+    ret = check_pcr(TEST_PCR_FW);
+    if (ret < 0) {
+        pr_err("PCR %d mismatch after append: %d\n", TEST_PCR_FW, ret);
+        return ret;
+    }
+
+    pr_info("Incremental update test passed!\n");
+    return 0;
+}
+
 /* Test event log export */
 static int test_eventlog_export(void)
 {
@@ -71,6 +182,19 @@ static int test_eventlog_export(void)
     if (export.count > 0)
         pr_info("Successfully exported %u events\n", export.count);
 
+    ret = fw_eventlog_export_pcr(TEST_PCR_CFG, &export, 0, 10);
+    if (ret < 0) {
+        pr_err("PCR event export failed: %d\n", ret);
+        goto out;
+    }
+
+    if (export.count != 1 || events[0].pcr_index != TEST_PCR_CFG) {
+        pr_err("Unexpected PCR %d export (%u events)\n",
+               TEST_PCR_CFG, export.count);
+        ret = -EINVAL;
+        goto out;
+    }
+
     ret = 0;
 
 out:
@@ -94,6 +218,7 @@ static int test_eventlog_stats(void)
 
     pr_info("Event count: %u\n", stats.event_count);
     pr_info("Last update: %llu\n", stats.last_update);
+    pr_info("Parsed bytes: %llu\n", stats.parsed_bytes);
 
     return 0;
 }
@@ -104,28 +229,48 @@ static int __init test_fw_eventlog_init(void)
 
     pr_info("Starting firmware event log tests!\n");
 
-    ret = test_eventlog_update();
+    /* The policy simulator stands in for the TPM */
+    fw_policy_sim_init();
+    ret = fw_eventlog_init();
     if (ret)
         return ret;
+    fw_eventlog_set_reader(fw_policy_sim_read_event_log);
+
+    ret = test_eventlog_update();
+    if (ret)
+        goto err;
 
     ret = test_pcr_validation();
     if (ret)
-        return ret;
+        goto err;
+
+    ret = test_incremental_update();
+    if (ret)
+        goto err;
 
     ret = test_eventlog_export();
     if (ret)
-        return ret;
+        goto err;
 
     ret = test_eventlog_stats();
     if (ret)
-        return ret;
+        goto err;
 
     pr_info("All firmware event log tests passed!\n");
     return 0;
+
+err:
+    fw_eventlog_set_reader(NULL);
+    fw_eventlog_exit();
+    fw_policy_sim_reset();
+    return ret;
 }
 
 static void __exit test_fw_eventlog_exit(void)
 {
+    fw_eventlog_set_reader(NULL);
+    fw_eventlog_exit();
+    fw_policy_sim_reset();
     pr_info("Firmware event log tests cleanup complete!\n");
 }
 
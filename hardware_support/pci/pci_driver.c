@@ -3,6 +3,7 @@
 #include <linux/firmware.h>
 #include "../supported_devices.h"
 #include "../../include/core/wifi67.h"
+#include "../firmware/fw_common.h"
 
 /* PCI device private structure */
 struct managh_pci_dev {
@@ -225,7 +226,19 @@ static struct pci_driver managh_pci_driver = {
     .resume = managh_pci_resume,
 };
 
-module_pci_driver(managh_pci_driver);
+static int __init managh_pci_init(void)
+{
+    return pci_register_driver(&managh_pci_driver);
+}
+
+static void __exit managh_pci_exit(void)
+{
+    pci_unregister_driver(&managh_pci_driver);
+    fw_hash_exit();
+}
+
+module_init(managh_pci_init);
+module_exit(managh_pci_exit);
 
 MODULE_AUTHOR("Your Name");
 MODULE_DESCRIPTION("Managh WiFi PCI Driver");
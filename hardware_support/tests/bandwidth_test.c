@@ -358,6 +358,8 @@ static void __exit bw_test_module_exit(void)
     pr_info("Bandwidth tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     bw_test_cleanup(NULL);
 }
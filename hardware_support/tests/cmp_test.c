@@ -532,6 +532,8 @@ static void __exit cmp_test_module_exit(void)
     pr_info("CMP tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     cmp_test_cleanup(NULL);
 }
@@ -0,0 +1,693 @@
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/skbuff.h>
+#include <linux/cpumask.h>
+#include <linux/math64.h>
+#include <linux/ieee80211.h>
+#include <crypto/aead.h>
+#include <crypto/skcipher.h>
+#include <asm/unaligned.h>
+#include "../../include/dma/dma_core.h"
+#include "../../include/crypto/crypto_core.h"
+#include "../../src/mac/wifi7_mac_core.h"
+#include "../../src/mac/wifi7_rate.h"
+#include "../../src/mac/wifi7_qos.h"
+#include "../vsim/wifi67_vsim.h"
+#include "test_framework.h"
+
+/*
+ * Multi-core contention stress. Each subsystem's public API is driven from
+ * 1, 2, 4, ... kthreads on different CPUs with a mix of data path and
+ * control operations, so its shared locks are taken from every CPU at once:
+ * the MAC frame and queue locks, the DMA ring locks behind the virtual
+ * pair, the rate control locks, the QoS and shaper locks and the crypto
+ * engine lock. Every thread count is a benchmark of its own; the last
+ * test prints the scaling curve and checks that no frame was lost.
+ *
+ * Lock correctness comes from running this under CONFIG_PROVE_LOCKING and
+ * CONFIG_KCSAN; hold and wait times from CONFIG_LOCK_STAT, which the
+ * stress target of the Makefile collects around a run.
+ */
+
+#define CONTENTION_MAX_STEPS    8       /* 1, 2, 4 .. TEST_BENCH_MAX_THREADS */
+#define CONTENTION_NAME_LEN     32
+#define CONTENTION_MAC_QUEUES   4       /* One per AC, so threads collide */
+#define CONTENTION_QOS_LINKS    2
+#define CONTENTION_FLUSH_MS     5000
+#define CONTENTION_RATE_MBPS    100000  /* Medium never the bottleneck */
+
+static unsigned int num_threads;
+module_param(num_threads, uint, 0444);
+MODULE_PARM_DESC(num_threads, "Largest thread count (0 = all online CPUs)");
+
+static unsigned int iterations = TEST_ITER_STRESS;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Operations per thread per thread count");
+
+static unsigned int frame_len = 256;
+module_param(frame_len, uint, 0444);
+MODULE_PARM_DESC(frame_len, "Frame length in bytes");
+
+/* Per thread; a cache line each so the counters add no sharing of their own */
+struct contention_thread {
+    u32 iter;
+    u64 queued;
+    u64 dequeued;
+    u64 posted[WIFI67_VSIM_NUM_ROLES];
+    u8 iv[2][WIFI67_CRYPTO_MAX_IV_SIZE];    /* Mapped into scatterlists */
+    u8 ref[TEST_BUFFER_SMALL];
+    struct wifi7_rate_table table;
+} ____cacheline_aligned_in_smp;
+
+struct contention_sys {
+    const char *name;
+    const char *desc;
+    test_bench_func_t op;
+    int (*setup)(void);
+    void (*teardown)(void);
+    bool ready;
+    char names[CONTENTION_MAX_STEPS][CONTENTION_NAME_LEN];
+    unsigned int threads[CONTENTION_MAX_STEPS];
+    unsigned int steps;
+};
+
+static struct contention_thread *contention_threads;
+static struct wifi7_dev *contention_dev;
+static struct wifi67_vsim *contention_vsim;
+static struct wifi67_priv *contention_priv;
+static struct sk_buff *contention_rate_skb;
+
+static const u8 contention_key[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static struct sk_buff *contention_alloc_frame(u32 seed)
+{
+    struct sk_buff *skb;
+
+    skb = alloc_skb(frame_len, GFP_KERNEL);
+    if (skb)
+        memset(skb_put(skb, frame_len), seed & 0xff, frame_len);
+    return skb;
+}
+
+/* MAC: frames into shared AC queues against the TX/RX works */
+static int contention_mac_op(void *data, unsigned int thread, u64 *sample)
+{
+    u32 i = contention_threads[thread].iter++;
+    struct sk_buff *skb;
+    int ret;
+
+    skb = contention_alloc_frame(i);
+    if (!skb)
+        return TEST_FAIL;
+
+    if (i % 4 == 3) {
+        ret = wifi7_mac_rx(contention_dev, skb);
+    } else {
+        skb->queue_mapping = (thread + i) % CONTENTION_MAC_QUEUES;
+        ret = wifi7_mac_tx(contention_dev, skb);
+    }
+    if (!ret)
+        return TEST_PASS;
+
+    kfree_skb(skb);
+    /* The works drain every 10 ms; a full queue is expected */
+    return ret == -ENOSPC ? TEST_PASS : TEST_FAIL;
+}
+
+/* DMA: both radios post on the one link; the poll works reap the rings */
+static int contention_dma_op(void *data, unsigned int thread, u64 *sample)
+{
+    struct contention_thread *t = &contention_threads[thread];
+    enum wifi67_vsim_role role;
+    struct wifi67_dma_stats st;
+    u32 i = t->iter++;
+    struct sk_buff *skb;
+    int ret;
+
+    role = i % 4 == 3 ? WIFI67_VSIM_STA : WIFI67_VSIM_AP;
+
+    if (i % 16 == 15)
+        return wifi67_dma_get_stats(wifi67_vsim_priv(contention_vsim, role),
+                                    &st) ? TEST_FAIL : TEST_PASS;
+
+    skb = contention_alloc_frame(i);
+    if (!skb)
+        return TEST_FAIL;
+
+    ret = wifi67_vsim_tx(contention_vsim, role, 0, skb);
+    if (ret == -EBUSY) {
+        kfree_skb(skb);
+        return TEST_PASS;
+    }
+    if (ret) {
+        kfree_skb(skb);
+        return TEST_FAIL;
+    }
+    t->posted[role]++;
+    return TEST_PASS;
+}
+
+/*
+ * Alternate the table between every MCS valid with the best throughput
+ * at the top, and only the lower half valid with the best at MCS 0. PID
+ * selection reads around the middle MCS, which stays valid in both.
+ */
+static void contention_rate_rewrite(struct wifi7_rate_table *table, u32 i)
+{
+    bool low = (i / 64) & 1;
+    int mcs;
+
+    for (mcs = 0; mcs <= table->max_mcs; mcs++) {
+        struct wifi7_rate_entry *e = &table->entries[mcs];
+
+        e->valid = !low || mcs <= table->max_mcs / 2 + 1;
+        e->max_tp_rate = low ? table->max_mcs - mcs : mcs;
+    }
+}
+
+/* Rate control: select and feed back, with readers and a config writer */
+static int contention_rate_op(void *data, unsigned int thread, u64 *sample)
+{
+    struct contention_thread *t = &contention_threads[thread];
+    struct wifi7_rate_config config;
+    struct wifi7_rate_stats stats;
+    struct wifi7_rate_entry rate;
+    u32 i = t->iter++;
+
+    /* Thread 0 also rewrites the table that the others copy entries of */
+    if (thread == 0 && i % 64 == 31) {
+        if (wifi7_rate_get_table(contention_dev, &t->table))
+            return TEST_FAIL;
+        contention_rate_rewrite(&t->table, i);
+        return wifi7_rate_update_table(contention_dev, &t->table) ?
+               TEST_FAIL : TEST_PASS;
+    }
+
+    if (thread == 0 && i % 64 == 63) {
+        if (wifi7_rate_get_config(contention_dev, &config))
+            return TEST_FAIL;
+        config.algorithm = config.algorithm == WIFI7_RATE_ALGO_MINSTREL ?
+                           WIFI7_RATE_ALGO_PID : WIFI7_RATE_ALGO_MINSTREL;
+        return wifi7_rate_set_config(contention_dev, &config) ?
+               TEST_FAIL : TEST_PASS;
+    }
+
+    if (i % 16 == 7)
+        return wifi7_rate_get_table(contention_dev, &t->table) ?
+               TEST_FAIL : TEST_PASS;
+
+    if (i % 8 == 3)
+        return wifi7_rate_get_stats(contention_dev, &stats) ?
+               TEST_FAIL : TEST_PASS;
+
+    if (wifi7_rate_select(contention_dev, contention_rate_skb, &rate))
+        return TEST_FAIL;
+    /* A torn copy of an entry being rewritten shows up here */
+    if (!rate.valid || rate.mcs > WIFI7_RATE_MAX_MCS)
+        return TEST_FAIL;
+
+    return wifi7_rate_update(contention_dev, contention_rate_skb, &rate,
+                             i % 5 != 0) ? TEST_FAIL : TEST_PASS;
+}
+
+/* QoS: enqueue, DRR dequeue through the shapers, TX status feedback */
+static int contention_qos_op(void *data, unsigned int thread, u64 *sample)
+{
+    struct contention_thread *t = &contention_threads[thread];
+    u32 i = t->iter++;
+    u8 link = (thread + i) % CONTENTION_QOS_LINKS;
+    u8 tid = i % WIFI7_NUM_TIDS;
+    struct sk_buff *skb;
+    int ret;
+
+    switch (i % 4) {
+    case 0:
+    case 1:
+        skb = contention_alloc_frame(i);
+        if (!skb)
+            return TEST_FAIL;
+        ret = wifi7_qos_tx_enqueue(contention_dev, skb, link, tid);
+        if (ret == -ENOSPC) {
+            kfree_skb(skb);
+            return TEST_PASS;
+        }
+        if (ret) {
+            kfree_skb(skb);
+            return TEST_FAIL;
+        }
+        t->queued++;
+        break;
+    case 2:
+        skb = wifi7_qos_tx_dequeue(contention_dev, link);
+        if (skb) {
+            t->dequeued++;
+            wifi7_qos_tx_status(contention_dev, skb->priority, true,
+                                WIFI67_VSIM_DEF_RATE, 0);
+            consume_skb(skb);
+        }
+        break;
+    default:
+        wifi7_qos_tx_pending(contention_dev, link);
+        wifi7_qos_tx_status(contention_dev, tid, i % 7 != 0,
+                            WIFI67_VSIM_DEF_RATE, i % 3);
+        break;
+    }
+
+    return TEST_PASS;
+}
+
+/* Crypto: CCMP encrypts mixed with a checked CTR round trip */
+static int contention_crypto_op(void *data, unsigned int thread, u64 *sample)
+{
+    struct contention_thread *t = &contention_threads[thread];
+    u32 i = t->iter++;
+    u32 len = min_t(u32, frame_len, sizeof(t->ref));
+    struct sk_buff *skb;
+    int ret = TEST_PASS;
+
+    skb = alloc_skb(len, GFP_KERNEL);
+    if (!skb)
+        return TEST_FAIL;
+    memset(skb_put(skb, len), i & 0xff, len);
+
+    /* Nonce per thread and iteration; CCM flags L = 4 in iv[0] */
+    memset(t->iv[0], 0, sizeof(t->iv[0]));
+    t->iv[0][0] = 3;
+    t->iv[0][1] = thread;
+    put_unaligned_le32(i, &t->iv[0][2]);
+    memcpy(t->iv[1], t->iv[0], sizeof(t->iv[1]));
+
+    if (i % 2) {
+        if (wifi67_crypto_encrypt(contention_priv, skb, 0, t->iv[0]))
+            ret = TEST_FAIL;
+    } else {
+        memcpy(t->ref, skb->data, len);
+        if (wifi67_crypto_encrypt(contention_priv, skb, 1, t->iv[0]) ||
+            wifi67_crypto_decrypt(contention_priv, skb, 1, t->iv[1]) ||
+            memcmp(t->ref, skb->data, len))
+            ret = TEST_FAIL;
+    }
+
+    kfree_skb(skb);
+    return ret;
+}
+
+static int contention_crypto_setup(void)
+{
+    struct wifi67_crypto_ctx *ctx;
+    int ret;
+
+    /* The engine registers are RAM; the transforms do the work */
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return -ENOMEM;
+    ctx->regs = (void __iomem *)kzalloc(PAGE_SIZE, GFP_KERNEL);
+    if (!ctx->regs) {
+        ret = -ENOMEM;
+        goto err_free;
+    }
+    spin_lock_init(&ctx->lock);
+
+    ctx->tfm_aead = crypto_alloc_aead("ccm(aes)", 0, CRYPTO_ALG_ASYNC);
+    if (IS_ERR(ctx->tfm_aead)) {
+        ret = PTR_ERR(ctx->tfm_aead);
+        goto err_free;
+    }
+    ret = crypto_aead_setkey(ctx->tfm_aead, contention_key,
+                             sizeof(contention_key));
+    if (!ret)
+        ret = crypto_aead_setauthsize(ctx->tfm_aead, IEEE80211_CCMP_MIC_LEN);
+    if (ret)
+        goto err_free_aead;
+
+    ctx->tfm_cipher = crypto_alloc_skcipher("ctr(aes)", 0, CRYPTO_ALG_ASYNC);
+    if (IS_ERR(ctx->tfm_cipher)) {
+        ret = PTR_ERR(ctx->tfm_cipher);
+        goto err_free_aead;
+    }
+    ret = crypto_skcipher_setkey(ctx->tfm_cipher, contention_key,
+                                 sizeof(contention_key));
+    if (ret)
+        goto err_free_cipher;
+
+    ctx->keys[0].cipher = WLAN_CIPHER_SUITE_CCMP;
+    ctx->keys[0].valid = true;
+    ctx->keys[1].key_idx = 1;
+    ctx->keys[1].cipher = WLAN_CIPHER_SUITE_TKIP;
+    ctx->keys[1].valid = true;
+    ctx->initialized = true;
+
+    contention_priv->crypto_ctx = ctx;
+    return 0;
+
+err_free_cipher:
+    crypto_free_skcipher(ctx->tfm_cipher);
+err_free_aead:
+    crypto_free_aead(ctx->tfm_aead);
+err_free:
+    kfree((void __force *)ctx->regs);
+    kfree(ctx);
+    return ret;
+}
+
+static void contention_crypto_teardown(void)
+{
+    struct wifi67_crypto_ctx *ctx = contention_priv->crypto_ctx;
+
+    if (!ctx)
+        return;
+
+    crypto_free_skcipher(ctx->tfm_cipher);
+    crypto_free_aead(ctx->tfm_aead);
+    kfree((void __force *)ctx->regs);
+    kfree(ctx);
+    contention_priv->crypto_ctx = NULL;
+}
+
+static int contention_dma_setup(void)
+{
+    struct wifi67_vsim_link_params lp = {
+        .up = true,
+        .rate_mbps = CONTENTION_RATE_MBPS,
+        .retry_limit = WIFI67_VSIM_RETRY_LIMIT,
+    };
+    int ret;
+
+    contention_vsim = wifi67_vsim_create(1);
+    if (IS_ERR(contention_vsim)) {
+        ret = PTR_ERR(contention_vsim);
+        contention_vsim = NULL;
+        return ret;
+    }
+
+    ret = wifi67_vsim_set_link(contention_vsim, 0, &lp);
+    if (ret) {
+        wifi67_vsim_destroy(contention_vsim);
+        contention_vsim = NULL;
+    }
+    return ret;
+}
+
+static int contention_mac_setup(void)
+{
+    int ret;
+
+    ret = wifi7_mac_init(contention_dev);
+    if (ret)
+        return ret;
+
+    ret = wifi7_mac_start(contention_dev);
+    if (ret)
+        wifi7_mac_deinit(contention_dev);
+    return ret;
+}
+
+static void contention_mac_teardown(void)
+{
+    wifi7_mac_deinit(contention_dev);
+}
+
+static void contention_dma_teardown(void)
+{
+    wifi67_vsim_flush(contention_vsim, CONTENTION_FLUSH_MS);
+    wifi67_vsim_destroy(contention_vsim);
+    contention_vsim = NULL;
+}
+
+static int contention_rate_setup(void)
+{
+    int ret;
+
+    ret = wifi7_rate_init(contention_dev);
+    if (ret)
+        return ret;
+
+    ret = wifi7_rate_start(contention_dev);
+    if (ret)
+        wifi7_rate_deinit(contention_dev);
+    return ret;
+}
+
+static void contention_rate_teardown(void)
+{
+    wifi7_rate_stop(contention_dev);
+    wifi7_rate_deinit(contention_dev);
+}
+
+static int contention_qos_setup(void)
+{
+    return wifi7_qos_init(contention_dev);
+}
+
+static void contention_qos_teardown(void)
+{
+    wifi7_qos_deinit(contention_dev);
+}
+
+#define CONTENTION_SYS(_name, _desc) {                  \
+    .name = #_name,                                     \
+    .desc = _desc,                                      \
+    .op = contention_##_name##_op,                      \
+    .setup = contention_##_name##_setup,                \
+    .teardown = contention_##_name##_teardown,          \
+}
+
+static struct contention_sys contention_systems[] = {
+    CONTENTION_SYS(mac, "MAC TX/RX into shared queues"),
+    CONTENTION_SYS(dma, "DMA ring posts on one link"),
+    CONTENTION_SYS(rate, "Rate select/update with table and config writers"),
+    CONTENTION_SYS(qos, "QoS enqueue/dequeue/status"),
+    CONTENTION_SYS(crypto, "CCMP and CTR through the crypto engine"),
+};
+
+static struct contention_sys *contention_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(contention_systems); i++)
+        if (!strcmp(contention_systems[i].name, name))
+            return &contention_systems[i];
+    return NULL;
+}
+
+/* Sums over all threads; the benchmarks run one at a time */
+static void contention_totals(u64 *queued, u64 *dequeued, u64 *posted)
+{
+    int i, role;
+
+    *queued = *dequeued = 0;
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++)
+        posted[role] = 0;
+
+    for (i = 0; i < TEST_BENCH_MAX_THREADS; i++) {
+        *queued += contention_threads[i].queued;
+        *dequeued += contention_threads[i].dequeued;
+        for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++)
+            posted[role] += contention_threads[i].posted[role];
+    }
+}
+
+/* Frames still queued in QoS must be exactly those never dequeued */
+static int contention_check_qos(void)
+{
+    u64 queued, dequeued, posted[WIFI67_VSIM_NUM_ROLES];
+    u64 pending = 0;
+    int link;
+
+    contention_totals(&queued, &dequeued, posted);
+    for (link = 0; link < CONTENTION_QOS_LINKS; link++)
+        pending += wifi7_qos_tx_pending(contention_dev, link);
+
+    pr_info("contention: qos: %llu queued, %llu dequeued, %llu pending\n",
+            queued, dequeued, pending);
+    TEST_ASSERT(queued - dequeued == pending,
+                "QoS lost frames: %llu queued, %llu dequeued, %llu pending",
+                queued, dequeued, pending);
+    return TEST_PASS;
+}
+
+/* Every frame posted to a TX ring must have been sent by the device */
+static int contention_check_dma(void)
+{
+    u64 queued, dequeued, posted[WIFI67_VSIM_NUM_ROLES];
+    struct wifi67_vsim_link_stats st;
+    int role;
+
+    TEST_ASSERT(!wifi67_vsim_flush(contention_vsim, CONTENTION_FLUSH_MS),
+                "Virtual pair did not drain");
+
+    contention_totals(&queued, &dequeued, posted);
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+        wifi67_vsim_get_stats(contention_vsim, role, 0, &st);
+        pr_info("contention: dma: role %d: %llu posted, %llu sent\n",
+                role, posted[role], st.tx_frames);
+        TEST_ASSERT(st.tx_frames == posted[role],
+                    "Role %d posted %llu frames, device sent %llu",
+                    role, posted[role], st.tx_frames);
+    }
+    return TEST_PASS;
+}
+
+/* Throughput scaling of every subsystem against its single thread run */
+static int test_contention_scaling(void *data)
+{
+    struct test_bench_stats st;
+    unsigned int s, ran = 0;
+    u64 base, speedup;
+    int i, ret;
+
+    for (i = 0; i < ARRAY_SIZE(contention_systems); i++) {
+        struct contention_sys *sys = &contention_systems[i];
+
+        base = 0;
+        for (s = 0; sys->ready && s < sys->steps; s++) {
+            if (get_bench_stats(sys->names[s], -1, &st)) {
+                pr_info("contention: %s: %u threads: not run\n",
+                        sys->name, sys->threads[s]);
+                continue;
+            }
+            if (!s)
+                base = st.ops_per_sec;
+            speedup = base ? div64_u64(st.ops_per_sec * 100, base) : 0;
+            pr_info("contention: %s: %2u threads: %llu ops/s, speedup %llu.%02llu, efficiency %llu%%, mean %llu p99 %llu max %llu ns\n",
+                    sys->name, sys->threads[s], st.ops_per_sec,
+                    speedup / 100, speedup % 100,
+                    div_u64(speedup, sys->threads[s]),
+                    st.mean, st.p99, st.max);
+            ran++;
+        }
+    }
+
+    if (!ran)
+        TEST_SKIP("No contention benchmark has run");
+
+    if (contention_find("qos")->ready) {
+        ret = contention_check_qos();
+        if (ret != TEST_PASS)
+            return ret;
+    }
+    if (contention_find("dma")->ready) {
+        ret = contention_check_dma();
+        if (ret != TEST_PASS)
+            return ret;
+    }
+
+    TEST_PASS();
+}
+
+static void contention_register(struct contention_sys *sys,
+                                unsigned int max_threads)
+{
+    struct test_bench_params params = {
+        .iterations = iterations,
+    };
+    unsigned int n = 1;
+
+    /* Doubling up to the largest count, which is always run */
+    while (sys->steps < CONTENTION_MAX_STEPS) {
+        sys->threads[sys->steps] = n;
+        snprintf(sys->names[sys->steps], CONTENTION_NAME_LEN,
+                 "contention_%s_%ut", sys->name, n);
+        params.threads = n;
+        if (REGISTER_BENCH(sys->names[sys->steps], sys->desc, sys->op,
+                           NULL, &params, TEST_FLAG_SLOW))
+            break;
+        sys->steps++;
+
+        if (n == max_threads)
+            break;
+        n = min(n * 2, max_threads);
+    }
+}
+
+static void contention_cleanup(void)
+{
+    int i;
+
+    for (i = ARRAY_SIZE(contention_systems) - 1; i >= 0; i--) {
+        struct contention_sys *sys = &contention_systems[i];
+
+        if (sys->ready)
+            sys->teardown();
+        sys->ready = false;
+    }
+
+    kfree_skb(contention_rate_skb);
+    kfree(contention_priv);
+    kfree(contention_dev);
+    kfree(contention_threads);
+}
+
+static int __init contention_test_module_init(void)
+{
+    unsigned int max_threads;
+    int i, ret;
+
+    max_threads = num_threads ? : num_online_cpus();
+    max_threads = clamp(max_threads, 1U,
+                        min_t(unsigned int, num_online_cpus(),
+                              TEST_BENCH_MAX_THREADS));
+    if (!frame_len || frame_len > WIFI67_VSIM_MAX_FRAME)
+        return -EINVAL;
+
+    contention_threads = kcalloc(TEST_BENCH_MAX_THREADS,
+                                 sizeof(*contention_threads), GFP_KERNEL);
+    contention_dev = kzalloc(sizeof(*contention_dev), GFP_KERNEL);
+    contention_priv = kzalloc(sizeof(*contention_priv), GFP_KERNEL);
+    contention_rate_skb = alloc_skb(frame_len, GFP_KERNEL);
+    if (!contention_threads || !contention_dev || !contention_priv ||
+        !contention_rate_skb) {
+        contention_cleanup();
+        return -ENOMEM;
+    }
+    skb_put(contention_rate_skb, frame_len);
+
+    /* Subsystems that cannot be brought up are reported and left out */
+    for (i = 0; i < ARRAY_SIZE(contention_systems); i++) {
+        struct contention_sys *sys = &contention_systems[i];
+
+        ret = sys->setup();
+        if (ret) {
+            pr_info("contention: %s: setup failed: %d, skipped\n",
+                    sys->name, ret);
+            continue;
+        }
+        sys->ready = true;
+        contention_register(sys, max_threads);
+    }
+
+    /* A stress test, so it runs after the benchmarks registered above */
+    REGISTER_TEST("contention_scaling",
+                 "Throughput scaling and frame accounting under contention",
+                 test_contention_scaling, NULL,
+                 TEST_FLAG_STRESS | TEST_FLAG_SLOW);
+
+    pr_info("contention: up to %u threads, %u operations per thread\n",
+            max_threads, iterations);
+    return 0;
+}
+
+static void __exit contention_test_module_exit(void)
+{
+    struct test_results results;
+
+    get_test_results(&results);
+    pr_info("Contention tests completed: %d passed, %d failed, %d skipped\n",
+            results.passed, results.failed, results.skipped);
+
+    UNREGISTER_TESTS();
+
+    contention_cleanup();
+}
+
+module_init(contention_test_module_init);
+module_exit(contention_test_module_exit);
+
+MODULE_LICENSE("Dual MIT/GPL");
+MODULE_AUTHOR("Fayssal Chokri");
+MODULE_DESCRIPTION("WiFi 6E/7 Multi-Core Contention Stress Tests");
+MODULE_VERSION("1.0");
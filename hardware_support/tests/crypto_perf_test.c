@@ -0,0 +1,438 @@
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/cpumask.h>
+#include <linux/ktime.h>
+#include <linux/sort.h>
+#include <linux/math64.h>
+#include <linux/scatterlist.h>
+#include <linux/random.h>
+#include <crypto/aead.h>
+#include "test_framework.h"
+
+/*
+ * Software crypto benchmark for the data-path ciphers. Runs CCMP/GCMP
+ * encrypt and decrypt through the kernel AEAD API on synthetic keys and
+ * frames, so it needs no hardware and measures whatever implementation
+ * the crypto API selects on this box (AES-NI, ARMv8-CE, generic C).
+ */
+
+#define CRYPTO_PERF_MAX_SIZES     8
+#define CRYPTO_PERF_MAX_BATCH     256
+#define CRYPTO_PERF_MAX_SAMPLES   8192
+#define CRYPTO_PERF_AAD_LEN       24    /* QoS data header AAD */
+#define CRYPTO_PERF_MAX_MIC       16
+#define CRYPTO_PERF_IV_SIZE       16
+
+static unsigned int frame_sizes[CRYPTO_PERF_MAX_SIZES] = { 64, 512, 1500, 4096 };
+static int num_frame_sizes = 4;
+module_param_array(frame_sizes, uint, &num_frame_sizes, 0444);
+MODULE_PARM_DESC(frame_sizes, "Payload sizes in bytes (max 8)");
+
+static unsigned int batch_size = 32;
+module_param(batch_size, uint, 0444);
+MODULE_PARM_DESC(batch_size, "Frames per batch (working set per CPU)");
+
+static unsigned int num_cpus;
+module_param(num_cpus, uint, 0444);
+MODULE_PARM_DESC(num_cpus, "CPUs to run on (0 = all online)");
+
+static unsigned int iterations = TEST_ITER_EXTENDED;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Batches per CPU per measurement");
+
+struct crypto_perf_cipher {
+    const char *name;
+    const char *verify_test;
+    const char *bench_test;
+    const char *alg;
+    u8 key_len;
+    u8 mic_len;
+    bool ccm;
+};
+
+static const struct crypto_perf_cipher crypto_perf_ciphers[] = {
+    { "ccmp128", "crypto_perf_ccmp128_verify", "crypto_perf_ccmp128",
+      "ccm(aes)", 16, 8,  true  },
+    { "ccmp256", "crypto_perf_ccmp256_verify", "crypto_perf_ccmp256",
+      "ccm(aes)", 32, 16, true  },
+    { "gcmp128", "crypto_perf_gcmp128_verify", "crypto_perf_gcmp128",
+      "gcm(aes)", 16, 16, false },
+    { "gcmp256", "crypto_perf_gcmp256_verify", "crypto_perf_gcmp256",
+      "gcm(aes)", 32, 16, false },
+};
+
+/* Per-CPU worker state */
+struct crypto_perf_worker {
+    const struct crypto_perf_cipher *cipher;
+    unsigned int frame_len;
+    bool decrypt;
+    int ret;
+
+    struct crypto_aead *tfm;
+    struct aead_request *reqs[CRYPTO_PERF_MAX_BATCH];
+    struct scatterlist sg[CRYPTO_PERF_MAX_BATCH];
+    struct scatterlist dst_sg[CRYPTO_PERF_MAX_BATCH];
+    u8 *bufs[CRYPTO_PERF_MAX_BATCH];
+    u8 *dst_bufs[CRYPTO_PERF_MAX_BATCH];
+    u8 iv[CRYPTO_PERF_IV_SIZE];
+
+    u64 frames;
+    u64 *samples;
+    unsigned int nr_samples;
+};
+
+struct crypto_perf_result {
+    u64 frames;
+    u64 bytes;
+    u64 wall_ns;
+    u64 p50_ns;
+    u64 p99_ns;
+    u64 p999_ns;
+};
+
+static u8 crypto_perf_key[32];
+
+static void crypto_perf_set_iv(struct crypto_perf_worker *w, u64 pn)
+{
+    memset(w->iv, 0, sizeof(w->iv));
+
+    if (w->cipher->ccm) {
+        /* CCM: flags byte L' = 1 (2-byte length), then 13-byte nonce */
+        w->iv[0] = 1;
+        memcpy(&w->iv[8], &pn, 6);
+    } else {
+        /* GCM: 12-byte nonce A2 || PN */
+        memcpy(&w->iv[6], &pn, 6);
+    }
+}
+
+static void crypto_perf_worker_free(struct crypto_perf_worker *w)
+{
+    int i;
+
+    for (i = 0; i < CRYPTO_PERF_MAX_BATCH; i++) {
+        aead_request_free(w->reqs[i]);
+        kfree(w->bufs[i]);
+        kfree(w->dst_bufs[i]);
+        w->reqs[i] = NULL;
+        w->bufs[i] = NULL;
+        w->dst_bufs[i] = NULL;
+    }
+
+    if (!IS_ERR_OR_NULL(w->tfm))
+        crypto_free_aead(w->tfm);
+    w->tfm = NULL;
+
+    kvfree(w->samples);
+    w->samples = NULL;
+}
+
+static int crypto_perf_worker_setup(struct crypto_perf_worker *w)
+{
+    unsigned int buf_len;
+    int i, ret;
+
+    /* Synchronous implementation only; async offload skews latency */
+    w->tfm = crypto_alloc_aead(w->cipher->alg, 0, CRYPTO_ALG_ASYNC);
+    if (IS_ERR(w->tfm))
+        return PTR_ERR(w->tfm);
+
+    ret = crypto_aead_setkey(w->tfm, crypto_perf_key, w->cipher->key_len);
+    if (ret)
+        return ret;
+
+    ret = crypto_aead_setauthsize(w->tfm, w->cipher->mic_len);
+    if (ret)
+        return ret;
+
+    w->samples = kvcalloc(CRYPTO_PERF_MAX_SAMPLES, sizeof(u64), GFP_KERNEL);
+    if (!w->samples)
+        return -ENOMEM;
+
+    buf_len = CRYPTO_PERF_AAD_LEN + w->frame_len + CRYPTO_PERF_MAX_MIC;
+
+    for (i = 0; i < batch_size; i++) {
+        w->bufs[i] = kmalloc(buf_len, GFP_KERNEL);
+        w->reqs[i] = aead_request_alloc(w->tfm, GFP_KERNEL);
+        if (!w->bufs[i] || !w->reqs[i])
+            return -ENOMEM;
+
+        get_random_bytes(w->bufs[i], CRYPTO_PERF_AAD_LEN + w->frame_len);
+        sg_init_one(&w->sg[i], w->bufs[i], buf_len);
+        aead_request_set_callback(w->reqs[i], 0, NULL, NULL);
+        aead_request_set_ad(w->reqs[i], CRYPTO_PERF_AAD_LEN);
+    }
+
+    /*
+     * Decrypt runs need valid ciphertext to authenticate against, and
+     * decrypt out of place so that ciphertext survives every iteration.
+     */
+    if (w->decrypt) {
+        for (i = 0; i < batch_size; i++) {
+            w->dst_bufs[i] = kmalloc(buf_len, GFP_KERNEL);
+            if (!w->dst_bufs[i])
+                return -ENOMEM;
+            sg_init_one(&w->dst_sg[i], w->dst_bufs[i], buf_len);
+
+            crypto_perf_set_iv(w, i);
+            aead_request_set_crypt(w->reqs[i], &w->sg[i], &w->sg[i],
+                                   w->frame_len, w->iv);
+            ret = crypto_aead_encrypt(w->reqs[i]);
+            if (ret)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
+static void crypto_perf_worker_fn(void *data, unsigned int thread)
+{
+    struct crypto_perf_worker *w = (struct crypto_perf_worker *)data + thread;
+    unsigned int cryptlen;
+    u64 t0, t1, pn = 0;
+    int i, iter;
+
+    w->ret = crypto_perf_worker_setup(w);
+    if (w->ret)
+        return;
+
+    cryptlen = w->frame_len + (w->decrypt ? w->cipher->mic_len : 0);
+
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < batch_size; i++) {
+            /* Decrypt must reuse the PN each buffer was sealed with */
+            crypto_perf_set_iv(w, w->decrypt ? i : pn++);
+            aead_request_set_crypt(w->reqs[i], &w->sg[i],
+                                   w->decrypt ? &w->dst_sg[i] : &w->sg[i],
+                                   cryptlen, w->iv);
+
+            t0 = ktime_get_ns();
+            if (w->decrypt)
+                w->ret = crypto_aead_decrypt(w->reqs[i]);
+            else
+                w->ret = crypto_aead_encrypt(w->reqs[i]);
+            t1 = ktime_get_ns();
+
+            if (w->ret)
+                return;
+
+            /* Keep the most recent samples once the buffer wraps */
+            w->samples[w->nr_samples++ % CRYPTO_PERF_MAX_SAMPLES] = t1 - t0;
+            w->frames++;
+        }
+        cond_resched();
+    }
+}
+
+static int crypto_perf_cmp_u64(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int crypto_perf_run(const struct crypto_perf_cipher *cipher,
+                           unsigned int frame_len, bool decrypt,
+                           struct crypto_perf_result *res)
+{
+    struct crypto_perf_worker *workers;
+    unsigned int max_workers, total = 0;
+    int i, nr_workers, ret = 0;
+    u64 *merged;
+
+    max_workers = test_nr_threads(num_cpus);
+    workers = kcalloc(max_workers, sizeof(*workers), GFP_KERNEL);
+    if (!workers)
+        return -ENOMEM;
+
+    for (i = 0; i < max_workers; i++) {
+        workers[i].cipher = cipher;
+        workers[i].frame_len = frame_len;
+        workers[i].decrypt = decrypt;
+    }
+
+    res->wall_ns = 0;
+    nr_workers = test_run_threads(crypto_perf_worker_fn, workers, max_workers,
+                                  "crypto_perf/%u", &res->wall_ns);
+    if (nr_workers < 0) {
+        kfree(workers);
+        return nr_workers;
+    }
+
+    res->frames = 0;
+    res->p50_ns = res->p99_ns = res->p999_ns = 0;
+
+    merged = kvcalloc(nr_workers * CRYPTO_PERF_MAX_SAMPLES, sizeof(u64),
+                      GFP_KERNEL);
+
+    for (i = 0; i < nr_workers; i++) {
+        struct crypto_perf_worker *w = &workers[i];
+        unsigned int n = min_t(unsigned int, w->nr_samples,
+                               CRYPTO_PERF_MAX_SAMPLES);
+
+        if (w->ret && !ret)
+            ret = w->ret;
+
+        res->frames += w->frames;
+        if (merged && w->samples) {
+            memcpy(&merged[total], w->samples, n * sizeof(u64));
+            total += n;
+        }
+        crypto_perf_worker_free(w);
+    }
+
+    res->bytes = res->frames * frame_len;
+
+    if (merged && total) {
+        sort(merged, total, sizeof(u64), crypto_perf_cmp_u64, NULL);
+        res->p50_ns = merged[total / 2];
+        res->p99_ns = merged[div_u64((u64)total * 99, 100)];
+        res->p999_ns = merged[div_u64((u64)total * 999, 1000)];
+    }
+
+    kvfree(merged);
+    kfree(workers);
+    return ret;
+}
+
+static void crypto_perf_report(const struct crypto_perf_cipher *cipher,
+                               unsigned int frame_len, bool decrypt,
+                               const struct crypto_perf_result *res)
+{
+    u64 kpps = 0, mbps = 0;
+
+    if (res->wall_ns) {
+        /* frames/ns * 1e9 / 1e3 -> kpps; bits/ns * 1e3 -> Mbps */
+        kpps = div64_u64(res->frames * 1000000ULL, res->wall_ns);
+        mbps = div64_u64(res->bytes * 8000ULL, res->wall_ns);
+    }
+
+    pr_info("crypto_perf: %s %s len=%u batch=%u: %llu.%03llu Mpps %llu.%03llu Gbps p50=%lluns p99=%lluns p99.9=%lluns\n",
+            cipher->name, decrypt ? "dec" : "enc", frame_len, batch_size,
+            kpps / 1000, kpps % 1000, mbps / 1000, mbps % 1000,
+            res->p50_ns, res->p99_ns, res->p999_ns);
+}
+
+/* Test cases */
+static int test_crypto_perf_roundtrip(void *data)
+{
+    const struct crypto_perf_cipher *cipher = data;
+    struct crypto_perf_worker *w;
+    u8 *ref;
+    int ret;
+
+    w = kzalloc(sizeof(*w), GFP_KERNEL);
+    ref = kmalloc(CRYPTO_PERF_AAD_LEN + TEST_BUFFER_SMALL, GFP_KERNEL);
+    if (!w || !ref) {
+        kfree(w);
+        kfree(ref);
+        TEST_SKIP("Out of memory");
+    }
+
+    w->cipher = cipher;
+    w->frame_len = TEST_BUFFER_SMALL;
+    batch_size = clamp_t(unsigned int, batch_size, 1, CRYPTO_PERF_MAX_BATCH);
+
+    ret = crypto_perf_worker_setup(w);
+    if (ret == -ENOENT) {
+        crypto_perf_worker_free(w);
+        kfree(w);
+        kfree(ref);
+        TEST_SKIP("%s not available", cipher->alg);
+    }
+    if (ret)
+        goto out;
+
+    memcpy(ref, w->bufs[0], CRYPTO_PERF_AAD_LEN + w->frame_len);
+
+    crypto_perf_set_iv(w, 1);
+    aead_request_set_crypt(w->reqs[0], &w->sg[0], &w->sg[0],
+                           w->frame_len, w->iv);
+    ret = crypto_aead_encrypt(w->reqs[0]);
+    if (ret)
+        goto out;
+
+    crypto_perf_set_iv(w, 1);
+    aead_request_set_crypt(w->reqs[0], &w->sg[0], &w->sg[0],
+                           w->frame_len + cipher->mic_len, w->iv);
+    ret = crypto_aead_decrypt(w->reqs[0]);
+    if (!ret && memcmp(ref, w->bufs[0], CRYPTO_PERF_AAD_LEN + w->frame_len))
+        ret = -EBADMSG;
+
+out:
+    crypto_perf_worker_free(w);
+    kfree(w);
+    kfree(ref);
+    TEST_ASSERT(ret == 0, "%s round trip failed: %d", cipher->name, ret);
+    TEST_PASS();
+}
+
+static int test_crypto_perf_bench(void *data)
+{
+    const struct crypto_perf_cipher *cipher = data;
+    struct crypto_perf_result res;
+    int i, dir, ret;
+
+    batch_size = clamp_t(unsigned int, batch_size, 1, CRYPTO_PERF_MAX_BATCH);
+
+    for (i = 0; i < num_frame_sizes; i++) {
+        for (dir = 0; dir < 2; dir++) {
+            ret = crypto_perf_run(cipher, frame_sizes[i], dir, &res);
+            if (ret == -ENOENT)
+                TEST_SKIP("%s not available", cipher->alg);
+            TEST_ASSERT(ret == 0, "%s len=%u run failed: %d",
+                        cipher->name, frame_sizes[i], ret);
+            crypto_perf_report(cipher, frame_sizes[i], dir, &res);
+        }
+    }
+
+    TEST_PASS();
+}
+
+/* Module initialization */
+static int __init crypto_perf_test_module_init(void)
+{
+    int i;
+
+    get_random_bytes(crypto_perf_key, sizeof(crypto_perf_key));
+
+    pr_info("crypto_perf: %d sizes, batch %u, %u cpus, %u iterations\n",
+            num_frame_sizes, batch_size,
+            num_cpus ? num_cpus : num_online_cpus(), iterations);
+
+    for (i = 0; i < ARRAY_SIZE(crypto_perf_ciphers); i++) {
+        const struct crypto_perf_cipher *c = &crypto_perf_ciphers[i];
+
+        REGISTER_TEST(c->verify_test,
+                     "Verify software AEAD round trip",
+                     test_crypto_perf_roundtrip, (void *)c, 0);
+
+        REGISTER_TEST(c->bench_test,
+                     "Benchmark software AEAD throughput and latency",
+                     test_crypto_perf_bench, (void *)c,
+                     TEST_FLAG_BENCHMARK | TEST_FLAG_SLOW);
+    }
+
+    return 0;
+}
+
+static void __exit crypto_perf_test_module_exit(void)
+{
+    struct test_results results;
+
+    get_test_results(&results);
+    pr_info("Crypto perf tests completed: %d passed, %d failed, %d skipped\n",
+            results.passed, results.failed, results.skipped);
+
+    UNREGISTER_TESTS();
+}
+
+module_init(crypto_perf_test_module_init);
+module_exit(crypto_perf_test_module_exit);
+
+MODULE_LICENSE("MIT");
+MODULE_AUTHOR("Fayssal Chokri");
+MODULE_DESCRIPTION("WiFi 6E/7 Crypto Throughput and Latency Benchmark");
+MODULE_VERSION("1.0");
@@ -364,6 +364,7 @@ static void __exit crypto_test_module_exit(void)
     get_test_results(&results);
     pr_info("Crypto tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
+    UNREGISTER_TESTS();
     crypto_test_cleanup(NULL); /* ctx is managed by test framework */
 }
 
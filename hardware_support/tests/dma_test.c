@@ -337,6 +337,7 @@ static void __exit dma_test_module_exit(void)
     get_test_results(&results);
     pr_info("DMA tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
+    UNREGISTER_TESTS();
     dma_test_cleanup(NULL); /* ctx is managed by test framework */
 }
 
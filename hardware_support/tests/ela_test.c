@@ -544,6 +544,8 @@ static void __exit ela_test_module_exit(void)
     pr_info("Enhanced Link Adaptation tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     ela_test_cleanup(NULL);
 }
@@ -352,6 +352,7 @@ static void __exit fw_test_module_exit(void)
     get_test_results(&results);
     pr_info("Firmware tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
+    UNREGISTER_TESTS();
     fw_test_cleanup(NULL); /* ctx is managed by test framework */
 }
 
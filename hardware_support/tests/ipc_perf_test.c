@@ -0,0 +1,318 @@
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/cpumask.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include "../../include/firmware/fw_ipc.h"
+#include "test_framework.h"
+
+/*
+ * Host/firmware IPC ring benchmark. A kthread stands in for the firmware:
+ * it sleeps until the doorbell wakes it, consumes every published command
+ * and answers each with an event. The host side queues commands in
+ * batches and drains events in bulk, reporting messages per second and
+ * how many doorbells the coalescing saved.
+ */
+
+#define IPC_PERF_MAX_BATCHES    8
+#define IPC_PERF_EVT_FLAG       0x8000
+#define IPC_PERF_TIMEOUT_MS     10000
+
+static unsigned int batch_sizes[IPC_PERF_MAX_BATCHES] = { 1, 8, 32, 128 };
+static int num_batch_sizes = 4;
+module_param_array(batch_sizes, uint, &num_batch_sizes, 0444);
+MODULE_PARM_DESC(batch_sizes, "Commands per flush (max 8 values)");
+
+static unsigned int num_msgs = 1000000;
+module_param(num_msgs, uint, 0444);
+MODULE_PARM_DESC(num_msgs, "Commands per measurement");
+
+static int fw_cpu = -1;
+module_param(fw_cpu, int, 0444);
+MODULE_PARM_DESC(fw_cpu, "CPU for the firmware stand-in (-1 = last online)");
+
+struct ipc_perf_ctx {
+    struct wifi67_ipc ipc;
+    void *shared;
+    struct task_struct *fw_task;
+
+    /* Firmware stand-in private indices */
+    u32 fw_cmd_cons;
+    u32 fw_evt_prod;
+    u64 fw_wakeups;
+
+    /* Host side event accounting */
+    u32 next_seq;
+    u64 events;
+    u64 seq_errors;
+};
+
+/* Software firmware: echo every command back as an event */
+static int ipc_perf_fw_fn(void *data)
+{
+    struct ipc_perf_ctx *ctx = data;
+    struct wifi67_ipc_ctrl *ctrl = ctx->ipc.ctrl;
+    u32 prod, evt_cons;
+
+    while (!kthread_should_stop()) {
+        prod = le32_to_cpu(READ_ONCE(ctrl->cmd_prod));
+
+        if (prod == ctx->fw_cmd_cons) {
+            set_current_state(TASK_INTERRUPTIBLE);
+            /* Re-check after publishing our state, as real firmware must */
+            prod = le32_to_cpu(READ_ONCE(ctrl->cmd_prod));
+            if (prod == ctx->fw_cmd_cons && !kthread_should_stop()) {
+                schedule();
+                ctx->fw_wakeups++;
+            }
+            __set_current_state(TASK_RUNNING);
+            continue;
+        }
+
+        dma_rmb();
+
+        while (ctx->fw_cmd_cons != prod) {
+            const struct wifi67_ipc_msg *cmd;
+            struct wifi67_ipc_msg *evt;
+
+            evt_cons = le32_to_cpu(READ_ONCE(ctrl->evt_cons));
+            if (ctx->fw_evt_prod - evt_cons >= WIFI67_IPC_EVT_ENTRIES)
+                break;
+
+            cmd = &ctx->ipc.cmd_ring[ctx->fw_cmd_cons &
+                                     (WIFI67_IPC_CMD_ENTRIES - 1)];
+            evt = &ctx->ipc.evt_ring[ctx->fw_evt_prod &
+                                     (WIFI67_IPC_EVT_ENTRIES - 1)];
+            evt->id = cpu_to_le16(le16_to_cpu(cmd->id) | IPC_PERF_EVT_FLAG);
+            evt->len = 0;
+            evt->seq = cmd->seq;
+
+            ctx->fw_cmd_cons++;
+            ctx->fw_evt_prod++;
+        }
+
+        dma_wmb();
+        WRITE_ONCE(ctrl->evt_prod, cpu_to_le32(ctx->fw_evt_prod));
+        WRITE_ONCE(ctrl->cmd_cons, cpu_to_le32(ctx->fw_cmd_cons));
+        /* Pairs with the barrier in the host flush path */
+        mb();
+
+        if (ctx->fw_cmd_cons != prod)
+            cond_resched();     /* Event ring full, let the host drain */
+    }
+
+    return 0;
+}
+
+static void ipc_perf_doorbell(void *priv)
+{
+    struct ipc_perf_ctx *ctx = priv;
+
+    wake_up_process(ctx->fw_task);
+}
+
+static void ipc_perf_event(void *priv, const struct wifi67_ipc_msg *msg)
+{
+    struct ipc_perf_ctx *ctx = priv;
+
+    if (le32_to_cpu(msg->seq) != ctx->next_seq ||
+        !(le16_to_cpu(msg->id) & IPC_PERF_EVT_FLAG))
+        ctx->seq_errors++;
+
+    ctx->next_seq = le32_to_cpu(msg->seq) + 1;
+    ctx->events++;
+}
+
+static const struct wifi67_ipc_ops ipc_perf_ops = {
+    .doorbell = ipc_perf_doorbell,
+    .event = ipc_perf_event,
+};
+
+static void ipc_perf_destroy(struct ipc_perf_ctx *ctx)
+{
+    if (!IS_ERR_OR_NULL(ctx->fw_task))
+        kthread_stop(ctx->fw_task);
+    kvfree(ctx->shared);
+    kfree(ctx);
+}
+
+static struct ipc_perf_ctx *ipc_perf_create(void)
+{
+    struct ipc_perf_ctx *ctx;
+    int cpu = fw_cpu;
+    int ret;
+
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return ERR_PTR(-ENOMEM);
+
+    ctx->shared = kvzalloc(WIFI67_IPC_SHARED_SIZE, GFP_KERNEL);
+    if (!ctx->shared) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    ret = wifi67_ipc_init(&ctx->ipc, ctx->shared, WIFI67_IPC_SHARED_SIZE,
+                          &ipc_perf_ops, ctx);
+    if (ret)
+        goto err;
+
+    if (cpu < 0 || !cpu_online(cpu))
+        cpu = cpumask_last(cpu_online_mask);
+
+    ctx->fw_task = kthread_create_on_cpu(ipc_perf_fw_fn, ctx, cpu,
+                                         "ipc_perf_fw/%u");
+    if (IS_ERR(ctx->fw_task)) {
+        ret = PTR_ERR(ctx->fw_task);
+        goto err;
+    }
+    wake_up_process(ctx->fw_task);
+
+    return ctx;
+
+err:
+    ipc_perf_destroy(ctx);
+    return ERR_PTR(ret);
+}
+
+/* Push @count commands in batches of @batch and wait for every event */
+static int ipc_perf_run(struct ipc_perf_ctx *ctx, unsigned int count,
+                        unsigned int batch, u64 *wall_ns)
+{
+    unsigned long timeout;
+    unsigned int sent = 0, i;
+    u64 start, target;
+    int ret;
+
+    target = ctx->events + count;
+    start = ktime_get_ns();
+
+    while (sent < count) {
+        unsigned int n = min(batch, count - sent);
+
+        for (i = 0; i < n; i++) {
+            while ((ret = wifi67_ipc_queue(&ctx->ipc, 1, &sent,
+                                           sizeof(sent))) == -ENOSPC) {
+                wifi67_ipc_flush(&ctx->ipc);
+                if (!wifi67_ipc_poll(&ctx->ipc, WIFI67_IPC_POLL_BUDGET))
+                    cond_resched();
+            }
+            if (ret)
+                return ret;
+            sent++;
+        }
+
+        wifi67_ipc_flush(&ctx->ipc);
+        wifi67_ipc_poll(&ctx->ipc, WIFI67_IPC_POLL_BUDGET);
+    }
+
+    timeout = jiffies + msecs_to_jiffies(IPC_PERF_TIMEOUT_MS);
+    while (ctx->events < target) {
+        if (!wifi67_ipc_poll(&ctx->ipc, WIFI67_IPC_POLL_BUDGET)) {
+            if (time_after(jiffies, timeout))
+                return -ETIMEDOUT;
+            cond_resched();
+        }
+    }
+
+    *wall_ns = ktime_get_ns() - start;
+    return 0;
+}
+
+/* Test cases */
+static int test_ipc_perf_verify(void *data)
+{
+    struct ipc_perf_ctx *ctx;
+    u64 wall_ns;
+    int ret;
+
+    ctx = ipc_perf_create();
+    if (IS_ERR(ctx))
+        TEST_SKIP("Setup failed: %ld", PTR_ERR(ctx));
+
+    /* More than both rings hold, so wrap and backpressure are exercised */
+    ret = ipc_perf_run(ctx, 4 * WIFI67_IPC_EVT_ENTRIES, 7, &wall_ns);
+    if (!ret && (ctx->seq_errors || ctx->events != 4 * WIFI67_IPC_EVT_ENTRIES))
+        ret = -EBADMSG;
+    if (!ret && ctx->ipc.stats.doorbells + ctx->ipc.stats.doorbells_coalesced !=
+                ctx->ipc.stats.flushes)
+        ret = -EINVAL;
+
+    ipc_perf_destroy(ctx);
+    TEST_ASSERT(ret == 0, "IPC echo run failed: %d", ret);
+    TEST_PASS();
+}
+
+static int test_ipc_perf_bench(void *data)
+{
+    struct ipc_perf_ctx *ctx;
+    u64 wall_ns, kmps, doorbells, coalesced, events, polls;
+    int i, ret;
+
+    for (i = 0; i < num_batch_sizes; i++) {
+        unsigned int batch = clamp_t(unsigned int, batch_sizes[i], 1,
+                                     WIFI67_IPC_CMD_ENTRIES);
+
+        ctx = ipc_perf_create();
+        if (IS_ERR(ctx))
+            TEST_SKIP("Setup failed: %ld", PTR_ERR(ctx));
+
+        ret = ipc_perf_run(ctx, num_msgs, batch, &wall_ns);
+        doorbells = ctx->ipc.stats.doorbells;
+        coalesced = ctx->ipc.stats.doorbells_coalesced;
+        events = ctx->ipc.stats.events;
+        polls = ctx->ipc.stats.polls;
+        if (!ret && ctx->seq_errors)
+            ret = -EBADMSG;
+        ipc_perf_destroy(ctx);
+
+        TEST_ASSERT(ret == 0, "batch=%u run failed: %d", batch, ret);
+
+        kmps = wall_ns ? div64_u64((u64)num_msgs * 1000000ULL, wall_ns) : 0;
+        pr_info("ipc_perf: batch=%u msgs=%u: %llu.%03llu Mmsg/s doorbells=%llu coalesced=%llu events/poll=%llu\n",
+                batch, num_msgs, kmps / 1000, kmps % 1000, doorbells,
+                coalesced, polls ? div64_u64(events, polls) : 0);
+    }
+
+    TEST_PASS();
+}
+
+/* Module initialization */
+static int __init ipc_perf_test_module_init(void)
+{
+    pr_info("ipc_perf: %d batch sizes, %u msgs per run\n",
+            num_batch_sizes, num_msgs);
+
+    REGISTER_TEST("ipc_perf_verify",
+                 "Verify IPC ring ordering, wrap and doorbell accounting",
+                 test_ipc_perf_verify, NULL, 0);
+
+    REGISTER_TEST("ipc_perf_bench",
+                 "Benchmark batched IPC messages per second",
+                 test_ipc_perf_bench, NULL,
+                 TEST_FLAG_BENCHMARK | TEST_FLAG_SLOW);
+
+    return 0;
+}
+
+static void __exit ipc_perf_test_module_exit(void)
+{
+    struct test_results results;
+
+    get_test_results(&results);
+    pr_info("IPC perf tests completed: %d passed, %d failed, %d skipped\n",
+            results.passed, results.failed, results.skipped);
+
+    UNREGISTER_TESTS();
+}
+
+module_init(ipc_perf_test_module_init);
+module_exit(ipc_perf_test_module_exit);
+
+MODULE_LICENSE("MIT");
+MODULE_AUTHOR("Fayssal Chokri");
+MODULE_DESCRIPTION("WiFi 6E/7 Host/Firmware IPC Ring Benchmark");
+MODULE_VERSION("1.0");
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for the aggregation and reorder trees.
+ * Included from src/mac/wifi7_aggregation.c.
+ */
+
+#include "wifi67_kunit.h"
+
+#define AGG_KUNIT_TREE_SIZE     256
+
+static struct wifi7_frame_entry *agg_kunit_entries(struct kunit *test, int n)
+{
+    struct wifi7_frame_entry *e;
+
+    e = kunit_kcalloc(test, n, sizeof(*e), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, e);
+
+    return e;
+}
+
+static struct sk_buff *agg_kunit_frame(struct kunit *test, u8 tid, u16 sn)
+{
+    struct ieee80211_qos_hdr *hdr;
+    struct sk_buff *skb;
+
+    skb = alloc_skb(sizeof(*hdr) + 64, GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, skb);
+
+    hdr = skb_put_zero(skb, sizeof(*hdr));
+    hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA |
+                                     IEEE80211_STYPE_QOS_DATA);
+    hdr->seq_ctrl = cpu_to_le16(IEEE80211_SN_TO_SEQ(sn));
+    hdr->qos_ctrl = cpu_to_le16(tid);
+    skb_put_zero(skb, 64);
+
+    return skb;
+}
+
+static void agg_seq_cmp_test(struct kunit *test)
+{
+    KUNIT_EXPECT_EQ(test, wifi7_seq_cmp(7, 7), 0);
+    KUNIT_EXPECT_LT(test, wifi7_seq_cmp(3, 5), 0);
+    KUNIT_EXPECT_GT(test, wifi7_seq_cmp(5, 3), 0);
+
+    /* Across the 12-bit wrap 0 follows 4095 */
+    KUNIT_EXPECT_GT(test, wifi7_seq_cmp(0, 4095), 0);
+    KUNIT_EXPECT_LT(test, wifi7_seq_cmp(4095, 0), 0);
+    KUNIT_EXPECT_GT(test, wifi7_seq_cmp(10, 4000), 0);
+}
+
+static void agg_tree_order_wrap_test(struct kunit *test)
+{
+    static const u16 in[] = { 4094, 1, 4095, 0, 2 };
+    static const u16 out[] = { 4094, 4095, 0, 1, 2 };
+    struct wifi7_frame_entry *e = agg_kunit_entries(test, ARRAY_SIZE(in));
+    struct rb_root root = RB_ROOT;
+    struct rb_node *node;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(in); i++) {
+        e[i].ssn = in[i];
+        frame_entry_insert(&root, &e[i]);
+    }
+
+    /* In-order walk releases frames in sequence order */
+    node = rb_first(&root);
+    for (i = 0; i < ARRAY_SIZE(out); i++) {
+        KUNIT_ASSERT_NOT_NULL(test, node);
+        KUNIT_EXPECT_EQ(test, rb_entry(node, struct wifi7_frame_entry,
+                                       node)->ssn, out[i]);
+        node = rb_next(node);
+    }
+    KUNIT_EXPECT_NULL(test, node);
+}
+
+static void agg_tree_search_test(struct kunit *test)
+{
+    struct wifi7_frame_entry *e = agg_kunit_entries(test, 64);
+    struct rb_root root = RB_ROOT;
+    int i;
+
+    /* 64 consecutive sequence numbers starting just before the wrap */
+    for (i = 0; i < 64; i++) {
+        e[i].ssn = (4064 + i) & 0xFFF;
+        frame_entry_insert(&root, &e[i]);
+    }
+
+    for (i = 0; i < 64; i++)
+        KUNIT_EXPECT_PTR_EQ(test, frame_entry_search(&root, e[i].ssn),
+                            &e[i]);
+    KUNIT_EXPECT_NULL(test, frame_entry_search(&root, 100));
+
+    frame_entry_remove(&root, &e[40]);
+    KUNIT_EXPECT_NULL(test, frame_entry_search(&root, e[40].ssn));
+    KUNIT_EXPECT_PTR_EQ(test, frame_entry_search(&root, e[41].ssn), &e[41]);
+}
+
+static void agg_queue_limit_test(struct kunit *test)
+{
+    struct wifi7_agg_tid_ctx *ctx = &wifi7_agg_ctx.agg_contexts[2];
+    struct sk_buff *skb;
+    int i;
+
+    if (wifi7_agg_ctx.initialized)
+        kunit_skip(test, "aggregation already owned by a device");
+
+    KUNIT_ASSERT_EQ(test, wifi7_aggregation_init(NULL), 0);
+    ctx->max_frames = 4;
+    ctx->timeout = 10000;   /* Keep the flush work out of the way */
+
+    for (i = 0; i < 4; i++)
+        KUNIT_EXPECT_EQ(test, wifi7_add_agg_frame(NULL,
+                                                  agg_kunit_frame(test, 2, i),
+                                                  2, 0), 0);
+
+    skb = agg_kunit_frame(test, 2, 4);
+    KUNIT_EXPECT_EQ(test, wifi7_add_agg_frame(NULL, skb, 2, 0), -ENOSPC);
+    KUNIT_EXPECT_EQ(test, atomic_read(&ctx->pending_count), 4);
+    kfree_skb(skb);
+
+    /* Teardown frees the four queued frames */
+    wifi7_aggregation_deinit(NULL);
+    KUNIT_EXPECT_FALSE(test, wifi7_agg_ctx.initialized);
+    KUNIT_EXPECT_TRUE(test, RB_EMPTY_ROOT(&ctx->pending_frames));
+}
+
+static void agg_bench_insert_remove(struct kunit *test)
+{
+    struct wifi7_frame_entry *e = agg_kunit_entries(test,
+                                                    AGG_KUNIT_TREE_SIZE + 1);
+    struct wifi7_frame_entry *probe = &e[AGG_KUNIT_TREE_SIZE];
+    struct rb_root root = RB_ROOT;
+    int i;
+
+    for (i = 0; i < AGG_KUNIT_TREE_SIZE; i++) {
+        e[i].ssn = i * 2;
+        frame_entry_insert(&root, &e[i]);
+    }
+    probe->ssn = AGG_KUNIT_TREE_SIZE + 1;
+
+    /* One out-of-order arrival into a full reorder window */
+    WIFI67_BENCH(test, "agg.tree_insert_remove",
+                 ({
+                     frame_entry_insert(&root, probe);
+                     frame_entry_remove(&root, probe);
+                 }),
+                 (void)0);
+}
+
+static void agg_bench_search(struct kunit *test)
+{
+    struct wifi7_frame_entry *e = agg_kunit_entries(test, AGG_KUNIT_TREE_SIZE);
+    struct wifi7_frame_entry *found = NULL;
+    struct rb_root root = RB_ROOT;
+    int i;
+
+    for (i = 0; i < AGG_KUNIT_TREE_SIZE; i++) {
+        e[i].ssn = i;
+        frame_entry_insert(&root, &e[i]);
+    }
+
+    WIFI67_BENCH(test, "agg.tree_search",
+                 found = frame_entry_search(&root,
+                                            _i & (AGG_KUNIT_TREE_SIZE - 1)),
+                 (void)0);
+
+    KUNIT_EXPECT_NOT_NULL(test, found);
+}
+
+static struct kunit_case wifi7_agg_test_cases[] = {
+    KUNIT_CASE(agg_seq_cmp_test),
+    KUNIT_CASE(agg_tree_order_wrap_test),
+    KUNIT_CASE(agg_tree_search_test),
+    KUNIT_CASE(agg_queue_limit_test),
+    KUNIT_CASE_SLOW(agg_bench_insert_remove),
+    KUNIT_CASE_SLOW(agg_bench_search),
+    {}
+};
+
+static struct kunit_suite wifi7_agg_test_suite = {
+    .name = "wifi67_agg",
+    .test_cases = wifi7_agg_test_cases,
+};
+
+kunit_test_suite(wifi7_agg_test_suite);
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for block ack window arithmetic and reorder flushing.
+ * Included from src/mac/wifi7_ba.c.
+ */
+
+#include "wifi67_kunit.h"
+
+static const u8 ba_kunit_peer[ETH_ALEN] = { 0x02, 0x67, 0x00, 0x00, 0x00, 0x01 };
+
+static struct wifi7_ba_session *ba_kunit_session(struct kunit *test, u16 head)
+{
+    struct wifi7_ba_session *s;
+
+    s = kunit_kzalloc(test, sizeof(*s), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, s);
+
+    spin_lock_init(&s->lock);
+    skb_queue_head_init(&s->reorder_queue);
+    s->tid = 5;
+    s->state = WIFI7_BA_STATE_ACTIVE;
+    s->head_seq = head;
+    s->ssn = head;
+    s->active = true;
+    ether_addr_copy(s->peer_addr, ba_kunit_peer);
+
+    return s;
+}
+
+/* Park a frame for @seq in the reorder buffer, as the RX path does */
+static struct sk_buff *ba_kunit_park(struct kunit *test,
+                                     struct wifi7_ba_session *s, u16 seq)
+{
+    struct sk_buff *skb = alloc_skb(64, GFP_KERNEL);
+    u16 idx = seq_to_index(seq);
+
+    KUNIT_ASSERT_NOT_NULL(test, skb);
+    s->reorder_buf[idx] = skb;
+    set_bit(idx, s->reorder_bitmap);
+
+    return skb;
+}
+
+static void ba_seq_index_test(struct kunit *test)
+{
+    KUNIT_EXPECT_EQ(test, seq_to_index(0), 0);
+    KUNIT_EXPECT_EQ(test, seq_to_index(WIFI7_BA_MAX_REORDER - 1),
+                    WIFI7_BA_MAX_REORDER - 1);
+    KUNIT_EXPECT_EQ(test, seq_to_index(WIFI7_BA_MAX_REORDER), 0);
+    KUNIT_EXPECT_EQ(test, seq_to_index(4095), WIFI7_BA_MAX_REORDER - 1);
+}
+
+static void ba_seq_valid_test(struct kunit *test)
+{
+    /* Plain window */
+    KUNIT_EXPECT_TRUE(test, is_seq_valid(100, 100, 163));
+    KUNIT_EXPECT_TRUE(test, is_seq_valid(163, 100, 163));
+    KUNIT_EXPECT_FALSE(test, is_seq_valid(164, 100, 163));
+    KUNIT_EXPECT_FALSE(test, is_seq_valid(99, 100, 163));
+
+    /* Window straddling the 12-bit sequence wrap */
+    KUNIT_EXPECT_TRUE(test, is_seq_valid(4090, 4090, 5));
+    KUNIT_EXPECT_TRUE(test, is_seq_valid(4095, 4090, 5));
+    KUNIT_EXPECT_TRUE(test, is_seq_valid(0, 4090, 5));
+    KUNIT_EXPECT_TRUE(test, is_seq_valid(5, 4090, 5));
+    KUNIT_EXPECT_FALSE(test, is_seq_valid(6, 4090, 5));
+    KUNIT_EXPECT_FALSE(test, is_seq_valid(4089, 4090, 5));
+}
+
+static void ba_flush_holes_test(struct kunit *test)
+{
+    struct wifi7_ba_session *s = ba_kunit_session(test, 10);
+    struct sk_buff *a, *b;
+
+    a = ba_kunit_park(test, s, 10);
+    b = ba_kunit_park(test, s, 13);
+
+    wifi7_ba_flush_reorder_buffer(s, 16);
+
+    KUNIT_EXPECT_EQ(test, s->head_seq, 16);
+    KUNIT_EXPECT_EQ(test, s->rx_reorder, 2U);
+    KUNIT_EXPECT_EQ(test, s->rx_drop, 4U);
+    KUNIT_EXPECT_TRUE(test, bitmap_empty(s->reorder_bitmap,
+                                         WIFI7_BA_MAX_REORDER));
+
+    /* Released in sequence order */
+    KUNIT_EXPECT_PTR_EQ(test, skb_dequeue(&s->reorder_queue), a);
+    KUNIT_EXPECT_PTR_EQ(test, skb_dequeue(&s->reorder_queue), b);
+    KUNIT_EXPECT_TRUE(test, skb_queue_empty(&s->reorder_queue));
+
+    kfree_skb(a);
+    kfree_skb(b);
+}
+
+static void ba_flush_wrap_test(struct kunit *test)
+{
+    struct wifi7_ba_session *s = ba_kunit_session(test, 4094);
+    u16 seq;
+
+    for (seq = 4094; seq != 3; seq = (seq + 1) & 0xFFF)
+        ba_kunit_park(test, s, seq);
+
+    wifi7_ba_flush_reorder_buffer(s, 3);
+
+    KUNIT_EXPECT_EQ(test, s->head_seq, 3);
+    KUNIT_EXPECT_EQ(test, s->rx_reorder, 5U);
+    KUNIT_EXPECT_EQ(test, s->rx_drop, 0U);
+    KUNIT_EXPECT_EQ(test, skb_queue_len(&s->reorder_queue), 5U);
+
+    skb_queue_purge(&s->reorder_queue);
+}
+
+static void ba_flush_noop_test(struct kunit *test)
+{
+    struct wifi7_ba_session *s = ba_kunit_session(test, 200);
+    struct sk_buff *skb = ba_kunit_park(test, s, 201);
+
+    wifi7_ba_flush_reorder_buffer(s, 200);
+
+    KUNIT_EXPECT_EQ(test, s->head_seq, 200);
+    KUNIT_EXPECT_EQ(test, s->rx_reorder + s->rx_drop, 0U);
+    KUNIT_EXPECT_PTR_EQ(test, s->reorder_buf[seq_to_index(201)], skb);
+
+    kfree_skb(skb);
+}
+
+static void ba_session_lookup_test(struct kunit *test)
+{
+    struct wifi7_ba *ba = kunit_kzalloc(test, sizeof(*ba), GFP_KERNEL);
+    u8 other[ETH_ALEN] = { 0x02, 0x67, 0x00, 0x00, 0x00, 0x02 };
+    struct wifi7_ba_session *s;
+
+    KUNIT_ASSERT_NOT_NULL(test, ba);
+
+    s = wifi7_ba_alloc_session(ba);
+    KUNIT_ASSERT_PTR_EQ(test, s, &ba->sessions[0]);
+    s->tid = 3;
+    s->active = true;
+    ether_addr_copy(s->peer_addr, ba_kunit_peer);
+
+    KUNIT_EXPECT_PTR_EQ(test, wifi7_ba_alloc_session(ba), &ba->sessions[1]);
+    KUNIT_EXPECT_PTR_EQ(test, wifi7_ba_find_session(ba, 3, ba_kunit_peer), s);
+    KUNIT_EXPECT_NULL(test, wifi7_ba_find_session(ba, 4, ba_kunit_peer));
+    KUNIT_EXPECT_NULL(test, wifi7_ba_find_session(ba, 3, other));
+}
+
+static void ba_session_exhaust_test(struct kunit *test)
+{
+    struct wifi7_ba *ba = kunit_kzalloc(test, sizeof(*ba), GFP_KERNEL);
+    int i;
+
+    KUNIT_ASSERT_NOT_NULL(test, ba);
+
+    for (i = 0; i < WIFI7_BA_MAX_SESSIONS; i++)
+        ba->sessions[i].active = true;
+
+    KUNIT_EXPECT_NULL(test, wifi7_ba_alloc_session(ba));
+}
+
+static void ba_bench_flush(struct kunit *test)
+{
+    struct wifi7_ba_session *s = ba_kunit_session(test, 0);
+    struct sk_buff *skb = alloc_skb(64, GFP_KERNEL);
+    u16 idx;
+
+    KUNIT_ASSERT_NOT_NULL(test, skb);
+
+    /* Release one in-order frame per call, recycling the same skb */
+    WIFI67_BENCH(test, "ba.flush_one",
+                 ({
+                     idx = seq_to_index(s->head_seq);
+                     s->reorder_buf[idx] = skb;
+                     set_bit(idx, s->reorder_bitmap);
+                     wifi7_ba_flush_reorder_buffer(s,
+                                                   (s->head_seq + 1) & 0xFFF);
+                     __skb_unlink(skb, &s->reorder_queue);
+                 }),
+                 (void)0);
+
+    kfree_skb(skb);
+}
+
+static void ba_bench_find_session(struct kunit *test)
+{
+    struct wifi7_ba *ba = kunit_kzalloc(test, sizeof(*ba), GFP_KERNEL);
+    struct wifi7_ba_session *last, *found = NULL;
+    int i;
+
+    KUNIT_ASSERT_NOT_NULL(test, ba);
+
+    /* Worst case: every slot busy, the match in the last one */
+    for (i = 0; i < WIFI7_BA_MAX_SESSIONS; i++) {
+        ba->sessions[i].active = true;
+        ba->sessions[i].tid = i % WIFI7_BA_MAX_TID;
+        ether_addr_copy(ba->sessions[i].peer_addr, ba_kunit_peer);
+        ba->sessions[i].peer_addr[4] = i;
+    }
+    last = &ba->sessions[WIFI7_BA_MAX_SESSIONS - 1];
+    last->peer_addr[4] = 0xff;
+
+    WIFI67_BENCH(test, "ba.find_session",
+                 found = wifi7_ba_find_session(ba, last->tid, last->peer_addr),
+                 (void)0);
+
+    KUNIT_EXPECT_PTR_EQ(test, found, last);
+}
+
+static struct kunit_case wifi7_ba_test_cases[] = {
+    KUNIT_CASE(ba_seq_index_test),
+    KUNIT_CASE(ba_seq_valid_test),
+    KUNIT_CASE(ba_flush_holes_test),
+    KUNIT_CASE(ba_flush_wrap_test),
+    KUNIT_CASE(ba_flush_noop_test),
+    KUNIT_CASE(ba_session_lookup_test),
+    KUNIT_CASE(ba_session_exhaust_test),
+    KUNIT_CASE_SLOW(ba_bench_flush),
+    KUNIT_CASE_SLOW(ba_bench_find_session),
+    {}
+};
+
+static struct kunit_suite wifi7_ba_test_suite = {
+    .name = "wifi67_ba",
+    .test_cases = wifi7_ba_test_cases,
+};
+
+kunit_test_suite(wifi7_ba_test_suite);
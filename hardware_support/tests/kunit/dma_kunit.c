@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for DMA descriptor ring bookkeeping.
+ * Included from src/dma/dma_core.c.
+ *
+ * The engine is backed by a zeroed register window in RAM; completion is
+ * simulated by clearing the OWN bit the way hardware would. Descriptors
+ * and buffers are really mapped, so the suite needs CONFIG_HAS_DMA and is
+ * skipped on UML.
+ */
+
+#include <kunit/device.h>
+#include "../../../include/mac/mac_core.h"
+#include "wifi67_kunit.h"
+
+#define DMA_KUNIT_REGS_SIZE     0x6000
+#define DMA_KUNIT_BUF_LEN       256
+#define DMA_KUNIT_NBUF          8
+
+struct dma_kunit_ctx {
+    struct wifi67_priv priv;
+    struct wifi67_hw_info hw;
+    u8 *bufs[DMA_KUNIT_NBUF];
+};
+
+static struct wifi67_dma_channel *dma_kunit_chan(struct dma_kunit_ctx *ctx)
+{
+    return &ctx->priv.dma_dev->channels[0];
+}
+
+/* ERR_STATUS is write-one-to-clear on hardware; RAM just keeps the ones */
+static void dma_kunit_clear_errors(struct dma_kunit_ctx *ctx)
+{
+    writel(0, dma_kunit_chan(ctx)->regs + WIFI67_DMA_REG_ERR_STATUS);
+}
+
+static void dma_kunit_complete(struct wifi67_dma_ring *ring, u32 idx)
+{
+    ring->desc[idx].flags &= ~cpu_to_le32(WIFI67_DMA_DESC_OWN);
+}
+
+static int dma_kunit_init(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx;
+    struct device *dev;
+    int i;
+
+    if (!IS_ENABLED(CONFIG_HAS_DMA))
+        kunit_skip(test, "requires CONFIG_HAS_DMA");
+
+    ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, ctx);
+
+    dev = kunit_device_register(test, "wifi67-dma-kunit");
+    KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dev);
+    KUNIT_ASSERT_EQ(test, dma_coerce_mask_and_coherent(dev,
+                                                       DMA_BIT_MASK(32)), 0);
+
+    ctx->hw.membase = (void __iomem *)kunit_kzalloc(test, DMA_KUNIT_REGS_SIZE,
+                                                    GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, (void __force *)ctx->hw.membase);
+    ctx->priv.hw_info = &ctx->hw;
+    ctx->priv.dev = dev;
+
+    for (i = 0; i < DMA_KUNIT_NBUF; i++) {
+        ctx->bufs[i] = kunit_kzalloc(test, DMA_KUNIT_BUF_LEN, GFP_KERNEL);
+        KUNIT_ASSERT_NOT_NULL(test, ctx->bufs[i]);
+    }
+
+    KUNIT_ASSERT_EQ(test, wifi67_dma_init(&ctx->priv), 0);
+    test->priv = ctx;
+    KUNIT_ASSERT_EQ(test, wifi67_dma_channel_init(&ctx->priv, 0), 0);
+    dma_kunit_clear_errors(ctx);
+    KUNIT_ASSERT_EQ(test, wifi67_dma_channel_start(&ctx->priv, 0), 0);
+
+    return 0;
+}
+
+static void dma_kunit_exit(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_ring *ring;
+    u32 len;
+
+    if (!ctx)
+        return;
+
+    /* Unmap anything a test left posted */
+    ring = &dma_kunit_chan(ctx)->tx_ring;
+    if (ring->desc) {
+        dma_kunit_clear_errors(ctx);
+        ring->enabled = true;
+        while (ring->tail != ring->head) {
+            dma_kunit_complete(ring, ring->tail);
+            wifi67_dma_ring_get_buffer(&ctx->priv, 0, true, &len);
+        }
+        wifi67_dma_channel_deinit(&ctx->priv, 0);
+    }
+    wifi67_dma_deinit(&ctx->priv);
+}
+
+static void dma_ring_add_get_test(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_ring *ring = &dma_kunit_chan(ctx)->tx_ring;
+    struct wifi67_dma_stats stats;
+    u32 len = 0;
+    int i;
+
+    for (i = 0; i < 3; i++)
+        KUNIT_ASSERT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                         ctx->bufs[i],
+                                                         100 + i), 0);
+    KUNIT_EXPECT_EQ(test, ring->head, 3U);
+    KUNIT_EXPECT_TRUE(test, ring->desc[0].flags &
+                            cpu_to_le32(WIFI67_DMA_DESC_OWN));
+    KUNIT_EXPECT_EQ(test, le16_to_cpu(ring->desc[2].next_desc), 3);
+
+    /* Nothing comes back while the device owns the descriptor */
+    KUNIT_EXPECT_NULL(test, wifi67_dma_ring_get_buffer(&ctx->priv, 0, true,
+                                                       &len));
+
+    dma_kunit_complete(ring, 0);
+    KUNIT_EXPECT_PTR_EQ(test, wifi67_dma_ring_get_buffer(&ctx->priv, 0, true,
+                                                         &len),
+                        (void *)ctx->bufs[0]);
+    KUNIT_EXPECT_EQ(test, len, 100U);
+    KUNIT_EXPECT_EQ(test, ring->tail, 1U);
+
+    /* Completion is strictly in ring order */
+    dma_kunit_complete(ring, 2);
+    KUNIT_EXPECT_NULL(test, wifi67_dma_ring_get_buffer(&ctx->priv, 0, true,
+                                                       &len));
+
+    KUNIT_ASSERT_EQ(test, wifi67_dma_get_stats(&ctx->priv, &stats), 0);
+    KUNIT_EXPECT_EQ(test, stats.tx_packets, 1ULL);
+    KUNIT_EXPECT_EQ(test, stats.tx_bytes, 303ULL);
+    KUNIT_EXPECT_EQ(test, stats.rx_bytes, 0ULL);
+}
+
+static void dma_ring_full_test(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_ring *ring = &dma_kunit_chan(ctx)->tx_ring;
+
+    /* One slot is always kept free to tell full from empty */
+    ring->head = ring->size - 1;
+    ring->tail = 0;
+
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     ctx->bufs[0],
+                                                     DMA_KUNIT_BUF_LEN),
+                    -ENOSPC);
+    KUNIT_EXPECT_EQ(test, ring->head, ring->size - 1);
+    KUNIT_EXPECT_NULL(test, ring->buf_addr[ring->size - 1]);
+
+    ring->head = ring->tail = 0;
+}
+
+static void dma_ring_wrap_test(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_ring *ring = &dma_kunit_chan(ctx)->tx_ring;
+    u32 last = ring->size - 1;
+    u32 len;
+
+    ring->head = ring->tail = last;
+
+    KUNIT_ASSERT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     ctx->bufs[1], 64), 0);
+    KUNIT_EXPECT_EQ(test, ring->head, 0U);
+    KUNIT_EXPECT_EQ(test, le16_to_cpu(ring->desc[last].next_desc), 0);
+
+    dma_kunit_complete(ring, last);
+    KUNIT_EXPECT_PTR_EQ(test, wifi67_dma_ring_get_buffer(&ctx->priv, 0, true,
+                                                         &len),
+                        (void *)ctx->bufs[1]);
+    KUNIT_EXPECT_EQ(test, ring->tail, 0U);
+}
+
+static void dma_ring_invalid_test(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    u32 len;
+
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv,
+                                                     WIFI67_DMA_MAX_CHANNELS,
+                                                     true, ctx->bufs[0], 64),
+                    -EINVAL);
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     NULL, 64), -EINVAL);
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     ctx->bufs[0], 0),
+                    -EINVAL);
+
+    /* A stopped channel refuses work in both directions */
+    wifi67_dma_channel_stop(&ctx->priv, 0);
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, false,
+                                                     ctx->bufs[0], 64),
+                    -EINVAL);
+    KUNIT_EXPECT_NULL(test, wifi67_dma_ring_get_buffer(&ctx->priv, 0, false,
+                                                       &len));
+}
+
+static void dma_desc_error_test(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_ring *ring = &dma_kunit_chan(ctx)->tx_ring;
+    dma_addr_t addr;
+    u32 len;
+
+    KUNIT_ASSERT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     ctx->bufs[0], 64), 0);
+    addr = ring->buf_dma[0];
+
+    dma_kunit_complete(ring, 0);
+    ring->desc[0].status = cpu_to_le32(0x01000000);
+
+    /* Recovery runs outside the ring lock and leaves the ring usable */
+    KUNIT_EXPECT_NULL(test, wifi67_dma_ring_get_buffer(&ctx->priv, 0, true,
+                                                       &len));
+    KUNIT_EXPECT_EQ(test, ring->head, 0U);
+    KUNIT_EXPECT_EQ(test, ring->tail, 0U);
+    KUNIT_EXPECT_TRUE(test, ring->enabled);
+
+    /* Recovery drops the slot without unmapping it */
+    dma_unmap_single(ctx->priv.dev, addr, 64, DMA_TO_DEVICE);
+}
+
+static void dma_hw_error_test(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_channel *chan = dma_kunit_chan(ctx);
+
+    writel(BIT(1), chan->regs + WIFI67_DMA_REG_ERR_STATUS);
+
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     ctx->bufs[0], 64), -EIO);
+    KUNIT_EXPECT_EQ(test, chan->tx_ring.head, 0U);
+    KUNIT_EXPECT_TRUE(test, chan->tx_ring.enabled);
+
+    /* Once the error is acknowledged the channel takes work again */
+    dma_kunit_clear_errors(ctx);
+    KUNIT_EXPECT_EQ(test, wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                     ctx->bufs[0], 64), 0);
+}
+
+static void dma_bench_add_get(struct kunit *test)
+{
+    struct dma_kunit_ctx *ctx = test->priv;
+    struct wifi67_dma_ring *ring = &dma_kunit_chan(ctx)->tx_ring;
+    void *buf = NULL;
+    u32 len;
+
+    /* Post, complete and reap one buffer; the ring wraps along the way */
+    WIFI67_BENCH(test, "dma.add_get",
+                 ({
+                     wifi67_dma_ring_add_buffer(&ctx->priv, 0, true,
+                                                ctx->bufs[0],
+                                                DMA_KUNIT_BUF_LEN);
+                     dma_kunit_complete(ring, ring->tail);
+                     buf = wifi67_dma_ring_get_buffer(&ctx->priv, 0, true,
+                                                      &len);
+                 }),
+                 (void)0);
+
+    KUNIT_EXPECT_PTR_EQ(test, buf, (void *)ctx->bufs[0]);
+}
+
+static struct kunit_case wifi67_dma_test_cases[] = {
+    KUNIT_CASE(dma_ring_add_get_test),
+    KUNIT_CASE(dma_ring_full_test),
+    KUNIT_CASE(dma_ring_wrap_test),
+    KUNIT_CASE(dma_ring_invalid_test),
+    KUNIT_CASE(dma_desc_error_test),
+    KUNIT_CASE(dma_hw_error_test),
+    KUNIT_CASE_SLOW(dma_bench_add_get),
+    {}
+};
+
+static struct kunit_suite wifi67_dma_test_suite = {
+    .name = "wifi67_dma",
+    .init = dma_kunit_init,
+    .exit = dma_kunit_exit,
+    .test_cases = wifi67_dma_test_cases,
+};
+
+kunit_test_suite(wifi67_dma_test_suite);
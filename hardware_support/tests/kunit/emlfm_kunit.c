@@ -0,0 +1,365 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for firmware crash capture.
+ * Included from src/firmware/emlfm.c.
+ *
+ * Radio 0 of a firmware manager is backed by a zeroed register and memory
+ * window in RAM and a host IPC ring; no interrupt or DMA region is set up.
+ * A crash is an assert record written into SRAM with a command still
+ * pending in the ring. Dumps go through wifi67_emlfm_coredump() with the
+ * devcoredump hand-off stubbed, so the test gets the buffer back.
+ */
+
+#include <kunit/device.h>
+#include <kunit/static_stub.h>
+#include "wifi67_kunit.h"
+
+#define EMLFM_KUNIT_MMIO_SIZE   (WIFI67_FW_IRAM_SIZE + WIFI67_FW_DRAM_SIZE + \
+                                 WIFI67_FW_SRAM_SIZE)
+#define EMLFM_KUNIT_ERROR       0xA55E0042
+#define EMLFM_KUNIT_ASSERT      "ASSERT fw/mac/tx.c:1234"
+
+struct emlfm_kunit_ctx {
+    struct wifi67_priv priv;
+    struct wifi67_emlfm emlfm;
+    void *dump;
+    size_t dump_len;
+    int dumps;
+};
+
+static void emlfm_kunit_vfree(void *ptr)
+{
+    vfree(ptr);
+}
+
+/* Replaces the devcoredump hand-off; the test owns the buffer */
+static void emlfm_kunit_deliver_dump(struct wifi67_priv *priv, void *data,
+                                     size_t len)
+{
+    struct emlfm_kunit_ctx *ctx = kunit_get_current_test()->priv;
+
+    vfree(ctx->dump);
+    ctx->dump = data;
+    ctx->dump_len = len;
+    ctx->dumps++;
+}
+
+static int emlfm_kunit_init(struct kunit *test)
+{
+    struct emlfm_kunit_ctx *ctx;
+    struct wifi67_emlfm *emlfm;
+    struct device *dev;
+    void *mmio;
+
+    if (!IS_ENABLED(CONFIG_HAS_IOMEM))
+        kunit_skip(test, "requires CONFIG_HAS_IOMEM");
+
+    ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, ctx);
+
+    dev = kunit_device_register(test, "wifi67-emlfm-kunit");
+    KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dev);
+
+    mmio = vzalloc(EMLFM_KUNIT_MMIO_SIZE);
+    KUNIT_ASSERT_NOT_NULL(test, mmio);
+    KUNIT_ASSERT_EQ(test, kunit_add_action_or_reset(test, emlfm_kunit_vfree,
+                                                    mmio), 0);
+
+    ctx->priv.dev = dev;
+    ctx->priv.mmio = (void __iomem *)mmio;
+
+    /* What wifi67_emlfm_init() sets up, minus IRQ and DMA regions */
+    emlfm = &ctx->emlfm;
+    emlfm->priv = &ctx->priv;
+    spin_lock_init(&emlfm->lock);
+    mutex_init(&emlfm->recovery_lock);
+    INIT_WORK(&emlfm->recovery_work, wifi67_emlfm_handle_crash);
+    wifi67_fw_hist_init(&emlfm->hist);
+
+    emlfm->ipc[0].emlfm = emlfm;
+    emlfm->ipc[0].ringbuf_size = WIFI67_IPC_RING_SIZE;
+    emlfm->ipc[0].ringbuf = kunit_kzalloc(test, WIFI67_IPC_RING_SIZE,
+                                          GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, emlfm->ipc[0].ringbuf);
+    KUNIT_ASSERT_EQ(test, wifi67_ipc_init(&emlfm->ipc[0].ring,
+                                          emlfm->ipc[0].ringbuf,
+                                          emlfm->ipc[0].ringbuf_size,
+                                          &wifi67_emlfm_ipc_ops,
+                                          &emlfm->ipc[0]), 0);
+
+    emlfm->fw[0].version = 0x00010002;
+    emlfm->fw[0].radio_mask = BIT(0);
+    emlfm->fw[0].state = WIFI67_FW_STATE_READY;
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_LOAD, 0,
+                          WIFI67_FW_IRAM_SIZE, 0);
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_START, 0, 0, 0);
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_READY, 0, 0, 0);
+
+    ctx->priv.emlfm = emlfm;
+    test->priv = ctx;
+    return 0;
+}
+
+static void emlfm_kunit_exit(struct kunit *test)
+{
+    struct emlfm_kunit_ctx *ctx = test->priv;
+
+    if (!ctx)
+        return;
+
+    cancel_work_sync(&ctx->emlfm.recovery_work);
+    vfree(ctx->dump);
+}
+
+/* Firmware asserts with a command still sitting in the IPC ring */
+static void emlfm_kunit_crash(struct kunit *test, struct emlfm_kunit_ctx *ctx)
+{
+    void __iomem *sram;
+    u32 cmd = 0x1234;
+
+    KUNIT_ASSERT_EQ(test, wifi67_emlfm_ipc_queue(&ctx->priv, 0, 7, &cmd,
+                                                 sizeof(cmd)), 0);
+    wifi67_emlfm_ipc_flush(&ctx->priv, 0);
+
+    sram = wifi67_hw_fw_region_base(&ctx->priv, 0, WIFI67_FW_REGION_SRAM);
+    memcpy_toio(sram, EMLFM_KUNIT_ASSERT, sizeof(EMLFM_KUNIT_ASSERT));
+
+    ctx->emlfm.fw[0].state = WIFI67_FW_STATE_CRASHED;
+    ctx->emlfm.status[0].error_code = EMLFM_KUNIT_ERROR;
+    wifi67_fw_hist_record(&ctx->emlfm.hist, WIFI67_FW_HIST_CRASH, 0,
+                          EMLFM_KUNIT_ERROR, 0);
+}
+
+static const struct wifi67_fw_dump_section *
+emlfm_kunit_section(const void *data, size_t len, u32 type)
+{
+    const struct wifi67_fw_dump_hdr *hdr = data;
+    const struct wifi67_fw_dump_section *sec;
+    size_t pos = sizeof(*hdr);
+    u32 i;
+
+    for (i = 0; i < le32_to_cpu(hdr->num_sections); i++) {
+        if (pos + sizeof(*sec) > len)
+            return NULL;
+        sec = data + pos;
+        if (le32_to_cpu(sec->type) == type)
+            return sec;
+        pos += sizeof(*sec) + le32_to_cpu(sec->len);
+    }
+
+    return NULL;
+}
+
+/* Sections must tile the dump exactly */
+static bool emlfm_kunit_dump_valid(const void *data, size_t len)
+{
+    const struct wifi67_fw_dump_hdr *hdr = data;
+    const struct wifi67_fw_dump_section *sec;
+    size_t pos = sizeof(*hdr);
+    u32 i;
+
+    if (len < sizeof(*hdr) ||
+        le32_to_cpu(hdr->magic) != WIFI67_FW_DUMP_MAGIC ||
+        le32_to_cpu(hdr->total_len) != len)
+        return false;
+
+    for (i = 0; i < le32_to_cpu(hdr->num_sections); i++) {
+        if (pos + sizeof(*sec) > len)
+            return false;
+        sec = data + pos;
+        if (le32_to_cpu(sec->len) > le32_to_cpu(sec->orig_len))
+            return false;
+        pos += sizeof(*sec) + le32_to_cpu(sec->len);
+    }
+
+    return pos == len;
+}
+
+static void emlfm_coredump_capture_test(struct kunit *test)
+{
+    struct emlfm_kunit_ctx *ctx = test->priv;
+    const struct wifi67_fw_dump_section *sec;
+    const struct wifi67_fw_hist_entry *ev;
+    const struct wifi67_ipc_msg *cmd;
+    const struct wifi67_fw_dump_hdr *hdr;
+    size_t n;
+
+    kunit_activate_static_stub(test, wifi67_emlfm_deliver_dump,
+                               emlfm_kunit_deliver_dump);
+
+    emlfm_kunit_crash(test, ctx);
+    wifi67_emlfm_coredump(&ctx->emlfm, 0);
+
+    KUNIT_ASSERT_EQ(test, ctx->dumps, 1);
+    KUNIT_EXPECT_EQ(test, ctx->emlfm.status[0].recovery.coredumps, 1U);
+    KUNIT_ASSERT_TRUE(test, emlfm_kunit_dump_valid(ctx->dump, ctx->dump_len));
+
+    hdr = ctx->dump;
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(hdr->error_code), EMLFM_KUNIT_ERROR);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(hdr->fw_version), 0x00010002U);
+    KUNIT_EXPECT_NOT_NULL(test, emlfm_kunit_section(ctx->dump, ctx->dump_len,
+                                                    WIFI67_FW_DUMP_REGS));
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_SRAM);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(sec->len), WIFI67_FW_SRAM_SIZE);
+    KUNIT_EXPECT_MEMEQ(test, sec + 1, EMLFM_KUNIT_ASSERT,
+                       sizeof(EMLFM_KUNIT_ASSERT));
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_IRAM);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(sec->flags), 0U);
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_EVENTS);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    ev = (const void *)(sec + 1);
+    n = le32_to_cpu(sec->len) / sizeof(*ev);
+    KUNIT_ASSERT_EQ(test, n, (size_t)4);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(ev[n - 1].type), WIFI67_FW_HIST_CRASH);
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_IPC);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    cmd = (const void *)(sec + 1) + WIFI67_IPC_CMD_OFFSET;
+    KUNIT_EXPECT_EQ(test, le16_to_cpu(cmd->id), 7);
+}
+
+static void emlfm_coredump_size_bound_test(struct kunit *test)
+{
+    struct emlfm_kunit_ctx *ctx = test->priv;
+    const struct wifi67_fw_dump_section *sec;
+    size_t max = 256 * 1024;
+
+    emlfm_kunit_crash(test, ctx);
+    ctx->dump = wifi67_emlfm_build_dump(&ctx->emlfm, 0, max,
+                                        WIFI67_FW_DUMP_BUDGET_MS * 10,
+                                        &ctx->dump_len);
+    KUNIT_ASSERT_NOT_NULL(test, ctx->dump);
+    KUNIT_EXPECT_LE(test, ctx->dump_len, max);
+    KUNIT_ASSERT_TRUE(test, emlfm_kunit_dump_valid(ctx->dump, ctx->dump_len));
+
+    /* Small sections survive, the big regions are cut */
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_IPC);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(sec->flags), 0U);
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_DRAM);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    KUNIT_EXPECT_TRUE(test, le32_to_cpu(sec->flags) &
+                            WIFI67_FW_DUMP_F_TRUNC_SIZE);
+}
+
+static void emlfm_coredump_time_bound_test(struct kunit *test)
+{
+    static const u32 regions[] = {
+        WIFI67_FW_DUMP_SRAM, WIFI67_FW_DUMP_DRAM, WIFI67_FW_DUMP_IRAM,
+    };
+    struct emlfm_kunit_ctx *ctx = test->priv;
+    const struct wifi67_fw_dump_section *sec;
+    int i;
+
+    /* An expired budget cuts every memory region, never the small ones */
+    emlfm_kunit_crash(test, ctx);
+    ctx->dump = wifi67_emlfm_build_dump(&ctx->emlfm, 0,
+                                        WIFI67_FW_DUMP_MAX_SIZE, 0,
+                                        &ctx->dump_len);
+    KUNIT_ASSERT_NOT_NULL(test, ctx->dump);
+    KUNIT_ASSERT_TRUE(test, emlfm_kunit_dump_valid(ctx->dump, ctx->dump_len));
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_IPC);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(sec->len), WIFI67_IPC_SHARED_SIZE);
+
+    for (i = 0; i < ARRAY_SIZE(regions); i++) {
+        sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, regions[i]);
+        KUNIT_ASSERT_NOT_NULL(test, sec);
+        KUNIT_EXPECT_TRUE(test, le32_to_cpu(sec->flags) &
+                                WIFI67_FW_DUMP_F_TRUNC_TIME);
+        KUNIT_EXPECT_LT(test, le32_to_cpu(sec->len),
+                        le32_to_cpu(sec->orig_len));
+    }
+}
+
+/* fw_crash and a real assert interrupt share this path */
+static void emlfm_inject_crash_test(struct kunit *test)
+{
+    struct emlfm_kunit_ctx *ctx = test->priv;
+    struct wifi67_emlfm_recovery_stats stats;
+    struct wifi67_emlfm *emlfm = &ctx->emlfm;
+    const struct wifi67_fw_hist_entry *ev;
+    u32 next;
+
+    KUNIT_EXPECT_EQ(test, wifi67_emlfm_inject_crash(&ctx->priv,
+                                                    WIFI67_MAX_RADIOS),
+                    -EINVAL);
+
+    KUNIT_ASSERT_EQ(test, wifi67_emlfm_inject_crash(&ctx->priv, 0), 0);
+    flush_work(&emlfm->recovery_work);
+
+    /* Captured, reset, and left for a full load without a retained image */
+    KUNIT_EXPECT_EQ(test, emlfm->fw[0].state, WIFI67_FW_STATE_RESET);
+    KUNIT_EXPECT_EQ(test, emlfm->status[0].error_code,
+                    WIFI67_FW_ERR_INJECTED);
+    KUNIT_ASSERT_EQ(test, wifi67_emlfm_get_recovery_stats(&ctx->priv, 0,
+                                                          &stats), 0);
+    KUNIT_EXPECT_EQ(test, stats.crash_count, 1U);
+    KUNIT_EXPECT_EQ(test, stats.coredumps, 1U);
+    KUNIT_EXPECT_EQ(test, stats.full_reloads, 1U);
+    KUNIT_EXPECT_EQ(test, stats.fast_recoveries, 0U);
+
+    next = emlfm->hist.next;
+    ev = &emlfm->hist.entries[(next - 1) & (WIFI67_FW_HIST_ENTRIES - 1)];
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(ev->type), WIFI67_FW_HIST_CRASH);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(ev->arg0), WIFI67_FW_ERR_INJECTED);
+
+    /* Only a running radio can be crashed */
+    KUNIT_EXPECT_EQ(test, wifi67_emlfm_inject_crash(&ctx->priv, 0), -EINVAL);
+}
+
+static void emlfm_hist_wrap_test(struct kunit *test)
+{
+    struct emlfm_kunit_ctx *ctx = test->priv;
+    const struct wifi67_fw_dump_section *sec;
+    const struct wifi67_fw_hist_entry *ev;
+    size_t n, i;
+
+    for (i = 0; i < 4 * WIFI67_FW_HIST_ENTRIES + 3; i++)
+        wifi67_fw_hist_record(&ctx->emlfm.hist, WIFI67_FW_HIST_LOAD, 0,
+                              i, 0);
+
+    ctx->dump = wifi67_emlfm_build_dump(&ctx->emlfm, 0,
+                                        WIFI67_FW_DUMP_MAX_SIZE,
+                                        WIFI67_FW_DUMP_BUDGET_MS * 10,
+                                        &ctx->dump_len);
+    KUNIT_ASSERT_NOT_NULL(test, ctx->dump);
+
+    sec = emlfm_kunit_section(ctx->dump, ctx->dump_len, WIFI67_FW_DUMP_EVENTS);
+    KUNIT_ASSERT_NOT_NULL(test, sec);
+
+    /* Oldest first, newest entries kept */
+    ev = (const void *)(sec + 1);
+    n = le32_to_cpu(sec->len) / sizeof(*ev);
+    KUNIT_ASSERT_EQ(test, n, (size_t)WIFI67_FW_HIST_ENTRIES);
+    for (i = 1; i < n; i++)
+        KUNIT_ASSERT_EQ(test, le32_to_cpu(ev[i].arg0),
+                        le32_to_cpu(ev[i - 1].arg0) + 1);
+    KUNIT_EXPECT_EQ(test, le32_to_cpu(ev[n - 1].arg0),
+                    4 * WIFI67_FW_HIST_ENTRIES + 2);
+}
+
+static struct kunit_case wifi67_emlfm_test_cases[] = {
+    KUNIT_CASE(emlfm_coredump_capture_test),
+    KUNIT_CASE(emlfm_coredump_size_bound_test),
+    KUNIT_CASE(emlfm_coredump_time_bound_test),
+    KUNIT_CASE(emlfm_inject_crash_test),
+    KUNIT_CASE(emlfm_hist_wrap_test),
+    {}
+};
+
+static struct kunit_suite wifi67_emlfm_test_suite = {
+    .name = "wifi67_emlfm",
+    .init = emlfm_kunit_init,
+    .exit = emlfm_kunit_exit,
+    .test_cases = wifi67_emlfm_test_cases,
+};
+
+kunit_test_suite(wifi67_emlfm_test_suite);
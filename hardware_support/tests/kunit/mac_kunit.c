@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for MAC link state and per-link TX accounting.
+ * Included from src/mac/wifi7_mac.c.
+ */
+
+#include "wifi67_kunit.h"
+
+struct mac_kunit_hw {
+    int tx_calls;
+    int tx_ret;
+    int setup_ret;
+};
+
+static struct mac_kunit_hw *mac_kunit_hw(struct wifi7_mac_dev *dev)
+{
+    return dev->hw_priv;
+}
+
+static int mac_kunit_link_setup(struct wifi7_mac_dev *dev, u8 link_id)
+{
+    return mac_kunit_hw(dev)->setup_ret;
+}
+
+static int mac_kunit_tx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb,
+                              u8 link_id)
+{
+    mac_kunit_hw(dev)->tx_calls++;
+
+    return mac_kunit_hw(dev)->tx_ret;
+}
+
+static struct wifi7_mac_ops mac_kunit_ops = {
+    .link_setup = mac_kunit_link_setup,
+    .tx_frame = mac_kunit_tx_frame,
+};
+
+static int mac_kunit_init(struct kunit *test)
+{
+    struct wifi7_mac_dev *dev;
+
+    dev = wifi7_mac_alloc(NULL);
+    KUNIT_ASSERT_NOT_NULL(test, dev);
+
+    dev->ops = &mac_kunit_ops;
+    dev->hw_priv = kunit_kzalloc(test, sizeof(struct mac_kunit_hw),
+                                 GFP_KERNEL);
+    test->priv = dev;
+    KUNIT_ASSERT_NOT_NULL(test, dev->hw_priv);
+
+    return 0;
+}
+
+static void mac_kunit_exit(struct kunit *test)
+{
+    wifi7_mac_free(test->priv);
+}
+
+static struct sk_buff *mac_kunit_skb(struct kunit *test, unsigned int len)
+{
+    struct sk_buff *skb = alloc_skb(len, GFP_KERNEL);
+
+    KUNIT_ASSERT_NOT_NULL(test, skb);
+    skb_put_zero(skb, len);
+
+    return skb;
+}
+
+static void mac_link_state_test(struct kunit *test)
+{
+    struct wifi7_mac_dev *dev = test->priv;
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_setup(dev, 1), 0);
+    KUNIT_EXPECT_TRUE(test, dev->links[1].enabled);
+    KUNIT_EXPECT_EQ(test, dev->links[1].mlo_state, MLO_STATE_ACTIVE);
+    KUNIT_EXPECT_EQ(test, atomic_read(&dev->active_links), 1);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_setup(dev, 1), -EBUSY);
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_setup(dev, max_links), -EINVAL);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_teardown(dev, 1), 0);
+    KUNIT_EXPECT_FALSE(test, dev->links[1].enabled);
+    KUNIT_EXPECT_EQ(test, dev->links[1].mlo_state, MLO_STATE_DISABLED);
+    KUNIT_EXPECT_EQ(test, atomic_read(&dev->active_links), 0);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_teardown(dev, 1), -EINVAL);
+}
+
+static void mac_link_setup_fail_test(struct kunit *test)
+{
+    struct wifi7_mac_dev *dev = test->priv;
+
+    mac_kunit_hw(dev)->setup_ret = -EIO;
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_setup(dev, 0), -EIO);
+    KUNIT_EXPECT_FALSE(test, dev->links[0].enabled);
+    KUNIT_EXPECT_EQ(test, dev->links[0].mlo_state, MLO_STATE_ERROR);
+    KUNIT_EXPECT_EQ(test, atomic_read(&dev->active_links), 0);
+}
+
+static void mac_tx_link_down_test(struct kunit *test)
+{
+    struct wifi7_mac_dev *dev = test->priv;
+    struct sk_buff *skb = mac_kunit_skb(test, 100);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_tx_frame(dev, skb, 2), -EINVAL);
+    KUNIT_EXPECT_EQ(test, wifi7_mac_tx_frame(dev, NULL, 2), -EINVAL);
+    KUNIT_EXPECT_EQ(test, mac_kunit_hw(dev)->tx_calls, 0);
+    KUNIT_EXPECT_EQ(test, dev->links[2].tx_packets, 0ULL);
+
+    kfree_skb(skb);
+}
+
+static void mac_tx_accounting_test(struct kunit *test)
+{
+    struct wifi7_mac_dev *dev = test->priv;
+    struct sk_buff *skb = mac_kunit_skb(test, 100);
+    struct wifi7_link_state *link = &dev->links[2];
+
+    KUNIT_ASSERT_EQ(test, wifi7_mac_link_setup(dev, 2), 0);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_tx_frame(dev, skb, 2), 0);
+    KUNIT_EXPECT_EQ(test, wifi7_mac_tx_frame(dev, skb, 2), 0);
+    KUNIT_EXPECT_EQ(test, mac_kunit_hw(dev)->tx_calls, 2);
+    KUNIT_EXPECT_EQ(test, link->tx_packets, 2ULL);
+    KUNIT_EXPECT_EQ(test, link->tx_bytes, 200ULL);
+    KUNIT_EXPECT_EQ(test, link->tx_errors, 0ULL);
+
+    /* A hardware refusal is counted as an error on top of the attempt */
+    mac_kunit_hw(dev)->tx_ret = -EBUSY;
+    KUNIT_EXPECT_EQ(test, wifi7_mac_tx_frame(dev, skb, 2), -EBUSY);
+    KUNIT_EXPECT_EQ(test, link->tx_packets, 3ULL);
+    KUNIT_EXPECT_EQ(test, link->tx_errors, 1ULL);
+
+    /* Other links are untouched */
+    KUNIT_EXPECT_EQ(test, dev->links[1].tx_packets, 0ULL);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mac_link_teardown(dev, 2), 0);
+    KUNIT_EXPECT_EQ(test, wifi7_mac_tx_frame(dev, skb, 2), -EINVAL);
+
+    kfree_skb(skb);
+}
+
+static void mac_bench_tx_frame(struct kunit *test)
+{
+    struct wifi7_mac_dev *dev = test->priv;
+    struct sk_buff *skb = mac_kunit_skb(test, 1500);
+
+    KUNIT_ASSERT_EQ(test, wifi7_mac_link_setup(dev, 0), 0);
+
+    WIFI67_BENCH(test, "mac.tx_frame", wifi7_mac_tx_frame(dev, skb, 0),
+                 (void)0);
+
+    KUNIT_EXPECT_EQ(test, dev->links[0].tx_packets,
+                    (u64)WIFI67_BENCH_BATCHES * WIFI67_BENCH_BATCH);
+
+    kfree_skb(skb);
+}
+
+static struct kunit_case wifi7_mac_test_cases[] = {
+    KUNIT_CASE(mac_link_state_test),
+    KUNIT_CASE(mac_link_setup_fail_test),
+    KUNIT_CASE(mac_tx_link_down_test),
+    KUNIT_CASE(mac_tx_accounting_test),
+    KUNIT_CASE_SLOW(mac_bench_tx_frame),
+    {}
+};
+
+static struct kunit_suite wifi7_mac_test_suite = {
+    .name = "wifi67_mac",
+    .init = mac_kunit_init,
+    .exit = mac_kunit_exit,
+    .test_cases = wifi7_mac_test_cases,
+};
+
+kunit_test_suite(wifi7_mac_test_suite);
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for MLO link selection policies.
+ * Included from src/mac/wifi7_mlo.c.
+ */
+
+#include "wifi67_kunit.h"
+
+#define MLO_KUNIT_LINKS     4
+
+struct mlo_kunit_link {
+    bool enabled;
+    u32 rssi;
+    u32 airtime;
+    u32 latency;
+    u32 loss;
+    u32 tx_rate;
+};
+
+static struct wifi7_mlo *mlo_kunit_alloc(struct kunit *test,
+                                         const struct mlo_kunit_link *links,
+                                         int n, u8 active)
+{
+    struct wifi7_mlo *mlo;
+    int i;
+
+    mlo = kunit_kzalloc(test, sizeof(*mlo), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, mlo);
+
+    mlo->config.num_links = n;
+    mlo->link.active_link = active;
+    for (i = 0; i < n; i++) {
+        struct wifi7_mlo_metrics *m = &mlo->link.metrics[i];
+
+        mlo->config.links[i].link_id = i;
+        mlo->config.links[i].enabled = links[i].enabled;
+        m->rssi = links[i].rssi;
+        m->airtime = links[i].airtime;
+        m->latency = links[i].latency;
+        m->loss = links[i].loss;
+        m->tx_rate = links[i].tx_rate;
+    }
+
+    return mlo;
+}
+
+static const struct mlo_kunit_link mlo_kunit_links[MLO_KUNIT_LINKS] = {
+    { .enabled = true,  .rssi = 40, .airtime = 70, .latency = 900, .loss = 9, .tx_rate = 600 },
+    { .enabled = true,  .rssi = 70, .airtime = 50, .latency = 300, .loss = 2, .tx_rate = 2400 },
+    { .enabled = true,  .rssi = 55, .airtime = 10, .latency = 100, .loss = 1, .tx_rate = 1200 },
+    { .enabled = false, .rssi = 90, .airtime = 0,  .latency = 1,   .loss = 0, .tx_rate = 5760 },
+};
+
+static void mlo_select_rssi_test(struct kunit *test)
+{
+    struct wifi7_mlo *mlo = mlo_kunit_alloc(test, mlo_kunit_links,
+                                            MLO_KUNIT_LINKS, 0);
+
+    /* Link 3 is strongest but disabled */
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_rssi(mlo), 1);
+}
+
+static void mlo_select_load_test(struct kunit *test)
+{
+    struct wifi7_mlo *mlo = mlo_kunit_alloc(test, mlo_kunit_links,
+                                            MLO_KUNIT_LINKS, 0);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_load(mlo), 2);
+}
+
+static void mlo_select_latency_test(struct kunit *test)
+{
+    struct wifi7_mlo *mlo = mlo_kunit_alloc(test, mlo_kunit_links,
+                                            MLO_KUNIT_LINKS, 0);
+
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_latency(mlo), 2);
+}
+
+static void mlo_select_ml_test(struct kunit *test)
+{
+    struct wifi7_mlo *mlo = mlo_kunit_alloc(test, mlo_kunit_links,
+                                            MLO_KUNIT_LINKS, 0);
+
+    /* Link 1's rate outweighs link 2's lower latency and load */
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_ml(mlo), 1);
+}
+
+static void mlo_select_ml_saturate_test(struct kunit *test)
+{
+    static const struct mlo_kunit_link links[] = {
+        { .enabled = true, .rssi = 50, .airtime = 20, .latency = 20, .loss = 1, .tx_rate = 1000 },
+        { .enabled = true, .rssi = 50, .airtime = 150, .latency = 50000, .loss = 120, .tx_rate = 1000 },
+    };
+    struct wifi7_mlo *mlo = mlo_kunit_alloc(test, links, ARRAY_SIZE(links), 0);
+
+    /* Out-of-range readings score worst, not best */
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_ml(mlo), 0);
+}
+
+static void mlo_select_none_enabled_test(struct kunit *test)
+{
+    struct mlo_kunit_link links[MLO_KUNIT_LINKS];
+    struct wifi7_mlo *mlo;
+    int i;
+
+    memcpy(links, mlo_kunit_links, sizeof(links));
+    for (i = 0; i < MLO_KUNIT_LINKS; i++)
+        links[i].enabled = false;
+    mlo = mlo_kunit_alloc(test, links, MLO_KUNIT_LINKS, 2);
+
+    /* With nothing to choose from every policy keeps the current link */
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_rssi(mlo), 2);
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_load(mlo), 2);
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_latency(mlo), 2);
+    KUNIT_EXPECT_EQ(test, wifi7_mlo_select_ml(mlo), 2);
+}
+
+static void mlo_bench_select(struct kunit *test)
+{
+    struct wifi7_mlo *mlo = mlo_kunit_alloc(test, mlo_kunit_links,
+                                            MLO_KUNIT_LINKS, 0);
+    u8 link = 0;
+
+    WIFI67_BENCH(test, "mlo.select_rssi", link = wifi7_mlo_select_rssi(mlo),
+                 (void)0);
+    WIFI67_BENCH(test, "mlo.select_load", link = wifi7_mlo_select_load(mlo),
+                 (void)0);
+    WIFI67_BENCH(test, "mlo.select_latency",
+                 link = wifi7_mlo_select_latency(mlo), (void)0);
+    WIFI67_BENCH(test, "mlo.select_ml", link = wifi7_mlo_select_ml(mlo),
+                 (void)0);
+
+    KUNIT_EXPECT_LT(test, link, MLO_KUNIT_LINKS);
+}
+
+static struct kunit_case wifi7_mlo_test_cases[] = {
+    KUNIT_CASE(mlo_select_rssi_test),
+    KUNIT_CASE(mlo_select_load_test),
+    KUNIT_CASE(mlo_select_latency_test),
+    KUNIT_CASE(mlo_select_ml_test),
+    KUNIT_CASE(mlo_select_ml_saturate_test),
+    KUNIT_CASE(mlo_select_none_enabled_test),
+    KUNIT_CASE_SLOW(mlo_bench_select),
+    {}
+};
+
+static struct kunit_suite wifi7_mlo_test_suite = {
+    .name = "wifi67_mlo",
+    .test_cases = wifi7_mlo_test_cases,
+};
+
+kunit_test_suite(wifi7_mlo_test_suite);
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for the QoS token bucket shaper and DRR scheduler.
+ * Included from src/mac/wifi7_qos.c.
+ */
+
+#include "wifi67_kunit.h"
+
+#define QOS_KUNIT_FRAME_LEN     1000
+
+/* A queue set up like wifi7_qos_init() but without the periodic work */
+static struct wifi7_qos *qos_kunit_alloc(struct kunit *test)
+{
+    struct wifi7_qos *qos;
+    int i, j;
+
+    qos = kunit_kzalloc(test, sizeof(*qos), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, qos);
+
+    spin_lock_init(&qos->lock);
+    for (i = 0; i < WIFI7_MAX_LINKS; i++)
+        for (j = 0; j < WIFI7_NUM_TIDS; j++)
+            skb_queue_head_init(&qos->links[i].queues[j]);
+
+    for (i = 0; i < WIFI7_NUM_TIDS; i++) {
+        struct wifi7_shaper *sh = &qos->tids[i].shaper;
+
+        spin_lock_init(&sh->lock);
+        sh->rate = WIFI7_MAX_RATE_BPS;
+        sh->burst = WIFI7_MAX_BURST;
+        sh->tokens = (u64)sh->burst << WIFI7_TOKEN_SHIFT;
+        sh->last_update = ktime_get();
+        qos->quantum[i] = 256 << (i / 2);
+    }
+
+    return qos;
+}
+
+static void qos_kunit_free(struct wifi7_qos *qos)
+{
+    int i, j;
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++)
+        for (j = 0; j < WIFI7_NUM_TIDS; j++)
+            skb_queue_purge(&qos->links[i].queues[j]);
+}
+
+static void qos_kunit_enqueue(struct kunit *test, struct wifi7_qos *qos,
+                              u8 link, u8 tid, int count)
+{
+    struct sk_buff *skb;
+
+    while (count--) {
+        skb = alloc_skb(QOS_KUNIT_FRAME_LEN, GFP_KERNEL);
+        KUNIT_ASSERT_NOT_NULL(test, skb);
+        skb_put(skb, QOS_KUNIT_FRAME_LEN);
+        skb->priority = tid;
+        skb_queue_tail(&qos->links[link].queues[tid], skb);
+        qos->tids[tid].queue_len++;
+    }
+    qos->tids[tid].active = true;
+}
+
+/* A frozen bucket: no refill, so only the initial tokens count */
+static void qos_kunit_shaper_freeze(struct wifi7_shaper *sh, u32 tokens)
+{
+    sh->rate = 0;
+    sh->burst = tokens;
+    sh->tokens = (u64)tokens << WIFI7_TOKEN_SHIFT;
+    sh->last_update = ktime_get();
+}
+
+static void qos_shaper_burst_test(struct kunit *test)
+{
+    struct wifi7_shaper sh = {};
+
+    spin_lock_init(&sh.lock);
+    qos_kunit_shaper_freeze(&sh, 3000);
+
+    KUNIT_EXPECT_TRUE(test, wifi7_shaper_allow(&sh, 1500));
+    KUNIT_EXPECT_TRUE(test, wifi7_shaper_allow(&sh, 1500));
+    KUNIT_EXPECT_FALSE(test, wifi7_shaper_allow(&sh, 1));
+    KUNIT_EXPECT_EQ(test, sh.tokens >> WIFI7_TOKEN_SHIFT, 0ULL);
+}
+
+static void qos_shaper_overhead_test(struct kunit *test)
+{
+    struct wifi7_shaper sh = {};
+
+    spin_lock_init(&sh.lock);
+    qos_kunit_shaper_freeze(&sh, 1000);
+    sh.mpu = 256;
+    sh.overhead = 24;
+
+    /* Small frames are charged the minimum policed unit */
+    KUNIT_EXPECT_TRUE(test, wifi7_shaper_allow(&sh, 64));
+    KUNIT_EXPECT_EQ(test, sh.tokens >> WIFI7_TOKEN_SHIFT, 744ULL);
+
+    /* Larger ones pay the per-frame overhead on top of their length */
+    KUNIT_EXPECT_TRUE(test, wifi7_shaper_allow(&sh, 500));
+    KUNIT_EXPECT_EQ(test, sh.tokens >> WIFI7_TOKEN_SHIFT, 220ULL);
+    KUNIT_EXPECT_FALSE(test, wifi7_shaper_allow(&sh, 200));
+}
+
+static void qos_shaper_refill_test(struct kunit *test)
+{
+    struct wifi7_shaper sh = {};
+
+    spin_lock_init(&sh.lock);
+    qos_kunit_shaper_freeze(&sh, 0);
+
+    /* One token (byte) per microsecond, capped at the burst size */
+    sh.rate = WIFI7_TOKEN_SCALE;
+    sh.burst = 1000;
+    sh.last_update = ktime_sub_us(ktime_get(), 5000);
+
+    KUNIT_EXPECT_TRUE(test, wifi7_shaper_allow(&sh, 1000));
+    KUNIT_EXPECT_FALSE(test, wifi7_shaper_allow(&sh, 1000));
+}
+
+static void qos_drr_inactive_test(struct kunit *test)
+{
+    struct wifi7_qos *qos = qos_kunit_alloc(test);
+
+    qos_kunit_enqueue(test, qos, 0, 3, 1);
+    qos->tids[3].active = false;
+
+    KUNIT_EXPECT_NULL(test, wifi7_drr_dequeue(qos, 0));
+    KUNIT_EXPECT_EQ(test, qos->tids[3].queue_len, 1U);
+
+    qos_kunit_free(qos);
+}
+
+static void qos_drr_no_starvation_test(struct kunit *test)
+{
+    struct wifi7_qos *qos = qos_kunit_alloc(test);
+    struct sk_buff *skb;
+    int served[WIFI7_NUM_TIDS] = {};
+    int i;
+
+    /* Frames larger than the quantum drive the deficit negative */
+    qos_kunit_enqueue(test, qos, 0, 0, 16);
+    qos_kunit_enqueue(test, qos, 0, 1, 16);
+
+    for (i = 0; i < 8; i++) {
+        skb = wifi7_drr_dequeue(qos, 0);
+        KUNIT_ASSERT_NOT_NULL(test, skb);
+        served[skb->priority]++;
+        kfree_skb(skb);
+    }
+
+    KUNIT_EXPECT_GT(test, served[0], 0);
+    KUNIT_EXPECT_GT(test, served[1], 0);
+    KUNIT_EXPECT_EQ(test, served[0] + served[1], 8);
+    KUNIT_EXPECT_EQ(test, qos->tids[0].queue_len + qos->tids[1].queue_len, 24U);
+
+    qos_kunit_free(qos);
+}
+
+static void qos_drr_shaper_hold_test(struct kunit *test)
+{
+    struct wifi7_qos *qos = qos_kunit_alloc(test);
+    struct sk_buff *head;
+
+    qos_kunit_enqueue(test, qos, 0, 2, 2);
+    qos_kunit_shaper_freeze(&qos->tids[2].shaper, 0);
+    head = skb_peek(&qos->links[0].queues[2]);
+
+    /* A held frame goes back to the head of its queue, order intact */
+    KUNIT_EXPECT_NULL(test, wifi7_drr_dequeue(qos, 0));
+    KUNIT_EXPECT_PTR_EQ(test, skb_peek(&qos->links[0].queues[2]), head);
+    KUNIT_EXPECT_EQ(test, qos->tids[2].queue_len, 2U);
+    KUNIT_EXPECT_EQ(test, qos->tids[2].packets_in_flight, 0U);
+    KUNIT_EXPECT_EQ(test, qos->tids[2].bytes_in_flight, 0U);
+
+    qos_kunit_free(qos);
+}
+
+static void qos_bench_shaper_allow(struct kunit *test)
+{
+    struct wifi7_shaper sh = {};
+
+    spin_lock_init(&sh.lock);
+    sh.rate = WIFI7_MAX_RATE_BPS;
+    sh.burst = WIFI7_MAX_BURST;
+    sh.tokens = (u64)sh.burst << WIFI7_TOKEN_SHIFT;
+    sh.last_update = ktime_get();
+
+    WIFI67_BENCH(test, "qos.shaper_allow", wifi7_shaper_allow(&sh, 64),
+                 sh.tokens = (u64)sh.burst << WIFI7_TOKEN_SHIFT);
+}
+
+static void qos_bench_drr_dequeue(struct kunit *test)
+{
+    struct wifi7_qos *qos = qos_kunit_alloc(test);
+    struct sk_buff *skb;
+    int tid;
+
+    for (tid = 0; tid < WIFI7_NUM_TIDS; tid++)
+        qos_kunit_enqueue(test, qos, 0, tid, 4);
+
+    /* Each dequeued frame is put back so the backlog stays constant */
+    WIFI67_BENCH(test, "qos.drr_dequeue",
+                 ({
+                     skb = wifi7_drr_dequeue(qos, 0);
+                     if (skb) {
+                         tid = skb->priority;
+                         skb_queue_tail(&qos->links[0].queues[tid], skb);
+                         qos->tids[tid].queue_len++;
+                     }
+                 }),
+                 memset(qos->deficit, 0, sizeof(qos->deficit)));
+
+    qos_kunit_free(qos);
+}
+
+static struct kunit_case wifi7_qos_test_cases[] = {
+    KUNIT_CASE(qos_shaper_burst_test),
+    KUNIT_CASE(qos_shaper_overhead_test),
+    KUNIT_CASE(qos_shaper_refill_test),
+    KUNIT_CASE(qos_drr_inactive_test),
+    KUNIT_CASE(qos_drr_no_starvation_test),
+    KUNIT_CASE(qos_drr_shaper_hold_test),
+    KUNIT_CASE_SLOW(qos_bench_shaper_allow),
+    KUNIT_CASE_SLOW(qos_bench_drr_dequeue),
+    {}
+};
+
+static struct kunit_suite wifi7_qos_test_suite = {
+    .name = "wifi67_qos",
+    .test_cases = wifi7_qos_test_cases,
+};
+
+kunit_test_suite(wifi7_qos_test_suite);
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+/*
+ * KUnit tests for the benchmark statistics and the baseline gate.
+ * Included from hardware_support/tests/test_framework.c.
+ */
+
+#include "wifi67_kunit.h"
+
+static void bench_compute_stats_test(struct kunit *test)
+{
+    u64 samples[] = { 5, 1, 4, 2, 3 };
+    struct test_bench_stats st;
+
+    test_bench_compute(samples, ARRAY_SIZE(samples), 1000, &st);
+
+    /* Samples are sorted in place; stddev is over n - 1 */
+    KUNIT_EXPECT_EQ(test, samples[0], 1ULL);
+    KUNIT_EXPECT_EQ(test, samples[4], 5ULL);
+    KUNIT_EXPECT_EQ(test, st.samples, 5ULL);
+    KUNIT_EXPECT_EQ(test, st.mean, 3ULL);
+    KUNIT_EXPECT_EQ(test, st.stddev, 1ULL);
+    KUNIT_EXPECT_EQ(test, st.min, 1ULL);
+    KUNIT_EXPECT_EQ(test, st.p50, 3ULL);
+    KUNIT_EXPECT_EQ(test, st.p90, 4ULL);
+    KUNIT_EXPECT_EQ(test, st.p99, 4ULL);
+    KUNIT_EXPECT_EQ(test, st.max, 5ULL);
+    KUNIT_EXPECT_EQ(test, st.ops_per_sec, 5000000ULL);
+}
+
+static void bench_compute_percentile_test(struct kunit *test)
+{
+    struct test_bench_stats st;
+    u64 *samples;
+    int i;
+
+    samples = kunit_kmalloc_array(test, 100, sizeof(*samples), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, samples);
+    for (i = 0; i < 100; i++)
+        samples[i] = 100 - i;
+
+    /* Nearest rank below, so p99 of 1..100 is 99 */
+    test_bench_compute(samples, 100, 0, &st);
+    KUNIT_EXPECT_EQ(test, st.mean, 50ULL);
+    KUNIT_EXPECT_EQ(test, st.p50, 50ULL);
+    KUNIT_EXPECT_EQ(test, st.p90, 90ULL);
+    KUNIT_EXPECT_EQ(test, st.p99, 99ULL);
+    KUNIT_EXPECT_EQ(test, st.max, 100ULL);
+    KUNIT_EXPECT_EQ(test, st.ops_per_sec, 0ULL);
+}
+
+static void bench_compute_edge_test(struct kunit *test)
+{
+    u64 one = 42, wide[] = { 0, 10 * NSEC_PER_SEC };
+    struct test_bench_stats st;
+
+    test_bench_compute(NULL, 0, 1000, &st);
+    KUNIT_EXPECT_EQ(test, st.samples, 0ULL);
+    KUNIT_EXPECT_EQ(test, st.mean, 0ULL);
+    KUNIT_EXPECT_EQ(test, st.ops_per_sec, 0ULL);
+
+    test_bench_compute(&one, 1, NSEC_PER_SEC, &st);
+    KUNIT_EXPECT_EQ(test, st.stddev, 0ULL);
+    KUNIT_EXPECT_EQ(test, st.min, 42ULL);
+    KUNIT_EXPECT_EQ(test, st.p99, 42ULL);
+    KUNIT_EXPECT_EQ(test, st.max, 42ULL);
+    KUNIT_EXPECT_EQ(test, st.ops_per_sec, 1ULL);
+
+    /* Deviations of 5 s: the variance saturates instead of wrapping */
+    test_bench_compute(wide, ARRAY_SIZE(wide), 0, &st);
+    KUNIT_EXPECT_EQ(test, st.mean, (u64)5 * NSEC_PER_SEC);
+    KUNIT_EXPECT_EQ(test, st.stddev, (u64)U32_MAX);
+}
+
+static void bench_regressed_test(struct kunit *test)
+{
+    /* Lower is better: up to the tolerance over the baseline passes */
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(90, 100, 10, false));
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(110, 100, 10, false));
+    KUNIT_EXPECT_TRUE(test, test_bench_regressed(111, 100, 10, false));
+    KUNIT_EXPECT_TRUE(test, test_bench_regressed(101, 100, 0, false));
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(0, 0, 10, false));
+    KUNIT_EXPECT_TRUE(test, test_bench_regressed(1, 0, 10, false));
+
+    /* Higher is better: a drop beyond the tolerance fails */
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(200, 100, 10, true));
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(90, 100, 10, true));
+    KUNIT_EXPECT_TRUE(test, test_bench_regressed(89, 100, 10, true));
+
+    /* A tolerance of 100% or more never fails on a drop */
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(0, 100, 100, true));
+    KUNIT_EXPECT_FALSE(test, test_bench_regressed(0, 100, 250, true));
+}
+
+static struct kunit_case test_bench_test_cases[] = {
+    KUNIT_CASE(bench_compute_stats_test),
+    KUNIT_CASE(bench_compute_percentile_test),
+    KUNIT_CASE(bench_compute_edge_test),
+    KUNIT_CASE(bench_regressed_test),
+    {}
+};
+
+static struct kunit_suite test_bench_test_suite = {
+    .name = "wifi67_test_bench",
+    .test_cases = test_bench_test_cases,
+};
+
+kunit_test_suite(test_bench_test_suite);
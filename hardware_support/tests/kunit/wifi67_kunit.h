@@ -0,0 +1,80 @@
+#ifndef _WIFI67_KUNIT_H_
+#define _WIFI67_KUNIT_H_
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/sort.h>
+#include <linux/timex.h>
+
+/*
+ * Shared helpers for the KUnit suites. Each suite is #included at the end
+ * of the file it tests so it can reach static helpers and private
+ * structures; this header holds only what they have in common.
+ *
+ * Microbenchmarks time WIFI67_BENCH_BATCHES batches of WIFI67_BENCH_BATCH
+ * calls and report the per-call median, minimum and 99th percentile. The
+ * unit is cycles where get_cycles() works and nanoseconds elsewhere (UML).
+ * Every result is one KTAP diagnostic line starting with "bench:", so two
+ * kunit.py logs can be diffed in review.
+ */
+
+#define WIFI67_BENCH_BATCHES    64
+#define WIFI67_BENCH_BATCH      256
+
+static inline u64 wifi67_bench_now(void)
+{
+    cycles_t c = get_cycles();
+
+    return c ? c : ktime_get_ns();
+}
+
+static inline const char *wifi67_bench_unit(void)
+{
+    return get_cycles() ? "cycles" : "ns";
+}
+
+static inline int wifi67_bench_cmp(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static inline void wifi67_bench_report(struct kunit *test, const char *name,
+                                       u64 *batch, u32 nbatch, u32 per_batch)
+{
+    sort(batch, nbatch, sizeof(*batch), wifi67_bench_cmp, NULL);
+
+    kunit_info(test, "bench: %s median=%llu min=%llu p99=%llu %s/op\n",
+               name, div_u64(batch[nbatch / 2], per_batch),
+               div_u64(batch[0], per_batch),
+               div_u64(batch[nbatch * 99 / 100], per_batch),
+               wifi67_bench_unit());
+}
+
+/*
+ * Time @op, which may refer to the loop index _i. @reset runs outside the
+ * timed region after every batch, so stateful operations (ring fill,
+ * window advance) start each batch from the same state.
+ */
+#define WIFI67_BENCH(test, name, op, reset)                                 \
+do {                                                                        \
+    u64 *_batch = kunit_kcalloc(test, WIFI67_BENCH_BATCHES,                 \
+                                sizeof(u64), GFP_KERNEL);                   \
+    u64 _t0;                                                                \
+    int _b, _i;                                                             \
+                                                                            \
+    KUNIT_ASSERT_NOT_NULL(test, _batch);                                    \
+    for (_b = 0; _b < WIFI67_BENCH_BATCHES; _b++) {                         \
+        _t0 = wifi67_bench_now();                                           \
+        for (_i = 0; _i < WIFI67_BENCH_BATCH; _i++) {                       \
+            op;                                                             \
+        }                                                                   \
+        _batch[_b] = wifi67_bench_now() - _t0;                              \
+        reset;                                                              \
+    }                                                                       \
+    wifi67_bench_report(test, name, _batch, WIFI67_BENCH_BATCHES,           \
+                        WIFI67_BENCH_BATCH);                                \
+} while (0)
+
+#endif /* _WIFI67_KUNIT_H_ */
@@ -298,6 +298,7 @@ static void __exit mac_test_module_exit(void)
     get_test_results(&results);
     pr_info("MAC tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
+    UNREGISTER_TESTS();
     mac_test_cleanup(NULL); /* ctx is managed by test framework */
 }
 
@@ -406,6 +406,8 @@ static void __exit mlo_test_module_exit(void)
     pr_info("MLO tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     mlo_test_cleanup(NULL);
 }
@@ -490,6 +490,8 @@ static void __exit mumimo_test_module_exit(void)
     pr_info("MU-MIMO tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     mumimo_test_cleanup(NULL);
 }
@@ -522,6 +522,8 @@ static void __exit multi_ru_test_module_exit(void)
     pr_info("Multi-RU tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     ru_test_cleanup(NULL);
 }
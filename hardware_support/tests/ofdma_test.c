@@ -408,6 +408,8 @@ static void __exit ofdma_test_module_exit(void)
     pr_info("OFDMA tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     ofdma_test_cleanup(NULL);
 }
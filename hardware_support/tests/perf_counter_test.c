@@ -0,0 +1,182 @@
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/cpumask.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/atomic.h>
+#include "../../include/perf/perf_counters.h"
+#include "test_framework.h"
+
+/*
+ * Data path counter benchmark. One thread per CPU counts packets as fast
+ * as it can, first into shared atomics (the old scheme, all CPUs hitting
+ * one cache line) and then into the per-CPU counters, and reports the
+ * cost per update of each. The totals are checked after folding.
+ */
+
+#define PERF_CNT_PKT_LEN    1500
+
+static unsigned int num_cpus;
+module_param(num_cpus, uint, 0444);
+MODULE_PARM_DESC(num_cpus, "CPUs to run on (0 = all online)");
+
+static unsigned int iterations = 1000000;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Packets counted per CPU per measurement");
+
+/* The old layout: every counter shared by all CPUs */
+struct perf_cnt_shared {
+    atomic64_t tx_packets;
+    atomic64_t tx_bytes;
+};
+
+struct perf_cnt_run {
+    struct perf_cnt_shared *shared;
+    struct wifi67_perf_counters *counters;
+    u64 *ns;                    /* Per thread */
+};
+
+static void perf_cnt_thread_fn(void *data, unsigned int thread)
+{
+    struct perf_cnt_run *run = data;
+    unsigned int i;
+    u64 start;
+
+    start = ktime_get_ns();
+    if (run->shared) {
+        for (i = 0; i < iterations; i++) {
+            atomic64_inc(&run->shared->tx_packets);
+            atomic64_add(PERF_CNT_PKT_LEN, &run->shared->tx_bytes);
+        }
+    } else {
+        for (i = 0; i < iterations; i++)
+            wifi67_perf_add_packet(run->counters, WIFI67_PERF_TX_PACKETS,
+                                   PERF_CNT_PKT_LEN);
+    }
+    run->ns[thread] = ktime_get_ns() - start;
+}
+
+/* Run one thread per CPU; returns the mean ns per update, scaled by 1000 */
+static int perf_cnt_run(struct perf_cnt_shared *shared,
+                        struct wifi67_perf_counters *counters,
+                        unsigned int *nr_cpus, u64 *ps_per_op)
+{
+    struct perf_cnt_run run = { .shared = shared, .counters = counters };
+    unsigned int max = test_nr_threads(num_cpus);
+    u64 total_ns = 0;
+    int i, nr;
+
+    run.ns = kcalloc(max, sizeof(*run.ns), GFP_KERNEL);
+    if (!run.ns)
+        return -ENOMEM;
+
+    nr = test_run_threads(perf_cnt_thread_fn, &run, max, "perf_cnt/%u", NULL);
+    for (i = 0; i < nr; i++)
+        total_ns += run.ns[i];
+    kfree(run.ns);
+
+    if (nr < 0)
+        return nr;
+
+    *nr_cpus = nr;
+    *ps_per_op = iterations ?
+                 div64_u64(total_ns * 1000, (u64)nr * iterations) : 0;
+    return 0;
+}
+
+/* Test cases */
+static int test_perf_counter_fold(void *data)
+{
+    struct wifi67_perf_counters counters;
+    struct wifi67_perf_snapshot snap;
+    unsigned int nr_cpus;
+    u64 ps;
+    int ret;
+
+    ret = wifi67_perf_counters_init(&counters);
+    if (ret)
+        TEST_SKIP("Counter allocation failed: %d", ret);
+
+    ret = perf_cnt_run(NULL, &counters, &nr_cpus, &ps);
+    wifi67_perf_add(&counters, WIFI67_PERF_RX_ERRORS, 3);
+    wifi67_perf_counters_read(&counters, &snap);
+    wifi67_perf_counters_free(&counters);
+
+    TEST_ASSERT(ret == 0, "Counter run failed: %d", ret);
+    TEST_ASSERT(snap.cnt[WIFI67_PERF_TX_PACKETS] == (u64)nr_cpus * iterations,
+                "Folded %llu packets, expected %llu",
+                snap.cnt[WIFI67_PERF_TX_PACKETS], (u64)nr_cpus * iterations);
+    TEST_ASSERT(snap.cnt[WIFI67_PERF_TX_BYTES] ==
+                (u64)nr_cpus * iterations * PERF_CNT_PKT_LEN,
+                "Folded %llu bytes", snap.cnt[WIFI67_PERF_TX_BYTES]);
+    TEST_ASSERT(snap.cnt[WIFI67_PERF_RX_ERRORS] == 3,
+                "Folded %llu RX errors", snap.cnt[WIFI67_PERF_RX_ERRORS]);
+    TEST_PASS();
+}
+
+static int test_perf_counter_bench(void *data)
+{
+    struct wifi67_perf_counters counters;
+    struct perf_cnt_shared *shared;
+    unsigned int nr_cpus;
+    u64 atomic_ps, pcpu_ps;
+    int ret;
+
+    shared = kzalloc(sizeof(*shared), GFP_KERNEL);
+    if (!shared)
+        TEST_SKIP("Allocation failed");
+
+    ret = perf_cnt_run(shared, NULL, &nr_cpus, &atomic_ps);
+    kfree(shared);
+    TEST_ASSERT(ret == 0, "Shared atomic run failed: %d", ret);
+
+    ret = wifi67_perf_counters_init(&counters);
+    if (ret)
+        TEST_SKIP("Counter allocation failed: %d", ret);
+    ret = perf_cnt_run(NULL, &counters, &nr_cpus, &pcpu_ps);
+    wifi67_perf_counters_free(&counters);
+    TEST_ASSERT(ret == 0, "Per-CPU run failed: %d", ret);
+
+    pr_info("perf_counter: %u cpus: shared atomic %llu.%03llu ns/pkt, per-cpu %llu.%03llu ns/pkt\n",
+            nr_cpus, atomic_ps / 1000, atomic_ps % 1000,
+            pcpu_ps / 1000, pcpu_ps % 1000);
+    TEST_PASS();
+}
+
+/* Module initialization */
+static int __init perf_counter_test_module_init(void)
+{
+    pr_info("perf_counter: %u cpus, %u packets per cpu\n",
+            num_cpus ? num_cpus : num_online_cpus(), iterations);
+
+    REGISTER_TEST("perf_counter_fold",
+                 "Verify per-CPU counters fold to exact totals",
+                 test_perf_counter_fold, NULL, 0);
+
+    REGISTER_TEST("perf_counter_bench",
+                 "Compare shared atomic and per-CPU counter update cost",
+                 test_perf_counter_bench, NULL,
+                 TEST_FLAG_BENCHMARK | TEST_FLAG_SLOW);
+
+    return 0;
+}
+
+static void __exit perf_counter_test_module_exit(void)
+{
+    struct test_results results;
+
+    get_test_results(&results);
+    pr_info("Perf counter tests completed: %d passed, %d failed, %d skipped\n",
+            results.passed, results.failed, results.skipped);
+
+    UNREGISTER_TESTS();
+}
+
+module_init(perf_counter_test_module_init);
+module_exit(perf_counter_test_module_exit);
+
+MODULE_LICENSE("MIT");
+MODULE_AUTHOR("Fayssal Chokri");
+MODULE_DESCRIPTION("WiFi 6E/7 Per-CPU Performance Counter Benchmark");
+MODULE_VERSION("1.0");
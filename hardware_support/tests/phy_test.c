@@ -293,6 +293,7 @@ static void __exit phy_test_module_exit(void)
     get_test_results(&results);
     pr_info("PHY tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
+    UNREGISTER_TESTS();
     phy_test_cleanup(NULL); /* ctx is managed by test framework */
 }
 
@@ -316,6 +316,7 @@ static void __exit power_test_module_exit(void)
     get_test_results(&results);
     pr_info("Power management tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
+    UNREGISTER_TESTS();
     power_test_cleanup(NULL); /* ctx is managed by test framework */
 }
 
@@ -548,6 +548,8 @@ static void __exit pp_test_module_exit(void)
     pr_info("Preamble Puncturing tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     pp_test_cleanup(NULL);
 }
@@ -338,6 +338,8 @@ static void __exit qam_test_module_exit(void)
     pr_info("QAM tests completed: %d passed, %d failed, %d skipped\n",
             results.passed, results.failed, results.skipped);
 
+    UNREGISTER_TESTS();
+
     /* Cleanup is handled by test framework */
     qam_test_cleanup(NULL);
 }
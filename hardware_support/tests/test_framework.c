@@ -7,8 +7,29 @@
 #include <linux/completion.h>
 #include <linux/workqueue.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/kthread.h>
+#include <linux/cpumask.h>
+#include <linux/sort.h>
+#include <linux/math64.h>
+#include <linux/overflow.h>
+#include <linux/uaccess.h>
 #include "test_framework.h"
 
+#define TEST_NAME_MAX       64
+
+static unsigned int bench_warmup = TEST_BENCH_DEF_WARMUP;
+module_param(bench_warmup, uint, 0644);
+MODULE_PARM_DESC(bench_warmup, "Benchmark warmup iterations per thread");
+
+static unsigned int bench_iterations = TEST_BENCH_DEF_ITERATIONS;
+module_param(bench_iterations, uint, 0644);
+MODULE_PARM_DESC(bench_iterations, "Benchmark measured iterations per thread");
+
+static unsigned int bench_tolerance = TEST_BENCH_DEF_TOLERANCE;
+module_param(bench_tolerance, uint, 0644);
+MODULE_PARM_DESC(bench_tolerance, "Allowed regression against the baseline, in percent");
+
 /* Test case management */
 static LIST_HEAD(test_cases);
 static DEFINE_MUTEX(test_lock);
@@ -25,6 +46,29 @@ static struct test_stats {
     ktime_t end_time;
 } stats;
 
+/* Stored benchmark results to gate against, loaded through debugfs */
+struct test_baseline {
+    struct list_head list;
+    char name[TEST_NAME_MAX];
+    u64 mean;
+    u64 p99;
+};
+
+static LIST_HEAD(test_baselines);
+
+struct test_bench {
+    test_bench_func_t func;
+    struct test_bench_params params;
+    unsigned int warmup;
+    unsigned int iterations;
+
+    /* Last run, under test_lock */
+    bool has_stats;
+    unsigned int nr_threads;
+    struct test_bench_stats stats;
+    struct test_bench_stats *thread_stats;
+};
+
 /* Test case structure */
 struct test_case {
     struct list_head list;
@@ -38,6 +82,17 @@ struct test_case {
     ktime_t start_time;
     ktime_t end_time;
     unsigned long flags;
+    struct test_bench *bench;
+    struct module *owner;
+};
+
+struct test_bench_thread {
+    struct test_case *test;
+    unsigned int id;
+    int cpu;
+    u64 *samples;
+    u64 elapsed_ns;
+    int result;
 };
 
 /* Test work structure */
@@ -46,6 +101,10 @@ struct test_work {
     struct test_case *test;
 };
 
+static const struct file_operations test_run_fops;
+static const struct file_operations test_baseline_fops;
+static const struct file_operations test_bench_results_fops;
+
 /* Initialize test framework */
 int test_framework_init(void)
 {
@@ -68,6 +127,11 @@ int test_framework_init(void)
                            &stats.failed_tests);
     debugfs_create_atomic_t("skipped_tests", 0444, test_dir,
                            &stats.skipped_tests);
+    debugfs_create_file("run", 0200, test_dir, NULL, &test_run_fops);
+    debugfs_create_file("bench_baseline", 0600, test_dir, NULL,
+                        &test_baseline_fops);
+    debugfs_create_file("bench_results", 0444, test_dir, NULL,
+                        &test_bench_results_fops);
 
     /* Initialize statistics */
     atomic_set(&stats.total_tests, 0);
@@ -78,33 +142,43 @@ int test_framework_init(void)
     return 0;
 }
 
+static void test_case_free(struct test_case *test)
+{
+    list_del(&test->list);
+    if (test->bench)
+        kfree(test->bench->thread_stats);
+    kfree(test->bench);
+    kfree(test->error_msg);
+    kfree(test);
+}
+
 /* Cleanup test framework */
 void test_framework_exit(void)
 {
+    struct test_baseline *base, *btmp;
     struct test_case *test, *tmp;
 
+    debugfs_remove_recursive(test_dir);
+
     mutex_lock(&test_lock);
-    list_for_each_entry_safe(test, tmp, &test_cases, list) {
-        list_del(&test->list);
-        kfree(test->error_msg);
-        kfree(test);
+    list_for_each_entry_safe(test, tmp, &test_cases, list)
+        test_case_free(test);
+    list_for_each_entry_safe(base, btmp, &test_baselines, list) {
+        list_del(&base->list);
+        kfree(base);
     }
     mutex_unlock(&test_lock);
 
-    debugfs_remove_recursive(test_dir);
     destroy_workqueue(test_wq);
 }
 
-/* Register a test case */
-int register_test_case(const char *name, const char *description,
-                      test_func_t test_func, void *test_data,
-                      unsigned long flags)
+static int test_case_add(const char *name, const char *description,
+                         test_func_t test_func, void *test_data,
+                         unsigned long flags, struct test_bench *bench,
+                         struct module *owner)
 {
     struct test_case *test;
 
-    if (!name || !test_func)
-        return -EINVAL;
-
     test = kzalloc(sizeof(*test), GFP_KERNEL);
     if (!test)
         return -ENOMEM;
@@ -114,6 +188,8 @@ int register_test_case(const char *name, const char *description,
     test->test_func = test_func;
     test->test_data = test_data;
     test->flags = flags;
+    test->bench = bench;
+    test->owner = owner;
     init_completion(&test->done);
 
     mutex_lock(&test_lock);
@@ -124,15 +200,466 @@ int register_test_case(const char *name, const char *description,
     return 0;
 }
 
+/* Register a test case */
+int __register_test_case(const char *name, const char *description,
+                         test_func_t test_func, void *test_data,
+                         unsigned long flags, struct module *owner)
+{
+    if (!name || !test_func)
+        return -EINVAL;
+
+    return test_case_add(name, description, test_func, test_data, flags,
+                         NULL, owner);
+}
+
+/* Register a benchmark; @params is copied */
+int __register_bench_case(const char *name, const char *description,
+                          test_bench_func_t bench_func, void *test_data,
+                          const struct test_bench_params *params,
+                          unsigned long flags, struct module *owner)
+{
+    struct test_bench *bench;
+    int ret;
+
+    if (!name || !bench_func || !params ||
+        strlen(name) >= TEST_NAME_MAX)
+        return -EINVAL;
+
+    bench = kzalloc(sizeof(*bench), GFP_KERNEL);
+    if (!bench)
+        return -ENOMEM;
+
+    bench->func = bench_func;
+    bench->params = *params;
+    bench->params.threads = clamp(params->threads, 1U,
+                                  (unsigned int)TEST_BENCH_MAX_THREADS);
+    bench->thread_stats = kcalloc(bench->params.threads,
+                                  sizeof(*bench->thread_stats), GFP_KERNEL);
+    if (!bench->thread_stats) {
+        kfree(bench);
+        return -ENOMEM;
+    }
+
+    flags |= TEST_FLAG_BENCHMARK;
+    if (bench->params.threads > 1)
+        flags |= TEST_FLAG_STRESS;
+
+    ret = test_case_add(name, description, NULL, test_data, flags, bench,
+                        owner);
+    if (ret) {
+        kfree(bench->thread_stats);
+        kfree(bench);
+    }
+    return ret;
+}
+
+/*
+ * Unregister one test case, or every test case of @owner. Runs hold a
+ * reference on the owning module, so from its exit none is in flight.
+ */
+static void test_case_remove(const char *name, struct module *owner)
+{
+    struct test_case *test, *tmp;
+
+    mutex_lock(&test_lock);
+    list_for_each_entry_safe(test, tmp, &test_cases, list) {
+        if (name ? strcmp(test->name, name) : test->owner != owner)
+            continue;
+        test_case_free(test);
+        atomic_dec(&stats.total_tests);
+        if (name)
+            break;
+    }
+    mutex_unlock(&test_lock);
+}
+
+void unregister_test_case(const char *name)
+{
+    if (name)
+        test_case_remove(name, NULL);
+}
+
+void __unregister_test_cases(struct module *owner)
+{
+    test_case_remove(NULL, owner);
+}
+
+/* Benchmark mode */
+static int test_bench_cmp(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void test_bench_compute(u64 *samples, u64 n, u64 elapsed_ns,
+                               struct test_bench_stats *st)
+{
+    u64 sum = 0, var = 0, i;
+
+    memset(st, 0, sizeof(*st));
+    if (!n)
+        return;
+
+    sort(samples, n, sizeof(*samples), test_bench_cmp, NULL);
+
+    for (i = 0; i < n; i++)
+        sum += samples[i];
+    st->mean = div64_u64(sum, n);
+
+    /* Deviations beyond 4 s saturate, and so does the sum of squares */
+    for (i = 0; i < n; i++) {
+        u64 d = samples[i] > st->mean ? samples[i] - st->mean :
+                                        st->mean - samples[i];
+
+        d = min_t(u64, d, U32_MAX);
+        if (check_add_overflow(var, d * d, &var))
+            var = U64_MAX;
+    }
+
+    st->samples = n;
+    st->stddev = n > 1 ? int_sqrt64(div64_u64(var, n - 1)) : 0;
+    st->min = samples[0];
+    st->p50 = samples[div64_u64((n - 1) * 50, 100)];
+    st->p90 = samples[div64_u64((n - 1) * 90, 100)];
+    st->p99 = samples[div64_u64((n - 1) * 99, 100)];
+    st->max = samples[n - 1];
+    st->ops_per_sec = elapsed_ns ? div64_u64(n * NSEC_PER_SEC, elapsed_ns) : 0;
+}
+
+/* One run of test_run_threads() */
+struct test_thread_run {
+    test_thread_func_t fn;
+    void *data;
+    struct completion start;
+    struct completion done;
+    atomic_t pending;
+};
+
+struct test_thread {
+    struct task_struct *task;
+    struct test_thread_run *run;
+    unsigned int id;
+};
+
+static int test_thread_fn(void *arg)
+{
+    struct test_thread *t = arg;
+    struct test_thread_run *run = t->run;
+
+    wait_for_completion(&run->start);
+    run->fn(run->data, t->id);
+
+    if (atomic_dec_and_test(&run->pending))
+        complete(&run->done);
+    return 0;
+}
+
+/* Threads test_run_threads() will start for @nr, 0 meaning every online CPU */
+unsigned int test_nr_threads(unsigned int nr)
+{
+    unsigned int online = num_online_cpus();
+
+    return nr ? min(nr, online) : online;
+}
+
+/*
+ * Run @fn once on each of test_nr_threads(@nr) online CPUs, one kthread
+ * per CPU. Every thread is created before any is released, so all of them
+ * start under full contention. Returns the number of threads run, or a
+ * negative error if not all of them could be created, in which case none
+ * ran. @wall_ns, if set, gets the time from release to the last finish.
+ */
+int test_run_threads(test_thread_func_t fn, void *data, unsigned int nr,
+                     const char *name, u64 *wall_ns)
+{
+    struct test_thread_run run = { .fn = fn, .data = data };
+    struct test_thread *threads;
+    unsigned int created = 0, i;
+    int cpu, ret = 0;
+    u64 start;
+
+    nr = test_nr_threads(nr);
+    threads = kcalloc(nr, sizeof(*threads), GFP_KERNEL);
+    if (!threads)
+        return -ENOMEM;
+
+    init_completion(&run.start);
+    init_completion(&run.done);
+    atomic_set(&run.pending, nr);
+
+    for_each_online_cpu(cpu) {
+        struct test_thread *t = &threads[created];
+
+        if (created >= nr)
+            break;
+
+        t->run = &run;
+        t->id = created;
+        t->task = kthread_create_on_cpu(test_thread_fn, t, cpu, name);
+        if (IS_ERR(t->task)) {
+            ret = PTR_ERR(t->task);
+            break;
+        }
+        created++;
+    }
+
+    if (!ret && created < nr)
+        ret = -ENODEV;      /* CPUs went offline under us */
+
+    if (ret) {
+        /* Not yet woken, so they exit without running test_thread_fn */
+        for (i = 0; i < created; i++)
+            kthread_stop(threads[i].task);
+        kfree(threads);
+        return ret;
+    }
+
+    for (i = 0; i < nr; i++)
+        wake_up_process(threads[i].task);
+
+    start = ktime_get_ns();
+    complete_all(&run.start);
+    wait_for_completion(&run.done);
+    if (wall_ns)
+        *wall_ns = ktime_get_ns() - start;
+
+    kfree(threads);
+    return nr;
+}
+
+static int test_bench_loop(struct test_case *test,
+                           struct test_bench_thread *t)
+{
+    struct test_bench *bench = test->bench;
+    u64 start, sample;
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < bench->warmup; i++) {
+        ret = bench->func(test->test_data, t->id, &sample);
+        if (ret != TEST_PASS)
+            return ret;
+        cond_resched();
+    }
+
+    t->elapsed_ns = ktime_get_ns();
+    for (i = 0; i < bench->iterations; i++) {
+        sample = 0;
+        start = ktime_get_ns();
+        ret = bench->func(test->test_data, t->id, &sample);
+        if (!bench->params.unit)
+            sample = ktime_get_ns() - start;
+        if (ret != TEST_PASS)
+            return ret;
+        t->samples[i] = sample;
+        cond_resched();
+    }
+    t->elapsed_ns = ktime_get_ns() - t->elapsed_ns;
+
+    return TEST_PASS;
+}
+
+static void test_bench_thread_fn(void *data, unsigned int thread)
+{
+    struct test_bench_thread *t = (struct test_bench_thread *)data + thread;
+
+    t->cpu = raw_smp_processor_id();
+    t->result = test_bench_loop(t->test, t);
+}
+
+static struct test_baseline *test_baseline_find(const char *name)
+{
+    struct test_baseline *base;
+
+    lockdep_assert_held(&test_lock);
+
+    list_for_each_entry(base, &test_baselines, list)
+        if (!strcmp(base->name, name))
+            return base;
+    return NULL;
+}
+
+static bool test_bench_regressed(u64 val, u64 base, unsigned int tolerance,
+                                 bool higher_is_better)
+{
+    if (higher_is_better)
+        return val * 100 < base * (100 - min(tolerance, 100U));
+    return val * 100 > base * (100 + tolerance);
+}
+
+/* Fail if the mean or the p99 is worse than the baseline by more than the tolerance */
+static int test_bench_check(struct test_case *test,
+                            const struct test_bench_stats *st)
+{
+    struct test_bench *bench = test->bench;
+    unsigned int tol = bench->params.tolerance ? : READ_ONCE(bench_tolerance);
+    bool hib = bench->params.higher_is_better;
+    struct test_baseline *base;
+    u64 mean = 0, p99 = 0;
+    bool found = false;
+
+    mutex_lock(&test_lock);
+    base = test_baseline_find(test->name);
+    if (base) {
+        mean = base->mean;
+        p99 = base->p99;
+        found = true;
+    }
+    mutex_unlock(&test_lock);
+
+    if (!found)
+        return TEST_PASS;
+
+    if (test_bench_regressed(st->mean, mean, tol, hib) ||
+        test_bench_regressed(st->p99, p99, tol, hib)) {
+        pr_warn("test_bench: %s: regression: mean %llu p99 %llu, baseline %llu %llu, tolerance %u%%\n",
+                test->name, st->mean, st->p99, mean, p99, tol);
+        set_test_error(test->name,
+                       "Regressed: mean %llu p99 %llu, baseline %llu %llu, tolerance %u%%",
+                       st->mean, st->p99, mean, p99, tol);
+        return TEST_FAIL;
+    }
+
+    pr_info("test_bench: %s: within %u%% of baseline mean %llu p99 %llu\n",
+            test->name, tol, mean, p99);
+    return TEST_PASS;
+}
+
+static int test_bench_run(struct test_case *test)
+{
+    struct test_bench *bench = test->bench;
+    const char *unit = bench->params.unit ? : "ns";
+    struct test_bench_stats agg, *thread_stats = NULL;
+    struct test_bench_thread *threads;
+    unsigned int nr = 0, max_threads, i;
+    u64 *samples = NULL, ops = 0;
+    int ret = TEST_PASS;
+
+    bench->warmup = bench->params.warmup ? : READ_ONCE(bench_warmup);
+    bench->iterations = bench->params.iterations ? :
+                        READ_ONCE(bench_iterations);
+    if (!bench->iterations) {
+        set_test_error(test->name, "No iterations");
+        return TEST_SKIP;
+    }
+
+    max_threads = min(bench->params.threads, num_online_cpus());
+    threads = kcalloc(max_threads, sizeof(*threads), GFP_KERNEL);
+    thread_stats = kcalloc(max_threads, sizeof(*thread_stats), GFP_KERNEL);
+    if (threads && thread_stats)
+        samples = kvmalloc_array((size_t)max_threads * bench->iterations,
+                                 sizeof(*samples), GFP_KERNEL);
+    if (!samples) {
+        set_test_error(test->name, "No memory for %u x %u samples",
+                       max_threads, bench->iterations);
+        ret = TEST_SKIP;
+        goto out;
+    }
+
+    for (i = 0; i < max_threads; i++) {
+        threads[i].test = test;
+        threads[i].id = i;
+        threads[i].cpu = -1;
+        threads[i].samples = samples + (size_t)i * bench->iterations;
+    }
+
+    if (max_threads == 1) {
+        threads[0].result = test_bench_loop(test, &threads[0]);
+        nr = 1;
+    } else {
+        /* Released together so every thread measures under full contention */
+        ret = test_run_threads(test_bench_thread_fn, threads, max_threads,
+                               "wifi67_bench/%u", NULL);
+        if (ret < 0) {
+            set_test_error(test->name, "Could not start %u threads: %d",
+                           max_threads, ret);
+            ret = TEST_FAIL;
+            goto out;
+        }
+        nr = ret;
+        ret = TEST_PASS;
+    }
+
+    for (i = 0; i < nr; i++) {
+        if (threads[i].result != TEST_PASS) {
+            ret = threads[i].result;
+            goto out;
+        }
+        test_bench_compute(threads[i].samples, bench->iterations,
+                           threads[i].elapsed_ns, &thread_stats[i]);
+        ops += thread_stats[i].ops_per_sec;
+    }
+    test_bench_compute(samples, (u64)nr * bench->iterations, 0, &agg);
+    agg.ops_per_sec = ops;
+
+    pr_info("test_bench: %s: %u thread(s), %llu samples: mean %llu stddev %llu min %llu p50 %llu p90 %llu p99 %llu max %llu %s, %llu ops/s\n",
+            test->name, nr, agg.samples, agg.mean, agg.stddev, agg.min,
+            agg.p50, agg.p90, agg.p99, agg.max, unit, agg.ops_per_sec);
+    for (i = 0; nr > 1 && i < nr; i++)
+        pr_info("test_bench: %s: thread %u cpu %d: mean %llu stddev %llu p99 %llu max %llu %s, %llu ops/s\n",
+                test->name, i, threads[i].cpu, thread_stats[i].mean,
+                thread_stats[i].stddev, thread_stats[i].p99,
+                thread_stats[i].max, unit, thread_stats[i].ops_per_sec);
+
+    mutex_lock(&test_lock);
+    bench->stats = agg;
+    bench->nr_threads = nr;
+    memcpy(bench->thread_stats, thread_stats, nr * sizeof(*thread_stats));
+    bench->has_stats = true;
+    mutex_unlock(&test_lock);
+
+    ret = test_bench_check(test, &agg);
+out:
+    kvfree(samples);
+    kfree(thread_stats);
+    kfree(threads);
+    return ret;
+}
+
+/* Stats of the last run of a benchmark, over all threads if @thread < 0 */
+int get_bench_stats(const char *name, int thread,
+                    struct test_bench_stats *st)
+{
+    struct test_case *test;
+    int ret = -ENOENT;
+
+    mutex_lock(&test_lock);
+    list_for_each_entry(test, &test_cases, list) {
+        if (!test->bench || strcmp(test->name, name))
+            continue;
+
+        if (!test->bench->has_stats) {
+            ret = -ENODATA;
+        } else if (thread < 0) {
+            *st = test->bench->stats;
+            ret = 0;
+        } else if (thread < test->bench->nr_threads) {
+            *st = test->bench->thread_stats[thread];
+            ret = 0;
+        } else {
+            ret = -ERANGE;
+        }
+        break;
+    }
+    mutex_unlock(&test_lock);
+
+    return ret;
+}
+
 /* Test execution worker */
 static void test_worker(struct work_struct *work)
 {
     struct test_work *test_work = container_of(work, struct test_work, work);
     struct test_case *test = test_work->test;
+    struct module *owner = test->owner;
     int ret;
 
     test->start_time = ktime_get();
-    ret = test->test_func(test->test_data);
+    if (test->bench)
+        ret = test_bench_run(test);
+    else
+        ret = test->test_func(test->test_data);
     test->end_time = ktime_get();
 
     if (ret == TEST_PASS) {
@@ -148,19 +675,49 @@ static void test_worker(struct work_struct *work)
 
     complete(&test->done);
     kfree(test_work);
+    module_put(owner);
+}
+
+/* The queued run holds a reference on the module that owns the test */
+static int test_queue(struct test_case *test)
+{
+    struct test_work *work;
+
+    if (!try_module_get(test->owner))
+        return -ENODEV;
+
+    work = kzalloc(sizeof(*work), GFP_KERNEL);
+    if (!work) {
+        module_put(test->owner);
+        return -ENOMEM;
+    }
+
+    INIT_WORK(&work->work, test_worker);
+    work->test = test;
+    reinit_completion(&test->done);
+
+    queue_work(test_wq, &work->work);
+    return 0;
+}
+
+/* Benchmarks and stress tests run alone so they do not skew each other */
+static bool test_is_exclusive(const struct test_case *test)
+{
+    return test->flags & (TEST_FLAG_BENCHMARK | TEST_FLAG_STRESS);
 }
 
 /* Run a specific test case */
 int run_test_case(const char *name)
 {
     struct test_case *test;
-    struct test_work *work;
     bool found = false;
+    int ret;
 
+    /* Our own reference keeps the test registered until we read it */
     mutex_lock(&test_lock);
     list_for_each_entry(test, &test_cases, list) {
         if (strcmp(test->name, name) == 0) {
-            found = true;
+            found = try_module_get(test->owner);
             break;
         }
     }
@@ -169,40 +726,49 @@ int run_test_case(const char *name)
     if (!found)
         return -ENOENT;
 
-    work = kzalloc(sizeof(*work), GFP_KERNEL);
-    if (!work)
-        return -ENOMEM;
-
-    INIT_WORK(&work->work, test_worker);
-    work->test = test;
-
-    queue_work(test_wq, &work->work);
-    wait_for_completion(&test->done);
+    ret = test_queue(test);
+    if (!ret) {
+        wait_for_completion(&test->done);
+        ret = test->result;
+    }
+    module_put(test->owner);
 
-    return test->result;
+    return ret;
 }
 
 /* Run all test cases */
 void run_all_tests(void)
 {
     struct test_case *test;
-    struct test_work *work;
 
     stats.start_time = ktime_get();
 
     mutex_lock(&test_lock);
     list_for_each_entry(test, &test_cases, list) {
-        work = kzalloc(sizeof(*work), GFP_KERNEL);
-        if (!work)
-            continue;
-
-        INIT_WORK(&work->work, test_worker);
-        work->test = test;
-        queue_work(test_wq, &work->work);
+        if (!test_is_exclusive(test))
+            test_queue(test);
     }
     mutex_unlock(&test_lock);
 
     flush_workqueue(test_wq);
+
+    /*
+     * The reference on the owner keeps the cursor registered while it is
+     * waited on unlocked; it is dropped under test_lock, before moving on.
+     */
+    mutex_lock(&test_lock);
+    list_for_each_entry(test, &test_cases, list) {
+        if (!test_is_exclusive(test) || !try_module_get(test->owner))
+            continue;
+        if (!test_queue(test)) {
+            mutex_unlock(&test_lock);
+            wait_for_completion(&test->done);
+            mutex_lock(&test_lock);
+        }
+        module_put(test->owner);
+    }
+    mutex_unlock(&test_lock);
+
     stats.end_time = ktime_get();
 }
 
@@ -263,6 +829,8 @@ void reset_test_framework(void)
         test->error_msg = NULL;
         test->start_time = 0;
         test->end_time = 0;
+        if (test->bench)
+            test->bench->has_stats = false;
         init_completion(&test->done);
     }
     mutex_unlock(&test_lock);
@@ -275,11 +843,195 @@ void reset_test_framework(void)
     stats.end_time = 0;
 }
 
+/* debugfs: "all" or a test name, run synchronously */
+static ssize_t test_run_write(struct file *file, const char __user *ubuf,
+                              size_t count, loff_t *ppos)
+{
+    char buf[TEST_NAME_MAX];
+    char *name;
+    int ret;
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+    name = strim(buf);
+
+    if (!strcmp(name, "all")) {
+        run_all_tests();
+        return count;
+    }
+
+    ret = run_test_case(name);
+    return ret < 0 ? ret : count;
+}
+
+static const struct file_operations test_run_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .write = test_run_write,
+    .llseek = noop_llseek,
+};
+
+/* One "<name> <mean> <p99>" line; "clear" drops every baseline */
+static int test_baseline_parse(char *line)
+{
+    struct test_baseline *base, *tmp;
+    char name[TEST_NAME_MAX];
+    u64 mean, p99;
+
+    if (!*line || *line == '#')
+        return 0;
+
+    if (!strcmp(line, "clear")) {
+        mutex_lock(&test_lock);
+        list_for_each_entry_safe(base, tmp, &test_baselines, list) {
+            list_del(&base->list);
+            kfree(base);
+        }
+        mutex_unlock(&test_lock);
+        return 0;
+    }
+
+    if (sscanf(line, "%63s %llu %llu", name, &mean, &p99) != 3)
+        return -EINVAL;
+
+    mutex_lock(&test_lock);
+    base = test_baseline_find(name);
+    if (!base) {
+        base = kzalloc(sizeof(*base), GFP_KERNEL);
+        if (!base) {
+            mutex_unlock(&test_lock);
+            return -ENOMEM;
+        }
+        strscpy(base->name, name, sizeof(base->name));
+        list_add_tail(&base->list, &test_baselines);
+    }
+    base->mean = mean;
+    base->p99 = p99;
+    mutex_unlock(&test_lock);
+
+    return 0;
+}
+
+static ssize_t test_baseline_write(struct file *file, const char __user *ubuf,
+                                   size_t count, loff_t *ppos)
+{
+    size_t len = min_t(size_t, count, PAGE_SIZE - 1);
+    char *buf, *p, *line, *end;
+    ssize_t used;
+    int ret = 0;
+
+    buf = memdup_user_nul(ubuf, len);
+    if (IS_ERR(buf))
+        return PTR_ERR(buf);
+
+    /* Take whole lines only; the caller writes the rest again */
+    end = strrchr(buf, '\n');
+    if (end) {
+        *end = '\0';
+        used = end - buf + 1;
+    } else if (len < count) {
+        kfree(buf);
+        return -EINVAL;
+    } else {
+        used = len;
+    }
+
+    p = buf;
+    while (!ret && (line = strsep(&p, "\n")))
+        ret = test_baseline_parse(strim(line));
+
+    kfree(buf);
+    return ret ? ret : used;
+}
+
+static int test_baseline_show(struct seq_file *m, void *v)
+{
+    struct test_baseline *base;
+
+    mutex_lock(&test_lock);
+    list_for_each_entry(base, &test_baselines, list)
+        seq_printf(m, "%s %llu %llu\n", base->name, base->mean, base->p99);
+    mutex_unlock(&test_lock);
+
+    return 0;
+}
+
+static int test_baseline_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, test_baseline_show, inode->i_private);
+}
+
+static const struct file_operations test_baseline_fops = {
+    .owner = THIS_MODULE,
+    .open = test_baseline_open,
+    .read = seq_read,
+    .write = test_baseline_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/* Same leading fields as bench_baseline, so a run can be saved as one */
+static int test_bench_results_show(struct seq_file *m, void *v)
+{
+    struct test_case *test;
+
+    seq_puts(m, "# name mean p99 stddev min p50 p90 max samples ops_per_sec unit\n");
+
+    mutex_lock(&test_lock);
+    list_for_each_entry(test, &test_cases, list) {
+        const struct test_bench_stats *st;
+
+        if (!test->bench || !test->bench->has_stats)
+            continue;
+
+        st = &test->bench->stats;
+        seq_printf(m, "%s %llu %llu %llu %llu %llu %llu %llu %llu %llu %s\n",
+                   test->name, st->mean, st->p99, st->stddev, st->min,
+                   st->p50, st->p90, st->max, st->samples, st->ops_per_sec,
+                   test->bench->params.unit ? : "ns");
+    }
+    mutex_unlock(&test_lock);
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(test_bench_results);
+
+static int __init test_framework_module_init(void)
+{
+    return test_framework_init();
+}
+
+static void __exit test_framework_module_exit(void)
+{
+    test_framework_exit();
+}
+
+module_init(test_framework_module_init);
+module_exit(test_framework_module_exit);
+
 EXPORT_SYMBOL_GPL(test_framework_init);
 EXPORT_SYMBOL_GPL(test_framework_exit);
-EXPORT_SYMBOL_GPL(register_test_case);
+EXPORT_SYMBOL_GPL(__register_test_case);
+EXPORT_SYMBOL_GPL(unregister_test_case);
+EXPORT_SYMBOL_GPL(__unregister_test_cases);
 EXPORT_SYMBOL_GPL(run_test_case);
 EXPORT_SYMBOL_GPL(run_all_tests);
 EXPORT_SYMBOL_GPL(get_test_results);
 EXPORT_SYMBOL_GPL(set_test_error);
-EXPORT_SYMBOL_GPL(reset_test_framework); 
\ No newline at end of file
+EXPORT_SYMBOL_GPL(reset_test_framework);
+EXPORT_SYMBOL_GPL(__register_bench_case);
+EXPORT_SYMBOL_GPL(get_bench_stats);
+EXPORT_SYMBOL_GPL(test_nr_threads);
+EXPORT_SYMBOL_GPL(test_run_threads);
+
+MODULE_LICENSE("Dual MIT/GPL");
+MODULE_AUTHOR("Fayssal Chokri");
+MODULE_DESCRIPTION("WiFi 6E/7 Test Framework");
+MODULE_VERSION("1.0");
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "kunit/test_framework_kunit.c"
+#endif
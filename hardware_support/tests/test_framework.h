@@ -2,6 +2,7 @@
 #define _TEST_FRAMEWORK_H_
 
 #include <linux/types.h>
+#include <linux/module.h>
 
 /* Test result enum */
 enum test_result {
@@ -35,13 +36,65 @@ struct test_results {
     s64 duration_ns;
 };
 
+/*
+ * Benchmark mode. A benchmark is registered as one iteration; the
+ * framework runs it warmup + iterations times and keeps every sample.
+ * With more than one thread it is a stress run: one kthread per CPU,
+ * released together, each with its own samples and statistics.
+ */
+#define TEST_BENCH_MAX_THREADS      64
+#define TEST_BENCH_DEF_WARMUP       TEST_ITER_QUICK
+#define TEST_BENCH_DEF_ITERATIONS   TEST_ITER_EXTENDED
+#define TEST_BENCH_DEF_TOLERANCE    10      /* Percent */
+
+/*
+ * One iteration on stress thread @thread (0 when single-threaded).
+ * Returns TEST_PASS to go on. The framework times the call in ns, unless
+ * the benchmark has a unit, in which case the iteration sets @sample.
+ */
+typedef int (*test_bench_func_t)(void *data, unsigned int thread,
+                                 u64 *sample);
+
+struct test_bench_params {
+    unsigned int warmup;        /* Per thread, 0 for the module default */
+    unsigned int iterations;    /* Per thread, 0 for the module default */
+    unsigned int threads;       /* Capped at the online CPUs */
+    unsigned int tolerance;     /* Percent over baseline, 0 for default */
+    const char *unit;           /* NULL for ns per iteration */
+    bool higher_is_better;      /* Regression is a drop, e.g. Mbps */
+};
+
+/*
+ * Body of a test_run_threads() thread; @thread is 0..nr-1. Per-thread
+ * results go into caller state indexed by @thread.
+ */
+typedef void (*test_thread_func_t)(void *data, unsigned int thread);
+
+struct test_bench_stats {
+    u64 samples;
+    u64 mean;
+    u64 stddev;
+    u64 min;
+    u64 p50;
+    u64 p90;
+    u64 p99;
+    u64 max;
+    u64 ops_per_sec;            /* Iterations per second of run time */
+};
+
 /* Test framework functions */
 int test_framework_init(void);
 void test_framework_exit(void);
 
-int register_test_case(const char *name, const char *description,
-                      test_func_t test_func, void *test_data,
-                      unsigned long flags);
+/*
+ * Test cases belong to the module that registers them, which must
+ * unregister them from its exit; a run holds a reference on that module.
+ */
+int __register_test_case(const char *name, const char *description,
+                         test_func_t test_func, void *test_data,
+                         unsigned long flags, struct module *owner);
+void unregister_test_case(const char *name);
+void __unregister_test_cases(struct module *owner);
 
 int run_test_case(const char *name);
 void run_all_tests(void);
@@ -49,10 +102,33 @@ void get_test_results(struct test_results *results);
 void set_test_error(const char *name, const char *fmt, ...);
 void reset_test_framework(void);
 
+int __register_bench_case(const char *name, const char *description,
+                          test_bench_func_t bench_func, void *test_data,
+                          const struct test_bench_params *params,
+                          unsigned long flags, struct module *owner);
+int get_bench_stats(const char *name, int thread,
+                    struct test_bench_stats *stats);
+
+unsigned int test_nr_threads(unsigned int nr);
+int test_run_threads(test_thread_func_t fn, void *data, unsigned int nr,
+                     const char *name, u64 *wall_ns);
+
+#define register_test_case(name, desc, func, data, flags) \
+    __register_test_case(name, desc, func, data, flags, THIS_MODULE)
+
+#define register_bench_case(name, desc, func, data, params, flags) \
+    __register_bench_case(name, desc, func, data, params, flags, THIS_MODULE)
+
 /* Helper macros */
 #define REGISTER_TEST(name, desc, func, data, flags) \
     register_test_case(name, desc, func, data, flags)
 
+#define REGISTER_BENCH(name, desc, func, data, params, flags) \
+    register_bench_case(name, desc, func, data, params, flags)
+
+/* Every test case of the calling module */
+#define UNREGISTER_TESTS() __unregister_test_cases(THIS_MODULE)
+
 #define TEST_ASSERT(cond, fmt, ...) do { \
     if (!(cond)) { \
         set_test_error(__func__, fmt, ##__VA_ARGS__); \
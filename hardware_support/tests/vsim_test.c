@@ -0,0 +1,620 @@
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/skbuff.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <asm/unaligned.h>
+#include "../vsim/wifi67_vsim.h"
+#include "../../include/perf/perf_latency.h"
+#include "test_framework.h"
+
+/*
+ * End-to-end tests over a virtual AP/STA pair. Frames go through the real
+ * DMA rings and firmware IPC on both sides and cross a modelled medium,
+ * so delivery, ordering, retries, link rate and multi-link behaviour are
+ * checked the way iperf would see them. The benchmark reports goodput and
+ * one-way latency for a link setup given as module parameters.
+ */
+
+#define VSIM_TEST_MAGIC         0x56534954  /* "VSIT" */
+#define VSIM_TEST_FLUSH_MS      5000
+#define VSIM_TEST_TX_WAIT_MS    2000
+
+static unsigned int duration_ms = 2000;
+module_param(duration_ms, uint, 0444);
+MODULE_PARM_DESC(duration_ms, "Benchmark run time");
+
+static unsigned int frame_len = 1500;
+module_param(frame_len, uint, 0444);
+MODULE_PARM_DESC(frame_len, "Benchmark frame length in bytes");
+
+static unsigned int num_links = 2;
+module_param(num_links, uint, 0444);
+MODULE_PARM_DESC(num_links, "Benchmark links, frames spread round-robin");
+
+static unsigned int rate_mbps = WIFI67_VSIM_DEF_RATE;
+module_param(rate_mbps, uint, 0444);
+MODULE_PARM_DESC(rate_mbps, "Benchmark link rate");
+
+static unsigned int delay_us = WIFI67_VSIM_DEF_DELAY;
+module_param(delay_us, uint, 0444);
+MODULE_PARM_DESC(delay_us, "Benchmark propagation delay");
+
+static unsigned int jitter_us;
+module_param(jitter_us, uint, 0444);
+MODULE_PARM_DESC(jitter_us, "Benchmark delivery jitter");
+
+static unsigned int loss;
+module_param(loss, uint, 0444);
+MODULE_PARM_DESC(loss, "Benchmark loss per attempt, in percent");
+
+static bool bidir;
+module_param(bidir, bool, 0444);
+MODULE_PARM_DESC(bidir, "Benchmark traffic in both directions");
+
+struct vsim_test_hdr {
+    __le32 magic;
+    __le32 seq;
+    __le64 tstamp_ns;
+} __packed;
+
+/* What one radio's host saw; only touched from its poll work */
+struct vsim_test_end {
+    u64 rx_frames;
+    u64 rx_bytes;
+    u64 rx_bad;
+    u64 rx_ooo;             /* Behind an earlier frame on the same link */
+    u64 rx_cross_ooo;       /* Behind a frame from another link */
+    u32 rx_last[WIFI67_VSIM_MAX_LINKS];
+    u32 rx_last_any;
+    bool rx_seen[WIFI67_VSIM_MAX_LINKS];
+    u64 lat_sum_ns;
+    u64 lat_max_ns;
+    ktime_t rx_first;
+    ktime_t rx_last_time;
+
+    u64 txs_acked;
+    u64 txs_failed;
+    u64 txs_retries;
+    u64 txs_bad_order;
+    u32 txs_next[WIFI67_VSIM_MAX_LINKS];
+
+    u64 events;
+    u32 last_event_seq;
+};
+
+struct vsim_test_ctx {
+    struct wifi67_vsim *vsim;
+    struct vsim_test_end ends[WIFI67_VSIM_NUM_ROLES];
+    u32 tx_seq[WIFI67_VSIM_NUM_ROLES];
+};
+
+static void vsim_test_rx(void *data, u8 link_id, struct sk_buff *skb)
+{
+    struct vsim_test_end *end = data;
+    const struct vsim_test_hdr *hdr = (const void *)skb->data;
+    ktime_t now = ktime_get();
+    u64 lat;
+    u32 seq;
+
+    if (skb->len < sizeof(*hdr) || le32_to_cpu(hdr->magic) != VSIM_TEST_MAGIC) {
+        end->rx_bad++;
+        goto out;
+    }
+
+    seq = le32_to_cpu(hdr->seq);
+    if (end->rx_seen[link_id] && (s32)(seq - end->rx_last[link_id]) < 0)
+        end->rx_ooo++;
+    else if (end->rx_frames && (s32)(seq - end->rx_last_any) < 0)
+        end->rx_cross_ooo++;
+    end->rx_last[link_id] = seq;
+    end->rx_seen[link_id] = true;
+    end->rx_last_any = seq;
+
+    lat = ktime_get_ns() - le64_to_cpu(hdr->tstamp_ns);
+    end->lat_sum_ns += lat;
+    end->lat_max_ns = max(end->lat_max_ns, lat);
+
+    if (!end->rx_frames)
+        end->rx_first = now;
+    end->rx_last_time = now;
+    end->rx_frames++;
+    end->rx_bytes += skb->len;
+out:
+    consume_skb(skb);
+}
+
+static void vsim_test_tx_status(void *data, u8 link_id, struct sk_buff *skb,
+                                const struct wifi67_vsim_evt_txs *txs)
+{
+    struct vsim_test_end *end = data;
+
+    if (le32_to_cpu(txs->seq) != end->txs_next[link_id])
+        end->txs_bad_order++;
+    end->txs_next[link_id] = le32_to_cpu(txs->seq) + 1;
+
+    if (txs->acked)
+        end->txs_acked++;
+    else
+        end->txs_failed++;
+    end->txs_retries += txs->retries;
+
+    consume_skb(skb);
+}
+
+static void vsim_test_event(void *data, const struct wifi67_ipc_msg *msg)
+{
+    struct vsim_test_end *end = data;
+
+    if (le16_to_cpu(msg->id) == WIFI67_VSIM_EVT_CMD_DONE &&
+        le16_to_cpu(msg->len) >= sizeof(u32))
+        end->last_event_seq = get_unaligned_le32(msg->payload);
+    end->events++;
+}
+
+static const struct wifi67_vsim_ops vsim_test_ops = {
+    .rx = vsim_test_rx,
+    .tx_status = vsim_test_tx_status,
+    .event = vsim_test_event,
+};
+
+static void vsim_test_destroy(struct vsim_test_ctx *ctx)
+{
+    wifi67_vsim_destroy(ctx->vsim);
+    ctx->vsim = NULL;
+}
+
+/*
+ * Tests run concurrently, so each keeps its context on its own stack;
+ * results stay readable there after the pair is gone.
+ */
+static int vsim_test_create(struct vsim_test_ctx *ctx, u8 links)
+{
+    int role;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->vsim = wifi67_vsim_create(links);
+    if (IS_ERR(ctx->vsim))
+        return PTR_ERR(ctx->vsim);
+
+    /* Each radio's callbacks fill in the end that radio's host sees */
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++)
+        wifi67_vsim_set_ops(ctx->vsim, role, &vsim_test_ops,
+                            &ctx->ends[role]);
+
+    return 0;
+}
+
+static void vsim_test_link(struct vsim_test_ctx *ctx, u8 link_id, u32 rate,
+                           u32 delay, u32 jitter, u32 loss_pct)
+{
+    struct wifi67_vsim_link_params lp = {
+        .up = true,
+        .rate_mbps = rate,
+        .delay_us = delay,
+        .jitter_us = jitter,
+        .loss = loss_pct,
+        .retry_limit = WIFI67_VSIM_RETRY_LIMIT,
+    };
+
+    wifi67_vsim_set_link(ctx->vsim, link_id, &lp);
+}
+
+/* Send one numbered frame, waiting out a full ring */
+static int vsim_test_send(struct vsim_test_ctx *ctx, enum wifi67_vsim_role role,
+                          u8 link_id, u32 len)
+{
+    unsigned long timeout = jiffies + msecs_to_jiffies(VSIM_TEST_TX_WAIT_MS);
+    struct vsim_test_hdr *hdr;
+    struct sk_buff *skb;
+    int ret;
+
+    skb = alloc_skb(len, GFP_KERNEL);
+    if (!skb)
+        return -ENOMEM;
+
+    hdr = skb_put_zero(skb, len);
+    hdr->magic = cpu_to_le32(VSIM_TEST_MAGIC);
+    hdr->seq = cpu_to_le32(ctx->tx_seq[role]++);
+    hdr->tstamp_ns = cpu_to_le64(ktime_get_ns());
+    /* We stand in for the MAC, so the driver tracks the frame from here */
+    wifi67_lat_stamp(skb, WIFI67_LAT_ENQUEUE);
+
+    while ((ret = wifi67_vsim_tx(ctx->vsim, role, link_id, skb)) == -EBUSY) {
+        if (time_after(jiffies, timeout))
+            break;
+        usleep_range(50, 100);
+    }
+
+    if (ret)
+        kfree_skb(skb);
+    return ret;
+}
+
+static u64 vsim_test_mbps(const struct vsim_test_end *end)
+{
+    u64 ns = ktime_to_ns(ktime_sub(end->rx_last_time, end->rx_first));
+
+    return ns ? div64_u64(end->rx_bytes * 8 * 1000, ns) : 0;
+}
+
+/* Test cases */
+static int test_vsim_fw_echo(void *data)
+{
+    struct vsim_test_ctx ctx;
+    u32 i, n = 2 * WIFI67_IPC_EVT_ENTRIES;
+    int ret = 0;
+
+    ret = vsim_test_create(&ctx, 1);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+
+    /* More than the event ring holds, so the firmware must wait for room */
+    for (i = 0; i < n && !ret; i++) {
+        unsigned long timeout = jiffies + msecs_to_jiffies(VSIM_TEST_TX_WAIT_MS);
+
+        while ((ret = wifi67_vsim_fw_cmd(ctx.vsim, WIFI67_VSIM_STA,
+                                         WIFI67_VSIM_CMD_ECHO, &i,
+                                         sizeof(i))) == -ENOSPC &&
+               time_before(jiffies, timeout))
+            usleep_range(50, 100);
+    }
+    msleep(100);
+    vsim_test_destroy(&ctx);
+
+    TEST_ASSERT(ret == 0, "Command %u not accepted: %d", i, ret);
+    TEST_ASSERT(ctx.ends[WIFI67_VSIM_STA].events == n &&
+                ctx.ends[WIFI67_VSIM_STA].last_event_seq == n - 1,
+                "%llu of %u echoes, last %u",
+                ctx.ends[WIFI67_VSIM_STA].events, n,
+                ctx.ends[WIFI67_VSIM_STA].last_event_seq);
+    TEST_ASSERT(ctx.ends[WIFI67_VSIM_AP].events == 0,
+                "AP saw %llu STA events", ctx.ends[WIFI67_VSIM_AP].events);
+    TEST_PASS();
+}
+
+static int test_vsim_clean_link(void *data)
+{
+    struct wifi67_vsim_link_stats st;
+    struct vsim_test_ctx ctx;
+    struct vsim_test_end *sta, *ap;
+    u32 i, n = 3 * WIFI67_VSIM_RX_BUFS;
+    int ret = 0;
+
+    ret = vsim_test_create(&ctx, 1);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+    sta = &ctx.ends[WIFI67_VSIM_STA];
+    ap = &ctx.ends[WIFI67_VSIM_AP];
+
+    for (i = 0; i < n && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 64 + i % 1400);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    wifi67_vsim_get_stats(ctx.vsim, WIFI67_VSIM_AP, 0, &st);
+    vsim_test_destroy(&ctx);
+
+    TEST_ASSERT(ret == 0, "Run failed: %d", ret);
+    TEST_ASSERT(sta->rx_frames == n && !sta->rx_bad && !sta->rx_ooo,
+                "STA got %llu of %u, %llu bad, %llu out of order",
+                sta->rx_frames, n, sta->rx_bad, sta->rx_ooo);
+    TEST_ASSERT(ap->txs_acked == n && !ap->txs_failed && !ap->txs_bad_order,
+                "AP status: %llu acked %llu failed %llu misordered",
+                ap->txs_acked, ap->txs_failed, ap->txs_bad_order);
+    TEST_ASSERT(st.tx_frames == n && st.tx_attempts == n &&
+                st.rx_frames == n && !st.rx_overrun,
+                "Medium: tx %llu attempts %llu rx %llu overrun %llu",
+                st.tx_frames, st.tx_attempts, st.rx_frames, st.rx_overrun);
+    TEST_PASS();
+}
+
+static int test_vsim_loss(void *data)
+{
+    struct wifi67_vsim_link_params lp;
+    struct vsim_test_ctx ctx;
+    struct vsim_test_end *sta, *ap, base;
+    u32 i, n = 1000;
+    int ret = 0;
+
+    ret = vsim_test_create(&ctx, 1);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+    sta = &ctx.ends[WIFI67_VSIM_STA];
+    ap = &ctx.ends[WIFI67_VSIM_AP];
+
+    /* 30% per attempt: retries recover nearly everything */
+    vsim_test_link(&ctx, 0, WIFI67_VSIM_DEF_RATE, WIFI67_VSIM_DEF_DELAY, 0, 30);
+    for (i = 0; i < n && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 512);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    if (!ret && (ap->txs_acked + ap->txs_failed != n ||
+                 sta->rx_frames != ap->txs_acked || ap->txs_failed > 5 ||
+                 ap->txs_retries < n / 4 || ap->txs_retries > n))
+        ret = -EPROTO;
+
+    /* Everything lost: each frame spends the full retry budget */
+    base = *ap;
+    vsim_test_link(&ctx, 0, WIFI67_VSIM_DEF_RATE, WIFI67_VSIM_DEF_DELAY,
+                   0, 100);
+    for (i = 0; i < 100 && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 512);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    if (!ret && (sta->rx_frames != base.txs_acked ||
+                 ap->txs_failed - base.txs_failed != 100 ||
+                 ap->txs_retries - base.txs_retries !=
+                 100 * WIFI67_VSIM_RETRY_LIMIT))
+        ret = -EPROTO;
+
+    /* A link that is down fails frames without using the air */
+    base = *ap;
+    wifi67_vsim_get_link(ctx.vsim, 0, &lp);
+    lp.up = false;
+    lp.loss = 0;
+    wifi67_vsim_set_link(ctx.vsim, 0, &lp);
+    for (i = 0; i < 100 && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 512);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    if (!ret && (ap->txs_failed - base.txs_failed != 100 ||
+                 ap->txs_retries != base.txs_retries))
+        ret = -EPROTO;
+
+    vsim_test_destroy(&ctx);
+    TEST_ASSERT(ret == 0,
+                "Run failed: %d (acked %llu failed %llu retries %llu rx %llu)",
+                ret, ap->txs_acked, ap->txs_failed, ap->txs_retries,
+                sta->rx_frames);
+    TEST_ASSERT(!ap->txs_bad_order, "%llu TX statuses out of order",
+                ap->txs_bad_order);
+    TEST_PASS();
+}
+
+static int test_vsim_rate(void *data)
+{
+    struct vsim_test_ctx ctx;
+    struct vsim_test_end *sta;
+    ktime_t end;
+    u64 mbps;
+    int ret = 0;
+
+    ret = vsim_test_create(&ctx, 1);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+    sta = &ctx.ends[WIFI67_VSIM_STA];
+
+    /* Keep a 100 Mbps link backlogged for half a second */
+    vsim_test_link(&ctx, 0, 100, WIFI67_VSIM_DEF_DELAY, 0, 0);
+    end = ktime_add_ms(ktime_get(), 500);
+    while (!ret && ktime_before(ktime_get(), end))
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 1500);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    mbps = vsim_test_mbps(sta);
+    vsim_test_destroy(&ctx);
+
+    TEST_ASSERT(ret == 0, "Run failed: %d", ret);
+    TEST_ASSERT(mbps >= 90 && mbps <= 110, "Goodput %llu Mbps on a 100 Mbps link",
+                mbps);
+    TEST_PASS();
+}
+
+static int test_vsim_rate_ctrl(void *data)
+{
+    struct wifi67_vsim_cmd_rate rc = { .link_id = 0 };
+    struct vsim_test_ctx ctx;
+    struct vsim_test_end *ap;
+    u64 failed_above;
+    u32 i;
+    int ret = 0;
+
+    ret = vsim_test_create(&ctx, 1);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+    ap = &ctx.ends[WIFI67_VSIM_AP];
+
+    /* Above the link rate every attempt fails; back at it, all get through */
+    rc.rate_mbps = cpu_to_le32(2 * WIFI67_VSIM_DEF_RATE);
+    ret = wifi67_vsim_fw_cmd(ctx.vsim, WIFI67_VSIM_AP,
+                             WIFI67_VSIM_CMD_SET_RATE, &rc, sizeof(rc));
+    msleep(20);
+    for (i = 0; i < 50 && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 1000);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    failed_above = ap->txs_failed;
+
+    rc.rate_mbps = 0;
+    if (!ret)
+        ret = wifi67_vsim_fw_cmd(ctx.vsim, WIFI67_VSIM_AP,
+                                 WIFI67_VSIM_CMD_SET_RATE, &rc, sizeof(rc));
+    msleep(20);
+    for (i = 0; i < 50 && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, 0, 1000);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    vsim_test_destroy(&ctx);
+
+    TEST_ASSERT(ret == 0, "Run failed: %d", ret);
+    TEST_ASSERT(failed_above == 50 && ap->txs_acked == 50,
+                "%llu of 50 failed above the link rate, %llu of 50 acked at it",
+                failed_above, ap->txs_acked);
+    TEST_PASS();
+}
+
+static int test_vsim_mlo(void *data)
+{
+    struct wifi67_vsim_link_stats st[2];
+    struct vsim_test_ctx ctx;
+    struct vsim_test_end *sta, *ap;
+    u32 i, n = 2000;
+    int ret = 0;
+
+    ret = vsim_test_create(&ctx, 2);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+    sta = &ctx.ends[WIFI67_VSIM_STA];
+    ap = &ctx.ends[WIFI67_VSIM_AP];
+
+    /* A fast near link and a slow far one; the STA sees them interleave */
+    vsim_test_link(&ctx, 0, 1200, 10, 0, 0);
+    vsim_test_link(&ctx, 1, 300, 500, 0, 0);
+    for (i = 0; i < n && !ret; i++)
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, i % 2, 1000);
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+    wifi67_vsim_get_stats(ctx.vsim, WIFI67_VSIM_AP, 0, &st[0]);
+    wifi67_vsim_get_stats(ctx.vsim, WIFI67_VSIM_AP, 1, &st[1]);
+    vsim_test_destroy(&ctx);
+
+    TEST_ASSERT(ret == 0, "Run failed: %d", ret);
+    TEST_ASSERT(sta->rx_frames == n && !sta->rx_ooo && !ap->txs_bad_order,
+                "STA got %llu of %u, %llu out of order within a link",
+                sta->rx_frames, n, sta->rx_ooo);
+    TEST_ASSERT(sta->rx_cross_ooo > 0,
+                "No reordering across links with a 490 us delay difference");
+    TEST_ASSERT(st[0].rx_frames == n / 2 && st[1].rx_frames == n / 2 &&
+                st[1].airtime_us > 3 * st[0].airtime_us,
+                "Per-link rx %llu/%llu airtime %llu/%llu us",
+                st[0].rx_frames, st[1].rx_frames, st[0].airtime_us,
+                st[1].airtime_us);
+    TEST_PASS();
+}
+
+static void vsim_test_report(const char *dir, const struct vsim_test_end *rx,
+                             const struct vsim_test_end *tx)
+{
+    pr_info("vsim_bench: %s: %llu frames, %llu Mbps, latency avg %llu max %llu us, ooo %llu/%llu, tx acked %llu failed %llu retries %llu\n",
+            dir, rx->rx_frames, vsim_test_mbps(rx),
+            rx->rx_frames ?
+            div64_u64(rx->lat_sum_ns, rx->rx_frames * NSEC_PER_USEC) : 0,
+            div_u64(rx->lat_max_ns, NSEC_PER_USEC), rx->rx_ooo,
+            rx->rx_cross_ooo, tx->txs_acked, tx->txs_failed, tx->txs_retries);
+}
+
+/* The sending host's view: DMA post to TX status, per link */
+static void vsim_test_report_hw(struct vsim_test_ctx *ctx,
+                                enum wifi67_vsim_role role, const char *dir,
+                                u8 links)
+{
+    struct wifi67_priv *priv = wifi67_vsim_priv(ctx->vsim, role);
+    u32 p50, p99;
+    u64 n;
+    int link;
+
+    for (link = 0; link < links; link++) {
+        p50 = wifi67_lat_percentile(priv, WIFI67_LAT_STAGE_HW, true, link,
+                                    500, &n);
+        p99 = wifi67_lat_percentile(priv, WIFI67_LAT_STAGE_HW, true, link,
+                                    990, NULL);
+        if (n)
+            pr_info("vsim_bench: %s link %d: DMA post to TX status p50 %u p99 %u ns over %llu frames\n",
+                    dir, link, p50, p99, n);
+    }
+}
+
+static int test_vsim_bench(void *data)
+{
+    u8 links = clamp_t(u8, num_links, 1, WIFI67_VSIM_MAX_LINKS);
+    u32 len = clamp_t(u32, frame_len, sizeof(struct vsim_test_hdr),
+                      WIFI67_VSIM_MAX_FRAME);
+    struct vsim_test_ctx ctx;
+    ktime_t end;
+    u32 i = 0;
+    int link, ret = 0;
+
+    ret = vsim_test_create(&ctx, links);
+    if (ret)
+        TEST_SKIP("Setup failed: %d", ret);
+
+    for (link = 0; link < links; link++)
+        vsim_test_link(&ctx, link, rate_mbps, delay_us, jitter_us,
+                       min(loss, 100U));
+    wifi67_lat_enable(wifi67_vsim_priv(ctx.vsim, WIFI67_VSIM_AP), true);
+    if (bidir)
+        wifi67_lat_enable(wifi67_vsim_priv(ctx.vsim, WIFI67_VSIM_STA), true);
+
+    end = ktime_add_ms(ktime_get(), duration_ms);
+    while (!ret && ktime_before(ktime_get(), end)) {
+        ret = vsim_test_send(&ctx, WIFI67_VSIM_AP, i % links, len);
+        if (!ret && bidir)
+            ret = vsim_test_send(&ctx, WIFI67_VSIM_STA, i % links, len);
+        i++;
+    }
+    if (!ret)
+        ret = wifi67_vsim_flush(ctx.vsim, VSIM_TEST_FLUSH_MS);
+
+    if (!ret) {
+        pr_info("vsim_bench: %u links at %u Mbps, delay %u us, jitter %u us, loss %u%%, %u byte frames\n",
+                links, rate_mbps, delay_us, jitter_us, loss, len);
+        vsim_test_report("ap->sta", &ctx.ends[WIFI67_VSIM_STA],
+                         &ctx.ends[WIFI67_VSIM_AP]);
+        vsim_test_report_hw(&ctx, WIFI67_VSIM_AP, "ap->sta", links);
+        if (bidir) {
+            vsim_test_report("sta->ap", &ctx.ends[WIFI67_VSIM_AP],
+                             &ctx.ends[WIFI67_VSIM_STA]);
+            vsim_test_report_hw(&ctx, WIFI67_VSIM_STA, "sta->ap", links);
+        }
+    }
+    vsim_test_destroy(&ctx);
+
+    TEST_ASSERT(ret == 0, "Run failed: %d", ret);
+    TEST_PASS();
+}
+
+/* Module initialization */
+static int __init vsim_test_module_init(void)
+{
+    REGISTER_TEST("vsim_fw_echo",
+                 "Firmware IPC commands come back as events, with backpressure",
+                 test_vsim_fw_echo, NULL, 0);
+
+    REGISTER_TEST("vsim_clean_link",
+                 "Every frame on a clean link arrives in order and is acked",
+                 test_vsim_clean_link, NULL, 0);
+
+    REGISTER_TEST("vsim_loss",
+                 "Loss is retried, exhausted retries and down links fail",
+                 test_vsim_loss, NULL, 0);
+
+    REGISTER_TEST("vsim_rate",
+                 "A backlogged link delivers at its configured rate",
+                 test_vsim_rate, NULL, 0);
+
+    REGISTER_TEST("vsim_rate_ctrl",
+                 "Firmware TX rate above the link rate fails every attempt",
+                 test_vsim_rate_ctrl, NULL, 0);
+
+    REGISTER_TEST("vsim_mlo",
+                 "Two links with different rate and delay interleave frames",
+                 test_vsim_mlo, NULL, 0);
+
+    REGISTER_TEST("vsim_bench",
+                 "iperf-style goodput and latency over the virtual pair",
+                 test_vsim_bench, NULL,
+                 TEST_FLAG_BENCHMARK | TEST_FLAG_SLOW);
+
+    return 0;
+}
+
+static void __exit vsim_test_module_exit(void)
+{
+    struct test_results results;
+
+    get_test_results(&results);
+    pr_info("Virtual pair tests completed: %d passed, %d failed, %d skipped\n",
+            results.passed, results.failed, results.skipped);
+
+    UNREGISTER_TESTS();
+}
+
+module_init(vsim_test_module_init);
+module_exit(vsim_test_module_exit);
+
+MODULE_LICENSE("Dual MIT/GPL");
+MODULE_AUTHOR("Fayssal Chokri");
+MODULE_DESCRIPTION("WiFi 6E/7 Virtual AP/STA Pair Tests");
+MODULE_VERSION("1.0");
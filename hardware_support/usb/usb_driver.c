@@ -7,8 +7,15 @@
 #include <linux/usb.h>
 #include <linux/firmware.h>
 #include <linux/etherdevice.h>
+#include <linux/mm.h>
+#include <linux/skbuff.h>
+#include <linux/scatterlist.h>
+#include <linux/hrtimer.h>
 #include "usb_driver.h"
 #include "../firmware/firmware_loader.h"
+#include "../firmware/fw_common.h"
+#include "../../src/mac/wifi7_mac.h"
+#include "../../include/perf/perf_latency.h"
 
 /* Supported device table */
 static const struct usb_device_id wifi7_usb_ids[] = {
@@ -30,11 +37,55 @@ static const struct usb_device_id wifi7_usb_ids[] = {
 };
 MODULE_DEVICE_TABLE(usb, wifi7_usb_ids);
 
+static unsigned int num_rx_urbs = USB_DEF_RX_URBS;
+module_param(num_rx_urbs, uint, 0444);
+MODULE_PARM_DESC(num_rx_urbs, "RX URBs kept in flight (1-32)");
+
+static unsigned int num_tx_urbs = USB_DEF_TX_URBS;
+module_param(num_tx_urbs, uint, 0444);
+MODULE_PARM_DESC(num_tx_urbs, "TX aggregates kept in flight (1-16)");
+
+static unsigned int tx_agg_size = USB_TX_AGG_DEF_SIZE;
+module_param(tx_agg_size, uint, 0444);
+MODULE_PARM_DESC(tx_agg_size, "Max TX aggregate size in bytes");
+
+static unsigned int tx_agg_timeout_us = USB_TX_AGG_DEF_TIMEOUT_US;
+module_param(tx_agg_timeout_us, uint, 0444);
+MODULE_PARM_DESC(tx_agg_timeout_us, "Max TX aggregation delay in microseconds");
+
+struct wifi7_usb_dev;
+
+/* One TX bulk transfer and the frames it carries */
+struct wifi7_usb_tx_agg {
+    struct list_head list;              /* On tx_free when idle */
+    struct wifi7_usb_dev *usb_dev;
+    struct urb *urb;
+    struct sk_buff_head skbs;
+    u8 *buf;                            /* Linear buffer without SG */
+    unsigned int nsg;
+    struct scatterlist sg[USB_TX_AGG_MAX_SGS];
+    /* Per frame: padding of the previous frame, then its header */
+    u8 hdrs[USB_TX_AGG_MAX_FRAMES][2 * USB_TX_AGG_ALIGN];
+};
+
+/*
+ * RX page pool. Pages go back in FIFO order once an URB is done with them,
+ * while the stack may still hold fragments; a page is only handed out
+ * again when the pool holds the last reference.
+ */
+struct wifi7_usb_page_pool {
+    spinlock_t lock;
+    struct page *pages[USB_RX_POOL_SIZE];
+    unsigned int head;
+    unsigned int count;
+};
+
 /* USB device context */
 struct wifi7_usb_dev {
     struct usb_device *udev;
     struct usb_interface *intf;
     struct wifi7_dev *dev;
+    struct wifi7_mac_dev *mac;          /* TX path from the MAC core */
     
     /* Endpoints */
     u8 bulk_in_pipe;
@@ -42,15 +93,33 @@ struct wifi7_usb_dev {
     u8 intr_pipe;
     
     /* URBs */
-    struct urb *bulk_rx_urb;
+    struct urb *rx_urbs[USB_MAX_RX_URBS];
+    struct usb_anchor rx_submitted;     /* RX URBs in flight */
+    struct usb_anchor rx_parked;        /* RX URBs held back */
+    bool rx_stopping;                   /* Set once RX is torn down */
+    struct sk_buff_head rx_queue;       /* Received, awaiting delivery */
+    struct wifi7_usb_page_pool rx_pool;
     struct urb *intr_urb;
     
+    /* TX aggregation */
+    struct wifi7_usb_tx_agg *tx_aggs;
+    struct list_head tx_free;
+    struct usb_anchor tx_submitted;
+    struct sk_buff_head tx_pending;     /* Under tx_lock */
+    bool tx_stopped;                    /* Under tx_lock */
+    unsigned int tx_pending_bytes;
+    unsigned int tx_max_sgs;
+    struct hrtimer tx_timer;
+    spinlock_t tx_lock;
+    
     /* Buffers */
-    void *bulk_rx_buf;
     void *intr_buf;
     
+    /* Configuration */
+    struct wifi7_usb_config config;
+    
     /* Work items */
-    struct work_struct rx_work;
+    struct delayed_work rx_work;
     struct delayed_work stat_work;
     
     /* Device state */
@@ -66,6 +135,11 @@ struct wifi7_usb_dev {
         u32 tx_errors;
         u32 rx_dropped;
         u32 tx_dropped;
+        u32 rx_urbs_parked;
+        u32 rx_length_errors;
+        u32 rx_pages_alloc;
+        u32 rx_pages_recycled;
+        u32 tx_aggregates;
     } stats;
 };
 
@@ -89,24 +163,6 @@ static struct usb_driver wifi7_usb_driver = {
     .supports_autosuspend = 1,
 };
 
-/* Receive work handler */
-static void wifi7_usb_rx_work(struct work_struct *work)
-{
-    struct wifi7_usb_dev *usb_dev = container_of(work, struct wifi7_usb_dev,
-                                                rx_work);
-    struct urb *urb = usb_dev->bulk_rx_urb;
-    int ret;
-
-    /* Resubmit URB */
-    usb_fill_bulk_urb(urb, usb_dev->udev, usb_dev->bulk_in_pipe,
-                      usb_dev->bulk_rx_buf, USB_MAX_BULK_SIZE,
-                      wifi7_usb_rx_complete, usb_dev);
-                      
-    ret = usb_submit_urb(urb, GFP_KERNEL);
-    if (ret)
-        dev_err(&usb_dev->udev->dev, "Failed to resubmit RX URB: %d\n", ret);
-}
-
 /* Statistics work handler */
 static void wifi7_usb_stat_work(struct work_struct *work)
 {
@@ -122,26 +178,219 @@ static void wifi7_usb_stat_work(struct work_struct *work)
     schedule_delayed_work(&usb_dev->stat_work, HZ);
 }
 
+/* RX page pool */
+static struct page *wifi7_usb_rx_page_get(struct wifi7_usb_dev *usb_dev,
+                                          gfp_t gfp)
+{
+    struct wifi7_usb_page_pool *pool = &usb_dev->rx_pool;
+    struct page *page = NULL;
+    unsigned long flags;
+
+    spin_lock_irqsave(&pool->lock, flags);
+    if (pool->count) {
+        page = pool->pages[pool->head];
+        pool->head = (pool->head + 1) % USB_RX_POOL_SIZE;
+        pool->count--;
+    }
+    spin_unlock_irqrestore(&pool->lock, flags);
+
+    if (page) {
+        if (page_ref_count(page) == 1 && dev_page_is_reusable(page)) {
+            usb_dev->stats.rx_pages_recycled++;
+            return page;
+        }
+        /* Still referenced by the stack: let the last user free it */
+        put_page(page);
+    }
+
+    /* High-order pages are unlikely without reclaim: leave it to the work */
+    if (!gfpflags_allow_blocking(gfp))
+        return NULL;
+
+    page = alloc_pages(gfp | __GFP_COMP | __GFP_NOWARN, USB_RX_PAGE_ORDER);
+    if (page)
+        usb_dev->stats.rx_pages_alloc++;
+
+    return page;
+}
+
+static void wifi7_usb_rx_page_put(struct wifi7_usb_dev *usb_dev,
+                                  struct page *page)
+{
+    struct wifi7_usb_page_pool *pool = &usb_dev->rx_pool;
+    unsigned long flags;
+
+    spin_lock_irqsave(&pool->lock, flags);
+    if (pool->count < USB_RX_POOL_SIZE) {
+        pool->pages[(pool->head + pool->count) % USB_RX_POOL_SIZE] = page;
+        pool->count++;
+        page = NULL;
+    }
+    spin_unlock_irqrestore(&pool->lock, flags);
+
+    if (page)
+        put_page(page);
+}
+
+/* Stock the pool so completions find a free page without allocating */
+static void wifi7_usb_rx_pool_fill(struct wifi7_usb_dev *usb_dev)
+{
+    struct wifi7_usb_page_pool *pool = &usb_dev->rx_pool;
+    struct page *page;
+
+    while (READ_ONCE(pool->count) < usb_dev->config.num_rx_urbs) {
+        page = alloc_pages(GFP_KERNEL | __GFP_COMP | __GFP_NOWARN,
+                           USB_RX_PAGE_ORDER);
+        if (!page)
+            break;
+        usb_dev->stats.rx_pages_alloc++;
+        wifi7_usb_rx_page_put(usb_dev, page);
+    }
+}
+
+static void wifi7_usb_rx_pool_drain(struct wifi7_usb_dev *usb_dev)
+{
+    struct wifi7_usb_page_pool *pool = &usb_dev->rx_pool;
+
+    while (pool->count) {
+        put_page(pool->pages[pool->head]);
+        pool->head = (pool->head + 1) % USB_RX_POOL_SIZE;
+        pool->count--;
+    }
+}
+
+/*
+ * Give an RX URB a buffer nothing else references. The current page is
+ * kept if no frame fragments were taken from it, otherwise it goes back
+ * to the pool and a free page replaces it.
+ */
+static int wifi7_usb_rx_refill(struct wifi7_usb_dev *usb_dev,
+                               struct urb *urb, gfp_t gfp)
+{
+    struct page *page = NULL, *new;
+
+    if (urb->transfer_buffer) {
+        page = virt_to_head_page(urb->transfer_buffer);
+        if (page_ref_count(page) == 1)
+            return 0;
+    }
+
+    new = wifi7_usb_rx_page_get(usb_dev, gfp);
+    if (!new)
+        return -ENOMEM;
+
+    if (page)
+        wifi7_usb_rx_page_put(usb_dev, page);
+    urb->transfer_buffer = page_address(new);
+
+    return 0;
+}
+
+/* Split one bulk transfer into per-frame skbs over the same page */
+static void wifi7_usb_rx_deaggregate(struct wifi7_usb_dev *usb_dev,
+                                     struct urb *urb)
+{
+    struct page *page = virt_to_head_page(urb->transfer_buffer);
+    const struct wifi7_usb_rx_hdr *hdr;
+    u8 *buf = urb->transfer_buffer;
+    u32 total = urb->actual_length;
+    u32 off = 0, len, copy, end;
+    struct sk_buff *skb;
+
+    while (off + sizeof(*hdr) <= total) {
+        hdr = (const struct wifi7_usb_rx_hdr *)(buf + off);
+        len = le16_to_cpu(hdr->len);
+        off += sizeof(*hdr);
+
+        if (!len)
+            break;
+
+        if (len > total - off) {
+            usb_dev->stats.rx_length_errors++;
+            break;
+        }
+
+        skb = dev_alloc_skb(USB_RX_COPY_LEN);
+        if (!skb) {
+            usb_dev->stats.rx_dropped++;
+            goto next;
+        }
+
+        copy = min_t(u32, len, USB_RX_COPY_LEN);
+        skb_put_data(skb, buf + off, copy);
+        if (len > copy) {
+            /*
+             * Charge the frame's slice of the page up to the next header;
+             * the last frame also pins the unused rest of the page.
+             */
+            end = off + ALIGN(len, USB_RX_AGG_ALIGN);
+            if (end + sizeof(*hdr) > total)
+                end = page_size(page);
+            get_page(page);
+            skb_add_rx_frag(skb, 0, page, off + copy, len - copy,
+                            end - off - copy);
+        }
+
+        skb_queue_tail(&usb_dev->rx_queue, skb);
+        usb_dev->stats.rx_packets++;
+next:
+        off += ALIGN(len, USB_RX_AGG_ALIGN);
+    }
+}
+
 /* URB completion handlers */
+static void wifi7_usb_rx_complete(struct urb *urb);
+
+static int wifi7_usb_submit_rx_urb(struct wifi7_usb_dev *usb_dev,
+                                   struct urb *urb, gfp_t gfp)
+{
+    int ret;
+
+    usb_anchor_urb(urb, &usb_dev->rx_submitted);
+    ret = usb_submit_urb(urb, gfp);
+    if (ret)
+        usb_unanchor_urb(urb);
+
+    return ret;
+}
+
+/*
+ * Put a completed RX URB back on the bus unless the delivery backlog is
+ * too deep or no free page is available, in which case it waits on
+ * rx_parked for the RX work to retry. Atomic callers never allocate a
+ * page. Returns 0 once it is submitted.
+ */
+static int wifi7_usb_rx_resubmit(struct wifi7_usb_dev *usb_dev,
+                                 struct urb *urb, gfp_t gfp)
+{
+    int ret = -EBUSY;
+
+    if (skb_queue_len(&usb_dev->rx_queue) < USB_RX_QUEUE_HIGH) {
+        ret = wifi7_usb_rx_refill(usb_dev, urb, gfp);
+        if (!ret)
+            ret = wifi7_usb_submit_rx_urb(usb_dev, urb, gfp);
+        if (!ret)
+            return 0;
+
+        /* -EPERM means the URB was poisoned for teardown */
+        if (ret != -EPERM && ret != -ENODEV && ret != -ENOMEM)
+            dev_err_ratelimited(&usb_dev->udev->dev,
+                                "Failed to resubmit RX URB: %d\n", ret);
+    }
+
+    usb_anchor_urb(urb, &usb_dev->rx_parked);
+    usb_dev->stats.rx_urbs_parked++;
+    return ret;
+}
+
 static void wifi7_usb_rx_complete(struct urb *urb)
 {
     struct wifi7_usb_dev *usb_dev = urb->context;
-    struct sk_buff *skb;
-    int ret;
 
     switch (urb->status) {
     case 0:
         /* Process received data */
-        skb = dev_alloc_skb(urb->actual_length);
-        if (skb) {
-            memcpy(skb_put(skb, urb->actual_length),
-                   urb->transfer_buffer, urb->actual_length);
-            /* Pass to upper layer */
-            wifi7_rx_packet(usb_dev->dev, skb);
-            usb_dev->stats.rx_packets++;
-        } else {
-            usb_dev->stats.rx_dropped++;
-        }
+        wifi7_usb_rx_deaggregate(usb_dev, urb);
         break;
 
     case -ENOENT:
@@ -150,13 +399,69 @@ static void wifi7_usb_rx_complete(struct urb *urb)
         return;
 
     default:
-        dev_err(&usb_dev->udev->dev, "RX URB failed: %d\n", urb->status);
+        dev_err_ratelimited(&usb_dev->udev->dev, "RX URB failed: %d\n",
+                            urb->status);
         usb_dev->stats.rx_errors++;
         break;
     }
 
-    /* Resubmit URB via work queue */
-    schedule_work(&usb_dev->rx_work);
+    /* Resubmit at once so the bus never idles waiting on the work */
+    wifi7_usb_rx_resubmit(usb_dev, urb, GFP_ATOMIC);
+    mod_delayed_work(system_wq, &usb_dev->rx_work, 0);
+}
+
+/*
+ * Deliver queued frames, restart parked URBs once the backlog drains and
+ * allocate the pages completions could not
+ */
+static void wifi7_usb_rx_work(struct work_struct *work)
+{
+    struct wifi7_usb_dev *usb_dev = container_of(work, struct wifi7_usb_dev,
+                                                rx_work.work);
+    struct usb_anchor parked;
+    struct sk_buff *skb;
+    struct urb *urb;
+    int budget = USB_RX_BUDGET;
+    int ret = 0;
+
+    while (budget-- && (skb = skb_dequeue(&usb_dev->rx_queue)))
+        wifi7_rx_packet(usb_dev->dev, skb);
+
+    /*
+     * Take the parked URBs off rx_parked first: a failed resubmit parks
+     * its URB there again, so walking rx_parked itself would never end.
+     */
+    if (skb_queue_len(&usb_dev->rx_queue) <= USB_RX_QUEUE_LOW) {
+        init_usb_anchor(&parked);
+        while ((urb = usb_get_from_anchor(&usb_dev->rx_parked))) {
+            usb_anchor_urb(urb, &parked);
+            usb_free_urb(urb);
+        }
+
+        while (!READ_ONCE(usb_dev->rx_stopping) &&
+               (urb = usb_get_from_anchor(&parked))) {
+            ret = wifi7_usb_rx_resubmit(usb_dev, urb, GFP_KERNEL);
+            usb_free_urb(urb);
+            if (ret)
+                break;
+        }
+
+        while ((urb = usb_get_from_anchor(&parked))) {
+            usb_anchor_urb(urb, &usb_dev->rx_parked);
+            usb_free_urb(urb);
+        }
+    }
+
+    if (READ_ONCE(usb_dev->rx_stopping))
+        return;
+
+    wifi7_usb_rx_pool_fill(usb_dev);
+
+    /* Out of pages, nothing may complete to kick us: retry shortly */
+    if (!skb_queue_empty(&usb_dev->rx_queue))
+        mod_delayed_work(system_wq, &usb_dev->rx_work, 0);
+    else if (ret == -ENOMEM)
+        schedule_delayed_work(&usb_dev->rx_work, USB_RX_REFILL_DELAY);
 }
 
 static void wifi7_usb_intr_complete(struct urb *urb)
@@ -185,6 +490,426 @@ static void wifi7_usb_intr_complete(struct urb *urb)
         dev_err(&usb_dev->udev->dev, "Failed to resubmit INT URB: %d\n", ret);
 }
 
+static void wifi7_usb_free_rx_urbs(struct wifi7_usb_dev *usb_dev)
+{
+    struct urb *urb;
+    int i;
+
+    for (i = 0; i < USB_MAX_RX_URBS; i++) {
+        urb = usb_dev->rx_urbs[i];
+        if (!urb)
+            continue;
+
+        if (urb->transfer_buffer)
+            put_page(virt_to_head_page(urb->transfer_buffer));
+        usb_free_urb(urb);
+        usb_dev->rx_urbs[i] = NULL;
+    }
+
+    wifi7_usb_rx_pool_drain(usb_dev);
+}
+
+static int wifi7_usb_alloc_rx_urbs(struct wifi7_usb_dev *usb_dev)
+{
+    struct usb_device *udev = usb_dev->udev;
+    unsigned int pipe = usb_rcvbulkpipe(udev, usb_dev->bulk_in_pipe);
+    struct urb *urb;
+    int i;
+
+    spin_lock_init(&usb_dev->rx_pool.lock);
+    usb_dev->rx_pool.head = 0;
+    usb_dev->rx_pool.count = 0;
+
+    for (i = 0; i < usb_dev->config.num_rx_urbs; i++) {
+        urb = usb_alloc_urb(0, GFP_KERNEL);
+        if (!urb)
+            goto err;
+
+        /* The buffer is a pool page, mapped by the USB core per submit */
+        usb_fill_bulk_urb(urb, udev, pipe, NULL, USB_MAX_BULK_SIZE,
+                          wifi7_usb_rx_complete, usb_dev);
+        usb_dev->rx_urbs[i] = urb;
+
+        if (wifi7_usb_rx_refill(usb_dev, urb, GFP_KERNEL))
+            goto err;
+    }
+
+    return 0;
+
+err:
+    wifi7_usb_free_rx_urbs(usb_dev);
+    return -ENOMEM;
+}
+
+/* Stop RX for good: in-flight URBs are killed and cannot be resubmitted */
+static void wifi7_usb_stop_rx(struct wifi7_usb_dev *usb_dev)
+{
+    int i;
+
+    WRITE_ONCE(usb_dev->rx_stopping, true);
+    for (i = 0; i < USB_MAX_RX_URBS; i++) {
+        if (usb_dev->rx_urbs[i])
+            usb_poison_urb(usb_dev->rx_urbs[i]);
+    }
+
+    cancel_delayed_work_sync(&usb_dev->rx_work);
+    usb_scuttle_anchored_urbs(&usb_dev->rx_parked);
+    skb_queue_purge(&usb_dev->rx_queue);
+}
+
+/* Bytes a frame adds to an aggregate, including its header and padding */
+static unsigned int wifi7_usb_tx_cost(const struct sk_buff *skb)
+{
+    return sizeof(struct wifi7_usb_tx_hdr) + ALIGN(skb->len, USB_TX_AGG_ALIGN);
+}
+
+/* Move as many pending frames as fit into @agg; caller holds tx_lock */
+static unsigned int wifi7_usb_tx_build(struct wifi7_usb_dev *usb_dev,
+                                       struct wifi7_usb_tx_agg *agg)
+{
+    struct wifi7_usb_tx_hdr *hdr;
+    unsigned int frames = 0, cost = 0, len = 0, pad = 0, need;
+    struct sk_buff *skb;
+    u8 *slot;
+    int n;
+
+    agg->nsg = 0;
+    if (usb_dev->config.use_sg)
+        sg_init_table(agg->sg, usb_dev->tx_max_sgs);
+
+    while ((skb = skb_peek(&usb_dev->tx_pending))) {
+        need = usb_dev->config.use_sg ? 2 + skb_shinfo(skb)->nr_frags : 0;
+        if (frames && (frames == USB_TX_AGG_MAX_FRAMES ||
+                       cost + wifi7_usb_tx_cost(skb) >
+                       usb_dev->config.tx_agg_size ||
+                       agg->nsg + need > usb_dev->tx_max_sgs))
+            break;
+
+        __skb_unlink(skb, &usb_dev->tx_pending);
+        usb_dev->tx_pending_bytes -= wifi7_usb_tx_cost(skb);
+        cost += wifi7_usb_tx_cost(skb);
+
+        slot = agg->hdrs[frames];
+        memset(slot, 0, pad);
+        hdr = (struct wifi7_usb_tx_hdr *)(slot + pad);
+        hdr->len = cpu_to_le16(skb->len);
+        hdr->flags = 0;
+        hdr->info = 0;
+
+        if (usb_dev->config.use_sg) {
+            sg_set_buf(&agg->sg[agg->nsg++], slot, pad + sizeof(*hdr));
+            n = skb_to_sgvec_nomark(skb, &agg->sg[agg->nsg], 0, skb->len);
+            if (n < 0) {
+                /* Take the header back out and drop this frame alone */
+                agg->nsg--;
+                cost -= wifi7_usb_tx_cost(skb);
+                usb_dev->stats.tx_dropped++;
+                dev_kfree_skb_any(skb);
+                continue;
+            }
+            agg->nsg += n;
+        } else {
+            memcpy(agg->buf + len, slot, pad + sizeof(*hdr));
+            skb_copy_bits(skb, 0, agg->buf + len + pad + sizeof(*hdr),
+                          skb->len);
+        }
+
+        len += pad + sizeof(*hdr) + skb->len;
+        pad = ALIGN(skb->len, USB_TX_AGG_ALIGN) - skb->len;
+        wifi67_lat_stamp(skb, WIFI67_LAT_DMA_POST);
+        __skb_queue_tail(&agg->skbs, skb);
+        frames++;
+    }
+
+    if (usb_dev->config.use_sg && agg->nsg)
+        sg_mark_end(&agg->sg[agg->nsg - 1]);
+
+    return len;
+}
+
+static void wifi7_usb_tx_complete(struct urb *urb);
+
+/* Hand back an aggregate's frames; caller must not hold tx_lock */
+static void wifi7_usb_tx_done(struct wifi7_usb_tx_agg *agg, int status)
+{
+    struct wifi7_usb_dev *usb_dev = agg->usb_dev;
+    unsigned long flags;
+    struct sk_buff *skb;
+
+    while ((skb = __skb_dequeue(&agg->skbs))) {
+        if (status) {
+            usb_dev->stats.tx_errors++;
+        } else {
+            usb_dev->stats.tx_packets++;
+            /* A USB device runs a single link */
+            wifi67_lat_tx_done(usb_dev->dev->priv, skb, 0);
+        }
+        dev_kfree_skb_any(skb);
+    }
+
+    spin_lock_irqsave(&usb_dev->tx_lock, flags);
+    list_add(&agg->list, &usb_dev->tx_free);
+    spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+}
+
+/*
+ * Send pending frames. Without @force only full aggregates go out and a
+ * partial tail is left for the timer or the next completion.
+ */
+static void wifi7_usb_tx_kick(struct wifi7_usb_dev *usb_dev, bool force)
+{
+    unsigned int pipe = usb_sndbulkpipe(usb_dev->udev, usb_dev->bulk_out_pipe);
+    struct wifi7_usb_tx_agg *agg;
+    unsigned long flags;
+    unsigned int len;
+    int ret;
+
+    for (;;) {
+        spin_lock_irqsave(&usb_dev->tx_lock, flags);
+        if (usb_dev->tx_stopped || skb_queue_empty(&usb_dev->tx_pending) ||
+            list_empty(&usb_dev->tx_free) ||
+            (!force && usb_dev->tx_pending_bytes < usb_dev->config.tx_agg_size &&
+             skb_queue_len(&usb_dev->tx_pending) < USB_TX_AGG_MAX_FRAMES)) {
+            spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+            return;
+        }
+
+        agg = list_first_entry(&usb_dev->tx_free, struct wifi7_usb_tx_agg,
+                               list);
+        list_del(&agg->list);
+        len = wifi7_usb_tx_build(usb_dev, agg);
+        spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+
+        usb_fill_bulk_urb(agg->urb, usb_dev->udev, pipe,
+                          usb_dev->config.use_sg ? NULL : agg->buf, len,
+                          wifi7_usb_tx_complete, agg);
+        agg->urb->sg = usb_dev->config.use_sg ? agg->sg : NULL;
+        agg->urb->num_sgs = usb_dev->config.use_sg ? agg->nsg : 0;
+        agg->urb->transfer_flags |= URB_ZERO_PACKET;
+
+        usb_anchor_urb(agg->urb, &usb_dev->tx_submitted);
+        ret = usb_submit_urb(agg->urb, GFP_ATOMIC);
+        if (ret) {
+            usb_unanchor_urb(agg->urb);
+            if (ret != -EPERM && ret != -ENODEV)
+                dev_err_ratelimited(&usb_dev->udev->dev,
+                                    "Failed to submit TX URB: %d\n", ret);
+            wifi7_usb_tx_done(agg, ret);
+            return;
+        }
+
+        usb_dev->stats.tx_aggregates++;
+    }
+}
+
+static void wifi7_usb_tx_complete(struct urb *urb)
+{
+    struct wifi7_usb_tx_agg *agg = urb->context;
+    struct wifi7_usb_dev *usb_dev = agg->usb_dev;
+
+    switch (urb->status) {
+    case 0:
+    case -ENOENT:
+    case -ECONNRESET:
+    case -ESHUTDOWN:
+        break;
+
+    default:
+        dev_err_ratelimited(&usb_dev->udev->dev, "TX URB failed: %d\n",
+                            urb->status);
+        break;
+    }
+
+    wifi7_usb_tx_done(agg, urb->status);
+
+    /* A slot is free again: send whatever queued up meanwhile */
+    wifi7_usb_tx_kick(usb_dev, true);
+}
+
+static enum hrtimer_restart wifi7_usb_tx_timer(struct hrtimer *timer)
+{
+    struct wifi7_usb_dev *usb_dev = container_of(timer, struct wifi7_usb_dev,
+                                                tx_timer);
+
+    wifi7_usb_tx_kick(usb_dev, true);
+    return HRTIMER_NORESTART;
+}
+
+/*
+ * MAC core tx_frame op: queue a frame for transmission. On error @skb is
+ * not consumed; -EBUSY means the aggregation queue is full and the caller
+ * should hold the frame and retry.
+ */
+static int wifi7_usb_tx(struct wifi7_mac_dev *mac, struct sk_buff *skb,
+                        u8 link_id)
+{
+    struct wifi7_usb_dev *usb_dev = mac->hw_priv;
+    unsigned long flags;
+    unsigned int max_len;
+    bool idle, full;
+
+    if (!usb_dev || !usb_dev->initialized)
+        return -ENODEV;
+
+    /* Without SG a frame is copied whole into the aggregate buffer */
+    max_len = usb_dev->config.use_sg ? USB_MAX_BULK_SIZE :
+                                       usb_dev->config.tx_agg_size;
+    if (skb->len > max_len - sizeof(struct wifi7_usb_tx_hdr))
+        return -EMSGSIZE;
+
+    /* SG entries are built from the head and page frags only */
+    if (skb_has_frag_list(skb) && skb_linearize(skb))
+        return -ENOMEM;
+
+    spin_lock_irqsave(&usb_dev->tx_lock, flags);
+    if (usb_dev->tx_stopped) {
+        spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+        return -ENODEV;
+    }
+    if (skb_queue_len(&usb_dev->tx_pending) >= USB_TX_QUEUE_MAX) {
+        spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+        return -EBUSY;
+    }
+
+    __skb_queue_tail(&usb_dev->tx_pending, skb);
+    usb_dev->tx_pending_bytes += wifi7_usb_tx_cost(skb);
+    full = usb_dev->tx_pending_bytes >= usb_dev->config.tx_agg_size ||
+           skb_queue_len(&usb_dev->tx_pending) >= USB_TX_AGG_MAX_FRAMES;
+    spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+
+    /* Nothing in flight: waiting would only add latency */
+    idle = usb_anchor_empty(&usb_dev->tx_submitted);
+
+    if (idle || full)
+        wifi7_usb_tx_kick(usb_dev, idle);
+    else if (!hrtimer_active(&usb_dev->tx_timer))
+        hrtimer_start(&usb_dev->tx_timer,
+                      us_to_ktime(usb_dev->config.tx_agg_timeout_us),
+                      HRTIMER_MODE_REL);
+
+    return 0;
+}
+
+/*
+ * MAC core tx_flush op: its queue ran empty, send everything queued. Under
+ * RCU like tx_frame, which runs under a BH lock, so that stopping TX can
+ * wait for both.
+ */
+static void wifi7_usb_tx_flush(struct wifi7_mac_dev *mac)
+{
+    struct wifi7_usb_dev *usb_dev = mac->hw_priv;
+
+    rcu_read_lock();
+    if (usb_dev && usb_dev->initialized)
+        wifi7_usb_tx_kick(usb_dev, true);
+    rcu_read_unlock();
+}
+
+static struct wifi7_mac_ops wifi7_usb_mac_ops = {
+    .tx_frame = wifi7_usb_tx,
+    .tx_flush = wifi7_usb_tx_flush,
+};
+
+static void wifi7_usb_free_tx(struct wifi7_usb_dev *usb_dev)
+{
+    int i;
+
+    if (!usb_dev->tx_aggs)
+        return;
+
+    for (i = 0; i < usb_dev->config.num_tx_urbs; i++) {
+        usb_free_urb(usb_dev->tx_aggs[i].urb);
+        kfree(usb_dev->tx_aggs[i].buf);
+    }
+
+    kfree(usb_dev->tx_aggs);
+    usb_dev->tx_aggs = NULL;
+}
+
+static int wifi7_usb_alloc_tx(struct wifi7_usb_dev *usb_dev)
+{
+    struct wifi7_usb_tx_agg *agg;
+    int i;
+
+    INIT_LIST_HEAD(&usb_dev->tx_free);
+    init_usb_anchor(&usb_dev->tx_submitted);
+    __skb_queue_head_init(&usb_dev->tx_pending);
+    usb_dev->tx_pending_bytes = 0;
+    usb_dev->tx_stopped = false;
+    spin_lock_init(&usb_dev->tx_lock);
+    hrtimer_init(&usb_dev->tx_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    usb_dev->tx_timer.function = wifi7_usb_tx_timer;
+
+    /* The host controller may take fewer SG entries than an aggregate */
+    usb_dev->tx_max_sgs = min_t(unsigned int, USB_TX_AGG_MAX_SGS,
+                                usb_dev->udev->bus->sg_tablesize);
+    usb_dev->config.use_sg = (usb_dev->config.capabilities & USB_CAP_BULK_SG) &&
+                             usb_dev->tx_max_sgs >= 2 + MAX_SKB_FRAGS;
+    if (usb_dev->config.use_sg)
+        usb_dev->config.flags |= USB_FLAG_BULK_SG;
+    else
+        usb_dev->config.flags &= ~USB_FLAG_BULK_SG;
+
+    usb_dev->tx_aggs = kcalloc(usb_dev->config.num_tx_urbs,
+                               sizeof(*usb_dev->tx_aggs), GFP_KERNEL);
+    if (!usb_dev->tx_aggs)
+        return -ENOMEM;
+
+    for (i = 0; i < usb_dev->config.num_tx_urbs; i++) {
+        agg = &usb_dev->tx_aggs[i];
+        agg->usb_dev = usb_dev;
+        __skb_queue_head_init(&agg->skbs);
+
+        agg->urb = usb_alloc_urb(0, GFP_KERNEL);
+        if (!agg->urb)
+            goto err;
+
+        if (!usb_dev->config.use_sg) {
+            agg->buf = kmalloc(usb_dev->config.tx_agg_size, GFP_KERNEL);
+            if (!agg->buf)
+                goto err;
+        }
+
+        list_add_tail(&agg->list, &usb_dev->tx_free);
+    }
+
+    return 0;
+
+err:
+    wifi7_usb_free_tx(usb_dev);
+    return -ENOMEM;
+}
+
+/*
+ * Stop TX: in-flight aggregates are killed and queued frames dropped.
+ * Once tx_stopped is set nothing new is queued or submitted; the grace
+ * period waits out callers already past that check, which may still arm
+ * the timer, before the timer and URBs are torn down.
+ */
+static void wifi7_usb_stop_tx(struct wifi7_usb_dev *usb_dev)
+{
+    struct sk_buff_head purge;
+    unsigned long flags;
+    int i;
+
+    __skb_queue_head_init(&purge);
+
+    spin_lock_irqsave(&usb_dev->tx_lock, flags);
+    usb_dev->tx_stopped = true;
+    skb_queue_splice_init(&usb_dev->tx_pending, &purge);
+    usb_dev->tx_pending_bytes = 0;
+    spin_unlock_irqrestore(&usb_dev->tx_lock, flags);
+
+    synchronize_net();
+    hrtimer_cancel(&usb_dev->tx_timer);
+
+    for (i = 0; i < usb_dev->config.num_tx_urbs; i++)
+        usb_poison_urb(usb_dev->tx_aggs[i].urb);
+
+    usb_dev->stats.tx_dropped += skb_queue_len(&purge);
+    __skb_queue_purge(&purge);
+}
+
 /* Device initialization */
 static int wifi7_usb_init_device(struct wifi7_usb_dev *usb_dev)
 {
@@ -208,24 +933,24 @@ static int wifi7_usb_init_device(struct wifi7_usb_dev *usb_dev)
             usb_dev->intr_pipe = endpoint->bEndpointAddress;
     }
 
-    /* Allocate URBs */
-    usb_dev->bulk_rx_urb = usb_alloc_urb(0, GFP_KERNEL);
-    if (!usb_dev->bulk_rx_urb)
-        return -ENOMEM;
+    /* Allocate URBs and buffers */
+    init_usb_anchor(&usb_dev->rx_submitted);
+    init_usb_anchor(&usb_dev->rx_parked);
+    usb_dev->rx_stopping = false;
+    skb_queue_head_init(&usb_dev->rx_queue);
 
-    usb_dev->intr_urb = usb_alloc_urb(0, GFP_KERNEL);
-    if (!usb_dev->intr_urb) {
-        ret = -ENOMEM;
+    ret = wifi7_usb_alloc_rx_urbs(usb_dev);
+    if (ret)
+        return ret;
+
+    ret = wifi7_usb_alloc_tx(usb_dev);
+    if (ret)
         goto err_free_rx;
-    }
 
-    /* Allocate buffers */
-    usb_dev->bulk_rx_buf = usb_alloc_coherent(udev, USB_MAX_BULK_SIZE,
-                                             GFP_KERNEL,
-                                             &usb_dev->bulk_rx_urb->transfer_dma);
-    if (!usb_dev->bulk_rx_buf) {
+    usb_dev->intr_urb = usb_alloc_urb(0, GFP_KERNEL);
+    if (!usb_dev->intr_urb) {
         ret = -ENOMEM;
-        goto err_free_intr;
+        goto err_free_tx;
     }
 
     usb_dev->intr_buf = usb_alloc_coherent(udev, USB_MAX_INTR_SIZE,
@@ -233,28 +958,26 @@ static int wifi7_usb_init_device(struct wifi7_usb_dev *usb_dev)
                                           &usb_dev->intr_urb->transfer_dma);
     if (!usb_dev->intr_buf) {
         ret = -ENOMEM;
-        goto err_free_rx_buf;
+        goto err_free_intr;
     }
 
     /* Initialize work items */
-    INIT_WORK(&usb_dev->rx_work, wifi7_usb_rx_work);
+    INIT_DELAYED_WORK(&usb_dev->rx_work, wifi7_usb_rx_work);
     INIT_DELAYED_WORK(&usb_dev->stat_work, wifi7_usb_stat_work);
 
     /* Setup URBs */
-    usb_fill_bulk_urb(usb_dev->bulk_rx_urb, udev, usb_dev->bulk_in_pipe,
-                      usb_dev->bulk_rx_buf, USB_MAX_BULK_SIZE,
-                      wifi7_usb_rx_complete, usb_dev);
-    usb_dev->bulk_rx_urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
-
     usb_fill_int_urb(usb_dev->intr_urb, udev, usb_dev->intr_pipe,
                      usb_dev->intr_buf, USB_MAX_INTR_SIZE,
                      wifi7_usb_intr_complete, usb_dev, 1);
     usb_dev->intr_urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
 
     /* Submit URBs */
-    ret = usb_submit_urb(usb_dev->bulk_rx_urb, GFP_KERNEL);
-    if (ret)
-        goto err_free_intr_buf;
+    for (i = 0; i < usb_dev->config.num_rx_urbs; i++) {
+        ret = wifi7_usb_submit_rx_urb(usb_dev, usb_dev->rx_urbs[i],
+                                      GFP_KERNEL);
+        if (ret)
+            goto err_kill_rx;
+    }
 
     ret = usb_submit_urb(usb_dev->intr_urb, GFP_KERNEL);
     if (ret)
@@ -267,17 +990,15 @@ static int wifi7_usb_init_device(struct wifi7_usb_dev *usb_dev)
     return 0;
 
 err_kill_rx:
-    usb_kill_urb(usb_dev->bulk_rx_urb);
-err_free_intr_buf:
+    wifi7_usb_stop_rx(usb_dev);
     usb_free_coherent(udev, USB_MAX_INTR_SIZE, usb_dev->intr_buf,
                       usb_dev->intr_urb->transfer_dma);
-err_free_rx_buf:
-    usb_free_coherent(udev, USB_MAX_BULK_SIZE, usb_dev->bulk_rx_buf,
-                      usb_dev->bulk_rx_urb->transfer_dma);
 err_free_intr:
     usb_free_urb(usb_dev->intr_urb);
+err_free_tx:
+    wifi7_usb_free_tx(usb_dev);
 err_free_rx:
-    usb_free_urb(usb_dev->bulk_rx_urb);
+    wifi7_usb_free_rx_urbs(usb_dev);
     return ret;
 }
 
@@ -287,27 +1008,22 @@ static void wifi7_usb_deinit_device(struct wifi7_usb_dev *usb_dev)
     if (!usb_dev->initialized)
         return;
 
-    /* Cancel work items */
-    cancel_work_sync(&usb_dev->rx_work);
+    /* Cancel work items and kill URBs */
+    usb_dev->initialized = false;
     cancel_delayed_work_sync(&usb_dev->stat_work);
-
-    /* Kill URBs */
-    usb_kill_urb(usb_dev->bulk_rx_urb);
+    wifi7_usb_stop_tx(usb_dev);
+    wifi7_usb_stop_rx(usb_dev);
     usb_kill_urb(usb_dev->intr_urb);
 
     /* Free buffers */
-    usb_free_coherent(usb_dev->udev, USB_MAX_BULK_SIZE,
-                      usb_dev->bulk_rx_buf,
-                      usb_dev->bulk_rx_urb->transfer_dma);
     usb_free_coherent(usb_dev->udev, USB_MAX_INTR_SIZE,
                       usb_dev->intr_buf,
                       usb_dev->intr_urb->transfer_dma);
 
     /* Free URBs */
-    usb_free_urb(usb_dev->bulk_rx_urb);
+    wifi7_usb_free_tx(usb_dev);
+    wifi7_usb_free_rx_urbs(usb_dev);
     usb_free_urb(usb_dev->intr_urb);
-
-    usb_dev->initialized = false;
 }
 
 /* USB driver callbacks */
@@ -327,6 +1043,23 @@ static int wifi7_usb_probe(struct usb_interface *intf,
     usb_dev->udev = udev;
     usb_dev->intf = intf;
     spin_lock_init(&usb_dev->lock);
+    usb_dev->config.num_rx_urbs = clamp_t(unsigned int, num_rx_urbs, 1,
+                                          USB_MAX_RX_URBS);
+    usb_dev->config.num_tx_urbs = clamp_t(unsigned int, num_tx_urbs, 1,
+                                          USB_MAX_TX_URBS);
+    usb_dev->config.tx_agg_size = clamp_t(unsigned int, tx_agg_size,
+                                          PAGE_SIZE, USB_MAX_BULK_SIZE);
+    usb_dev->config.tx_agg_timeout_us = tx_agg_timeout_us;
+    /*
+     * Aggregate headers are short SG entries, so the controller must
+     * accept entries that are not multiples of the max packet size.
+     */
+    if (udev->bus->sg_tablesize && udev->bus->no_sg_constraint)
+        usb_dev->config.capabilities |= USB_CAP_BULK_SG;
+    if (udev->speed >= USB_SPEED_SUPER)
+        usb_dev->config.capabilities |= USB_CAP_SS;
+    if (udev->speed >= USB_SPEED_SUPER_PLUS)
+        usb_dev->config.capabilities |= USB_CAP_SSP;
 
     /* Set interface data */
     usb_set_intfdata(intf, usb_dev);
@@ -341,9 +1074,24 @@ static int wifi7_usb_probe(struct usb_interface *intf,
     if (ret)
         goto err_deinit;
 
+    /* Frames sent through the MAC core land in wifi7_usb_tx() */
+    usb_dev->mac = wifi7_mac_alloc(&intf->dev);
+    if (!usb_dev->mac) {
+        ret = -ENOMEM;
+        goto err_deinit;
+    }
+    usb_dev->mac->ops = &wifi7_usb_mac_ops;
+    usb_dev->mac->hw_priv = usb_dev;
+
+    ret = wifi7_mac_register(usb_dev->mac);
+    if (ret)
+        goto err_free_mac;
+
     dev_info(&udev->dev, "WiFi 7 USB device initialized\n");
     return 0;
 
+err_free_mac:
+    wifi7_mac_free(usb_dev->mac);
 err_deinit:
     wifi7_usb_deinit_device(usb_dev);
 err_free:
@@ -359,7 +1107,9 @@ static void wifi7_usb_disconnect(struct usb_interface *intf)
         return;
 
     /* Clean up device */
+    wifi7_mac_unregister(usb_dev->mac);
     wifi7_usb_deinit_device(usb_dev);
+    wifi7_mac_free(usb_dev->mac);
 
     /* Free device context */
     kfree(usb_dev);
@@ -419,6 +1169,7 @@ static int __init wifi7_usb_init(void)
 static void __exit wifi7_usb_exit(void)
 {
     usb_deregister(&wifi7_usb_driver);
+    fw_hash_exit();
     pr_info("WiFi 7 USB driver unloaded\n");
 }
 
@@ -14,6 +14,65 @@
 #define USB_MAX_BULK_SIZE    (64 * 1024)  /* 64KB */
 #define USB_MAX_INTR_SIZE    64           /* 64 bytes */
 
+/*
+ * RX URB pool. Completed transfers are queued for delivery and the URB is
+ * resubmitted straight from its completion handler; once the delivery
+ * backlog reaches RX_QUEUE_HIGH, URBs are parked instead and resubmitted
+ * when it drains below RX_QUEUE_LOW.
+ */
+#define USB_DEF_RX_URBS      8
+#define USB_MAX_RX_URBS      32
+#define USB_RX_QUEUE_HIGH    1024         /* Frames */
+#define USB_RX_QUEUE_LOW     256          /* Frames */
+#define USB_RX_BUDGET        64           /* Frames per delivery pass */
+
+/*
+ * RX aggregation. A bulk IN transfer carries one or more frames, each
+ * preceded by a wifi7_usb_rx_hdr and padded to USB_RX_AGG_ALIGN; a zero
+ * length header ends the transfer early. Transfers land in pool pages
+ * and each frame's payload is attached to its skb as a page fragment,
+ * only the first USB_RX_COPY_LEN bytes are copied so headers are linear.
+ */
+#define USB_RX_AGG_ALIGN     8
+#define USB_RX_COPY_LEN      128
+#define USB_RX_PAGE_ORDER    get_order(USB_MAX_BULK_SIZE)
+#define USB_RX_POOL_SIZE     64           /* Pages */
+
+/*
+ * Completions only reuse pages; new pages are allocated by the RX work,
+ * which retries this often while parked URBs wait for one.
+ */
+#define USB_RX_REFILL_DELAY  msecs_to_jiffies(10)
+
+struct wifi7_usb_rx_hdr {
+    __le16 len;              /* Frame bytes that follow */
+    __le16 flags;
+    __le32 info;
+} __packed;
+
+/*
+ * TX aggregation, the mirror of the RX format: frames are queued and sent
+ * several per bulk OUT transfer, each behind a wifi7_usb_tx_hdr and
+ * padded to USB_TX_AGG_ALIGN. With USB_CAP_BULK_SG the transfer is a
+ * scatter-gather URB over the skb data, otherwise frames are copied into
+ * a linear buffer. An aggregate is sent once it reaches the configured
+ * size, when the timeout expires, or at once if no TX URB is in flight.
+ */
+#define USB_DEF_TX_URBS      4
+#define USB_MAX_TX_URBS      16
+#define USB_TX_AGG_ALIGN     8
+#define USB_TX_AGG_MAX_FRAMES 32
+#define USB_TX_AGG_MAX_SGS   64           /* SG entries per aggregate */
+#define USB_TX_AGG_DEF_SIZE  (16 * 1024)
+#define USB_TX_AGG_DEF_TIMEOUT_US 100
+#define USB_TX_QUEUE_MAX     1024         /* Frames awaiting aggregation */
+
+struct wifi7_usb_tx_hdr {
+    __le16 len;              /* Frame bytes that follow */
+    __le16 flags;
+    __le32 info;
+} __packed;
+
 /* USB timeout values (in milliseconds) */
 #define USB_CTRL_TIMEOUT     1000
 #define USB_BULK_TIMEOUT     2000
@@ -67,6 +126,10 @@ struct wifi7_usb_stats {
     u32 tx_timeouts;         /* TX timeouts */
     u32 resets;              /* Device resets */
     u32 recovery_complete;   /* Recovery complete */
+    u32 rx_urbs_parked;      /* RX URBs held back by backpressure */
+    u32 rx_pages_alloc;      /* RX pages newly allocated */
+    u32 rx_pages_recycled;   /* RX pages reused from the pool */
+    u32 tx_aggregates;       /* TX bulk transfers sent */
 };
 
 /* USB device configuration */
@@ -86,6 +149,8 @@ struct wifi7_usb_config {
     u8 tx_urb_size;         /* TX URB size */
     bool use_dma;           /* Use DMA */
     bool use_sg;            /* Use scatter-gather */
+    u32 tx_agg_size;        /* Max TX aggregate bytes */
+    u32 tx_agg_timeout_us;  /* Max TX aggregation delay */
 };
 
 /* Function prototypes */
@@ -95,7 +160,6 @@ void wifi7_usb_deinit(struct wifi7_dev *dev);
 int wifi7_usb_start(struct wifi7_dev *dev);
 void wifi7_usb_stop(struct wifi7_dev *dev);
 
-int wifi7_usb_tx(struct wifi7_dev *dev, struct sk_buff *skb);
 void wifi7_usb_rx(struct wifi7_dev *dev, struct sk_buff *skb);
 
 int wifi7_usb_set_config(struct wifi7_dev *dev,
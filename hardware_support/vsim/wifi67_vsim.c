@@ -0,0 +1,1052 @@
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/device.h>
+#include <linux/dma-mapping.h>
+#include <linux/dma-direct.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
+#include <linux/wait.h>
+#include <linux/random.h>
+#include <linux/idr.h>
+#include <linux/io.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include "wifi67_vsim.h"
+#include "../../include/mac/mac_core.h"
+#include "../../include/dma/dma_core.h"
+#include "../../include/firmware/fw_regs.h"
+#include "../../include/debug/debug.h"
+#include "../../include/core/emlrc.h"
+#include "../../include/perf/perf_latency.h"
+#include "../../include/perf/perf_monitor.h"
+
+#define WIFI67_VSIM_FW_VERSION      0x00010000
+#define WIFI67_VSIM_FETCH_BUDGET    64      /* Descriptors per link per pass */
+
+#define WIFI67_VSIM_CMD_MASK        (WIFI67_IPC_CMD_ENTRIES - 1)
+#define WIFI67_VSIM_EVT_MASK        (WIFI67_IPC_EVT_ENTRIES - 1)
+
+enum wifi67_vsim_frame_kind {
+    WIFI67_VSIM_FRAME_DATA,         /* Reaches the peer's RX ring */
+    WIFI67_VSIM_FRAME_STATUS,       /* Reaches the sender's firmware */
+};
+
+/* A frame or a TX status on the medium, ordered by due time */
+struct wifi67_vsim_frame {
+    struct list_head list;
+    ktime_t due;
+    ktime_t fetched;
+    u8 kind;
+    u8 src;
+    struct wifi67_vsim_evt_txs txs;
+    u32 len;
+    u8 data[];
+};
+
+struct wifi67_vsim_radio {
+    struct wifi67_vsim *vsim;
+    enum wifi67_vsim_role role;
+    struct wifi67_priv priv;
+    struct wifi67_hw_info hw;
+    struct device *dev;
+    void *regs;
+    u8 num_chans;               /* DMA channels set up, for teardown */
+
+    /* Host side */
+    const struct wifi67_vsim_ops *ops;
+    void *ops_data;
+    struct sk_buff_head tx_pending[WIFI67_VSIM_MAX_LINKS];
+    struct wifi67_ipc ipc;
+    void *ipc_shared;
+    struct work_struct poll_work;       /* Interrupt bottom half */
+
+    /* Device side */
+    struct work_struct engine_work;     /* TX descriptor fetch */
+    struct work_struct fw_work;
+    u32 dev_tx_idx[WIFI67_VSIM_MAX_LINKS];
+    u32 dev_rx_idx[WIFI67_VSIM_MAX_LINKS];
+    u32 fw_cmd_cons;
+    u32 fw_evt_prod;
+
+    /* Under vsim->lock */
+    u32 tx_seq[WIFI67_VSIM_MAX_LINKS];
+    u32 tx_rate[WIFI67_VSIM_MAX_LINKS];
+    struct list_head fw_backlog;        /* TX status awaiting event slots */
+    struct wifi67_vsim_link_stats stats[WIFI67_VSIM_MAX_LINKS];
+};
+
+struct wifi67_vsim {
+    struct wifi67_vsim_radio radios[WIFI67_VSIM_NUM_ROLES];
+    struct wifi67_vsim_link_params links[WIFI67_VSIM_MAX_LINKS];
+    u8 num_links;
+    int id;
+
+    /* Medium: frames in flight and per-link occupancy */
+    spinlock_t lock;
+    struct list_head air;
+    ktime_t busy_until[WIFI67_VSIM_MAX_LINKS];
+    ktime_t status_due[WIFI67_VSIM_MAX_LINKS];
+    struct hrtimer timer;
+    bool dead;
+
+    atomic_t in_flight;         /* Posted, TX status not yet handled */
+    wait_queue_head_t idle;
+
+    struct dentry *debugfs_dir;
+};
+
+static DEFINE_IDA(wifi67_vsim_ida);
+
+static const char * const wifi67_vsim_role_names[] = {
+    [WIFI67_VSIM_AP] = "ap",
+    [WIFI67_VSIM_STA] = "sta",
+};
+
+static void wifi67_vsim_kick(struct wifi67_vsim *vsim, struct work_struct *work)
+{
+    if (!READ_ONCE(vsim->dead))
+        queue_work(system_highpri_wq, work);
+}
+
+/* The device is direct-mapped, so a bus address is a physical address */
+static void *wifi67_vsim_bus_to_virt(struct wifi67_vsim_radio *radio, u32 addr)
+{
+    return phys_to_virt(dma_to_phys(radio->dev, addr));
+}
+
+static bool wifi67_vsim_chan_running(struct wifi67_dma_channel *chan)
+{
+    return readl(chan->regs + WIFI67_DMA_REG_RING_CTRL) & WIFI67_DMA_RING_ENABLE;
+}
+
+/* Insert keeping due order; equal times stay in insertion order */
+static void wifi67_vsim_air_insert(struct wifi67_vsim *vsim,
+                                   struct wifi67_vsim_frame *frame)
+{
+    struct wifi67_vsim_frame *pos;
+
+    list_for_each_entry_reverse(pos, &vsim->air, list) {
+        if (!ktime_before(frame->due, pos->due)) {
+            list_add(&frame->list, &pos->list);
+            return;
+        }
+    }
+    list_add(&frame->list, &vsim->air);
+}
+
+static void wifi67_vsim_air_arm(struct wifi67_vsim *vsim)
+{
+    struct wifi67_vsim_frame *next;
+
+    next = list_first_entry_or_null(&vsim->air, struct wifi67_vsim_frame,
+                                    list);
+    if (next && !vsim->dead)
+        hrtimer_start(&vsim->timer, next->due, HRTIMER_MODE_ABS_SOFT);
+}
+
+/*
+ * Put a fetched frame on the medium. Airtime is charged for every
+ * attempt; the TX status is due one propagation delay after the last
+ * attempt whatever the outcome. Statuses on a link must come back in
+ * posting order, since that is how the host matches them to frames.
+ */
+static void wifi67_vsim_air_tx(struct wifi67_vsim_radio *radio, u8 link_id,
+                               struct wifi67_vsim_frame *frame,
+                               struct wifi67_vsim_frame *status)
+{
+    struct wifi67_vsim *vsim = radio->vsim;
+    struct wifi67_vsim_link_params *lp = &vsim->links[link_id];
+    struct wifi67_vsim_link_stats *st = &radio->stats[link_id];
+    ktime_t now = ktime_get(), start, end = now;
+    u32 rate, loss, attempts = 0;
+    u64 airtime_ns = 0;
+    bool acked = false;
+
+    spin_lock_bh(&vsim->lock);
+
+    rate = radio->tx_rate[link_id] ? : lp->rate_mbps;
+    /* Nothing sent above the link rate decodes */
+    loss = rate > lp->rate_mbps ? 100 : min_t(u32, lp->loss, 100);
+
+    if (lp->up && rate) {
+        start = ktime_before(now, vsim->busy_until[link_id]) ?
+                vsim->busy_until[link_id] : now;
+        do {
+            attempts++;
+            acked = loss < 100 && get_random_u32() % 100 >= loss;
+        } while (!acked && attempts <= lp->retry_limit);
+
+        /* Mbps is bits per microsecond */
+        airtime_ns = div_u64((u64)frame->len * 8000 * attempts, rate);
+        end = ktime_add_ns(start, airtime_ns);
+        vsim->busy_until[link_id] = end;
+    }
+
+    frame->fetched = now;
+    frame->src = radio->role;
+    frame->txs.link_id = link_id;
+    frame->txs.acked = acked;
+    frame->txs.retries = attempts ? attempts - 1 : 0;
+    frame->txs.seq = cpu_to_le32(radio->tx_seq[link_id]++);
+    frame->txs.rate_mbps = cpu_to_le32(rate);
+    frame->txs.airtime_us = cpu_to_le32(div_u64(airtime_ns, NSEC_PER_USEC));
+
+    st->tx_frames++;
+    st->tx_bytes += frame->len;
+    st->tx_attempts += attempts;
+    st->airtime_us += div_u64(airtime_ns, NSEC_PER_USEC);
+
+    if (acked) {
+        u32 jitter = lp->jitter_us ? get_random_u32() % (lp->jitter_us + 1) : 0;
+
+        *status = *frame;
+        status->kind = WIFI67_VSIM_FRAME_STATUS;
+        status->len = 0;
+
+        frame->kind = WIFI67_VSIM_FRAME_DATA;
+        frame->due = ktime_add_us(end, lp->delay_us + jitter);
+        status->due = ktime_add_us(end, lp->delay_us);
+    } else {
+        st->tx_failed++;
+        kfree(status);
+        status = frame;
+        status->kind = WIFI67_VSIM_FRAME_STATUS;
+        status->due = ktime_add_us(end, lp->up ? lp->delay_us : 0);
+        frame = NULL;
+    }
+
+    /* A link taken down fails new frames at once, but not ahead of old ones */
+    if (ktime_before(status->due, vsim->status_due[link_id]))
+        status->due = vsim->status_due[link_id];
+    vsim->status_due[link_id] = status->due;
+
+    if (vsim->dead) {
+        kfree(frame);
+        kfree(status);
+    } else {
+        if (frame)
+            wifi67_vsim_air_insert(vsim, frame);
+        wifi67_vsim_air_insert(vsim, status);
+        wifi67_vsim_air_arm(vsim);
+    }
+
+    spin_unlock_bh(&vsim->lock);
+}
+
+/* Take one posted TX descriptor from the host, the way the DMA engine would */
+static bool wifi67_vsim_fetch(struct wifi67_vsim_radio *radio, u8 link_id)
+{
+    struct wifi67_dma_channel *chan = &radio->priv.dma_dev->channels[link_id];
+    struct wifi67_dma_ring *ring = &chan->tx_ring;
+    u32 idx = radio->dev_tx_idx[link_id];
+    struct wifi67_dma_desc *desc = &ring->desc[idx];
+    struct wifi67_vsim_frame *frame, *status;
+    u32 len;
+
+    if (!wifi67_vsim_chan_running(chan) ||
+        !(READ_ONCE(desc->flags) & cpu_to_le32(WIFI67_DMA_DESC_OWN)))
+        return false;
+    /* Read the descriptor only after seeing it owned */
+    dma_rmb();
+
+    len = le16_to_cpu(desc->buf_len);
+    frame = kmalloc(struct_size(frame, data, len), GFP_KERNEL);
+    status = kmalloc(sizeof(*status), GFP_KERNEL);
+    if (!frame || !status) {
+        /* Left owned; the next doorbell retries it */
+        kfree(frame);
+        kfree(status);
+        return false;
+    }
+
+    frame->len = len;
+    memcpy(frame->data, wifi67_vsim_bus_to_virt(radio,
+                                                le32_to_cpu(desc->buf_addr)),
+           len);
+
+    desc->status = 0;
+    desc->timestamp = cpu_to_le32(jiffies);
+    dma_wmb();
+    WRITE_ONCE(desc->flags, desc->flags & ~cpu_to_le32(WIFI67_DMA_DESC_OWN));
+    radio->dev_tx_idx[link_id] = (idx + 1) % ring->size;
+
+    wifi67_vsim_air_tx(radio, link_id, frame, status);
+    return true;
+}
+
+static void wifi67_vsim_engine_work(struct work_struct *work)
+{
+    struct wifi67_vsim_radio *radio = container_of(work,
+                                                   struct wifi67_vsim_radio,
+                                                   engine_work);
+    bool more = false;
+    int link, n;
+
+    for (link = 0; link < radio->vsim->num_links; link++) {
+        for (n = 0; n < WIFI67_VSIM_FETCH_BUDGET; n++)
+            if (!wifi67_vsim_fetch(radio, link))
+                break;
+        more |= n == WIFI67_VSIM_FETCH_BUDGET;
+    }
+
+    if (more)
+        wifi67_vsim_kick(radio->vsim, &radio->engine_work);
+}
+
+/*
+ * Write a frame into the next RX buffer the peer has posted. With none
+ * posted the frame is lost, as on a device whose RX FIFO overflows.
+ */
+static bool wifi67_vsim_deliver(struct wifi67_vsim *vsim,
+                                struct wifi67_vsim_frame *frame, ktime_t now)
+{
+    struct wifi67_vsim_radio *peer = &vsim->radios[!frame->src];
+    u8 link_id = frame->txs.link_id;
+    struct wifi67_vsim_link_stats *st = &vsim->radios[frame->src].stats[link_id];
+    struct wifi67_dma_channel *chan = &peer->priv.dma_dev->channels[link_id];
+    struct wifi67_dma_ring *ring = &chan->rx_ring;
+    u32 idx = peer->dev_rx_idx[link_id];
+    struct wifi67_dma_desc *desc = &ring->desc[idx];
+    u64 lat;
+
+    if (!wifi67_vsim_chan_running(chan) ||
+        !(READ_ONCE(desc->flags) & cpu_to_le32(WIFI67_DMA_DESC_OWN))) {
+        st->rx_overrun++;
+        return false;
+    }
+    dma_rmb();
+
+    if (le16_to_cpu(desc->buf_len) < frame->len) {
+        st->rx_overrun++;
+        return false;
+    }
+
+    memcpy(wifi67_vsim_bus_to_virt(peer, le32_to_cpu(desc->buf_addr)),
+           frame->data, frame->len);
+    desc->buf_len = cpu_to_le16(frame->len);
+    desc->status = 0;
+    desc->timestamp = cpu_to_le32(jiffies);
+    dma_wmb();
+    WRITE_ONCE(desc->flags, desc->flags & ~cpu_to_le32(WIFI67_DMA_DESC_OWN));
+    peer->dev_rx_idx[link_id] = (idx + 1) % ring->size;
+
+    lat = ktime_to_ns(ktime_sub(now, frame->fetched));
+    st->rx_frames++;
+    st->rx_bytes += frame->len;
+    st->lat_sum_ns += lat;
+    st->lat_max_ns = max(st->lat_max_ns, lat);
+    return true;
+}
+
+static enum hrtimer_restart wifi67_vsim_timer(struct hrtimer *timer)
+{
+    struct wifi67_vsim *vsim = container_of(timer, struct wifi67_vsim, timer);
+    struct wifi67_vsim_frame *frame;
+    unsigned long rx_kick = 0, fw_kick = 0;
+    ktime_t now = ktime_get();
+    int i;
+
+    spin_lock(&vsim->lock);
+
+    while ((frame = list_first_entry_or_null(&vsim->air,
+                                             struct wifi67_vsim_frame, list)) &&
+           !ktime_after(frame->due, now)) {
+        list_del(&frame->list);
+
+        if (frame->kind == WIFI67_VSIM_FRAME_DATA) {
+            if (wifi67_vsim_deliver(vsim, frame, now))
+                __set_bit(!frame->src, &rx_kick);
+            kfree(frame);
+            continue;
+        }
+
+        list_add_tail(&frame->list, &vsim->radios[frame->src].fw_backlog);
+        __set_bit(frame->src, &fw_kick);
+    }
+
+    wifi67_vsim_air_arm(vsim);
+    if (list_empty(&vsim->air))
+        wake_up(&vsim->idle);
+
+    spin_unlock(&vsim->lock);
+
+    for (i = 0; i < WIFI67_VSIM_NUM_ROLES; i++) {
+        if (test_bit(i, &rx_kick))
+            wifi67_vsim_kick(vsim, &vsim->radios[i].poll_work);
+        if (test_bit(i, &fw_kick))
+            wifi67_vsim_kick(vsim, &vsim->radios[i].fw_work);
+    }
+
+    return HRTIMER_NORESTART;
+}
+
+/* Firmware side of the IPC rings */
+static struct wifi67_ipc_msg *wifi67_vsim_fw_evt(struct wifi67_vsim_radio *radio,
+                                                 u16 id, u16 len)
+{
+    struct wifi67_ipc_ctrl *ctrl = radio->ipc.ctrl;
+    struct wifi67_ipc_msg *evt;
+
+    if (radio->fw_evt_prod - le32_to_cpu(READ_ONCE(ctrl->evt_cons)) >=
+        WIFI67_IPC_EVT_ENTRIES)
+        return NULL;
+
+    evt = &radio->ipc.evt_ring[radio->fw_evt_prod & WIFI67_VSIM_EVT_MASK];
+    evt->id = cpu_to_le16(id);
+    evt->len = cpu_to_le16(len);
+    evt->seq = cpu_to_le32(radio->fw_evt_prod);
+    radio->fw_evt_prod++;
+    return evt;
+}
+
+static void wifi67_vsim_fw_cmd_handle(struct wifi67_vsim_radio *radio,
+                                      const struct wifi67_ipc_msg *cmd,
+                                      struct wifi67_ipc_msg *evt)
+{
+    struct wifi67_vsim *vsim = radio->vsim;
+    u16 len = min_t(u16, le16_to_cpu(cmd->len), WIFI67_IPC_MSG_PAYLOAD);
+
+    if (le16_to_cpu(cmd->id) == WIFI67_VSIM_CMD_SET_RATE &&
+        len >= sizeof(struct wifi67_vsim_cmd_rate)) {
+        const struct wifi67_vsim_cmd_rate *rc = (const void *)cmd->payload;
+
+        if (rc->link_id < vsim->num_links) {
+            spin_lock_bh(&vsim->lock);
+            radio->tx_rate[rc->link_id] = le32_to_cpu(rc->rate_mbps);
+            spin_unlock_bh(&vsim->lock);
+        }
+    }
+
+    /* Every command is acknowledged with its own payload */
+    evt->seq = cmd->seq;
+    evt->len = cpu_to_le16(len);
+    memcpy(evt->payload, cmd->payload, len);
+}
+
+static void wifi67_vsim_fw_work(struct work_struct *work)
+{
+    struct wifi67_vsim_radio *radio = container_of(work,
+                                                   struct wifi67_vsim_radio,
+                                                   fw_work);
+    struct wifi67_vsim *vsim = radio->vsim;
+    struct wifi67_ipc_ctrl *ctrl = radio->ipc.ctrl;
+    u32 evt_start = radio->fw_evt_prod;
+    struct wifi67_vsim_frame *frame;
+    struct wifi67_ipc_msg *evt;
+    u32 prod;
+
+    prod = le32_to_cpu(READ_ONCE(ctrl->cmd_prod));
+    dma_rmb();
+
+    while (radio->fw_cmd_cons != prod) {
+        evt = wifi67_vsim_fw_evt(radio, WIFI67_VSIM_EVT_CMD_DONE, 0);
+        if (!evt)
+            break;
+        wifi67_vsim_fw_cmd_handle(radio,
+                                  &radio->ipc.cmd_ring[radio->fw_cmd_cons &
+                                                       WIFI67_VSIM_CMD_MASK],
+                                  evt);
+        radio->fw_cmd_cons++;
+    }
+
+    spin_lock_bh(&vsim->lock);
+    while ((frame = list_first_entry_or_null(&radio->fw_backlog,
+                                             struct wifi67_vsim_frame, list))) {
+        evt = wifi67_vsim_fw_evt(radio, WIFI67_VSIM_EVT_TX_STATUS,
+                                 sizeof(frame->txs));
+        if (!evt)
+            break;
+        memcpy(evt->payload, &frame->txs, sizeof(frame->txs));
+        list_del(&frame->list);
+        kfree(frame);
+    }
+    spin_unlock_bh(&vsim->lock);
+
+    /* Publish events and command slots, then raise the interrupt */
+    dma_wmb();
+    WRITE_ONCE(ctrl->evt_prod, cpu_to_le32(radio->fw_evt_prod));
+    WRITE_ONCE(ctrl->cmd_cons, cpu_to_le32(radio->fw_cmd_cons));
+    /* Pairs with the barrier in the host flush path */
+    mb();
+
+    if (radio->fw_evt_prod != evt_start)
+        wifi67_vsim_kick(vsim, &radio->poll_work);
+}
+
+/* Host side */
+static void wifi67_vsim_tx_status(struct wifi67_vsim_radio *radio,
+                                  const struct wifi67_vsim_evt_txs *txs)
+{
+    struct wifi67_vsim *vsim = radio->vsim;
+    struct sk_buff *skb;
+    void *buf;
+    u32 len;
+
+    if (txs->link_id >= vsim->num_links)
+        return;
+
+    skb = skb_dequeue(&radio->tx_pending[txs->link_id]);
+    buf = wifi67_dma_ring_get_buffer(&radio->priv, txs->link_id, true, &len);
+    if (WARN_ON_ONCE(!skb || buf != skb->data)) {
+        wifi67_err(&radio->priv, WIFI67_LOG_DMA,
+                   "vsim %s link %u: TX status %u without its frame\n",
+                   wifi67_vsim_role_names[radio->role], txs->link_id,
+                   le32_to_cpu(txs->seq));
+        kfree_skb(skb);
+    } else {
+        /* The driver's TX completion: latency, perf history, rate control */
+        wifi67_emlrc_tx_status(&radio->priv, txs->link_id, skb, txs->acked,
+                               txs->retries);
+        if (radio->ops && radio->ops->tx_status)
+            radio->ops->tx_status(radio->ops_data, txs->link_id, skb, txs);
+        else
+            consume_skb(skb);
+    }
+
+    if (atomic_dec_and_test(&vsim->in_flight))
+        wake_up(&vsim->idle);
+}
+
+static void wifi67_vsim_ipc_doorbell(void *data)
+{
+    struct wifi67_vsim_radio *radio = data;
+
+    wifi67_vsim_kick(radio->vsim, &radio->fw_work);
+}
+
+static void wifi67_vsim_ipc_event(void *data, const struct wifi67_ipc_msg *msg)
+{
+    struct wifi67_vsim_radio *radio = data;
+
+    if (le16_to_cpu(msg->id) == WIFI67_VSIM_EVT_TX_STATUS) {
+        wifi67_vsim_tx_status(radio, (const void *)msg->payload);
+        return;
+    }
+
+    if (radio->ops && radio->ops->event)
+        radio->ops->event(radio->ops_data, msg);
+}
+
+static const struct wifi67_ipc_ops wifi67_vsim_ipc_ops = {
+    .doorbell = wifi67_vsim_ipc_doorbell,
+    .event = wifi67_vsim_ipc_event,
+};
+
+static int wifi67_vsim_rx_drain(struct wifi67_vsim_radio *radio, u8 link_id,
+                                int budget)
+{
+    struct sk_buff *skb;
+    int done = 0;
+    void *buf;
+    u32 len;
+
+    while (done < budget &&
+           (buf = wifi67_dma_ring_get_buffer(&radio->priv, link_id, false,
+                                             &len))) {
+        skb = dev_alloc_skb(len);
+        if (skb) {
+            skb_put_data(skb, buf, len);
+            if (radio->ops && radio->ops->rx)
+                radio->ops->rx(radio->ops_data, link_id, skb);
+            else
+                consume_skb(skb);
+        }
+
+        /* Recycle the buffer straight back to the device */
+        if (wifi67_dma_ring_add_buffer(&radio->priv, link_id, false, buf,
+                                       WIFI67_VSIM_MAX_FRAME))
+            kfree(buf);
+        done++;
+    }
+
+    return done;
+}
+
+/* NAPI-style: requeue while a budget is used up, as the IPC poll does */
+static void wifi67_vsim_poll_work(struct work_struct *work)
+{
+    struct wifi67_vsim_radio *radio = container_of(work,
+                                                   struct wifi67_vsim_radio,
+                                                   poll_work);
+    struct wifi67_vsim *vsim = radio->vsim;
+    bool more, backlog;
+    int link;
+
+    more = wifi67_ipc_poll(&radio->ipc, WIFI67_IPC_POLL_BUDGET) ==
+           WIFI67_IPC_POLL_BUDGET;
+    for (link = 0; link < vsim->num_links; link++)
+        more |= wifi67_vsim_rx_drain(radio, link, WIFI67_IPC_POLL_BUDGET) ==
+                WIFI67_IPC_POLL_BUDGET;
+
+    if (more)
+        wifi67_vsim_kick(vsim, &radio->poll_work);
+
+    /* Event slots were freed; let the firmware post what it held back */
+    spin_lock_bh(&vsim->lock);
+    backlog = !list_empty(&radio->fw_backlog);
+    spin_unlock_bh(&vsim->lock);
+    if (backlog)
+        wifi67_vsim_kick(vsim, &radio->fw_work);
+}
+
+/* Hand every descriptor back and free what the host had posted */
+static void wifi67_vsim_drain_ring(struct wifi67_vsim_radio *radio, u8 link_id,
+                                   bool is_tx)
+{
+    struct wifi67_dma_channel *chan = &radio->priv.dma_dev->channels[link_id];
+    struct wifi67_dma_ring *ring = is_tx ? &chan->tx_ring : &chan->rx_ring;
+    u32 idx, len;
+    void *buf;
+
+    for (idx = ring->tail; idx != ring->head; idx = (idx + 1) % ring->size)
+        ring->desc[idx].flags &= ~cpu_to_le32(WIFI67_DMA_DESC_OWN);
+
+    while ((buf = wifi67_dma_ring_get_buffer(&radio->priv, link_id, is_tx,
+                                             &len)))
+        if (!is_tx)
+            kfree(buf);
+
+    if (is_tx)
+        skb_queue_purge(&radio->tx_pending[link_id]);
+}
+
+static void wifi67_vsim_radio_deinit(struct wifi67_vsim_radio *radio)
+{
+    int link;
+
+    for (link = 0; link < radio->num_chans; link++) {
+        wifi67_vsim_drain_ring(radio, link, true);
+        wifi67_vsim_drain_ring(radio, link, false);
+        wifi67_dma_channel_deinit(&radio->priv, link);
+    }
+    radio->num_chans = 0;
+
+    if (radio->priv.dma_dev)
+        wifi67_dma_deinit(&radio->priv);
+    kvfree(radio->ipc_shared);
+    if (!IS_ERR_OR_NULL(radio->dev))
+        root_device_unregister(radio->dev);
+    kfree(radio->regs);
+}
+
+/* Firmware comes up at once: report it loaded and running */
+static void wifi67_vsim_fw_boot(struct wifi67_vsim_radio *radio)
+{
+    void __iomem *regs = radio->hw.membase;
+
+    writel(WIFI67_FW_CTRL_RUN | WIFI67_FW_CTRL_IRQ_EN,
+           regs + WIFI67_REG_FW_CTRL);
+    writel(WIFI67_VSIM_FW_VERSION, regs + WIFI67_REG_FW_VERSION);
+    writel(WIFI67_VSIM_FW_VERSION, regs + WIFI67_REG_FW_API_VERSION);
+    writel(WIFI67_FW_ERR_NONE, regs + WIFI67_REG_FW_ERROR);
+    writel(WIFI67_FW_STATUS_READY | WIFI67_FW_STATUS_RUNNING,
+           regs + WIFI67_REG_FW_STATUS);
+}
+
+static int wifi67_vsim_radio_init(struct wifi67_vsim *vsim,
+                                  enum wifi67_vsim_role role)
+{
+    struct wifi67_vsim_radio *radio = &vsim->radios[role];
+    char name[32];
+    int link, i, ret;
+
+    radio->regs = kzalloc(WIFI67_VSIM_REGS_SIZE, GFP_KERNEL);
+    if (!radio->regs)
+        return -ENOMEM;
+    radio->hw.membase = (void __iomem *)radio->regs;
+    radio->hw.reg_size = WIFI67_VSIM_REGS_SIZE;
+
+    snprintf(name, sizeof(name), "wifi67_vsim%d_%s", vsim->id,
+             wifi67_vsim_role_names[role]);
+    radio->dev = root_device_register(name);
+    if (IS_ERR(radio->dev))
+        return PTR_ERR(radio->dev);
+    /* Descriptors carry 32-bit buffer addresses */
+    ret = dma_coerce_mask_and_coherent(radio->dev, DMA_BIT_MASK(32));
+    if (ret)
+        return ret;
+
+    radio->priv.dev = radio->dev;
+    radio->priv.hw_info = &radio->hw;
+    wifi67_vsim_fw_boot(radio);
+
+    ret = wifi67_dma_init(&radio->priv);
+    if (ret)
+        return ret;
+
+    for (link = 0; link < vsim->num_links; link++) {
+        struct wifi67_dma_channel *chan;
+
+        ret = wifi67_dma_channel_init(&radio->priv, link);
+        if (ret)
+            return ret;
+        radio->num_chans++;
+
+        /* ERR_STATUS is write-one-to-clear; the RAM window keeps the ones */
+        chan = &radio->priv.dma_dev->channels[link];
+        writel(0, chan->regs + WIFI67_DMA_REG_ERR_STATUS);
+
+        ret = wifi67_dma_channel_start(&radio->priv, link);
+        if (ret)
+            return ret;
+
+        for (i = 0; i < WIFI67_VSIM_RX_BUFS; i++) {
+            void *buf = kmalloc(WIFI67_VSIM_MAX_FRAME, GFP_KERNEL);
+
+            if (!buf)
+                return -ENOMEM;
+            ret = wifi67_dma_ring_add_buffer(&radio->priv, link, false, buf,
+                                             WIFI67_VSIM_MAX_FRAME);
+            if (ret) {
+                kfree(buf);
+                return ret;
+            }
+        }
+    }
+
+    radio->ipc_shared = kvzalloc(WIFI67_IPC_SHARED_SIZE, GFP_KERNEL);
+    if (!radio->ipc_shared)
+        return -ENOMEM;
+
+    return wifi67_ipc_init(&radio->ipc, radio->ipc_shared,
+                           WIFI67_IPC_SHARED_SIZE, &wifi67_vsim_ipc_ops,
+                           radio);
+}
+
+/* debugfs */
+static int wifi67_vsim_stats_show(struct seq_file *m, void *v)
+{
+    struct wifi67_vsim *vsim = m->private;
+    struct wifi67_vsim_link_params lp;
+    struct wifi67_vsim_link_stats st;
+    int link, role;
+
+    for (link = 0; link < vsim->num_links; link++) {
+        wifi67_vsim_get_link(vsim, link, &lp);
+        seq_printf(m, "link %d: %s, %u Mbps, delay %u us, jitter %u us, loss %u%%, retry limit %u\n",
+                   link, lp.up ? "up" : "down", lp.rate_mbps, lp.delay_us,
+                   lp.jitter_us, lp.loss, lp.retry_limit);
+
+        for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+            wifi67_vsim_get_stats(vsim, role, link, &st);
+            seq_printf(m, "  %s->%s: tx %llu frames %llu bytes, %llu attempts, %llu failed, airtime %llu us\n",
+                       wifi67_vsim_role_names[role],
+                       wifi67_vsim_role_names[!role], st.tx_frames,
+                       st.tx_bytes, st.tx_attempts, st.tx_failed,
+                       st.airtime_us);
+            seq_printf(m, "    rx %llu frames %llu bytes, %llu overrun, latency avg %llu max %llu us\n",
+                       st.rx_frames, st.rx_bytes, st.rx_overrun,
+                       st.rx_frames ?
+                       div64_u64(st.lat_sum_ns, st.rx_frames * NSEC_PER_USEC) : 0,
+                       div_u64(st.lat_max_ns, NSEC_PER_USEC));
+        }
+    }
+
+    seq_printf(m, "in flight: %d\n", atomic_read(&vsim->in_flight));
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(wifi67_vsim_stats);
+
+static void wifi67_vsim_debugfs_init(struct wifi67_vsim *vsim)
+{
+    struct dentry *dir;
+    char name[16];
+    int link, role;
+
+    snprintf(name, sizeof(name), "wifi67_vsim%d", vsim->id);
+    vsim->debugfs_dir = debugfs_create_dir(name, NULL);
+
+    /* Parameters are read per frame, so writes apply to the next one */
+    for (link = 0; link < vsim->num_links; link++) {
+        struct wifi67_vsim_link_params *lp = &vsim->links[link];
+
+        snprintf(name, sizeof(name), "link%d", link);
+        dir = debugfs_create_dir(name, vsim->debugfs_dir);
+        debugfs_create_bool("up", 0644, dir, &lp->up);
+        debugfs_create_u32("rate_mbps", 0644, dir, &lp->rate_mbps);
+        debugfs_create_u32("delay_us", 0644, dir, &lp->delay_us);
+        debugfs_create_u32("jitter_us", 0644, dir, &lp->jitter_us);
+        debugfs_create_u32("loss", 0644, dir, &lp->loss);
+        debugfs_create_u32("retry_limit", 0644, dir, &lp->retry_limit);
+    }
+
+    debugfs_create_file("stats", 0444, vsim->debugfs_dir, vsim,
+                        &wifi67_vsim_stats_fops);
+
+    /* Each radio's host keeps its own TX latency and perf history */
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+        struct wifi67_priv *priv = &vsim->radios[role].priv;
+
+        priv->debugfs.dir = debugfs_create_dir(wifi67_vsim_role_names[role],
+                                               vsim->debugfs_dir);
+        if (wifi67_perf_init(priv))
+            wifi67_err(priv, WIFI67_LOG_CORE,
+                       "vsim%d: no perf monitoring for the %s\n", vsim->id,
+                       wifi67_vsim_role_names[role]);
+    }
+}
+
+/* API */
+struct wifi67_vsim *wifi67_vsim_create(u8 num_links)
+{
+    struct wifi67_vsim *vsim;
+    int role, link, ret;
+
+    if (!num_links || num_links > WIFI67_VSIM_MAX_LINKS)
+        return ERR_PTR(-EINVAL);
+
+    vsim = kzalloc(sizeof(*vsim), GFP_KERNEL);
+    if (!vsim)
+        return ERR_PTR(-ENOMEM);
+
+    vsim->id = ida_alloc(&wifi67_vsim_ida, GFP_KERNEL);
+    if (vsim->id < 0) {
+        ret = vsim->id;
+        kfree(vsim);
+        return ERR_PTR(ret);
+    }
+
+    vsim->num_links = num_links;
+    spin_lock_init(&vsim->lock);
+    INIT_LIST_HEAD(&vsim->air);
+    init_waitqueue_head(&vsim->idle);
+    atomic_set(&vsim->in_flight, 0);
+    hrtimer_init(&vsim->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+    vsim->timer.function = wifi67_vsim_timer;
+
+    for (link = 0; link < num_links; link++) {
+        vsim->links[link].up = true;
+        vsim->links[link].rate_mbps = WIFI67_VSIM_DEF_RATE;
+        vsim->links[link].delay_us = WIFI67_VSIM_DEF_DELAY;
+        vsim->links[link].retry_limit = WIFI67_VSIM_RETRY_LIMIT;
+    }
+
+    /* Both radios must be safe to tear down before either is set up */
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+        struct wifi67_vsim_radio *radio = &vsim->radios[role];
+
+        radio->vsim = vsim;
+        radio->role = role;
+        INIT_LIST_HEAD(&radio->fw_backlog);
+        INIT_WORK(&radio->engine_work, wifi67_vsim_engine_work);
+        INIT_WORK(&radio->fw_work, wifi67_vsim_fw_work);
+        INIT_WORK(&radio->poll_work, wifi67_vsim_poll_work);
+        for (link = 0; link < WIFI67_VSIM_MAX_LINKS; link++)
+            skb_queue_head_init(&radio->tx_pending[link]);
+    }
+
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+        ret = wifi67_vsim_radio_init(vsim, role);
+        if (ret) {
+            wifi67_vsim_destroy(vsim);
+            return ERR_PTR(ret);
+        }
+    }
+
+    wifi67_vsim_debugfs_init(vsim);
+
+    wifi67_info(&vsim->radios[WIFI67_VSIM_AP].priv, WIFI67_LOG_CORE,
+                "vsim%d: AP/STA pair up with %u links\n", vsim->id, num_links);
+    return vsim;
+}
+
+void wifi67_vsim_destroy(struct wifi67_vsim *vsim)
+{
+    struct wifi67_vsim_frame *frame, *tmp;
+    int role, pass;
+
+    if (!vsim)
+        return;
+
+    spin_lock_bh(&vsim->lock);
+    vsim->dead = true;
+    spin_unlock_bh(&vsim->lock);
+
+    hrtimer_cancel(&vsim->timer);
+
+    /* The works kick each other; a second pass catches any requeue */
+    for (pass = 0; pass < 2; pass++) {
+        for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+            cancel_work_sync(&vsim->radios[role].engine_work);
+            cancel_work_sync(&vsim->radios[role].fw_work);
+            cancel_work_sync(&vsim->radios[role].poll_work);
+        }
+    }
+
+    list_for_each_entry_safe(frame, tmp, &vsim->air, list)
+        kfree(frame);
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+        list_for_each_entry_safe(frame, tmp, &vsim->radios[role].fw_backlog,
+                                 list)
+            kfree(frame);
+    }
+
+    /* No TX status can run any more; perf files live under our dir */
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++) {
+        if (vsim->radios[role].priv.perf.enabled)
+            wifi67_perf_deinit(&vsim->radios[role].priv);
+    }
+    debugfs_remove_recursive(vsim->debugfs_dir);
+
+    for (role = WIFI67_VSIM_NUM_ROLES - 1; role >= 0; role--)
+        wifi67_vsim_radio_deinit(&vsim->radios[role]);
+
+    ida_free(&wifi67_vsim_ida, vsim->id);
+    kfree(vsim);
+}
+
+struct wifi67_priv *wifi67_vsim_priv(struct wifi67_vsim *vsim,
+                                     enum wifi67_vsim_role role)
+{
+    if (role >= WIFI67_VSIM_NUM_ROLES)
+        return NULL;
+
+    return &vsim->radios[role].priv;
+}
+
+/* Set before traffic starts; the callbacks are not synchronised */
+void wifi67_vsim_set_ops(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                         const struct wifi67_vsim_ops *ops, void *data)
+{
+    if (role >= WIFI67_VSIM_NUM_ROLES)
+        return;
+
+    vsim->radios[role].ops_data = data;
+    vsim->radios[role].ops = ops;
+}
+
+int wifi67_vsim_set_link(struct wifi67_vsim *vsim, u8 link_id,
+                         const struct wifi67_vsim_link_params *params)
+{
+    if (link_id >= vsim->num_links || params->loss > 100)
+        return -EINVAL;
+
+    spin_lock_bh(&vsim->lock);
+    vsim->links[link_id] = *params;
+    spin_unlock_bh(&vsim->lock);
+
+    return 0;
+}
+
+int wifi67_vsim_get_link(struct wifi67_vsim *vsim, u8 link_id,
+                         struct wifi67_vsim_link_params *params)
+{
+    if (link_id >= vsim->num_links)
+        return -EINVAL;
+
+    spin_lock_bh(&vsim->lock);
+    *params = vsim->links[link_id];
+    spin_unlock_bh(&vsim->lock);
+
+    return 0;
+}
+
+/* Stats of frames sent by @role on @link_id, including their reception */
+int wifi67_vsim_get_stats(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                          u8 link_id, struct wifi67_vsim_link_stats *stats)
+{
+    if (role >= WIFI67_VSIM_NUM_ROLES || link_id >= vsim->num_links)
+        return -EINVAL;
+
+    spin_lock_bh(&vsim->lock);
+    *stats = vsim->radios[role].stats[link_id];
+    spin_unlock_bh(&vsim->lock);
+
+    return 0;
+}
+
+void wifi67_vsim_clear_stats(struct wifi67_vsim *vsim)
+{
+    int role;
+
+    spin_lock_bh(&vsim->lock);
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++)
+        memset(vsim->radios[role].stats, 0,
+               sizeof(vsim->radios[role].stats));
+    spin_unlock_bh(&vsim->lock);
+}
+
+/*
+ * Post one linear frame on a link's TX ring. The skb is held until its
+ * TX status comes back and is then passed to ops->tx_status. Returns
+ * -EBUSY while the ring is full.
+ */
+int wifi67_vsim_tx(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                   u8 link_id, struct sk_buff *skb)
+{
+    struct wifi67_vsim_radio *radio;
+    struct sk_buff_head *pending;
+    int ret;
+
+    if (role >= WIFI67_VSIM_NUM_ROLES || link_id >= vsim->num_links ||
+        !skb->len || skb->len > WIFI67_VSIM_MAX_FRAME || skb_linearize(skb))
+        return -EINVAL;
+
+    radio = &vsim->radios[role];
+    pending = &radio->tx_pending[link_id];
+
+    /* Queue and post under one lock so both stay in the same order */
+    spin_lock_bh(&pending->lock);
+    __skb_queue_tail(pending, skb);
+    atomic_inc(&vsim->in_flight);
+    wifi67_lat_stamp(skb, WIFI67_LAT_DMA_POST);
+    ret = wifi67_dma_ring_add_buffer(&radio->priv, link_id, true, skb->data,
+                                     skb->len);
+    if (ret) {
+        __skb_unlink(skb, pending);
+        atomic_dec(&vsim->in_flight);
+    }
+    spin_unlock_bh(&pending->lock);
+
+    if (ret)
+        return ret == -ENOSPC ? -EBUSY : ret;
+
+    /* The RAM window cannot trap the head pointer write; ring the engine */
+    wifi67_vsim_kick(vsim, &radio->engine_work);
+    return 0;
+}
+
+int wifi67_vsim_fw_cmd(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                       u16 id, const void *payload, u16 len)
+{
+    struct wifi67_ipc_msg msg = {
+        .id = cpu_to_le16(id),
+        .len = cpu_to_le16(len),
+    };
+
+    if (role >= WIFI67_VSIM_NUM_ROLES || len > WIFI67_IPC_MSG_PAYLOAD)
+        return -EINVAL;
+
+    memcpy(msg.payload, payload, len);
+    return wifi67_ipc_send(&vsim->radios[role].ipc, &msg, 1) == 1 ? 0 : -ENOSPC;
+}
+
+static bool wifi67_vsim_idle(struct wifi67_vsim *vsim)
+{
+    bool idle;
+
+    spin_lock_bh(&vsim->lock);
+    idle = !atomic_read(&vsim->in_flight) && list_empty(&vsim->air);
+    spin_unlock_bh(&vsim->lock);
+
+    return idle;
+}
+
+/*
+ * Wait until every posted frame has its TX status handled and nothing is
+ * left on the medium, then until both hosts have drained their RX rings.
+ */
+int wifi67_vsim_flush(struct wifi67_vsim *vsim, unsigned int timeout_ms)
+{
+    int role;
+
+    if (!wait_event_timeout(vsim->idle, wifi67_vsim_idle(vsim),
+                            msecs_to_jiffies(timeout_ms)))
+        return -ETIMEDOUT;
+
+    for (role = 0; role < WIFI67_VSIM_NUM_ROLES; role++)
+        flush_work(&vsim->radios[role].poll_work);
+
+    return 0;
+}
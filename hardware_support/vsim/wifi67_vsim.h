@@ -0,0 +1,125 @@
+#ifndef _WIFI67_VSIM_H_
+#define _WIFI67_VSIM_H_
+
+#include <linux/types.h>
+#include <linux/skbuff.h>
+#include "../../include/core/wifi67.h"
+#include "../../include/firmware/fw_ipc.h"
+
+/*
+ * Virtual radio pair, in the spirit of mac80211_hwsim: an AP and a STA
+ * instance of the driver wired back to back in memory.
+ *
+ * Each radio has a RAM-backed register window, one DMA channel per link
+ * driven by the real DMA core, and an IPC channel answered by a software
+ * firmware. A device engine per radio fetches posted TX descriptors,
+ * carries the frames over a per-link medium and writes them into the
+ * peer's posted RX buffers, then reports TX status as a firmware event.
+ *
+ * The medium of a link is shared by both directions. A frame holds it for
+ * len * 8 / rate per attempt. Every attempt is lost with the link's loss
+ * probability, up to the retry limit. A delivered frame reaches the peer
+ * after the propagation delay plus a uniform jitter, so jitter reorders
+ * frames within a link and different delays reorder them across links.
+ */
+
+#define WIFI67_VSIM_MAX_LINKS       4
+#define WIFI67_VSIM_MAX_FRAME       11454   /* Largest EHT MPDU */
+#define WIFI67_VSIM_RX_BUFS         256     /* Posted per link */
+#define WIFI67_VSIM_REGS_SIZE       0x6000  /* FW at 0x1000, DMA at 0x5000 */
+#define WIFI67_VSIM_RETRY_LIMIT     7
+
+/* Link defaults: a clean 2x2 160 MHz link */
+#define WIFI67_VSIM_DEF_RATE        1200
+#define WIFI67_VSIM_DEF_DELAY       10
+
+enum wifi67_vsim_role {
+    WIFI67_VSIM_AP,
+    WIFI67_VSIM_STA,
+    WIFI67_VSIM_NUM_ROLES,
+};
+
+/* Firmware commands (host -> firmware) */
+#define WIFI67_VSIM_CMD_ECHO        0x0001
+#define WIFI67_VSIM_CMD_SET_RATE    0x0002  /* struct wifi67_vsim_cmd_rate */
+
+/* Firmware events (firmware -> host) */
+#define WIFI67_VSIM_EVT_CMD_DONE    0x8001  /* Payload echoes the command */
+#define WIFI67_VSIM_EVT_TX_STATUS   0x8002  /* struct wifi67_vsim_evt_txs */
+
+struct wifi67_vsim_cmd_rate {
+    u8 link_id;
+    u8 pad[3];
+    __le32 rate_mbps;       /* 0 for the link rate */
+} __packed;
+
+struct wifi67_vsim_evt_txs {
+    u8 link_id;
+    u8 acked;
+    u8 retries;
+    u8 pad;
+    __le32 seq;             /* Per-link TX sequence, for ordering checks */
+    __le32 rate_mbps;
+    __le32 airtime_us;
+} __packed;
+
+/* Medium model of one link; read for every frame */
+struct wifi67_vsim_link_params {
+    bool up;
+    u32 rate_mbps;
+    u32 delay_us;
+    u32 jitter_us;
+    u32 loss;               /* Per attempt, in percent */
+    u32 retry_limit;
+};
+
+/* Per link and per sending radio */
+struct wifi67_vsim_link_stats {
+    u64 tx_frames;
+    u64 tx_bytes;
+    u64 tx_attempts;
+    u64 tx_failed;
+    u64 rx_frames;
+    u64 rx_bytes;
+    u64 rx_overrun;         /* Peer had no RX buffer posted */
+    u64 airtime_us;
+    u64 lat_sum_ns;         /* Descriptor fetch to peer RX */
+    u64 lat_max_ns;
+};
+
+/*
+ * Host side callbacks, called from the radio's poll work. rx and
+ * tx_status own the skb. TX status arrives in posting order per link.
+ */
+struct wifi67_vsim_ops {
+    void (*rx)(void *data, u8 link_id, struct sk_buff *skb);
+    void (*tx_status)(void *data, u8 link_id, struct sk_buff *skb,
+                      const struct wifi67_vsim_evt_txs *txs);
+    void (*event)(void *data, const struct wifi67_ipc_msg *msg);
+};
+
+struct wifi67_vsim;
+
+struct wifi67_vsim *wifi67_vsim_create(u8 num_links);
+void wifi67_vsim_destroy(struct wifi67_vsim *vsim);
+
+struct wifi67_priv *wifi67_vsim_priv(struct wifi67_vsim *vsim,
+                                     enum wifi67_vsim_role role);
+void wifi67_vsim_set_ops(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                         const struct wifi67_vsim_ops *ops, void *data);
+
+int wifi67_vsim_set_link(struct wifi67_vsim *vsim, u8 link_id,
+                         const struct wifi67_vsim_link_params *params);
+int wifi67_vsim_get_link(struct wifi67_vsim *vsim, u8 link_id,
+                         struct wifi67_vsim_link_params *params);
+int wifi67_vsim_get_stats(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                          u8 link_id, struct wifi67_vsim_link_stats *stats);
+void wifi67_vsim_clear_stats(struct wifi67_vsim *vsim);
+
+int wifi67_vsim_tx(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                   u8 link_id, struct sk_buff *skb);
+int wifi67_vsim_fw_cmd(struct wifi67_vsim *vsim, enum wifi67_vsim_role role,
+                       u16 id, const void *payload, u16 len);
+int wifi67_vsim_flush(struct wifi67_vsim *vsim, unsigned int timeout_ms);
+
+#endif /* _WIFI67_VSIM_H_ */
@@ -2,24 +2,82 @@
 #define _WIFI67_DEBUG_H_
 
 #include <linux/debugfs.h>
+#include <linux/jump_label.h>
+#include <linux/ratelimit.h>
 #include "../core/wifi67.h"
 
-/* Debug levels */
-#define WIFI67_DEBUG_ERROR   BIT(0)
-#define WIFI67_DEBUG_WARNING BIT(1)
-#define WIFI67_DEBUG_INFO    BIT(2)
-#define WIFI67_DEBUG_MAC     BIT(3)
-#define WIFI67_DEBUG_PHY     BIT(4)
-#define WIFI67_DEBUG_DMA     BIT(5)
-#define WIFI67_DEBUG_FW      BIT(6)
-#define WIFI67_DEBUG_REG     BIT(7)
-#define WIFI67_DEBUG_TX      BIT(8)
-#define WIFI67_DEBUG_RX      BIT(9)
-#define WIFI67_DEBUG_ALL     0xFFFFFFFF
-
-void wifi67_debug(struct wifi67_priv *priv, u32 level, const char *fmt, ...);
-
-#define wifi67_dbg(priv, level, fmt, ...) \
-    wifi67_debug(priv, level, fmt, ##__VA_ARGS__)
-
-#endif /* _WIFI67_DEBUG_H_ */ 
\ No newline at end of file
+/*
+ * Per-subsystem, per-level logging. Every (subsystem, level) pair has a
+ * static key, so a log site whose level is off costs a single patched-out
+ * branch; the arguments are not evaluated. Sites that are on go through a
+ * per-site ratelimit so a hot loop cannot flood the console.
+ *
+ * Levels are global to the driver and are set through the debug_level
+ * debugfs file of any device. By default errors and warnings are on for
+ * every subsystem.
+ */
+
+enum wifi67_log_subsys {
+    WIFI67_LOG_CORE,
+    WIFI67_LOG_DMA,
+    WIFI67_LOG_MAC,
+    WIFI67_LOG_AGG,
+    WIFI67_LOG_BA,
+    WIFI67_LOG_QOS,
+    WIFI67_LOG_MLO,
+    WIFI67_LOG_PHY,
+    WIFI67_LOG_FW,
+    WIFI67_LOG_USB,
+    WIFI67_LOG_NUM_SUBSYS,
+};
+
+enum wifi67_log_level {
+    WIFI67_LOG_ERR,
+    WIFI67_LOG_WARN,
+    WIFI67_LOG_INFO,
+    WIFI67_LOG_DBG,
+    WIFI67_LOG_NUM_LEVELS,
+};
+
+#define WIFI67_LOG_DEFAULT_LEVEL    WIFI67_LOG_WARN
+
+#define WIFI67_LOG_KEY(subsys, level) \
+    ((subsys) * WIFI67_LOG_NUM_LEVELS + (level))
+
+/*
+ * A key is set when its level differs from the default, so levels that
+ * start on (err, warn) and levels that start off (info, dbg) both need no
+ * patching at load time.
+ */
+extern struct static_key_false wifi67_log_keys[];
+
+#define wifi67_log_enabled(subsys, level)                                   \
+    ((level) <= WIFI67_LOG_DEFAULT_LEVEL ?                                  \
+     !static_branch_unlikely(&wifi67_log_keys[WIFI67_LOG_KEY(subsys, level)]) : \
+     static_branch_unlikely(&wifi67_log_keys[WIFI67_LOG_KEY(subsys, level)]))
+
+__printf(4, 5)
+void __wifi67_log(struct wifi67_priv *priv, unsigned int subsys,
+                  unsigned int level, const char *fmt, ...);
+
+int wifi67_log_set_level(unsigned int subsys, int level);
+
+/* @priv may be NULL in code that has no device context */
+#define wifi67_log(priv, subsys, level, fmt, ...)                           \
+do {                                                                        \
+    static DEFINE_RATELIMIT_STATE(_wifi67_rs, DEFAULT_RATELIMIT_INTERVAL,   \
+                                  DEFAULT_RATELIMIT_BURST);                 \
+    if (wifi67_log_enabled(subsys, level) && __ratelimit(&_wifi67_rs))      \
+        __wifi67_log(priv, subsys, level, fmt, ##__VA_ARGS__);              \
+} while (0)
+
+#define wifi67_err(priv, subsys, fmt, ...) \
+    wifi67_log(priv, subsys, WIFI67_LOG_ERR, fmt, ##__VA_ARGS__)
+#define wifi67_warn(priv, subsys, fmt, ...) \
+    wifi67_log(priv, subsys, WIFI67_LOG_WARN, fmt, ##__VA_ARGS__)
+#define wifi67_info(priv, subsys, fmt, ...) \
+    wifi67_log(priv, subsys, WIFI67_LOG_INFO, fmt, ##__VA_ARGS__)
+#define wifi67_dbg(priv, subsys, fmt, ...) \
+    wifi67_log(priv, subsys, WIFI67_LOG_DBG, fmt, ##__VA_ARGS__)
+
+#endif /* _WIFI67_DEBUG_H_ */
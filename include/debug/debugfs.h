@@ -8,7 +8,6 @@ struct wifi67_debugfs {
     struct dentry *debug_level;
     struct dentry *stats;
     struct dentry *registers;
-    u32 debug_mask;
 };
 
 #endif /* _WIFI67_DEBUGFS_H_ */ 
\ No newline at end of file
@@ -0,0 +1,271 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM wifi67
+
+#if !defined(_WIFI67_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _WIFI67_TRACE_H_
+
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+/*
+ * Data and control path tracepoints. Records are fixed-size binary
+ * fields with no strings or variable-length data, so perf, trace-cmd and
+ * BPF can keep up with production traffic; formatting only happens when
+ * the text trace buffer is read. A disabled tracepoint is a patched-out
+ * branch, so the call sites stay in hot paths unconditionally.
+ */
+
+/* DMA rings */
+DECLARE_EVENT_CLASS(wifi67_dma_desc,
+    TP_PROTO(u32 channel, bool is_tx, u32 idx, u32 len),
+    TP_ARGS(channel, is_tx, idx, len),
+
+    TP_STRUCT__entry(
+        __field(u16, channel)
+        __field(u8, is_tx)
+        __field(u16, idx)
+        __field(u32, len)
+    ),
+
+    TP_fast_assign(
+        __entry->channel = channel;
+        __entry->is_tx = is_tx;
+        __entry->idx = idx;
+        __entry->len = len;
+    ),
+
+    TP_printk("ch=%u %s idx=%u len=%u", __entry->channel,
+              __entry->is_tx ? "tx" : "rx", __entry->idx, __entry->len)
+);
+
+DEFINE_EVENT(wifi67_dma_desc, wifi67_dma_post,
+    TP_PROTO(u32 channel, bool is_tx, u32 idx, u32 len),
+    TP_ARGS(channel, is_tx, idx, len)
+);
+
+DEFINE_EVENT(wifi67_dma_desc, wifi67_dma_complete,
+    TP_PROTO(u32 channel, bool is_tx, u32 idx, u32 len),
+    TP_ARGS(channel, is_tx, idx, len)
+);
+
+/* Aggregation and block ack */
+TRACE_EVENT(wifi67_agg_build,
+    TP_PROTO(u8 tid, u32 frames, u32 bytes),
+    TP_ARGS(tid, frames, bytes),
+
+    TP_STRUCT__entry(
+        __field(u8, tid)
+        __field(u32, frames)
+        __field(u32, bytes)
+    ),
+
+    TP_fast_assign(
+        __entry->tid = tid;
+        __entry->frames = frames;
+        __entry->bytes = bytes;
+    ),
+
+    TP_printk("tid=%u frames=%u bytes=%u", __entry->tid, __entry->frames,
+              __entry->bytes)
+);
+
+TRACE_EVENT(wifi67_ba_window_move,
+    TP_PROTO(u8 tid, u16 old_head, u16 new_head),
+    TP_ARGS(tid, old_head, new_head),
+
+    TP_STRUCT__entry(
+        __field(u8, tid)
+        __field(u16, old_head)
+        __field(u16, new_head)
+    ),
+
+    TP_fast_assign(
+        __entry->tid = tid;
+        __entry->old_head = old_head;
+        __entry->new_head = new_head;
+    ),
+
+    TP_printk("tid=%u head=%u->%u", __entry->tid, __entry->old_head,
+              __entry->new_head)
+);
+
+TRACE_EVENT(wifi67_reorder_flush,
+    TP_PROTO(u8 tid, u16 head, u16 released, u16 dropped),
+    TP_ARGS(tid, head, released, dropped),
+
+    TP_STRUCT__entry(
+        __field(u8, tid)
+        __field(u16, head)
+        __field(u16, released)
+        __field(u16, dropped)
+    ),
+
+    TP_fast_assign(
+        __entry->tid = tid;
+        __entry->head = head;
+        __entry->released = released;
+        __entry->dropped = dropped;
+    ),
+
+    TP_printk("tid=%u head=%u released=%u dropped=%u", __entry->tid,
+              __entry->head, __entry->released, __entry->dropped)
+);
+
+/* Rate control */
+TRACE_EVENT(wifi67_rate_change,
+    TP_PROTO(u8 old_mcs, u8 mcs, u8 nss, u8 bw, u8 gi, u32 bitrate),
+    TP_ARGS(old_mcs, mcs, nss, bw, gi, bitrate),
+
+    TP_STRUCT__entry(
+        __field(u8, old_mcs)
+        __field(u8, mcs)
+        __field(u8, nss)
+        __field(u8, bw)
+        __field(u8, gi)
+        __field(u32, bitrate)
+    ),
+
+    TP_fast_assign(
+        __entry->old_mcs = old_mcs;
+        __entry->mcs = mcs;
+        __entry->nss = nss;
+        __entry->bw = bw;
+        __entry->gi = gi;
+        __entry->bitrate = bitrate;
+    ),
+
+    TP_printk("mcs=%u->%u nss=%u bw=%u gi=%u bitrate=%u",
+              __entry->old_mcs, __entry->mcs, __entry->nss, __entry->bw,
+              __entry->gi, __entry->bitrate)
+);
+
+/* Multi-link operation */
+TRACE_EVENT(wifi67_mlo_link_select,
+    TP_PROTO(u8 policy, u8 old_link, u8 new_link, int ret, u32 latency_us),
+    TP_ARGS(policy, old_link, new_link, ret, latency_us),
+
+    TP_STRUCT__entry(
+        __field(u8, policy)
+        __field(u8, old_link)
+        __field(u8, new_link)
+        __field(s32, ret)
+        __field(u32, latency_us)
+    ),
+
+    TP_fast_assign(
+        __entry->policy = policy;
+        __entry->old_link = old_link;
+        __entry->new_link = new_link;
+        __entry->ret = ret;
+        __entry->latency_us = latency_us;
+    ),
+
+    TP_printk("policy=%u link=%u->%u ret=%d latency=%uus",
+              __entry->policy, __entry->old_link, __entry->new_link,
+              __entry->ret, __entry->latency_us)
+);
+
+TRACE_EVENT(wifi67_emlsr_switch,
+    TP_PROTO(u8 old_link, u8 new_link, u32 transition_delay),
+    TP_ARGS(old_link, new_link, transition_delay),
+
+    TP_STRUCT__entry(
+        __field(u8, old_link)
+        __field(u8, new_link)
+        __field(u32, transition_delay)
+    ),
+
+    TP_fast_assign(
+        __entry->old_link = old_link;
+        __entry->new_link = new_link;
+        __entry->transition_delay = transition_delay;
+    ),
+
+    TP_printk("link=%u->%u delay=%u", __entry->old_link, __entry->new_link,
+              __entry->transition_delay)
+);
+
+/* Power save */
+TRACE_EVENT(wifi67_twt_sp,
+    TP_PROTO(u8 flow_id, u32 target_wake_time, u16 wake_duration,
+             u32 next_wake_time),
+    TP_ARGS(flow_id, target_wake_time, wake_duration, next_wake_time),
+
+    TP_STRUCT__entry(
+        __field(u8, flow_id)
+        __field(u16, wake_duration)
+        __field(u32, target_wake_time)
+        __field(u32, next_wake_time)
+    ),
+
+    TP_fast_assign(
+        __entry->flow_id = flow_id;
+        __entry->wake_duration = wake_duration;
+        __entry->target_wake_time = target_wake_time;
+        __entry->next_wake_time = next_wake_time;
+    ),
+
+    TP_printk("flow=%u twt=%u duration=%u next=%u", __entry->flow_id,
+              __entry->target_wake_time, __entry->wake_duration,
+              __entry->next_wake_time)
+);
+
+/* Host/firmware IPC */
+DECLARE_EVENT_CLASS(wifi67_ipc_msg,
+    TP_PROTO(u16 id, u32 seq, u16 len),
+    TP_ARGS(id, seq, len),
+
+    TP_STRUCT__entry(
+        __field(u16, id)
+        __field(u16, len)
+        __field(u32, seq)
+    ),
+
+    TP_fast_assign(
+        __entry->id = id;
+        __entry->len = len;
+        __entry->seq = seq;
+    ),
+
+    TP_printk("id=0x%04x seq=%u len=%u", __entry->id, __entry->seq,
+              __entry->len)
+);
+
+DEFINE_EVENT(wifi67_ipc_msg, wifi67_ipc_cmd,
+    TP_PROTO(u16 id, u32 seq, u16 len),
+    TP_ARGS(id, seq, len)
+);
+
+DEFINE_EVENT(wifi67_ipc_msg, wifi67_ipc_evt,
+    TP_PROTO(u16 id, u32 seq, u16 len),
+    TP_ARGS(id, seq, len)
+);
+
+TRACE_EVENT(wifi67_ipc_flush,
+    TP_PROTO(u32 prod, u32 count, bool doorbell),
+    TP_ARGS(prod, count, doorbell),
+
+    TP_STRUCT__entry(
+        __field(u32, prod)
+        __field(u32, count)
+        __field(u8, doorbell)
+    ),
+
+    TP_fast_assign(
+        __entry->prod = prod;
+        __entry->count = count;
+        __entry->doorbell = doorbell;
+    ),
+
+    TP_printk("prod=%u count=%u%s", __entry->prod, __entry->count,
+              __entry->doorbell ? " doorbell" : "")
+);
+
+#endif /* _WIFI67_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH debug
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE wifi67_trace
+#include <trace/define_trace.h>
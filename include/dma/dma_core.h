@@ -64,6 +64,7 @@ struct wifi67_dma_ring {
     dma_addr_t desc_dma;
     void **buf_addr;
     dma_addr_t *buf_dma;
+    u32 *buf_map_len;       /* Mapped length; RX may complete shorter */
     u32 size;
     u32 head;
     u32 tail;
@@ -13,6 +13,14 @@
 #define WIFI67_FW_REGION_RW      BIT(1)  /* Read-write memory */
 #define WIFI67_FW_REGION_SHARED  BIT(2)  /* Shared memory */
 
+/* Firmware image regions */
+enum wifi67_fw_region {
+    WIFI67_FW_REGION_IRAM,
+    WIFI67_FW_REGION_DRAM,
+    WIFI67_FW_REGION_SRAM,
+    WIFI67_FW_NUM_REGIONS
+};
+
 /* Hardware register offsets */
 #define WIFI67_REG_FW_STATUS    0x0100
 #define WIFI67_REG_FW_ERROR     0x0104
@@ -22,34 +30,93 @@
 #define WIFI67_REG_FW_SRAM_ADDR 0x0114
 #define WIFI67_REG_IPC_ADDR     0x0118
 #define WIFI67_REG_IPC_SIZE     0x011C
+#define WIFI67_REG_IPC_DOORBELL 0x0120  /* Write BIT(radio) to kick */
+#define WIFI67_REG_IPC_EVT_MASK 0x0124  /* BIT(radio) masks event IRQ */
 
 /* Firmware status register bits */
 #define WIFI67_FW_IRQ_CRASH     BIT(0)
 #define WIFI67_FW_IRQ_READY     BIT(1)
+#define WIFI67_FW_IRQ_EVENT     BIT(2)
 #define WIFI67_FW_RADIO_ID_MASK GENMASK(7, 4)
 
+/* Error code reported for crashes raised by wifi67_emlfm_inject_crash() */
+#define WIFI67_FW_ERR_INJECTED  0xDEAD0001
+
 /* Firmware states */
 enum wifi67_fw_state {
     WIFI67_FW_STATE_RESET,
     WIFI67_FW_STATE_LOADED,
     WIFI67_FW_STATE_STARTING,
     WIFI67_FW_STATE_READY,
-    WIFI67_FW_STATE_CRASHED
+    WIFI67_FW_STATE_CRASHED,
+    WIFI67_FW_STATE_LOADING   /* Image body being copied, lock dropped */
+};
+
+/* Per-radio recovery statistics */
+struct wifi67_emlfm_recovery_stats {
+    u32 crash_count;          /* Firmware crashes seen */
+    u32 fast_recoveries;      /* Recoveries from the retained image */
+    u32 full_reloads;         /* Recoveries that needed a full load */
+    u32 regions_reloaded;     /* Regions rewritten by fast recoveries */
+    u32 regions_reused;       /* Regions still holding the image */
+    u32 last_recovery_us;     /* Duration of the last recovery */
+    u32 max_recovery_us;      /* Slowest recovery */
+    u32 coredumps;            /* Crash dumps handed to devcoredump */
 };
 
+/* State replay after firmware restart (keys, stations, BA sessions) */
+struct wifi67_emlfm_recovery_ops {
+    int (*replay)(struct wifi67_priv *priv, u8 radio_id);
+};
+
+struct wifi67_ipc_msg;
+
+/* Firmware event delivery, called from the IPC poll worker */
+typedef void (*wifi67_emlfm_event_fn)(struct wifi67_priv *priv, u8 radio_id,
+                                      const struct wifi67_ipc_msg *msg);
+
 /* Function prototypes */
 int wifi67_emlfm_init(struct wifi67_priv *priv);
 void wifi67_emlfm_deinit(struct wifi67_priv *priv);
 int wifi67_emlfm_load_fw(struct wifi67_priv *priv, u8 radio_id,
                         const char *name);
+int wifi67_emlfm_load_fw_all(struct wifi67_priv *priv, u32 radio_mask,
+                            const char *name);
 int wifi67_emlfm_start_fw(struct wifi67_priv *priv, u8 radio_id);
 void wifi67_emlfm_stop_fw(struct wifi67_priv *priv, u8 radio_id);
+int wifi67_emlfm_resume(struct wifi67_priv *priv, u8 radio_id);
+void wifi67_emlfm_set_recovery_ops(struct wifi67_priv *priv,
+                                  const struct wifi67_emlfm_recovery_ops *ops);
+int wifi67_emlfm_get_recovery_stats(struct wifi67_priv *priv, u8 radio_id,
+                                   struct wifi67_emlfm_recovery_stats *stats);
+int wifi67_emlfm_ipc_queue(struct wifi67_priv *priv, u8 radio_id, u16 id,
+                          const void *payload, u16 len);
+void wifi67_emlfm_ipc_flush(struct wifi67_priv *priv, u8 radio_id);
+int wifi67_emlfm_ipc_send(struct wifi67_priv *priv, u8 radio_id,
+                         const struct wifi67_ipc_msg *msgs, int count);
+void wifi67_emlfm_set_event_handler(struct wifi67_priv *priv,
+                                   wifi67_emlfm_event_fn handler);
+int wifi67_emlfm_inject_crash(struct wifi67_priv *priv, u8 radio_id);
 
 /* Hardware abstraction layer functions that must be implemented by the driver */
 int wifi67_hw_load_fw(struct wifi67_priv *priv, u8 radio_id,
                      const void *data, size_t size,
                      dma_addr_t iram_addr, dma_addr_t dram_addr,
                      dma_addr_t sram_addr);
+int wifi67_hw_fw_setup(struct wifi67_priv *priv, u8 radio_id,
+                      const void *data, size_t size,
+                      dma_addr_t iram_addr, dma_addr_t dram_addr,
+                      dma_addr_t sram_addr);
+int wifi67_hw_fw_copy(struct wifi67_priv *priv, u8 radio_id,
+                     const void *data, size_t size);
+void __iomem *wifi67_hw_fw_region_base(struct wifi67_priv *priv, u8 radio_id,
+                                      enum wifi67_fw_region region);
+int wifi67_hw_fw_write_region(struct wifi67_priv *priv, u8 radio_id,
+                             enum wifi67_fw_region region,
+                             const void *data, size_t len);
+int wifi67_hw_fw_read_region(struct wifi67_priv *priv, u8 radio_id,
+                            enum wifi67_fw_region region, size_t offset,
+                            void *buf, size_t len);
 int wifi67_hw_start_fw(struct wifi67_priv *priv, u8 radio_id,
                       dma_addr_t ipc_addr, size_t ipc_size);
 void wifi67_hw_stop_fw(struct wifi67_priv *priv, u8 radio_id);
@@ -0,0 +1,122 @@
+#ifndef _WIFI67_FW_COREDUMP_H_
+#define _WIFI67_FW_COREDUMP_H_
+
+#include <linux/types.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+
+/*
+ * Firmware crash dump. A dump is a header followed by typed sections and
+ * is handed to devcoredump as one vmalloc'd buffer. Both the total size
+ * and the capture time are bounded; a section cut short by either limit
+ * is kept with a TRUNCATED flag and its original length.
+ */
+
+#define WIFI67_FW_DUMP_MAGIC        0x44373657  /* "W67D" */
+#define WIFI67_FW_DUMP_VERSION      1
+#define WIFI67_FW_DUMP_MAX_SIZE     (2 * 1024 * 1024)
+#define WIFI67_FW_DUMP_BUDGET_MS    100
+#define WIFI67_FW_DUMP_CHUNK        (16 * 1024)
+
+/* Section flags */
+#define WIFI67_FW_DUMP_F_TRUNC_SIZE BIT(0)
+#define WIFI67_FW_DUMP_F_TRUNC_TIME BIT(1)
+#define WIFI67_FW_DUMP_F_READ_ERR   BIT(2)
+
+enum wifi67_fw_dump_type {
+    WIFI67_FW_DUMP_REGS = 1,
+    WIFI67_FW_DUMP_EVENTS,
+    WIFI67_FW_DUMP_IPC,
+    WIFI67_FW_DUMP_DMA_RINGS,
+    WIFI67_FW_DUMP_SRAM,
+    WIFI67_FW_DUMP_DRAM,
+    WIFI67_FW_DUMP_IRAM,
+};
+
+struct wifi67_fw_dump_hdr {
+    __le32 magic;
+    __le32 version;
+    __le32 radio_id;
+    __le32 error_code;
+    __le32 fw_version;
+    __le32 num_sections;
+    __le32 total_len;
+    __le32 capture_us;
+    __le64 timestamp_ns;
+} __packed;
+
+struct wifi67_fw_dump_section {
+    __le32 type;
+    __le32 flags;
+    __le32 len;             /* Bytes that follow */
+    __le32 orig_len;        /* Bytes that were requested */
+} __packed;
+
+/* One ring's indices in a WIFI67_FW_DUMP_DMA_RINGS section */
+struct wifi67_fw_dump_dma_ring {
+    __le32 channel;
+    __le32 is_tx;
+    __le32 size;
+    __le32 head;
+    __le32 tail;
+    __le32 enabled;
+} __packed;
+
+/* Recent driver events, kept in a small ring and dumped on crash */
+#define WIFI67_FW_HIST_ENTRIES      256     /* Power of two */
+
+enum wifi67_fw_hist_type {
+    WIFI67_FW_HIST_LOAD = 1,
+    WIFI67_FW_HIST_START,
+    WIFI67_FW_HIST_READY,
+    WIFI67_FW_HIST_STOP,
+    WIFI67_FW_HIST_CRASH,
+    WIFI67_FW_HIST_RECOVER,
+    WIFI67_FW_HIST_RESUME,
+};
+
+struct wifi67_fw_hist_entry {
+    __le64 timestamp_ns;
+    __le32 type;
+    __le32 radio_id;
+    __le32 arg0;
+    __le32 arg1;
+} __packed;
+
+struct wifi67_fw_hist {
+    spinlock_t lock;
+    u32 next;
+    struct wifi67_fw_hist_entry entries[WIFI67_FW_HIST_ENTRIES];
+};
+
+struct wifi67_fw_dump {
+    u8 *buf;
+    size_t size;
+    size_t len;
+    u32 num_sections;
+    ktime_t start;
+    ktime_t deadline;
+};
+
+/* Reads @len bytes at @offset of a dumped memory region */
+typedef int (*wifi67_fw_dump_read_t)(void *ctx, size_t offset, void *buf,
+                                     size_t len);
+
+void wifi67_fw_hist_init(struct wifi67_fw_hist *hist);
+void wifi67_fw_hist_record(struct wifi67_fw_hist *hist, u32 type,
+                           u32 radio_id, u32 arg0, u32 arg1);
+
+int wifi67_fw_dump_begin(struct wifi67_fw_dump *dump, size_t max_size,
+                         unsigned int budget_ms, u32 radio_id,
+                         u32 error_code, u32 fw_version);
+int wifi67_fw_dump_add(struct wifi67_fw_dump *dump, u32 type,
+                       const void *data, size_t len);
+int wifi67_fw_dump_add_hist(struct wifi67_fw_dump *dump,
+                            struct wifi67_fw_hist *hist);
+int wifi67_fw_dump_add_region(struct wifi67_fw_dump *dump, u32 type,
+                              wifi67_fw_dump_read_t read, void *ctx,
+                              size_t len);
+void *wifi67_fw_dump_finish(struct wifi67_fw_dump *dump, size_t *len);
+void wifi67_fw_dump_abort(struct wifi67_fw_dump *dump);
+
+#endif /* _WIFI67_FW_COREDUMP_H_ */
@@ -0,0 +1,91 @@
+#ifndef _WIFI67_FW_IPC_H_
+#define _WIFI67_FW_IPC_H_
+
+#include <linux/types.h>
+#include <linux/cache.h>
+#include <linux/spinlock.h>
+
+/*
+ * Host <-> firmware message rings. Both directions are single-producer,
+ * single-consumer rings of fixed-size messages with free-running u32
+ * indices; each index lives on its own cache line in the shared control
+ * block so producer and consumer never write the same line.
+ *
+ * Shared buffer layout (WIFI67_IPC_RING_SIZE bytes):
+ *   0x0000  struct wifi67_ipc_ctrl
+ *   0x1000  command ring  (host -> firmware)
+ *   0x5000  event ring    (firmware -> host)
+ */
+
+#define WIFI67_IPC_MSG_SIZE         64
+#define WIFI67_IPC_MSG_PAYLOAD      56
+#define WIFI67_IPC_CMD_ENTRIES      256     /* Power of two */
+#define WIFI67_IPC_EVT_ENTRIES      512     /* Power of two */
+#define WIFI67_IPC_CMD_OFFSET       0x1000
+#define WIFI67_IPC_EVT_OFFSET       (WIFI67_IPC_CMD_OFFSET + \
+                                     WIFI67_IPC_CMD_ENTRIES * WIFI67_IPC_MSG_SIZE)
+#define WIFI67_IPC_SHARED_SIZE      (WIFI67_IPC_EVT_OFFSET + \
+                                     WIFI67_IPC_EVT_ENTRIES * WIFI67_IPC_MSG_SIZE)
+#define WIFI67_IPC_POLL_BUDGET      64      /* Events per poll pass */
+
+struct wifi67_ipc_msg {
+    __le16 id;
+    __le16 len;
+    __le32 seq;
+    u8 payload[WIFI67_IPC_MSG_PAYLOAD];
+} __packed;
+
+/* Shared control block; each index is written by exactly one side */
+struct wifi67_ipc_ctrl {
+    __le32 cmd_prod ____cacheline_aligned;  /* Host */
+    __le32 cmd_cons ____cacheline_aligned;  /* Firmware */
+    __le32 evt_prod ____cacheline_aligned;  /* Firmware */
+    __le32 evt_cons ____cacheline_aligned;  /* Host */
+};
+
+struct wifi67_ipc_ops {
+    void (*doorbell)(void *priv);
+    void (*event)(void *priv, const struct wifi67_ipc_msg *msg);
+};
+
+struct wifi67_ipc_stats {
+    u64 cmds;
+    u64 flushes;
+    u64 doorbells;
+    u64 doorbells_coalesced;
+    u64 ring_full;
+    u64 events;
+    u64 polls;
+};
+
+struct wifi67_ipc {
+    struct wifi67_ipc_ctrl *ctrl;
+    struct wifi67_ipc_msg *cmd_ring;
+    struct wifi67_ipc_msg *evt_ring;
+    const struct wifi67_ipc_ops *ops;
+    void *priv;
+
+    /* Command producer; the lock only orders host submitters */
+    spinlock_t cmd_lock;
+    u32 cmd_prod;           /* Next slot to fill, not yet visible */
+    u32 cmd_published;      /* Last index written to ctrl->cmd_prod */
+    u32 cmd_seq;
+
+    /* Event consumer, owned by the poll context */
+    u32 evt_cons ____cacheline_aligned;
+
+    struct wifi67_ipc_stats stats;
+};
+
+int wifi67_ipc_init(struct wifi67_ipc *ipc, void *ringbuf, size_t size,
+                    const struct wifi67_ipc_ops *ops, void *priv);
+void wifi67_ipc_reset(struct wifi67_ipc *ipc);
+int wifi67_ipc_queue(struct wifi67_ipc *ipc, u16 id,
+                     const void *payload, u16 len);
+void wifi67_ipc_flush(struct wifi67_ipc *ipc);
+int wifi67_ipc_send(struct wifi67_ipc *ipc, const struct wifi67_ipc_msg *msgs,
+                    int count);
+int wifi67_ipc_poll(struct wifi67_ipc *ipc, int budget);
+bool wifi67_ipc_evt_pending(struct wifi67_ipc *ipc);
+
+#endif /* _WIFI67_FW_IPC_H_ */
@@ -4,6 +4,7 @@
 #include <linux/types.h>
 #include <linux/pci.h>
 #include "../core/wifi67.h"
+#include "../firmware/emlfm.h"
 
 /* Hardware register definitions */
 #define WIFI67_REG_CONTROL     0x0000
@@ -64,6 +65,20 @@ int wifi67_hw_load_fw(struct wifi67_priv *priv, u8 radio_id,
                      const void *data, size_t size,
                      dma_addr_t iram_addr, dma_addr_t dram_addr,
                      dma_addr_t sram_addr);
+int wifi67_hw_fw_setup(struct wifi67_priv *priv, u8 radio_id,
+                      const void *data, size_t size,
+                      dma_addr_t iram_addr, dma_addr_t dram_addr,
+                      dma_addr_t sram_addr);
+int wifi67_hw_fw_copy(struct wifi67_priv *priv, u8 radio_id,
+                     const void *data, size_t size);
+void __iomem *wifi67_hw_fw_region_base(struct wifi67_priv *priv, u8 radio_id,
+                                      enum wifi67_fw_region region);
+int wifi67_hw_fw_write_region(struct wifi67_priv *priv, u8 radio_id,
+                             enum wifi67_fw_region region,
+                             const void *data, size_t len);
+int wifi67_hw_fw_read_region(struct wifi67_priv *priv, u8 radio_id,
+                            enum wifi67_fw_region region, size_t offset,
+                            void *buf, size_t len);
 int wifi67_hw_start_fw(struct wifi67_priv *priv, u8 radio_id,
                       dma_addr_t ipc_addr, size_t ipc_size);
 void wifi67_hw_stop_fw(struct wifi67_priv *priv, u8 radio_id);
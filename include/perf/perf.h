@@ -4,19 +4,23 @@
 #include <linux/types.h>
 #include <linux/workqueue.h>
 #include <linux/atomic.h>
+#include "perf_counters.h"
+
+struct wifi67_perf_latency;
+struct wifi67_perf_ring;
 
 struct wifi67_perf_monitor {
     struct delayed_work dwork;
-    atomic_t tx_packets;
-    atomic_t rx_packets;
-    atomic_t tx_bytes;
-    atomic_t rx_bytes;
-    atomic_t tx_errors;
-    atomic_t rx_errors;
+    struct wifi67_perf_counters counters;
     u32 hw_errors;
     u32 fifo_errors; 
     u32 dma_errors;
     ktime_t last_sample;
+    struct wifi67_perf_snapshot last;
+    u32 sample_interval;
+    bool enabled;
+    struct wifi67_perf_latency *latency;
+    struct wifi67_perf_ring *ring;
 };
 
-#endif /* _WIFI67_PERF_H_ */ 
\ No newline at end of file
+#endif /* _WIFI67_PERF_H_ */
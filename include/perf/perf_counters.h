@@ -0,0 +1,73 @@
+#ifndef _WIFI67_PERF_COUNTERS_H_
+#define _WIFI67_PERF_COUNTERS_H_
+
+#include <linux/types.h>
+#include <linux/percpu.h>
+#include <linux/u64_stats_sync.h>
+
+/*
+ * Data path counters. Each CPU updates its own copy so the hot path never
+ * bounces a shared cache line; readers fold all CPUs into a snapshot.
+ * u64_stats_sync keeps 64-bit values tear-free on 32-bit platforms and
+ * compiles away on 64-bit ones.
+ */
+
+/* Byte counters directly follow their packet counters */
+enum wifi67_perf_counter {
+    WIFI67_PERF_TX_PACKETS,
+    WIFI67_PERF_TX_BYTES,
+    WIFI67_PERF_RX_PACKETS,
+    WIFI67_PERF_RX_BYTES,
+    WIFI67_PERF_TX_ERRORS,
+    WIFI67_PERF_RX_ERRORS,
+    WIFI67_PERF_TX_DROPPED,
+    WIFI67_PERF_RX_DROPPED,
+    WIFI67_PERF_NUM_COUNTERS,
+};
+
+struct wifi67_perf_pcpu {
+    u64_stats_t cnt[WIFI67_PERF_NUM_COUNTERS];
+    struct u64_stats_sync syncp;
+};
+
+struct wifi67_perf_counters {
+    struct wifi67_perf_pcpu __percpu *pcpu;
+};
+
+struct wifi67_perf_snapshot {
+    u64 cnt[WIFI67_PERF_NUM_COUNTERS];
+};
+
+int wifi67_perf_counters_init(struct wifi67_perf_counters *c);
+void wifi67_perf_counters_free(struct wifi67_perf_counters *c);
+void wifi67_perf_counters_read(struct wifi67_perf_counters *c,
+                               struct wifi67_perf_snapshot *snap);
+
+/* Safe from any context, including hard IRQ */
+static inline void wifi67_perf_add(struct wifi67_perf_counters *c,
+                                   unsigned int idx, u64 val)
+{
+    struct wifi67_perf_pcpu *p = get_cpu_ptr(c->pcpu);
+    unsigned long flags;
+
+    flags = u64_stats_update_begin_irqsave(&p->syncp);
+    u64_stats_add(&p->cnt[idx], val);
+    u64_stats_update_end_irqrestore(&p->syncp, flags);
+    put_cpu_ptr(c->pcpu);
+}
+
+/* Count one packet of @len bytes; @idx is a *_PACKETS counter */
+static inline void wifi67_perf_add_packet(struct wifi67_perf_counters *c,
+                                          unsigned int idx, u64 len)
+{
+    struct wifi67_perf_pcpu *p = get_cpu_ptr(c->pcpu);
+    unsigned long flags;
+
+    flags = u64_stats_update_begin_irqsave(&p->syncp);
+    u64_stats_inc(&p->cnt[idx]);
+    u64_stats_add(&p->cnt[idx + 1], len);
+    u64_stats_update_end_irqrestore(&p->syncp, flags);
+    put_cpu_ptr(c->pcpu);
+}
+
+#endif /* _WIFI67_PERF_COUNTERS_H_ */
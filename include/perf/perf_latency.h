@@ -0,0 +1,70 @@
+#ifndef _WIFI67_PERF_LATENCY_H_
+#define _WIFI67_PERF_LATENCY_H_
+
+#include <linux/types.h>
+#include <linux/skbuff.h>
+#include <linux/jump_label.h>
+#include <net/mac80211.h>
+
+/*
+ * Per-frame TX latency. Frames are stamped as they pass each point of the
+ * data path and, on TX completion, the time spent in every stage goes
+ * into log-scale histograms kept per access category and per link. While
+ * tracking is off each hook is a patched-out branch.
+ *
+ * Stamps live in a table keyed by skb address, not in the skb control
+ * buffer, so info->control stays intact until TX status. They hold the
+ * low 32 bits of the ns clock: stages longer than ~4.2 s alias.
+ */
+
+enum wifi67_lat_point {
+    WIFI67_LAT_ENQUEUE,      /* Accepted by the MAC */
+    WIFI67_LAT_DEQUEUE,      /* Picked by the QoS scheduler */
+    WIFI67_LAT_DMA_POST,     /* Descriptor handed to hardware */
+    WIFI67_LAT_NUM_POINTS,
+};
+
+enum wifi67_lat_stage {
+    WIFI67_LAT_STAGE_QUEUE,  /* Enqueue to dequeue */
+    WIFI67_LAT_STAGE_SCHED,  /* Dequeue to DMA post */
+    WIFI67_LAT_STAGE_HW,     /* DMA post to TX completion */
+    WIFI67_LAT_STAGE_TOTAL,  /* Enqueue to TX completion */
+    WIFI67_LAT_NUM_STAGES,
+};
+
+/* Four buckets per power of two covers 1 ns to 4.2 s within 25% */
+#define WIFI67_LAT_BUCKETS       124
+#define WIFI67_LAT_MAX_LINKS     4
+
+struct wifi67_priv;
+struct wifi67_perf_latency;
+
+DECLARE_STATIC_KEY_FALSE(wifi67_lat_enabled);
+
+void __wifi67_lat_stamp(struct sk_buff *skb, enum wifi67_lat_point point);
+void __wifi67_lat_tx_done(struct wifi67_priv *priv, struct sk_buff *skb,
+                          u8 link_id);
+
+int wifi67_lat_init(struct wifi67_priv *priv, struct dentry *parent);
+void wifi67_lat_deinit(struct wifi67_priv *priv);
+int wifi67_lat_enable(struct wifi67_priv *priv, bool enable);
+void wifi67_lat_reset(struct wifi67_priv *priv);
+u32 wifi67_lat_percentile(struct wifi67_priv *priv, enum wifi67_lat_stage stage,
+                          bool per_link, unsigned int idx, u32 permille,
+                          u64 *count);
+
+static inline void wifi67_lat_stamp(struct sk_buff *skb,
+                                    enum wifi67_lat_point point)
+{
+    if (static_branch_unlikely(&wifi67_lat_enabled))
+        __wifi67_lat_stamp(skb, point);
+}
+
+static inline void wifi67_lat_tx_done(struct wifi67_priv *priv,
+                                      struct sk_buff *skb, u8 link_id)
+{
+    if (static_branch_unlikely(&wifi67_lat_enabled))
+        __wifi67_lat_tx_done(priv, skb, link_id);
+}
+
+#endif /* _WIFI67_PERF_LATENCY_H_ */
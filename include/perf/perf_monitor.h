@@ -10,26 +10,27 @@ int wifi67_perf_init(struct wifi67_priv *priv);
 void wifi67_perf_deinit(struct wifi67_priv *priv);
 void wifi67_perf_sample(struct wifi67_priv *priv);
 
+void wifi67_perf_get_snapshot(struct wifi67_priv *priv,
+                              struct wifi67_perf_snapshot *snap);
+
 static inline void wifi67_perf_tx_packet(struct wifi67_priv *priv, size_t len)
 {
-    atomic_inc(&priv->perf.tx_packets);
-    atomic_add(len, &priv->perf.tx_bytes);
+    wifi67_perf_add_packet(&priv->perf.counters, WIFI67_PERF_TX_PACKETS, len);
 }
 
 static inline void wifi67_perf_rx_packet(struct wifi67_priv *priv, size_t len)
 {
-    atomic_inc(&priv->perf.rx_packets);
-    atomic_add(len, &priv->perf.rx_bytes);
+    wifi67_perf_add_packet(&priv->perf.counters, WIFI67_PERF_RX_PACKETS, len);
 }
 
 static inline void wifi67_perf_tx_error(struct wifi67_priv *priv)
 {
-    atomic_inc(&priv->perf.tx_errors);
+    wifi67_perf_add(&priv->perf.counters, WIFI67_PERF_TX_ERRORS, 1);
 }
 
 static inline void wifi67_perf_rx_error(struct wifi67_priv *priv)
 {
-    atomic_inc(&priv->perf.rx_errors);
+    wifi67_perf_add(&priv->perf.counters, WIFI67_PERF_RX_ERRORS, 1);
 }
 
 #endif /* _WIFI67_PERF_MONITOR_H_ */ 
\ No newline at end of file
@@ -0,0 +1,179 @@
+#ifndef _WIFI67_PERF_RING_H_
+#define _WIFI67_PERF_RING_H_
+
+#include <linux/types.h>
+#include <linux/percpu.h>
+#include <linux/u64_stats_sync.h>
+#include <linux/hrtimer.h>
+#include <linux/kref.h>
+
+/*
+ * Binary perf history for userspace collectors. The debugfs file
+ * perf_ring/data maps a header page followed by a power-of-two array of
+ * fixed-size records. A single producer, an hrtimer, appends one record
+ * per sampling interval and never waits for readers: the oldest record
+ * is overwritten.
+ *
+ * Readers load hdr->head with acquire semantics, copy record
+ * (seq % nr_records) and keep the copy only if its seq field equals seq
+ * both before and after the copy; the producer sets it to ~0 while a
+ * record is rewritten. A gap between the sequence numbers of two kept
+ * records is the number of samples lost to overrun.
+ *
+ * Counters are cumulative since the ring was created, so rates come from
+ * deltas between records.
+ */
+
+#define WIFI67_PERF_RING_MAGIC      0x50373657  /* "W67P" */
+#define WIFI67_PERF_RING_VERSION    1
+#define WIFI67_PERF_RING_RECORDS    4096        /* Power of two */
+#define WIFI67_PERF_RING_MAX_LINKS  4
+#define WIFI67_PERF_RING_NUM_ACS    4
+
+/* Sampling interval bounds, in microseconds */
+#define WIFI67_PERF_RING_MIN_US     1000
+#define WIFI67_PERF_RING_MAX_US     10000000
+#define WIFI67_PERF_RING_DEF_US     100000
+
+/* Shared with userspace: bump the version on any layout change */
+struct wifi67_perf_ring_hdr {
+    __u32 magic;
+    __u32 version;
+    __u32 hdr_size;         /* Offset of record 0 */
+    __u32 rec_size;
+    __u32 nr_records;
+    __u32 interval_us;
+    __u32 num_links;
+    __u32 num_acs;
+    __u64 head __aligned(64);   /* Sequence of the next record */
+};
+
+struct wifi67_perf_rec_link {
+    __u64 tx_packets;
+    __u64 tx_bytes;
+    __u64 tx_errors;
+    __u64 airtime_us;
+};
+
+struct wifi67_perf_rec_ac {
+    __u64 tx_packets;
+    __u64 tx_bytes;
+};
+
+struct wifi67_perf_rec {
+    __u64 seq;
+    __u64 timestamp_ns;     /* CLOCK_MONOTONIC */
+    __u64 tx_packets;
+    __u64 tx_bytes;
+    __u64 rx_packets;
+    __u64 rx_bytes;
+    __u64 tx_errors;
+    __u64 rx_errors;
+    __u64 tx_dropped;
+    __u64 rx_dropped;
+    struct wifi67_perf_rec_link link[WIFI67_PERF_RING_MAX_LINKS];
+    struct wifi67_perf_rec_ac ac[WIFI67_PERF_RING_NUM_ACS];
+};
+
+/* Per-link and per-AC counters feeding the ring, kept per CPU */
+enum wifi67_perf_link_stat {
+    WIFI67_PERF_LINK_TX_PACKETS,
+    WIFI67_PERF_LINK_TX_BYTES,
+    WIFI67_PERF_LINK_TX_ERRORS,
+    WIFI67_PERF_LINK_AIRTIME,
+    WIFI67_PERF_LINK_NUM_STATS,
+};
+
+enum wifi67_perf_ac_stat {
+    WIFI67_PERF_AC_TX_PACKETS,
+    WIFI67_PERF_AC_TX_BYTES,
+    WIFI67_PERF_AC_NUM_STATS,
+};
+
+struct wifi67_perf_ring_pcpu {
+    u64_stats_t link[WIFI67_PERF_RING_MAX_LINKS][WIFI67_PERF_LINK_NUM_STATS];
+    u64_stats_t ac[WIFI67_PERF_RING_NUM_ACS][WIFI67_PERF_AC_NUM_STATS];
+    struct u64_stats_sync syncp;
+};
+
+struct wifi67_priv;
+struct dentry;
+
+struct wifi67_perf_ring {
+    struct wifi67_perf_ring_pcpu __percpu *pcpu;
+    struct wifi67_perf_ring_hdr *hdr;   /* vmalloc_user(), header page first */
+    struct wifi67_perf_rec *recs;
+    size_t size;
+    u64 seq;                            /* Producer only */
+    struct hrtimer timer;
+    struct wifi67_priv *priv;
+    struct dentry *dir;
+    struct kref ref;                    /* Owner plus each open data file */
+};
+
+int wifi67_perf_ring_init(struct wifi67_priv *priv, struct dentry *parent);
+void wifi67_perf_ring_deinit(struct wifi67_priv *priv);
+int wifi67_perf_ring_set_interval(struct wifi67_priv *priv, u32 interval_us);
+
+/* Safe from any context, including hard IRQ */
+static inline void wifi67_perf_ring_link_add(struct wifi67_perf_ring *ring,
+                                             unsigned int link,
+                                             unsigned int stat, u64 val)
+{
+    struct wifi67_perf_ring_pcpu *p;
+    unsigned long flags;
+
+    if (!ring || link >= WIFI67_PERF_RING_MAX_LINKS)
+        return;
+
+    p = get_cpu_ptr(ring->pcpu);
+    flags = u64_stats_update_begin_irqsave(&p->syncp);
+    u64_stats_add(&p->link[link][stat], val);
+    u64_stats_update_end_irqrestore(&p->syncp, flags);
+    put_cpu_ptr(ring->pcpu);
+}
+
+static inline void wifi67_perf_ring_ac_add(struct wifi67_perf_ring *ring,
+                                           unsigned int ac,
+                                           unsigned int stat, u64 val)
+{
+    struct wifi67_perf_ring_pcpu *p;
+    unsigned long flags;
+
+    if (!ring || ac >= WIFI67_PERF_RING_NUM_ACS)
+        return;
+
+    p = get_cpu_ptr(ring->pcpu);
+    flags = u64_stats_update_begin_irqsave(&p->syncp);
+    u64_stats_add(&p->ac[ac][stat], val);
+    u64_stats_update_end_irqrestore(&p->syncp, flags);
+    put_cpu_ptr(ring->pcpu);
+}
+
+/* One completed frame: link and AC counters under a single update */
+static inline void wifi67_perf_ring_tx_done(struct wifi67_perf_ring *ring,
+                                            unsigned int link, unsigned int ac,
+                                            u32 len, bool success)
+{
+    struct wifi67_perf_ring_pcpu *p;
+    unsigned long flags;
+
+    if (!ring || link >= WIFI67_PERF_RING_MAX_LINKS ||
+        ac >= WIFI67_PERF_RING_NUM_ACS)
+        return;
+
+    p = get_cpu_ptr(ring->pcpu);
+    flags = u64_stats_update_begin_irqsave(&p->syncp);
+    if (success) {
+        u64_stats_inc(&p->link[link][WIFI67_PERF_LINK_TX_PACKETS]);
+        u64_stats_add(&p->link[link][WIFI67_PERF_LINK_TX_BYTES], len);
+        u64_stats_inc(&p->ac[ac][WIFI67_PERF_AC_TX_PACKETS]);
+        u64_stats_add(&p->ac[ac][WIFI67_PERF_AC_TX_BYTES], len);
+    } else {
+        u64_stats_inc(&p->link[link][WIFI67_PERF_LINK_TX_ERRORS]);
+    }
+    u64_stats_update_end_irqrestore(&p->syncp, flags);
+    put_cpu_ptr(ring->pcpu);
+}
+
+#endif /* _WIFI67_PERF_RING_H_ */
@@ -5,6 +5,8 @@
 #include <linux/math64.h>
 #include "../../include/core/wifi67.h"
 #include "../../include/core/emlrc.h"
+#include "../../include/perf/perf_latency.h"
+#include "../../include/perf/perf_ring.h"
 
 struct wifi67_emlrc_stats {
     u32 attempts;
@@ -237,6 +239,10 @@ void wifi67_emlrc_tx_status(struct wifi67_priv *priv, u8 link_id,
     struct wifi67_rate_ctrl *rc;
     unsigned long flags;
 
+    wifi67_lat_tx_done(priv, skb, link_id);
+    wifi67_perf_ring_tx_done(READ_ONCE(priv->perf.ring), link_id,
+                             skb_get_queue_mapping(skb), skb->len, success);
+
     if (!emlrc || emlrc->state != WIFI67_EMLRC_ENABLED ||
         link_id >= WIFI67_MAX_LINKS)
         return;
@@ -4,6 +4,7 @@
 #include <linux/ieee80211.h>
 #include "../../include/core/wifi67.h"
 #include "../../include/core/emlsr.h"
+#include "../../include/debug/wifi67_trace.h"
 
 struct wifi67_emlsr {
     spinlock_t lock;
@@ -67,6 +68,8 @@ static void wifi67_emlsr_switch_handler(struct work_struct *work)
         goto out;
 
     next_link = (emlsr->active_link + 1) % WIFI67_MAX_LINKS;
+    trace_wifi67_emlsr_switch(emlsr->active_link, next_link,
+                              emlsr->transition_delay);
     wifi67_hw_switch_link(priv, next_link);
     emlsr->active_link = next_link;
 
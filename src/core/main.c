@@ -9,6 +9,8 @@
 #include "../../include/core/bands.h"
 #include "../../include/debug/debug.h"
 #include "../../include/core/mlo.h"
+#include "../../hardware_support/firmware/fw_common.h"
+#include "../../hardware_support/firmware/fw_attest.h"
 
 /* Function prototypes */
 static int wifi67_probe(struct pci_dev *pdev, const struct pci_device_id *id);
@@ -26,7 +28,7 @@ static int wifi67_probe(struct pci_dev *pdev, const struct pci_device_id *id)
     /* Allocate ieee80211_hw */
     hw = ieee80211_alloc_hw(sizeof(struct wifi67_priv), &wifi67_ops);
     if (!hw) {
-        wifi67_debug(NULL, WIFI67_DEBUG_ERROR, "Failed to allocate hw\n");
+        wifi67_err(NULL, WIFI67_LOG_CORE, "Failed to allocate hw\n");
         return -ENOMEM;
     }
 
@@ -38,7 +40,7 @@ static int wifi67_probe(struct pci_dev *pdev, const struct pci_device_id *id)
     /* Initialize PCI device */
     ret = wifi67_setup_pci(priv);
     if (ret) {
-        wifi67_debug(priv, WIFI67_DEBUG_ERROR, "Failed to setup PCI: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Failed to setup PCI: %d\n", ret);
         goto err_free_hw;
     }
 
@@ -48,34 +50,34 @@ static int wifi67_probe(struct pci_dev *pdev, const struct pci_device_id *id)
     /* Setup frequency bands */
     ret = wifi67_setup_bands(priv);
     if (ret) {
-        wifi67_debug(priv, WIFI67_DEBUG_ERROR, "Failed to setup bands: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Failed to setup bands: %d\n", ret);
         goto err_cleanup_pci;
     }
 
     /* Initialize subsystems */
     ret = wifi67_hw_diag_init(priv);
     if (ret) {
-        wifi67_debug(priv, WIFI67_DEBUG_ERROR, "Failed to init diagnostics: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Failed to init diagnostics: %d\n", ret);
         goto err_cleanup_pci;
     }
 
     ret = wifi67_power_init(priv);
     if (ret) {
-        wifi67_debug(priv, WIFI67_DEBUG_ERROR, "Failed to init power mgmt: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Failed to init power mgmt: %d\n", ret);
         goto err_deinit_diag;
     }
 
     /* Initialize MLO subsystem */
     ret = wifi67_mlo_init(priv);
     if (ret) {
-        wifi67_debug(priv, WIFI67_DEBUG_ERROR, "Failed to init MLO: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Failed to init MLO: %d\n", ret);
         goto err_deinit_power;
     }
 
     /* Register with mac80211 */
     ret = ieee80211_register_hw(hw);
     if (ret) {
-        wifi67_debug(priv, WIFI67_DEBUG_ERROR, "Failed to register hw: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Failed to register hw: %d\n", ret);
         goto err_deinit_mlo;
     }
 
@@ -123,7 +125,30 @@ static struct pci_driver wifi67_pci_driver = {
     .remove = wifi67_remove,
 };
 
-module_pci_driver(wifi67_pci_driver);
+static int __init wifi67_init(void)
+{
+    int ret;
+
+    ret = fw_attest_init();
+    if (ret)
+        return ret;
+
+    ret = pci_register_driver(&wifi67_pci_driver);
+    if (ret)
+        fw_attest_exit();
+
+    return ret;
+}
+
+static void __exit wifi67_exit(void)
+{
+    pci_unregister_driver(&wifi67_pci_driver);
+    fw_attest_exit();
+    fw_hash_exit();
+}
+
+module_init(wifi67_init);
+module_exit(wifi67_exit);
 
 MODULE_AUTHOR("Your Name");
 MODULE_DESCRIPTION("WiFi 6E/7 Driver");
@@ -161,14 +161,14 @@ u8 wifi67_mlo_get_link_for_tid(struct wifi67_mlo_link *link, u8 tid)
         target_link = link->tid_maps[tid].primary_link;
         
         if (link->tid_maps[tid].secondary_links != 0) {
-            u8 active_links = link->tid_maps[tid].secondary_links;
+            unsigned long active_links = link->tid_maps[tid].secondary_links;
             u8 num_active = hweight8(active_links);
             
             if (num_active > 0) {
                 u8 selected = prandom_u32() % (num_active + 1);
                 if (selected > 0) {
                     int i;
-                    for_each_set_bit(i, (unsigned long *)&active_links, 8) {
+                    for_each_set_bit(i, &active_links, 8) {
                         selected--;
                         if (selected == 0) {
                             target_link = i;
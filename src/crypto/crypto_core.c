@@ -24,7 +24,7 @@ static int wifi67_crypto_aead_encrypt(struct wifi67_crypto_ctx *ctx,
     struct scatterlist sg[2];
     int ret;
 
-    req = aead_request_alloc(ctx->tfm_aead, GFP_KERNEL);
+    req = aead_request_alloc(ctx->tfm_aead, GFP_ATOMIC);
     if (!req)
         return -ENOMEM;
 
@@ -33,7 +33,7 @@ static int wifi67_crypto_aead_encrypt(struct wifi67_crypto_ctx *ctx,
     sg_set_buf(&sg[1], iv, WIFI67_CRYPTO_MAX_IV_SIZE);
 
     aead_request_set_tfm(req, ctx->tfm_aead);
-    aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP, NULL, NULL);
+    aead_request_set_callback(req, 0, NULL, NULL);
     aead_request_set_crypt(req, sg, sg, skb->len, iv);
     aead_request_set_ad(req, 0);
 
@@ -51,13 +51,13 @@ static int wifi67_crypto_skcipher_encrypt(struct wifi67_crypto_ctx *ctx,
     struct scatterlist sg;
     int ret;
 
-    req = skcipher_request_alloc(ctx->tfm_cipher, GFP_KERNEL);
+    req = skcipher_request_alloc(ctx->tfm_cipher, GFP_ATOMIC);
     if (!req)
         return -ENOMEM;
 
     sg_init_one(&sg, skb->data, skb->len);
     skcipher_request_set_tfm(req, ctx->tfm_cipher);
-    skcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP, NULL, NULL);
+    skcipher_request_set_callback(req, 0, NULL, NULL);
     skcipher_request_set_crypt(req, &sg, &sg, skb->len, iv);
 
     ret = crypto_skcipher_encrypt(req);
@@ -85,6 +85,7 @@ int wifi67_crypto_encrypt(struct wifi67_priv *priv, struct sk_buff *skb,
     if (!key->valid)
         return -EINVAL;
 
+    /* The lock covers the engine registers only, not the transform */
     spin_lock_irqsave(&ctx->lock, flags);
 
     /* Set encryption mode and key index */
@@ -95,15 +96,15 @@ int wifi67_crypto_encrypt(struct wifi67_priv *priv, struct sk_buff *skb,
     /* Set IV */
     memcpy_toio(ctx->regs + WIFI67_CRYPTO_REG_IV, iv, WIFI67_CRYPTO_MAX_IV_SIZE);
 
-    /* Perform encryption */
+    spin_unlock_irqrestore(&ctx->lock, flags);
+
+    /* Perform encryption; may run in atomic context, so no sleeping */
     if (key->cipher == WLAN_CIPHER_SUITE_CCMP) {
         ret = wifi67_crypto_aead_encrypt(ctx, key, skb, iv);
     } else if (key->cipher == WLAN_CIPHER_SUITE_TKIP) {
         ret = wifi67_crypto_skcipher_encrypt(ctx, key, skb, iv);
     }
 
-    spin_unlock_irqrestore(&ctx->lock, flags);
-
     return ret;
 }
 
@@ -115,7 +116,7 @@ static int wifi67_crypto_aead_decrypt(struct wifi67_crypto_ctx *ctx,
     struct scatterlist sg[2];
     int ret;
 
-    req = aead_request_alloc(ctx->tfm_aead, GFP_KERNEL);
+    req = aead_request_alloc(ctx->tfm_aead, GFP_ATOMIC);
     if (!req)
         return -ENOMEM;
 
@@ -124,7 +125,7 @@ static int wifi67_crypto_aead_decrypt(struct wifi67_crypto_ctx *ctx,
     sg_set_buf(&sg[1], iv, WIFI67_CRYPTO_MAX_IV_SIZE);
 
     aead_request_set_tfm(req, ctx->tfm_aead);
-    aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP, NULL, NULL);
+    aead_request_set_callback(req, 0, NULL, NULL);
     aead_request_set_crypt(req, sg, sg, skb->len, iv);
     aead_request_set_ad(req, 0);
 
@@ -142,13 +143,13 @@ static int wifi67_crypto_skcipher_decrypt(struct wifi67_crypto_ctx *ctx,
     struct scatterlist sg;
     int ret;
 
-    req = skcipher_request_alloc(ctx->tfm_cipher, GFP_KERNEL);
+    req = skcipher_request_alloc(ctx->tfm_cipher, GFP_ATOMIC);
     if (!req)
         return -ENOMEM;
 
     sg_init_one(&sg, skb->data, skb->len);
     skcipher_request_set_tfm(req, ctx->tfm_cipher);
-    skcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP, NULL, NULL);
+    skcipher_request_set_callback(req, 0, NULL, NULL);
     skcipher_request_set_crypt(req, &sg, &sg, skb->len, iv);
 
     ret = crypto_skcipher_decrypt(req);
@@ -176,6 +177,7 @@ int wifi67_crypto_decrypt(struct wifi67_priv *priv, struct sk_buff *skb,
     if (!key->valid)
         return -EINVAL;
 
+    /* Registers only, as in wifi67_crypto_encrypt() */
     spin_lock_irqsave(&ctx->lock, flags);
 
     /* Set decryption mode and key index */
@@ -186,6 +188,8 @@ int wifi67_crypto_decrypt(struct wifi67_priv *priv, struct sk_buff *skb,
     /* Set IV */
     memcpy_toio(ctx->regs + WIFI67_CRYPTO_REG_IV, iv, WIFI67_CRYPTO_MAX_IV_SIZE);
 
+    spin_unlock_irqrestore(&ctx->lock, flags);
+
     /* Perform decryption */
     if (key->cipher == WLAN_CIPHER_SUITE_CCMP) {
         ret = wifi67_crypto_aead_decrypt(ctx, key, skb, iv);
@@ -193,8 +197,6 @@ int wifi67_crypto_decrypt(struct wifi67_priv *priv, struct sk_buff *skb,
         ret = wifi67_crypto_skcipher_decrypt(ctx, key, skb, iv);
     }
 
-    spin_unlock_irqrestore(&ctx->lock, flags);
-
     return ret;
 }
 
@@ -1,47 +1,166 @@
 #include <linux/module.h>
 #include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/mutex.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
 #include "../../include/debug/debug.h"
 
-void wifi67_debug(struct wifi67_priv *priv, u32 level, const char *fmt, ...)
+DEFINE_STATIC_KEY_ARRAY_FALSE(wifi67_log_keys,
+                              WIFI67_LOG_NUM_SUBSYS * WIFI67_LOG_NUM_LEVELS);
+
+/* Current level of each subsystem, as an index into the level names */
+static DEFINE_MUTEX(wifi67_log_mutex);
+static u8 wifi67_log_levels[WIFI67_LOG_NUM_SUBSYS] = {
+    [0 ... WIFI67_LOG_NUM_SUBSYS - 1] = WIFI67_LOG_DEFAULT_LEVEL + 1,
+};
+
+static const char * const wifi67_log_subsys_names[WIFI67_LOG_NUM_SUBSYS] = {
+    [WIFI67_LOG_CORE] = "core",
+    [WIFI67_LOG_DMA] = "dma",
+    [WIFI67_LOG_MAC] = "mac",
+    [WIFI67_LOG_AGG] = "agg",
+    [WIFI67_LOG_BA] = "ba",
+    [WIFI67_LOG_QOS] = "qos",
+    [WIFI67_LOG_MLO] = "mlo",
+    [WIFI67_LOG_PHY] = "phy",
+    [WIFI67_LOG_FW] = "fw",
+    [WIFI67_LOG_USB] = "usb",
+};
+
+/* "off" sits below the lowest level, so its index is the level plus one */
+static const char * const wifi67_log_level_names[] = {
+    "off", "err", "warn", "info", "dbg",
+};
+
+void __wifi67_log(struct wifi67_priv *priv, unsigned int subsys,
+                  unsigned int level, const char *fmt, ...)
 {
+    static const char * const kern_levels[WIFI67_LOG_NUM_LEVELS] = {
+        [WIFI67_LOG_ERR] = KERN_ERR,
+        [WIFI67_LOG_WARN] = KERN_WARNING,
+        [WIFI67_LOG_INFO] = KERN_INFO,
+        [WIFI67_LOG_DBG] = KERN_DEBUG,
+    };
+    struct va_format vaf;
     va_list args;
-    struct wifi67_debugfs *debugfs = &priv->debugfs;
-
-    if (!(debugfs->debug_mask & level))
-        return;
 
     va_start(args, fmt);
-    vprintk(fmt, args);
+    vaf.fmt = fmt;
+    vaf.va = &args;
+
+    if (priv && priv->pdev) {
+        dev_printk(kern_levels[level], &priv->pdev->dev, "%s: %pV",
+                   wifi67_log_subsys_names[subsys], &vaf);
+    } else {
+        /* printk only takes the level from the start of the format */
+        switch (level) {
+        case WIFI67_LOG_ERR:
+            pr_err("wifi67: %s: %pV", wifi67_log_subsys_names[subsys], &vaf);
+            break;
+        case WIFI67_LOG_WARN:
+            pr_warn("wifi67: %s: %pV", wifi67_log_subsys_names[subsys], &vaf);
+            break;
+        case WIFI67_LOG_INFO:
+            pr_info("wifi67: %s: %pV", wifi67_log_subsys_names[subsys], &vaf);
+            break;
+        default:
+            printk(KERN_DEBUG "wifi67: %s: %pV",
+                   wifi67_log_subsys_names[subsys], &vaf);
+            break;
+        }
+    }
+
     va_end(args);
 }
 
+/* Turn on every level up to @level (-1 for none) for one subsystem */
+int wifi67_log_set_level(unsigned int subsys, int level)
+{
+    struct static_key_false *key;
+    bool on;
+    int i;
+
+    if (subsys >= WIFI67_LOG_NUM_SUBSYS || level < -1 ||
+        level >= WIFI67_LOG_NUM_LEVELS)
+        return -EINVAL;
+
+    mutex_lock(&wifi67_log_mutex);
+
+    for (i = 0; i < WIFI67_LOG_NUM_LEVELS; i++) {
+        key = &wifi67_log_keys[WIFI67_LOG_KEY(subsys, i)];
+        on = i <= level;
+
+        /* Keys record a difference from the default state of the level */
+        if (on != (i <= WIFI67_LOG_DEFAULT_LEVEL))
+            static_branch_enable(key);
+        else
+            static_branch_disable(key);
+    }
+    wifi67_log_levels[subsys] = level + 1;
+
+    mutex_unlock(&wifi67_log_mutex);
+    return 0;
+}
+
 static ssize_t wifi67_debug_level_read(struct file *file,
                                      char __user *user_buf,
                                      size_t count, loff_t *ppos)
 {
-    struct wifi67_priv *priv = file->private_data;
-    char buf[32];
-    int len;
+    char buf[WIFI67_LOG_NUM_SUBSYS * 16];
+    int i, len = 0;
+
+    mutex_lock(&wifi67_log_mutex);
+    for (i = 0; i < WIFI67_LOG_NUM_SUBSYS; i++)
+        len += scnprintf(buf + len, sizeof(buf) - len, "%-5s %s\n",
+                         wifi67_log_subsys_names[i],
+                         wifi67_log_level_names[wifi67_log_levels[i]]);
+    mutex_unlock(&wifi67_log_mutex);
 
-    len = scnprintf(buf, sizeof(buf), "0x%08x\n", priv->debugfs.debug_mask);
     return simple_read_from_buffer(user_buf, count, ppos, buf, len);
 }
 
+/*
+ * Accepts "<subsystem> <level>" or "all <level>", where level is one of
+ * off, err, warn, info or dbg. Enabling a level enables all levels below.
+ */
 static ssize_t wifi67_debug_level_write(struct file *file,
                                       const char __user *user_buf,
                                       size_t count, loff_t *ppos)
 {
-    struct wifi67_priv *priv = file->private_data;
-    unsigned long value;
-    int ret;
+    char buf[32], *level_str, *subsys_str;
+    int subsys, level, i, ret;
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, user_buf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    level_str = strim(buf);
+    subsys_str = strsep(&level_str, " \t");
+    if (!level_str)
+        return -EINVAL;
+    level_str = skip_spaces(level_str);
+
+    level = match_string(wifi67_log_level_names,
+                         ARRAY_SIZE(wifi67_log_level_names), level_str);
+    if (level < 0)
+        return level;
+
+    if (!strcmp(subsys_str, "all")) {
+        for (i = 0; i < WIFI67_LOG_NUM_SUBSYS; i++)
+            wifi67_log_set_level(i, level - 1);
+        return count;
+    }
 
-    ret = kstrtoul_from_user(user_buf, count, 0, &value);
-    if (ret)
-        return ret;
+    subsys = match_string(wifi67_log_subsys_names, WIFI67_LOG_NUM_SUBSYS,
+                          subsys_str);
+    if (subsys < 0)
+        return subsys;
 
-    priv->debugfs.debug_mask = value;
-    return count;
+    ret = wifi67_log_set_level(subsys, level - 1);
+    return ret ? ret : count;
 }
 
 static const struct file_operations wifi67_debug_level_ops = {
@@ -74,7 +193,6 @@ int wifi67_debugfs_init(struct wifi67_priv *priv)
         goto err_remove;
     }
 
-    debugfs->debug_mask = WIFI67_DEBUG_ERROR | WIFI67_DEBUG_WARNING;
     return 0;
 
 err_remove:
@@ -88,6 +206,8 @@ void wifi67_debugfs_remove(struct wifi67_priv *priv)
     debugfs_remove_recursive(priv->debugfs.dir);
 }
 
-EXPORT_SYMBOL_GPL(wifi67_debug);
+EXPORT_SYMBOL_GPL(wifi67_log_keys);
+EXPORT_SYMBOL_GPL(__wifi67_log);
+EXPORT_SYMBOL_GPL(wifi67_log_set_level);
 EXPORT_SYMBOL_GPL(wifi67_debugfs_init);
 EXPORT_SYMBOL_GPL(wifi67_debugfs_remove); 
\ No newline at end of file
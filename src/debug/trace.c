@@ -0,0 +1,18 @@
+#include <linux/module.h>
+
+#define CREATE_TRACE_POINTS
+#include "../../include/debug/wifi67_trace.h"
+
+/* Defined once here; other modules attach to or fire these through wifi67.ko */
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_dma_post);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_dma_complete);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_agg_build);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_ba_window_move);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_reorder_flush);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_rate_change);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_mlo_link_select);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_emlsr_switch);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_twt_sp);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_ipc_cmd);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_ipc_evt);
+EXPORT_TRACEPOINT_SYMBOL_GPL(wifi67_ipc_flush);
@@ -19,12 +19,12 @@ static void wifi67_hw_diag_work(struct work_struct *work)
     /* Run enabled diagnostic tests */
     if (diag->test_mask & WIFI67_DIAG_TEST_REG) {
         /* Register access tests */
-        wifi67_debug(priv, WIFI67_DEBUG_INFO, "Running register tests\n");
+        wifi67_info(priv, WIFI67_LOG_CORE, "Running register tests\n");
     }
 
     if (diag->test_mask & WIFI67_DIAG_TEST_MEM) {
         /* Memory tests */
-        wifi67_debug(priv, WIFI67_DEBUG_INFO, "Running memory tests\n");
+        wifi67_info(priv, WIFI67_LOG_CORE, "Running memory tests\n");
     }
 
     spin_unlock_irqrestore(&diag->lock, flags);
@@ -96,10 +96,10 @@ void wifi67_hw_diag_thermal(struct wifi67_priv *priv)
     
     /* Check thermal thresholds */
     if (temp >= WIFI67_THERMAL_CRITICAL) {
-        wifi67_err(priv, "Critical temperature reached: %d°C\n", temp);
+        wifi67_err(priv, WIFI67_LOG_CORE, "Critical temperature reached: %d°C\n", temp);
         wifi67_hw_emergency_shutdown(priv);
     } else if (temp >= WIFI67_THERMAL_THROTTLE) {
-        wifi67_warn(priv, "High temperature - throttling: %d°C\n", temp);
+        wifi67_warn(priv, WIFI67_LOG_CORE, "High temperature - throttling: %d°C\n", temp);
         wifi67_power_set_frequency(priv, WIFI67_DVFS_MIN_FREQ);
         stats.throttle_events++;
     }
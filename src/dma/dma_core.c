@@ -4,6 +4,8 @@
 #include <linux/io.h>
 #include "../../include/core/wifi67.h"
 #include "../../include/dma/dma_core.h"
+#include "../../include/debug/debug.h"
+#include "../../include/debug/wifi67_trace.h"
 
 static int wifi67_dma_ring_alloc(struct wifi67_priv *priv,
                                 struct wifi67_dma_ring *ring)
@@ -24,6 +26,11 @@ static int wifi67_dma_ring_alloc(struct wifi67_priv *priv,
     if (!ring->buf_dma)
         goto err_free_buf;
 
+    ring->buf_map_len = kcalloc(WIFI67_DMA_RING_SIZE,
+                                sizeof(*ring->buf_map_len), GFP_KERNEL);
+    if (!ring->buf_map_len)
+        goto err_free_dma;
+
     ring->size = WIFI67_DMA_RING_SIZE;
     ring->head = 0;
     ring->tail = 0;
@@ -32,6 +39,8 @@ static int wifi67_dma_ring_alloc(struct wifi67_priv *priv,
 
     return 0;
 
+err_free_dma:
+    kfree(ring->buf_dma);
 err_free_buf:
     kfree(ring->buf_addr);
 err_free_desc:
@@ -44,6 +53,7 @@ err_free_desc:
 static void wifi67_dma_ring_free(struct wifi67_priv *priv,
                                 struct wifi67_dma_ring *ring)
 {
+    kfree(ring->buf_map_len);
     kfree(ring->buf_dma);
     kfree(ring->buf_addr);
     dma_free_coherent(priv->dma_dev->dev,
@@ -127,9 +137,13 @@ static void wifi67_dma_channel_recover(struct wifi67_priv *priv,
     atomic64_inc(&stats->successful_recoveries);
 }
 
-static void wifi67_dma_handle_error_locked(struct wifi67_priv *priv,
-                                         struct wifi67_dma_channel *chan,
-                                         u32 error_type)
+/*
+ * Recovery stops the channel and resets both rings under their locks, so
+ * this must run after the caller has dropped the ring lock.
+ */
+static void wifi67_dma_handle_error(struct wifi67_priv *priv,
+                                   struct wifi67_dma_channel *chan,
+                                   u32 error_type)
 {
     struct dma_monitor_stats *stats = &monitor_ctx.channel_stats[chan->channel_id];
     unsigned long flags;
@@ -140,8 +154,9 @@ static void wifi67_dma_handle_error_locked(struct wifi67_priv *priv,
     spin_unlock_irqrestore(&stats->lock, flags);
 
     if (error_type & DMA_ERR_FATAL) {
-        pr_err("Fatal DMA error on channel %d: 0x%08x\n",
-               chan->channel_id, error_type);
+        wifi67_err(priv, WIFI67_LOG_DMA,
+                   "Fatal DMA error on channel %d: 0x%08x\n",
+                   chan->channel_id, error_type);
         return;
     }
 
@@ -149,16 +164,13 @@ static void wifi67_dma_handle_error_locked(struct wifi67_priv *priv,
     wifi67_dma_channel_recover(priv, chan, error_type);
 }
 
-static int wifi67_dma_ring_check_errors(struct wifi67_priv *priv,
-                                      struct wifi67_dma_channel *chan,
-                                      struct wifi67_dma_ring *ring,
-                                      bool is_tx)
+static u32 wifi67_dma_ring_check_errors(struct wifi67_dma_channel *chan)
 {
     u32 val = readl(chan->regs + WIFI67_DMA_REG_ERR_STATUS);
     u32 error_type = DMA_ERR_NONE;
 
     if (!val)
-        return 0;
+        return DMA_ERR_NONE;
 
     if (val & BIT(0))
         error_type |= DMA_ERR_DESC_OWNERSHIP;
@@ -181,10 +193,7 @@ static int wifi67_dma_ring_check_errors(struct wifi67_priv *priv,
     if (val & BIT(31))
         error_type |= DMA_ERR_FATAL;
 
-    if (error_type != DMA_ERR_NONE)
-        wifi67_dma_handle_error_locked(priv, chan, error_type);
-
-    return error_type ? -EIO : 0;
+    return error_type;
 }
 
 int wifi67_dma_init(struct wifi67_priv *priv)
@@ -363,8 +372,9 @@ int wifi67_dma_ring_add_buffer(struct wifi67_priv *priv, u32 channel_id,
     struct wifi67_dma_desc *desc;
     unsigned long flags;
     dma_addr_t dma_addr;
+    u32 error_type = DMA_ERR_NONE;
     u32 next;
-    int ret;
+    int ret = 0;
 
     if (!dma || channel_id >= dma->num_channels || !buf || !len)
         return -EINVAL;
@@ -378,13 +388,17 @@ int wifi67_dma_ring_add_buffer(struct wifi67_priv *priv, u32 channel_id,
     spin_lock_irqsave(&ring->lock, flags);
 
     /* Check for errors before proceeding */
-    ret = wifi67_dma_ring_check_errors(priv, chan, ring, is_tx);
-    if (ret)
+    error_type = wifi67_dma_ring_check_errors(chan);
+    if (error_type != DMA_ERR_NONE) {
+        ret = -EIO;
         goto unlock;
+    }
 
     /* Check if ring is full */
     next = (ring->head + 1) % ring->size;
     if (next == ring->tail) {
+        wifi67_dbg(priv, WIFI67_LOG_DMA, "ch%u %s ring full\n", channel_id,
+                   is_tx ? "tx" : "rx");
         wifi67_dma_monitor_ring_full(priv, channel_id);
         ret = -ENOSPC;
         goto unlock;
@@ -411,20 +425,30 @@ int wifi67_dma_ring_add_buffer(struct wifi67_priv *priv, u32 channel_id,
     /* Store buffer info */
     ring->buf_addr[ring->head] = buf;
     ring->buf_dma[ring->head] = dma_addr;
+    ring->buf_map_len[ring->head] = len;
+    trace_wifi67_dma_post(channel_id, is_tx, ring->head, len);
 
     /* Update ring state */
     ring->head = next;
-    if (is_tx)
-        dma->stats.tx_bytes += len;
-    else
-        dma->stats.rx_bytes += len;
 
     /* Notify hardware of new descriptor */
     writel(ring->head, chan->regs + (is_tx ? WIFI67_DMA_REG_TX_HEAD :
                                             WIFI67_DMA_REG_RX_HEAD));
+    spin_unlock_irqrestore(&ring->lock, flags);
+
+    /* Stats are shared by all rings; keep them out of the ring lock */
+    spin_lock_irqsave(&dma->lock, flags);
+    if (is_tx)
+        dma->stats.tx_bytes += len;
+    else
+        dma->stats.rx_bytes += len;
+    spin_unlock_irqrestore(&dma->lock, flags);
+    return 0;
 
 unlock:
     spin_unlock_irqrestore(&ring->lock, flags);
+    if (error_type != DMA_ERR_NONE)
+        wifi67_dma_handle_error(priv, chan, error_type);
     return ret;
 }
 
@@ -436,8 +460,8 @@ void *wifi67_dma_ring_get_buffer(struct wifi67_priv *priv, u32 channel_id,
     struct wifi67_dma_ring *ring;
     struct wifi67_dma_desc *desc;
     unsigned long flags;
+    u32 error_type = DMA_ERR_NONE;
     void *buf;
-    int ret;
 
     if (!dma || channel_id >= dma->num_channels || !len)
         return NULL;
@@ -451,8 +475,8 @@ void *wifi67_dma_ring_get_buffer(struct wifi67_priv *priv, u32 channel_id,
     spin_lock_irqsave(&ring->lock, flags);
 
     /* Check for errors */
-    ret = wifi67_dma_ring_check_errors(priv, chan, ring, is_tx);
-    if (ret)
+    error_type = wifi67_dma_ring_check_errors(chan);
+    if (error_type != DMA_ERR_NONE)
         goto unlock;
 
     /* Check if ring is empty */
@@ -466,34 +490,43 @@ void *wifi67_dma_ring_get_buffer(struct wifi67_priv *priv, u32 channel_id,
 
     /* Check for descriptor errors */
     if (desc->status & cpu_to_le32(0xFF000000)) {
-        wifi67_dma_handle_error_locked(priv, chan, DMA_ERR_DESC_ERROR);
+        wifi67_warn(priv, WIFI67_LOG_DMA, "ch%u %s desc %u error 0x%08x\n",
+                    channel_id, is_tx ? "tx" : "rx", ring->tail,
+                    le32_to_cpu(desc->status));
+        error_type = DMA_ERR_DESC_ERROR;
         goto unlock;
     }
 
     /* Get buffer */
     buf = ring->buf_addr[ring->tail];
     *len = le16_to_cpu(desc->buf_len);
+    trace_wifi67_dma_complete(channel_id, is_tx, ring->tail, *len);
 
-    /* Unmap buffer */
-    dma_unmap_single(dma->dev, ring->buf_dma[ring->tail], *len,
+    /* Unmap what was mapped; the device writes back the RX length */
+    dma_unmap_single(dma->dev, ring->buf_dma[ring->tail],
+                     ring->buf_map_len[ring->tail],
                      is_tx ? DMA_TO_DEVICE : DMA_FROM_DEVICE);
 
     /* Update ring state */
     ring->tail = (ring->tail + 1) % ring->size;
-    if (is_tx)
-        dma->stats.tx_packets++;
-    else
-        dma->stats.rx_packets++;
 
     /* Update hardware tail pointer */
     writel(ring->tail, chan->regs + (is_tx ? WIFI67_DMA_REG_TX_TAIL :
                                             WIFI67_DMA_REG_RX_TAIL));
-
     spin_unlock_irqrestore(&ring->lock, flags);
+
+    spin_lock_irqsave(&dma->lock, flags);
+    if (is_tx)
+        dma->stats.tx_packets++;
+    else
+        dma->stats.rx_packets++;
+    spin_unlock_irqrestore(&dma->lock, flags);
     return buf;
 
 unlock:
     spin_unlock_irqrestore(&ring->lock, flags);
+    if (error_type != DMA_ERR_NONE)
+        wifi67_dma_handle_error(priv, chan, error_type);
     return NULL;
 }
 
@@ -552,3 +585,7 @@ EXPORT_SYMBOL_GPL(wifi67_dma_get_stats);
 EXPORT_SYMBOL_GPL(wifi67_dma_clear_stats);
 EXPORT_SYMBOL_GPL(wifi67_dma_set_burst_size);
 
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/dma_kunit.c"
+#endif
@@ -4,6 +4,7 @@
 #include <linux/seq_file.h>
 #include <linux/ktime.h>
 #include <linux/slab.h>
+#include <linux/mutex.h>
 #include "../../include/dma/dma_core.h"
 #include "../../include/dma/dma_monitor.h"
 
@@ -33,8 +34,11 @@ static struct dma_monitor_context {
     struct workqueue_struct *monitor_wq;
     atomic_t is_suspended;
     u32 num_channels;
+    unsigned int users;         /* One per DMA instance, under the mutex */
 } monitor_ctx;
 
+static DEFINE_MUTEX(dma_monitor_mutex);
+
 static void dma_monitor_dump_channel(struct seq_file *m, int channel)
 {
     struct dma_monitor_stats *stats = &monitor_ctx.channel_stats[channel];
@@ -172,10 +176,17 @@ void wifi67_dma_monitor_ring_full(struct wifi67_priv *priv, u32 channel_id)
 }
 EXPORT_SYMBOL_GPL(wifi67_dma_monitor_ring_full);
 
+/* The monitor is shared by every device; only the first user sets it up */
 int wifi67_dma_monitor_init(struct wifi67_priv *priv)
 {
     int i;
 
+    mutex_lock(&dma_monitor_mutex);
+    if (monitor_ctx.users++) {
+        mutex_unlock(&dma_monitor_mutex);
+        return 0;
+    }
+
     monitor_ctx.num_channels = WIFI67_DMA_MAX_CHANNELS;
     atomic_set(&monitor_ctx.is_suspended, 0);
 
@@ -184,7 +195,7 @@ int wifi67_dma_monitor_init(struct wifi67_priv *priv)
                                       sizeof(*monitor_ctx.channel_stats),
                                       GFP_KERNEL);
     if (!monitor_ctx.channel_stats)
-        return -ENOMEM;
+        goto err_unlock;
 
     /* Initialize per-channel statistics */
     for (i = 0; i < monitor_ctx.num_channels; i++) {
@@ -220,21 +231,33 @@ int wifi67_dma_monitor_init(struct wifi67_priv *priv)
     queue_delayed_work(monitor_ctx.monitor_wq, &monitor_ctx.watchdog_work,
                       msecs_to_jiffies(DMA_WATCHDOG_TIMEOUT_MS));
 
+    mutex_unlock(&dma_monitor_mutex);
     return 0;
 
 err_remove_debugfs:
     debugfs_remove_recursive(monitor_ctx.debugfs_root);
 err_free_stats:
     kfree(monitor_ctx.channel_stats);
+err_unlock:
+    monitor_ctx.users--;
+    mutex_unlock(&dma_monitor_mutex);
     return -ENOMEM;
 }
 EXPORT_SYMBOL_GPL(wifi67_dma_monitor_init);
 
 void wifi67_dma_monitor_deinit(struct wifi67_priv *priv)
 {
+    mutex_lock(&dma_monitor_mutex);
+    if (WARN_ON(!monitor_ctx.users) || --monitor_ctx.users) {
+        mutex_unlock(&dma_monitor_mutex);
+        return;
+    }
+
     cancel_delayed_work_sync(&monitor_ctx.watchdog_work);
     destroy_workqueue(monitor_ctx.monitor_wq);
     debugfs_remove_recursive(monitor_ctx.debugfs_root);
     kfree(monitor_ctx.channel_stats);
+    monitor_ctx.channel_stats = NULL;
+    mutex_unlock(&dma_monitor_mutex);
 }
 EXPORT_SYMBOL_GPL(wifi67_dma_monitor_deinit); 
\ No newline at end of file
@@ -3,8 +3,23 @@
 #include <linux/pci.h>
 #include <linux/dma-mapping.h>
 #include <linux/interrupt.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/vmalloc.h>
+#include <linux/debugfs.h>
+#include <linux/devcoredump.h>
+#include <crypto/hash.h>
+#include <crypto/sha2.h>
+#include <kunit/static_stub.h>
 #include "../../include/firmware/emlfm.h"
+#include "../../include/firmware/fw_ipc.h"
+#include "../../include/firmware/fw_coredump.h"
+#include "../../include/dma/dma_core.h"
 #include "../../include/core/wifi67.h"
+#include "../../include/hal/hardware.h"
+
+#define WIFI67_EMLFM_READBACK_CHUNK  (16 * 1024)
 
 struct wifi67_emlfm_region {
     void *vaddr;
@@ -13,7 +28,46 @@ struct wifi67_emlfm_region {
     u32 flags;
 };
 
+struct wifi67_emlfm;
+
+/*
+ * Verified copy of the last image loaded into a radio, with a digest per
+ * region. @written holds the digest of what the host last wrote into each
+ * device region and is cleared once running firmware may have modified
+ * it. Crash recovery and resume rewrite regions where the two differ, and
+ * otherwise only reuse a region whose read-back digest still matches.
+ */
+struct wifi67_emlfm_image {
+    void *data;
+    size_t size;
+    const u8 *region[WIFI67_FW_NUM_REGIONS];
+    size_t region_len[WIFI67_FW_NUM_REGIONS];
+    u8 digest[WIFI67_FW_NUM_REGIONS][SHA256_DIGEST_SIZE];
+    u8 written[WIFI67_FW_NUM_REGIONS][SHA256_DIGEST_SIZE];
+};
+
+/* Per-radio host/firmware message channel */
+struct wifi67_emlfm_ipc {
+    void *ringbuf;
+    dma_addr_t ringbuf_paddr;
+    size_t ringbuf_size;
+    struct wifi67_ipc ring;
+    struct work_struct poll_work;
+    struct wifi67_emlfm *emlfm;
+    u8 radio_id;
+};
+
+/* Per-radio firmware load worker */
+struct wifi67_emlfm_loader {
+    struct work_struct work;
+    struct wifi67_emlfm *emlfm;
+    const struct firmware *fw;
+    u8 radio_id;
+    int ret;
+};
+
 struct wifi67_emlfm {
+    struct wifi67_priv *priv;
     spinlock_t lock;
     struct {
         struct wifi67_emlfm_region iram;
@@ -30,47 +84,490 @@ struct wifi67_emlfm {
     
     struct {
         struct completion ready;
-        struct work_struct crash_work;
         u32 error_code;
         u32 crash_count;
+        struct wifi67_emlfm_recovery_stats recovery;
     } status[WIFI67_MAX_RADIOS];
     
-    struct {
-        void *ringbuf;
-        dma_addr_t ringbuf_paddr;
-        size_t ringbuf_size;
-        u32 read_idx;
-        u32 write_idx;
-        spinlock_t lock;
-    } ipc[WIFI67_MAX_RADIOS];
+    struct wifi67_emlfm_ipc ipc[WIFI67_MAX_RADIOS];
+    wifi67_emlfm_event_fn event_handler;
+
+    struct wifi67_emlfm_loader loader[WIFI67_MAX_RADIOS];
+
+    /* Fast recovery */
+    struct work_struct recovery_work;
+    struct mutex recovery_lock;     /* Serialises image retain/restore */
+    struct wifi67_emlfm_image image[WIFI67_MAX_RADIOS];
+    struct crypto_shash *sha256;
+    void *readback_buf;
+    const struct wifi67_emlfm_recovery_ops *recovery_ops;
+
+    /* Crash capture */
+    struct wifi67_fw_hist hist;
+    struct dentry *crash_dentry;
+};
+
+static const struct file_operations wifi67_emlfm_crash_fops;
+
+/* Region read-back for the crash dump */
+struct wifi67_emlfm_dump_src {
+    struct wifi67_emlfm *emlfm;
+    u8 radio_id;
+    enum wifi67_fw_region region;
 };
 
+static int wifi67_emlfm_dump_read(void *ctx, size_t offset, void *buf,
+                                  size_t len)
+{
+    struct wifi67_emlfm_dump_src *src = ctx;
+
+    return wifi67_hw_fw_read_region(src->emlfm->priv, src->radio_id,
+                                    src->region, offset, buf, len);
+}
+
+/* Host-side DMA ring indices; read unlocked, the device is wedged anyway */
+static void wifi67_emlfm_dump_dma(struct wifi67_emlfm *emlfm,
+                                  struct wifi67_fw_dump *dump)
+{
+    struct wifi67_dma *dma = emlfm->priv->dma_dev;
+    struct wifi67_fw_dump_dma_ring *rings;
+    u32 ch, n = 0;
+    int dir;
+
+    if (!dma)
+        return;
+
+    rings = kcalloc(2 * WIFI67_DMA_MAX_CHANNELS, sizeof(*rings), GFP_KERNEL);
+    if (!rings)
+        return;
+
+    for (ch = 0; ch < min_t(u32, dma->num_channels,
+                            WIFI67_DMA_MAX_CHANNELS); ch++) {
+        for (dir = 0; dir < 2; dir++) {
+            struct wifi67_dma_ring *ring = dir ?
+                &dma->channels[ch].rx_ring : &dma->channels[ch].tx_ring;
+
+            rings[n].channel = cpu_to_le32(ch);
+            rings[n].is_tx = cpu_to_le32(!dir);
+            rings[n].size = cpu_to_le32(READ_ONCE(ring->size));
+            rings[n].head = cpu_to_le32(READ_ONCE(ring->head));
+            rings[n].tail = cpu_to_le32(READ_ONCE(ring->tail));
+            rings[n].enabled = cpu_to_le32(READ_ONCE(ring->enabled));
+            n++;
+        }
+    }
+
+    wifi67_fw_dump_add(dump, WIFI67_FW_DUMP_DMA_RINGS, rings,
+                       n * sizeof(*rings));
+    kfree(rings);
+}
+
+/*
+ * Snapshot a crashed radio into a dump of at most @max_size bytes, taking
+ * no longer than about @budget_ms. Small, high-value sections go first so
+ * that the size and time bounds only ever cut into the large memory
+ * regions, IRAM last. Returns a vmalloc'd buffer or NULL.
+ */
+static void *wifi67_emlfm_build_dump(struct wifi67_emlfm *emlfm, u8 radio_id,
+                                     size_t max_size, unsigned int budget_ms,
+                                     size_t *len)
+{
+    static const struct {
+        u32 type;
+        enum wifi67_fw_region region;
+        size_t size;
+    } regions[] = {
+        { WIFI67_FW_DUMP_SRAM, WIFI67_FW_REGION_SRAM, WIFI67_FW_SRAM_SIZE },
+        { WIFI67_FW_DUMP_DRAM, WIFI67_FW_REGION_DRAM, WIFI67_FW_DRAM_SIZE },
+        { WIFI67_FW_DUMP_IRAM, WIFI67_FW_REGION_IRAM, WIFI67_FW_IRAM_SIZE },
+    };
+    struct wifi67_priv *priv = emlfm->priv;
+    struct wifi67_emlfm_dump_src src = {
+        .emlfm = emlfm,
+        .radio_id = radio_id,
+    };
+    struct wifi67_fw_dump dump;
+    __le32 regs[4];
+    int i;
+
+    if (wifi67_fw_dump_begin(&dump, max_size, budget_ms, radio_id,
+                             emlfm->status[radio_id].error_code,
+                             emlfm->fw[radio_id].version))
+        return NULL;
+
+    regs[0] = cpu_to_le32(wifi67_hw_read32(priv, WIFI67_REG_FW_STATUS));
+    regs[1] = cpu_to_le32(wifi67_hw_read32(priv, WIFI67_REG_FW_ERROR));
+    regs[2] = cpu_to_le32(wifi67_hw_read32(priv, WIFI67_REG_FW_CONTROL));
+    regs[3] = cpu_to_le32(wifi67_hw_read32(priv, WIFI67_REG_IPC_EVT_MASK));
+    wifi67_fw_dump_add(&dump, WIFI67_FW_DUMP_REGS, regs, sizeof(regs));
+
+    wifi67_fw_dump_add_hist(&dump, &emlfm->hist);
+
+    if (emlfm->ipc[radio_id].ringbuf)
+        wifi67_fw_dump_add(&dump, WIFI67_FW_DUMP_IPC,
+                           emlfm->ipc[radio_id].ringbuf,
+                           WIFI67_IPC_SHARED_SIZE);
+
+    wifi67_emlfm_dump_dma(emlfm, &dump);
+
+    for (i = 0; i < ARRAY_SIZE(regions); i++) {
+        src.region = regions[i].region;
+        wifi67_fw_dump_add_region(&dump, regions[i].type,
+                                  wifi67_emlfm_dump_read, &src,
+                                  regions[i].size);
+    }
+
+    return wifi67_fw_dump_finish(&dump, len);
+}
+
+/* devcoredump owns the buffer from here on */
+static void wifi67_emlfm_deliver_dump(struct wifi67_priv *priv, void *data,
+                                      size_t len)
+{
+    KUNIT_STATIC_STUB_REDIRECT(wifi67_emlfm_deliver_dump, priv, data, len);
+
+    dev_coredumpv(priv->dev, data, len, GFP_KERNEL);
+}
+
+/* Snapshot a crashed radio into a devcoredump before it is reset */
+static void wifi67_emlfm_coredump(struct wifi67_emlfm *emlfm, u8 radio_id)
+{
+    struct wifi67_priv *priv = emlfm->priv;
+    size_t len;
+    void *data;
+
+    data = wifi67_emlfm_build_dump(emlfm, radio_id, WIFI67_FW_DUMP_MAX_SIZE,
+                                   WIFI67_FW_DUMP_BUDGET_MS, &len);
+    if (!data)
+        return;
+
+    wifi67_emlfm_deliver_dump(priv, data, len);
+    emlfm->status[radio_id].recovery.coredumps++;
+
+    dev_err(priv->dev, "radio %u firmware crash 0x%08x, %zu byte dump captured\n",
+            radio_id, emlfm->status[radio_id].error_code, len);
+}
+
+static u32 wifi67_emlfm_region_flags(struct wifi67_emlfm *emlfm, u8 radio_id,
+                                    enum wifi67_fw_region region)
+{
+    switch (region) {
+    case WIFI67_FW_REGION_IRAM:
+        return emlfm->mem[radio_id].iram.flags;
+    case WIFI67_FW_REGION_DRAM:
+        return emlfm->mem[radio_id].dram.flags;
+    case WIFI67_FW_REGION_SRAM:
+        return emlfm->mem[radio_id].sram.flags;
+    default:
+        return 0;
+    }
+}
+
+/* Firmware writes its data and shared regions, so their contents are gone */
+static void wifi67_emlfm_dirty_regions(struct wifi67_emlfm *emlfm, u8 radio_id)
+{
+    struct wifi67_emlfm_image *img = &emlfm->image[radio_id];
+    int i;
+
+    mutex_lock(&emlfm->recovery_lock);
+    for (i = 0; i < WIFI67_FW_NUM_REGIONS; i++) {
+        if (wifi67_emlfm_region_flags(emlfm, radio_id, i) &
+            (WIFI67_FW_REGION_RW | WIFI67_FW_REGION_SHARED))
+            memset(img->written[i], 0, SHA256_DIGEST_SIZE);
+    }
+    mutex_unlock(&emlfm->recovery_lock);
+}
+
+static void wifi67_emlfm_drop_image(struct wifi67_emlfm_image *img)
+{
+    kvfree(img->data);
+    memset(img, 0, sizeof(*img));
+}
+
+/* Keep a verified copy of a freshly loaded image for fast recovery */
+static void wifi67_emlfm_retain_image(struct wifi67_emlfm *emlfm, u8 radio_id,
+                                     const struct firmware *fw)
+{
+    struct wifi67_emlfm_image *img = &emlfm->image[radio_id];
+    const struct wifi67_fw_header *hdr;
+    const u8 *ptr;
+    int i;
+
+    if (!emlfm->sha256)
+        return;
+
+    mutex_lock(&emlfm->recovery_lock);
+
+    wifi67_emlfm_drop_image(img);
+
+    img->data = kvmemdup(fw->data, fw->size, GFP_KERNEL);
+    if (!img->data)
+        goto out;
+    img->size = fw->size;
+
+    hdr = img->data;
+    ptr = img->data + sizeof(*hdr);
+    img->region[WIFI67_FW_REGION_IRAM] = ptr;
+    img->region_len[WIFI67_FW_REGION_IRAM] = hdr->iram_size;
+    ptr += hdr->iram_size;
+    img->region[WIFI67_FW_REGION_DRAM] = ptr;
+    img->region_len[WIFI67_FW_REGION_DRAM] = hdr->dram_size;
+    ptr += hdr->dram_size;
+    img->region[WIFI67_FW_REGION_SRAM] = ptr;
+    img->region_len[WIFI67_FW_REGION_SRAM] = hdr->sram_size;
+
+    /* The full image was just written, so every region holds it */
+    for (i = 0; i < WIFI67_FW_NUM_REGIONS; i++) {
+        if (crypto_shash_tfm_digest(emlfm->sha256, img->region[i],
+                                    img->region_len[i], img->digest[i])) {
+            wifi67_emlfm_drop_image(img);
+            break;
+        }
+        memcpy(img->written[i], img->digest[i], SHA256_DIGEST_SIZE);
+    }
+
+out:
+    mutex_unlock(&emlfm->recovery_lock);
+}
+
+/* Digest of what the device region actually holds now */
+static int wifi67_emlfm_digest_region(struct wifi67_emlfm *emlfm, u8 radio_id,
+                                     enum wifi67_fw_region region,
+                                     size_t len, u8 *digest)
+{
+    SHASH_DESC_ON_STACK(desc, emlfm->sha256);
+    size_t off, n;
+    int ret;
+
+    desc->tfm = emlfm->sha256;
+    ret = crypto_shash_init(desc);
+
+    for (off = 0; !ret && off < len; off += n) {
+        n = min_t(size_t, len - off, WIFI67_EMLFM_READBACK_CHUNK);
+        ret = wifi67_hw_fw_read_region(emlfm->priv, radio_id, region, off,
+                                       emlfm->readback_buf, n);
+        if (!ret)
+            ret = crypto_shash_update(desc, emlfm->readback_buf, n);
+        cond_resched();
+    }
+
+    if (!ret)
+        ret = crypto_shash_final(desc, digest);
+    shash_desc_zero(desc);
+    return ret;
+}
+
+/*
+ * Bring a radio in RESET state back up from its retained image: point it
+ * at its regions, rewrite every region the host knows to be stale or
+ * whose read-back digest no longer matches the image, start the firmware
+ * and replay driver state. Returns -ENOENT when no image is retained and
+ * a full load is required.
+ */
+static int wifi67_emlfm_fast_restart(struct wifi67_emlfm *emlfm, u8 radio_id)
+{
+    struct wifi67_priv *priv = emlfm->priv;
+    struct wifi67_emlfm_recovery_stats *rs = &emlfm->status[radio_id].recovery;
+    struct wifi67_emlfm_image *img = &emlfm->image[radio_id];
+    u8 digest[SHA256_DIGEST_SIZE];
+    u32 reloaded = 0, reused = 0, us;
+    ktime_t start = ktime_get();
+    int i, ret;
+
+    mutex_lock(&emlfm->recovery_lock);
+
+    if (!img->data) {
+        rs->full_reloads++;
+        mutex_unlock(&emlfm->recovery_lock);
+        return -ENOENT;
+    }
+
+    spin_lock_irq(&emlfm->lock);
+    if (emlfm->fw[radio_id].state != WIFI67_FW_STATE_RESET) {
+        spin_unlock_irq(&emlfm->lock);
+        mutex_unlock(&emlfm->recovery_lock);
+        return -EBUSY;
+    }
+
+    ret = wifi67_hw_fw_setup(priv, radio_id, img->data, img->size,
+                             emlfm->mem[radio_id].iram.paddr,
+                             emlfm->mem[radio_id].dram.paddr,
+                             emlfm->mem[radio_id].sram.paddr);
+    if (!ret)
+        emlfm->fw[radio_id].state = WIFI67_FW_STATE_LOADING;
+    spin_unlock_irq(&emlfm->lock);
+
+    for (i = 0; !ret && i < WIFI67_FW_NUM_REGIONS; i++) {
+        if (!img->region_len[i])
+            continue;
+
+        /* The host's record alone misses resets and power loss */
+        if (!memcmp(img->written[i], img->digest[i], SHA256_DIGEST_SIZE) &&
+            !wifi67_emlfm_digest_region(emlfm, radio_id, i,
+                                        img->region_len[i], digest) &&
+            !memcmp(digest, img->digest[i], SHA256_DIGEST_SIZE)) {
+            reused++;
+            continue;
+        }
+
+        ret = wifi67_hw_fw_write_region(priv, radio_id, i, img->region[i],
+                                        img->region_len[i]);
+        if (!ret)
+            memcpy(img->written[i], img->digest[i], SHA256_DIGEST_SIZE);
+        reloaded++;
+    }
+
+    spin_lock_irq(&emlfm->lock);
+    emlfm->fw[radio_id].state = ret ? WIFI67_FW_STATE_RESET :
+                                      WIFI67_FW_STATE_LOADED;
+    spin_unlock_irq(&emlfm->lock);
+
+    mutex_unlock(&emlfm->recovery_lock);
+
+    if (!ret)
+        ret = wifi67_emlfm_start_fw(priv, radio_id);
+
+    /* Keys, stations and BA sessions are owned by the upper layers */
+    if (!ret && emlfm->recovery_ops && emlfm->recovery_ops->replay)
+        ret = emlfm->recovery_ops->replay(priv, radio_id);
+
+    us = ktime_us_delta(ktime_get(), start);
+
+    mutex_lock(&emlfm->recovery_lock);
+    rs->last_recovery_us = us;
+    rs->max_recovery_us = max(rs->max_recovery_us, us);
+    rs->regions_reloaded += reloaded;
+    rs->regions_reused += reused;
+    if (!ret)
+        rs->fast_recoveries++;
+    mutex_unlock(&emlfm->recovery_lock);
+
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_RECOVER, radio_id,
+                          ret, us);
+
+    dev_info(priv->dev, "radio %u restarted in %u us (%u regions reloaded, %u reused): %d\n",
+             radio_id, us, reloaded, reused, ret);
+
+    return ret;
+}
+
 static void wifi67_emlfm_handle_crash(struct work_struct *work)
 {
     struct wifi67_emlfm *emlfm = container_of(work, struct wifi67_emlfm,
-                                            status[0].crash_work);
+                                            recovery_work);
+    struct wifi67_priv *priv = emlfm->priv;
     unsigned long flags;
+    u32 crashed = 0;
     int i;
 
+    spin_lock_irqsave(&emlfm->lock, flags);
+    for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
+        if ((emlfm->fw[i].radio_mask & BIT(i)) &&
+            emlfm->fw[i].state == WIFI67_FW_STATE_CRASHED)
+            crashed |= BIT(i);
+    }
+    spin_unlock_irqrestore(&emlfm->lock, flags);
+
+    /* Capture while device memory still holds the crashed state */
+    for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
+        if (crashed & BIT(i))
+            wifi67_emlfm_coredump(emlfm, i);
+    }
+
     spin_lock_irqsave(&emlfm->lock, flags);
     
     for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
-        if (!(emlfm->fw[i].radio_mask & BIT(i)))
+        if (!(crashed & BIT(i)))
             continue;
 
         if (emlfm->fw[i].state == WIFI67_FW_STATE_CRASHED) {
             wifi67_hw_reset_radio(priv, i);
             emlfm->status[i].crash_count++;
+            emlfm->status[i].recovery.crash_count++;
             emlfm->fw[i].state = WIFI67_FW_STATE_RESET;
+        } else {
+            crashed &= ~BIT(i);
         }
     }
     
     spin_unlock_irqrestore(&emlfm->lock, flags);
+
+    /* Radios without a retained image stay in RESET for a full reload */
+    for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
+        if (crashed & BIT(i))
+            wifi67_emlfm_fast_restart(emlfm, i);
+    }
+}
+
+static void wifi67_emlfm_ipc_doorbell(void *data)
+{
+    struct wifi67_emlfm_ipc *ipc = data;
+
+    wifi67_hw_write32(ipc->emlfm->priv, WIFI67_REG_IPC_DOORBELL,
+                      BIT(ipc->radio_id));
+}
+
+static void wifi67_emlfm_ipc_event(void *data, const struct wifi67_ipc_msg *msg)
+{
+    struct wifi67_emlfm_ipc *ipc = data;
+    wifi67_emlfm_event_fn handler = READ_ONCE(ipc->emlfm->event_handler);
+
+    if (handler)
+        handler(ipc->emlfm->priv, ipc->radio_id, msg);
+}
+
+static const struct wifi67_ipc_ops wifi67_emlfm_ipc_ops = {
+    .doorbell = wifi67_emlfm_ipc_doorbell,
+    .event = wifi67_emlfm_ipc_event,
+};
+
+static void wifi67_emlfm_ipc_irq_mask(struct wifi67_emlfm *emlfm, u8 radio_id,
+                                      bool mask)
+{
+    struct wifi67_priv *priv = emlfm->priv;
+    unsigned long flags;
+    u32 val;
+
+    spin_lock_irqsave(&emlfm->lock, flags);
+    val = wifi67_hw_read32(priv, WIFI67_REG_IPC_EVT_MASK);
+    if (mask)
+        val |= BIT(radio_id);
+    else
+        val &= ~BIT(radio_id);
+    wifi67_hw_write32(priv, WIFI67_REG_IPC_EVT_MASK, val);
+    spin_unlock_irqrestore(&emlfm->lock, flags);
+}
+
+/*
+ * NAPI-style event drain: the event interrupt stays masked while events
+ * keep arriving, each pass consumes up to a budget and requeues itself,
+ * and the interrupt is only re-enabled once the ring is found empty.
+ */
+static void wifi67_emlfm_ipc_poll(struct work_struct *work)
+{
+    struct wifi67_emlfm_ipc *ipc = container_of(work, struct wifi67_emlfm_ipc,
+                                                poll_work);
+    struct wifi67_emlfm *emlfm = ipc->emlfm;
+
+    if (wifi67_ipc_poll(&ipc->ring, WIFI67_IPC_POLL_BUDGET) ==
+        WIFI67_IPC_POLL_BUDGET) {
+        queue_work(system_highpri_wq, &ipc->poll_work);
+        return;
+    }
+
+    wifi67_emlfm_ipc_irq_mask(emlfm, ipc->radio_id, false);
+
+    /* Catch events posted between the last poll and the unmask */
+    if (wifi67_ipc_evt_pending(&ipc->ring)) {
+        wifi67_emlfm_ipc_irq_mask(emlfm, ipc->radio_id, true);
+        queue_work(system_highpri_wq, &ipc->poll_work);
+    }
 }
 
 static irqreturn_t wifi67_emlfm_irq_handler(int irq, void *data)
 {
     struct wifi67_emlfm *emlfm = data;
+    struct wifi67_priv *priv = emlfm->priv;
     u32 status, radio_id;
     
     status = wifi67_hw_read32(priv, WIFI67_REG_FW_STATUS);
@@ -80,13 +577,22 @@ static irqreturn_t wifi67_emlfm_irq_handler(int irq, void *data)
         emlfm->fw[radio_id].state = WIFI67_FW_STATE_CRASHED;
         emlfm->status[radio_id].error_code = 
             wifi67_hw_read32(priv, WIFI67_REG_FW_ERROR);
-        schedule_work(&emlfm->status[radio_id].crash_work);
+        wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_CRASH, radio_id,
+                              emlfm->status[radio_id].error_code, 0);
+        schedule_work(&emlfm->recovery_work);
     }
     
     if (status & WIFI67_FW_IRQ_READY) {
         emlfm->fw[radio_id].state = WIFI67_FW_STATE_READY;
+        wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_READY, radio_id,
+                              0, 0);
         complete(&emlfm->status[radio_id].ready);
     }
+
+    if (status & WIFI67_FW_IRQ_EVENT) {
+        wifi67_emlfm_ipc_irq_mask(emlfm, radio_id, true);
+        queue_work(system_highpri_wq, &emlfm->ipc[radio_id].poll_work);
+    }
     
     return IRQ_HANDLED;
 }
@@ -124,12 +630,26 @@ int wifi67_emlfm_init(struct wifi67_priv *priv)
     if (!emlfm)
         return -ENOMEM;
 
+    emlfm->priv = priv;
     spin_lock_init(&emlfm->lock);
+    mutex_init(&emlfm->recovery_lock);
+    INIT_WORK(&emlfm->recovery_work, wifi67_emlfm_handle_crash);
+    wifi67_fw_hist_init(&emlfm->hist);
+
+    /* Fast recovery is optional; without it crashes need a full reload */
+    emlfm->sha256 = crypto_alloc_shash("sha256", 0, 0);
+    emlfm->readback_buf = kmalloc(WIFI67_EMLFM_READBACK_CHUNK, GFP_KERNEL);
+    if (IS_ERR(emlfm->sha256) || !emlfm->readback_buf) {
+        if (!IS_ERR(emlfm->sha256))
+            crypto_free_shash(emlfm->sha256);
+        emlfm->sha256 = NULL;
+    }
 
     for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
         init_completion(&emlfm->status[i].ready);
-        INIT_WORK(&emlfm->status[i].crash_work, wifi67_emlfm_handle_crash);
-        spin_lock_init(&emlfm->ipc[i].lock);
+        emlfm->ipc[i].emlfm = emlfm;
+        emlfm->ipc[i].radio_id = i;
+        INIT_WORK(&emlfm->ipc[i].poll_work, wifi67_emlfm_ipc_poll);
         
         ret = wifi67_emlfm_alloc_region(emlfm, &emlfm->mem[i].iram,
                                       WIFI67_FW_IRAM_SIZE,
@@ -159,6 +679,12 @@ int wifi67_emlfm_init(struct wifi67_priv *priv)
         }
         
         emlfm->ipc[i].ringbuf_size = WIFI67_IPC_RING_SIZE;
+
+        ret = wifi67_ipc_init(&emlfm->ipc[i].ring, emlfm->ipc[i].ringbuf,
+                              emlfm->ipc[i].ringbuf_size,
+                              &wifi67_emlfm_ipc_ops, &emlfm->ipc[i]);
+        if (ret)
+            goto err_free;
     }
 
     ret = request_irq(priv->pdev->irq, wifi67_emlfm_irq_handler,
@@ -167,6 +693,12 @@ int wifi67_emlfm_init(struct wifi67_priv *priv)
         goto err_free;
 
     priv->emlfm = emlfm;
+
+    /* echo <radio> > fw_crash triggers a synthetic crash */
+    if (priv->debugfs.dir)
+        emlfm->crash_dentry = debugfs_create_file("fw_crash", 0200,
+                                                  priv->debugfs.dir, emlfm,
+                                                  &wifi67_emlfm_crash_fops);
     return 0;
 
 err_free:
@@ -179,6 +711,9 @@ err_free:
                             emlfm->ipc[i].ringbuf,
                             emlfm->ipc[i].ringbuf_paddr);
     }
+    if (emlfm->sha256)
+        crypto_free_shash(emlfm->sha256);
+    kfree(emlfm->readback_buf);
     kfree(emlfm);
     return ret;
 }
@@ -191,10 +726,15 @@ void wifi67_emlfm_deinit(struct wifi67_priv *priv)
     if (!emlfm)
         return;
 
+    debugfs_remove(emlfm->crash_dentry);
     free_irq(priv->pdev->irq, emlfm);
+    cancel_work_sync(&emlfm->recovery_work);
 
     for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
-        cancel_work_sync(&emlfm->status[i].crash_work);
+        cancel_work_sync(&emlfm->ipc[i].poll_work);
+        wifi67_emlfm_drop_image(&emlfm->image[i]);
+        if (emlfm->loader[i].emlfm)
+            cancel_work_sync(&emlfm->loader[i].work);
         wifi67_emlfm_free_region(emlfm, &emlfm->mem[i].iram);
         wifi67_emlfm_free_region(emlfm, &emlfm->mem[i].dram);
         wifi67_emlfm_free_region(emlfm, &emlfm->mem[i].sram);
@@ -204,10 +744,75 @@ void wifi67_emlfm_deinit(struct wifi67_priv *priv)
                             emlfm->ipc[i].ringbuf_paddr);
     }
 
+    if (emlfm->sha256)
+        crypto_free_shash(emlfm->sha256);
+    kfree(emlfm->readback_buf);
     kfree(emlfm);
     priv->emlfm = NULL;
 }
 
+/*
+ * Load one radio's image. Only the state check and the register handshake
+ * run under the lock; the radio is marked LOADING so concurrent loads and
+ * starts back off, and the image body is copied with interrupts enabled
+ * and preemption points between chunks.
+ */
+static int wifi67_emlfm_load_image(struct wifi67_emlfm *emlfm, u8 radio_id,
+                                  const struct firmware *fw)
+{
+    struct wifi67_priv *priv = emlfm->priv;
+    int ret;
+
+    spin_lock_irq(&emlfm->lock);
+
+    if (emlfm->fw[radio_id].state != WIFI67_FW_STATE_RESET) {
+        spin_unlock_irq(&emlfm->lock);
+        return -EBUSY;
+    }
+
+    ret = wifi67_hw_fw_setup(priv, radio_id, fw->data, fw->size,
+                             emlfm->mem[radio_id].iram.paddr,
+                             emlfm->mem[radio_id].dram.paddr,
+                             emlfm->mem[radio_id].sram.paddr);
+    if (!ret)
+        emlfm->fw[radio_id].state = WIFI67_FW_STATE_LOADING;
+
+    spin_unlock_irq(&emlfm->lock);
+
+    if (ret)
+        return ret;
+
+    ret = wifi67_hw_fw_copy(priv, radio_id, fw->data, fw->size);
+
+    spin_lock_irq(&emlfm->lock);
+
+    if (ret) {
+        emlfm->fw[radio_id].state = WIFI67_FW_STATE_RESET;
+    } else {
+        emlfm->fw[radio_id].state = WIFI67_FW_STATE_LOADED;
+        emlfm->fw[radio_id].radio_mask |= BIT(radio_id);
+    }
+
+    spin_unlock_irq(&emlfm->lock);
+
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_LOAD, radio_id,
+                          fw->size, ret);
+
+    if (!ret)
+        wifi67_emlfm_retain_image(emlfm, radio_id, fw);
+
+    return ret;
+}
+
+static void wifi67_emlfm_load_work(struct work_struct *work)
+{
+    struct wifi67_emlfm_loader *loader =
+        container_of(work, struct wifi67_emlfm_loader, work);
+
+    loader->ret = wifi67_emlfm_load_image(loader->emlfm, loader->radio_id,
+                                          loader->fw);
+}
+
 int wifi67_emlfm_load_fw(struct wifi67_priv *priv, u8 radio_id,
                         const char *name)
 {
@@ -222,25 +827,56 @@ int wifi67_emlfm_load_fw(struct wifi67_priv *priv, u8 radio_id,
     if (ret)
         return ret;
 
-    spin_lock_irq(&emlfm->lock);
-    
-    if (emlfm->fw[radio_id].state != WIFI67_FW_STATE_RESET) {
-        ret = -EBUSY;
-        goto out;
-    }
+    ret = wifi67_emlfm_load_image(emlfm, radio_id, fw);
+
+    release_firmware(fw);
+    return ret;
+}
 
-    ret = wifi67_hw_load_fw(priv, radio_id, fw->data, fw->size,
-                           emlfm->mem[radio_id].iram.paddr,
-                           emlfm->mem[radio_id].dram.paddr,
-                           emlfm->mem[radio_id].sram.paddr);
+/*
+ * Load the same image into every radio in @radio_mask concurrently, one
+ * unbound worker per radio. Returns the first error seen; radios that
+ * loaded successfully stay in LOADED state. Meant for the bus driver's
+ * multi-radio bring-up; nothing in this tree calls it yet, as no probe
+ * path sets up emlfm.
+ */
+int wifi67_emlfm_load_fw_all(struct wifi67_priv *priv, u32 radio_mask,
+                            const char *name)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+    const struct firmware *fw;
+    int i, ret;
+
+    if (!emlfm || !radio_mask || radio_mask >= BIT(WIFI67_MAX_RADIOS))
+        return -EINVAL;
+
+    ret = request_firmware(&fw, name, priv->dev);
     if (ret)
-        goto out;
+        return ret;
 
-    emlfm->fw[radio_id].state = WIFI67_FW_STATE_LOADED;
-    emlfm->fw[radio_id].radio_mask |= BIT(radio_id);
+    for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
+        struct wifi67_emlfm_loader *loader = &emlfm->loader[i];
+
+        if (!(radio_mask & BIT(i)))
+            continue;
+
+        INIT_WORK(&loader->work, wifi67_emlfm_load_work);
+        loader->emlfm = emlfm;
+        loader->fw = fw;
+        loader->radio_id = i;
+        loader->ret = 0;
+        queue_work(system_unbound_wq, &loader->work);
+    }
+
+    for (i = 0; i < WIFI67_MAX_RADIOS; i++) {
+        if (!(radio_mask & BIT(i)))
+            continue;
+
+        flush_work(&emlfm->loader[i].work);
+        if (emlfm->loader[i].ret && !ret)
+            ret = emlfm->loader[i].ret;
+    }
 
-out:
-    spin_unlock_irq(&emlfm->lock);
     release_firmware(fw);
     return ret;
 }
@@ -254,6 +890,8 @@ int wifi67_emlfm_start_fw(struct wifi67_priv *priv, u8 radio_id)
     if (!emlfm || radio_id >= WIFI67_MAX_RADIOS)
         return -EINVAL;
 
+    wifi67_emlfm_dirty_regions(emlfm, radio_id);
+
     spin_lock_irqsave(&emlfm->lock, flags);
     
     if (emlfm->fw[radio_id].state != WIFI67_FW_STATE_LOADED) {
@@ -262,6 +900,7 @@ int wifi67_emlfm_start_fw(struct wifi67_priv *priv, u8 radio_id)
     }
 
     reinit_completion(&emlfm->status[radio_id].ready);
+    wifi67_ipc_reset(&emlfm->ipc[radio_id].ring);
     
     ret = wifi67_hw_start_fw(priv, radio_id,
                             emlfm->ipc[radio_id].ringbuf_paddr,
@@ -270,6 +909,7 @@ int wifi67_emlfm_start_fw(struct wifi67_priv *priv, u8 radio_id)
         goto out;
 
     emlfm->fw[radio_id].state = WIFI67_FW_STATE_STARTING;
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_START, radio_id, 0, 0);
 
 out:
     spin_unlock_irqrestore(&emlfm->lock, flags);
@@ -298,13 +938,163 @@ void wifi67_emlfm_stop_fw(struct wifi67_priv *priv, u8 radio_id)
         emlfm->fw[radio_id].state == WIFI67_FW_STATE_CRASHED) {
         wifi67_hw_stop_fw(priv, radio_id);
         emlfm->fw[radio_id].state = WIFI67_FW_STATE_RESET;
+        wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_STOP, radio_id,
+                              0, 0);
     }
     
     spin_unlock_irqrestore(&emlfm->lock, flags);
 }
 
+/*
+ * Restart a stopped radio after system resume. Uses the retained image and
+ * only rewrites regions that lost their contents; returns -ENOENT if the
+ * caller must fall back to a full wifi67_emlfm_load_fw().
+ */
+int wifi67_emlfm_resume(struct wifi67_priv *priv, u8 radio_id)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+
+    if (!emlfm || radio_id >= WIFI67_MAX_RADIOS)
+        return -EINVAL;
+
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_RESUME, radio_id, 0, 0);
+    return wifi67_emlfm_fast_restart(emlfm, radio_id);
+}
+
+/*
+ * Fake a firmware assert on a running radio. Goes through the same
+ * capture, reset and recovery path as a real crash interrupt.
+ */
+int wifi67_emlfm_inject_crash(struct wifi67_priv *priv, u8 radio_id)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+    unsigned long flags;
+    int ret = 0;
+
+    if (!emlfm || radio_id >= WIFI67_MAX_RADIOS)
+        return -EINVAL;
+
+    spin_lock_irqsave(&emlfm->lock, flags);
+    if (emlfm->fw[radio_id].state != WIFI67_FW_STATE_READY) {
+        ret = -EINVAL;
+    } else {
+        emlfm->fw[radio_id].state = WIFI67_FW_STATE_CRASHED;
+        emlfm->status[radio_id].error_code = WIFI67_FW_ERR_INJECTED;
+    }
+    spin_unlock_irqrestore(&emlfm->lock, flags);
+
+    if (ret)
+        return ret;
+
+    wifi67_fw_hist_record(&emlfm->hist, WIFI67_FW_HIST_CRASH, radio_id,
+                          WIFI67_FW_ERR_INJECTED, 0);
+    schedule_work(&emlfm->recovery_work);
+    return 0;
+}
+
+static ssize_t wifi67_emlfm_crash_write(struct file *file,
+                                        const char __user *buf,
+                                        size_t count, loff_t *ppos)
+{
+    struct wifi67_emlfm *emlfm = file->private_data;
+    u8 radio_id;
+    int ret;
+
+    ret = kstrtou8_from_user(buf, count, 0, &radio_id);
+    if (ret)
+        return ret;
+
+    ret = wifi67_emlfm_inject_crash(emlfm->priv, radio_id);
+    return ret ? ret : count;
+}
+
+static const struct file_operations wifi67_emlfm_crash_fops = {
+    .open = simple_open,
+    .write = wifi67_emlfm_crash_write,
+    .llseek = noop_llseek,
+};
+
+void wifi67_emlfm_set_recovery_ops(struct wifi67_priv *priv,
+                                  const struct wifi67_emlfm_recovery_ops *ops)
+{
+    if (priv->emlfm)
+        priv->emlfm->recovery_ops = ops;
+}
+
+int wifi67_emlfm_get_recovery_stats(struct wifi67_priv *priv, u8 radio_id,
+                                   struct wifi67_emlfm_recovery_stats *stats)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+
+    if (!emlfm || radio_id >= WIFI67_MAX_RADIOS || !stats)
+        return -EINVAL;
+
+    mutex_lock(&emlfm->recovery_lock);
+    *stats = emlfm->status[radio_id].recovery;
+    mutex_unlock(&emlfm->recovery_lock);
+
+    return 0;
+}
+
+/*
+ * Commands queued with wifi67_emlfm_ipc_queue() are not visible to the
+ * firmware until wifi67_emlfm_ipc_flush(), so a burst (e.g. a mass
+ * station association) costs one index update and at most one doorbell.
+ */
+int wifi67_emlfm_ipc_queue(struct wifi67_priv *priv, u8 radio_id, u16 id,
+                          const void *payload, u16 len)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+
+    if (!emlfm || radio_id >= WIFI67_MAX_RADIOS)
+        return -EINVAL;
+
+    return wifi67_ipc_queue(&emlfm->ipc[radio_id].ring, id, payload, len);
+}
+
+void wifi67_emlfm_ipc_flush(struct wifi67_priv *priv, u8 radio_id)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+
+    if (!emlfm || radio_id >= WIFI67_MAX_RADIOS)
+        return;
+
+    wifi67_ipc_flush(&emlfm->ipc[radio_id].ring);
+}
+
+int wifi67_emlfm_ipc_send(struct wifi67_priv *priv, u8 radio_id,
+                         const struct wifi67_ipc_msg *msgs, int count)
+{
+    struct wifi67_emlfm *emlfm = priv->emlfm;
+
+    if (!emlfm || radio_id >= WIFI67_MAX_RADIOS || count <= 0)
+        return -EINVAL;
+
+    return wifi67_ipc_send(&emlfm->ipc[radio_id].ring, msgs, count);
+}
+
+void wifi67_emlfm_set_event_handler(struct wifi67_priv *priv,
+                                   wifi67_emlfm_event_fn handler)
+{
+    if (priv->emlfm)
+        WRITE_ONCE(priv->emlfm->event_handler, handler);
+}
+
 EXPORT_SYMBOL(wifi67_emlfm_init);
 EXPORT_SYMBOL(wifi67_emlfm_deinit);
 EXPORT_SYMBOL(wifi67_emlfm_load_fw);
+EXPORT_SYMBOL(wifi67_emlfm_load_fw_all);
 EXPORT_SYMBOL(wifi67_emlfm_start_fw);
-EXPORT_SYMBOL(wifi67_emlfm_stop_fw); 
\ No newline at end of file
+EXPORT_SYMBOL(wifi67_emlfm_stop_fw);
+EXPORT_SYMBOL(wifi67_emlfm_resume);
+EXPORT_SYMBOL(wifi67_emlfm_set_recovery_ops);
+EXPORT_SYMBOL(wifi67_emlfm_get_recovery_stats);
+EXPORT_SYMBOL(wifi67_emlfm_ipc_queue);
+EXPORT_SYMBOL(wifi67_emlfm_ipc_flush);
+EXPORT_SYMBOL(wifi67_emlfm_ipc_send);
+EXPORT_SYMBOL(wifi67_emlfm_set_event_handler);
+EXPORT_SYMBOL(wifi67_emlfm_inject_crash); 
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/emlfm_kunit.c"
+#endif
@@ -33,7 +33,7 @@ int wifi67_fw_load(struct wifi67_priv *priv)
 
     ret = request_firmware(&fw->fw, WIFI67_FW_NAME, &priv->pdev->dev);
     if (ret) {
-        wifi67_err(priv, "Failed to load firmware: %d\n", ret);
+        wifi67_err(priv, WIFI67_LOG_FW, "Failed to load firmware: %d\n", ret);
         return ret;
     }
 
@@ -41,7 +41,7 @@ int wifi67_fw_load(struct wifi67_priv *priv)
     fw->fw_mem = dma_alloc_coherent(&priv->pdev->dev, fw->fw_dma_size,
                                    &fw->fw_dma_addr, GFP_KERNEL);
     if (!fw->fw_mem) {
-        wifi67_err(priv, "Failed to allocate DMA memory for firmware\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Failed to allocate DMA memory for firmware\n");
         release_firmware(fw->fw);
         return -ENOMEM;
     }
@@ -50,7 +50,7 @@ int wifi67_fw_load(struct wifi67_priv *priv)
 
     header = (struct wifi67_fw_header *)fw->fw_mem;
     if (header->magic != WIFI67_FW_MAGIC) {
-        wifi67_err(priv, "Invalid firmware magic: 0x%08x\n", header->magic);
+        wifi67_err(priv, WIFI67_LOG_FW, "Invalid firmware magic: 0x%08x\n", header->magic);
         ret = -EINVAL;
         goto err_free;
     }
@@ -59,7 +59,7 @@ int wifi67_fw_load(struct wifi67_priv *priv)
     fw->api_version = header->api_version;
     fw->loaded = true;
 
-    wifi67_info(priv, "Firmware loaded: v%u.%u (API v%u)\n",
+    wifi67_info(priv, WIFI67_LOG_FW, "Firmware loaded: v%u.%u (API v%u)\n",
                 fw->version >> 16, fw->version & 0xFFFF,
                 fw->api_version);
 
@@ -109,14 +109,14 @@ int wifi67_fw_verify(struct wifi67_priv *priv)
 
     if (header->api_version < WIFI67_FW_API_VER_MIN ||
         header->api_version > WIFI67_FW_API_VER_MAX) {
-        wifi67_err(priv, "Unsupported firmware API version: %u\n",
+        wifi67_err(priv, WIFI67_LOG_FW, "Unsupported firmware API version: %u\n",
                   header->api_version);
         return -EINVAL;
     }
 
     checksum = crc32(0, data, header->data_size);
     if (checksum != header->checksum) {
-        wifi67_err(priv, "Firmware checksum mismatch\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Firmware checksum mismatch\n");
         return -EINVAL;
     }
 
@@ -148,7 +148,7 @@ int wifi67_fw_start(struct wifi67_priv *priv)
     ret = wifi67_wait_bit(priv->mmio + WIFI67_FW_REG_STATUS,
                          WIFI67_FW_STATUS_READY, 1000);
     if (ret) {
-        wifi67_err(priv, "Firmware failed to start\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Firmware failed to start\n");
         return ret;
     }
 
@@ -186,14 +186,14 @@ int wifi67_fw_update(struct wifi67_priv *priv, const struct firmware *new_fw)
     /* Verify firmware header and checksum */
     ret = wifi67_fw_verify_header(new_fw);
     if (ret) {
-        wifi67_err(priv, "Invalid firmware header\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Invalid firmware header\n");
         return ret;
     }
     
     /* Create backup of current firmware */
     ret = wifi67_fw_backup(priv);
     if (ret) {
-        wifi67_err(priv, "Failed to backup firmware\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Failed to backup firmware\n");
         return ret;
     }
     
@@ -203,7 +203,7 @@ int wifi67_fw_update(struct wifi67_priv *priv, const struct firmware *new_fw)
     /* Program new firmware */
     ret = wifi67_fw_program(priv, new_fw);
     if (ret) {
-        wifi67_err(priv, "Failed to program firmware\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Failed to program firmware\n");
         wifi67_fw_restore(priv);
         return ret;
     }
@@ -215,12 +215,12 @@ int wifi67_fw_update(struct wifi67_priv *priv, const struct firmware *new_fw)
     /* Restart firmware */
     ret = wifi67_fw_start(priv);
     if (ret) {
-        wifi67_err(priv, "Failed to start new firmware\n");
+        wifi67_err(priv, WIFI67_LOG_FW, "Failed to start new firmware\n");
         wifi67_fw_restore(priv);
         return ret;
     }
     
-    wifi67_info(priv, "Firmware updated successfully to v%u.%u\n",
+    wifi67_info(priv, WIFI67_LOG_FW, "Firmware updated successfully to v%u.%u\n",
                 fw->version >> 16, fw->version & 0xFFFF);
     
     return 0;
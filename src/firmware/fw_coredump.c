@@ -0,0 +1,209 @@
+#include <linux/kernel.h>
+#include <linux/vmalloc.h>
+#include <linux/sched.h>
+#include <linux/string.h>
+#include <linux/errno.h>
+#include "../../include/firmware/fw_coredump.h"
+
+void wifi67_fw_hist_init(struct wifi67_fw_hist *hist)
+{
+    spin_lock_init(&hist->lock);
+    hist->next = 0;
+    memset(hist->entries, 0, sizeof(hist->entries));
+}
+
+/* Safe from any context, including hard IRQ */
+void wifi67_fw_hist_record(struct wifi67_fw_hist *hist, u32 type,
+                           u32 radio_id, u32 arg0, u32 arg1)
+{
+    struct wifi67_fw_hist_entry *e;
+    unsigned long flags;
+
+    spin_lock_irqsave(&hist->lock, flags);
+    e = &hist->entries[hist->next++ & (WIFI67_FW_HIST_ENTRIES - 1)];
+    e->timestamp_ns = cpu_to_le64(ktime_get_ns());
+    e->type = cpu_to_le32(type);
+    e->radio_id = cpu_to_le32(radio_id);
+    e->arg0 = cpu_to_le32(arg0);
+    e->arg1 = cpu_to_le32(arg1);
+    spin_unlock_irqrestore(&hist->lock, flags);
+}
+
+int wifi67_fw_dump_begin(struct wifi67_fw_dump *dump, size_t max_size,
+                         unsigned int budget_ms, u32 radio_id,
+                         u32 error_code, u32 fw_version)
+{
+    struct wifi67_fw_dump_hdr *hdr;
+
+    if (max_size < sizeof(*hdr))
+        return -EINVAL;
+
+    dump->buf = vzalloc(max_size);
+    if (!dump->buf)
+        return -ENOMEM;
+
+    dump->size = max_size;
+    dump->len = sizeof(*hdr);
+    dump->num_sections = 0;
+    dump->start = ktime_get();
+    dump->deadline = ktime_add_ms(dump->start, budget_ms);
+
+    hdr = (struct wifi67_fw_dump_hdr *)dump->buf;
+    hdr->magic = cpu_to_le32(WIFI67_FW_DUMP_MAGIC);
+    hdr->version = cpu_to_le32(WIFI67_FW_DUMP_VERSION);
+    hdr->radio_id = cpu_to_le32(radio_id);
+    hdr->error_code = cpu_to_le32(error_code);
+    hdr->fw_version = cpu_to_le32(fw_version);
+    hdr->timestamp_ns = cpu_to_le64(ktime_get_real_ns());
+
+    return 0;
+}
+
+/* Reserve a section header; returns NULL once the dump is full */
+static struct wifi67_fw_dump_section *
+wifi67_fw_dump_section(struct wifi67_fw_dump *dump, u32 type, size_t len)
+{
+    struct wifi67_fw_dump_section *sec;
+
+    if (dump->size - dump->len < sizeof(*sec))
+        return NULL;
+
+    sec = (struct wifi67_fw_dump_section *)(dump->buf + dump->len);
+    sec->type = cpu_to_le32(type);
+    sec->flags = 0;
+    sec->len = 0;
+    sec->orig_len = cpu_to_le32(len);
+
+    dump->len += sizeof(*sec);
+    dump->num_sections++;
+    return sec;
+}
+
+static void wifi67_fw_dump_close(struct wifi67_fw_dump_section *sec,
+                                 size_t len, u32 flags)
+{
+    sec->len = cpu_to_le32(len);
+    sec->flags = cpu_to_le32(flags);
+}
+
+int wifi67_fw_dump_add(struct wifi67_fw_dump *dump, u32 type,
+                       const void *data, size_t len)
+{
+    struct wifi67_fw_dump_section *sec;
+    size_t n;
+
+    sec = wifi67_fw_dump_section(dump, type, len);
+    if (!sec)
+        return -ENOSPC;
+
+    n = min(len, dump->size - dump->len);
+    memcpy(dump->buf + dump->len, data, n);
+    dump->len += n;
+
+    wifi67_fw_dump_close(sec, n, n < len ? WIFI67_FW_DUMP_F_TRUNC_SIZE : 0);
+    return 0;
+}
+
+/* Copy the event history oldest first */
+int wifi67_fw_dump_add_hist(struct wifi67_fw_dump *dump,
+                            struct wifi67_fw_hist *hist)
+{
+    struct wifi67_fw_dump_section *sec;
+    struct wifi67_fw_hist_entry *out;
+    unsigned long flags;
+    u32 i, count, first, fit;
+
+    spin_lock_irqsave(&hist->lock, flags);
+
+    count = min_t(u32, hist->next, WIFI67_FW_HIST_ENTRIES);
+    first = hist->next - count;
+
+    sec = wifi67_fw_dump_section(dump, WIFI67_FW_DUMP_EVENTS,
+                                 count * sizeof(*out));
+    if (!sec) {
+        spin_unlock_irqrestore(&hist->lock, flags);
+        return -ENOSPC;
+    }
+
+    /* Keep the newest entries if the dump cannot hold them all */
+    fit = min_t(u32, count, (dump->size - dump->len) / sizeof(*out));
+    first += count - fit;
+
+    out = (struct wifi67_fw_hist_entry *)(dump->buf + dump->len);
+    for (i = 0; i < fit; i++)
+        out[i] = hist->entries[(first + i) & (WIFI67_FW_HIST_ENTRIES - 1)];
+
+    spin_unlock_irqrestore(&hist->lock, flags);
+
+    dump->len += fit * sizeof(*out);
+    wifi67_fw_dump_close(sec, fit * sizeof(*out),
+                         fit < count ? WIFI67_FW_DUMP_F_TRUNC_SIZE : 0);
+    return 0;
+}
+
+/*
+ * Copy a device memory region in chunks, stopping early when the dump is
+ * full or the capture deadline passes so a wedged bus cannot stall reset.
+ */
+int wifi67_fw_dump_add_region(struct wifi67_fw_dump *dump, u32 type,
+                              wifi67_fw_dump_read_t read, void *ctx,
+                              size_t len)
+{
+    struct wifi67_fw_dump_section *sec;
+    size_t off = 0, n;
+    u32 flags = 0;
+
+    sec = wifi67_fw_dump_section(dump, type, len);
+    if (!sec)
+        return -ENOSPC;
+
+    while (off < len) {
+        if (ktime_after(ktime_get(), dump->deadline)) {
+            flags |= WIFI67_FW_DUMP_F_TRUNC_TIME;
+            break;
+        }
+
+        n = min3(len - off, dump->size - dump->len,
+                 (size_t)WIFI67_FW_DUMP_CHUNK);
+        if (!n) {
+            flags |= WIFI67_FW_DUMP_F_TRUNC_SIZE;
+            break;
+        }
+
+        if (read(ctx, off, dump->buf + dump->len, n)) {
+            flags |= WIFI67_FW_DUMP_F_READ_ERR;
+            break;
+        }
+
+        dump->len += n;
+        off += n;
+        cond_resched();
+    }
+
+    wifi67_fw_dump_close(sec, off, flags);
+    return 0;
+}
+
+/* Finalise the header and hand the buffer (vmalloc'd) to the caller */
+void *wifi67_fw_dump_finish(struct wifi67_fw_dump *dump, size_t *len)
+{
+    struct wifi67_fw_dump_hdr *hdr = (struct wifi67_fw_dump_hdr *)dump->buf;
+    void *buf = dump->buf;
+
+    if (!buf)
+        return NULL;
+
+    hdr->num_sections = cpu_to_le32(dump->num_sections);
+    hdr->total_len = cpu_to_le32(dump->len);
+    hdr->capture_us = cpu_to_le32(ktime_us_delta(ktime_get(), dump->start));
+
+    *len = dump->len;
+    dump->buf = NULL;
+    return buf;
+}
+
+void wifi67_fw_dump_abort(struct wifi67_fw_dump *dump)
+{
+    vfree(dump->buf);
+    dump->buf = NULL;
+}
@@ -0,0 +1,206 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/errno.h>
+#include <linux/compiler.h>
+#include <asm/barrier.h>
+#include "../../include/firmware/fw_ipc.h"
+#include "../../include/debug/wifi67_trace.h"
+
+#define WIFI67_IPC_CMD_MASK     (WIFI67_IPC_CMD_ENTRIES - 1)
+#define WIFI67_IPC_EVT_MASK     (WIFI67_IPC_EVT_ENTRIES - 1)
+
+static_assert(sizeof(struct wifi67_ipc_msg) == WIFI67_IPC_MSG_SIZE);
+static_assert(sizeof(struct wifi67_ipc_ctrl) <= WIFI67_IPC_CMD_OFFSET);
+static_assert(!(WIFI67_IPC_CMD_ENTRIES & WIFI67_IPC_CMD_MASK));
+static_assert(!(WIFI67_IPC_EVT_ENTRIES & WIFI67_IPC_EVT_MASK));
+
+int wifi67_ipc_init(struct wifi67_ipc *ipc, void *ringbuf, size_t size,
+                    const struct wifi67_ipc_ops *ops, void *priv)
+{
+    if (!ringbuf || size < WIFI67_IPC_SHARED_SIZE || !ops || !ops->doorbell)
+        return -EINVAL;
+
+    memset(ipc, 0, sizeof(*ipc));
+    ipc->ctrl = ringbuf;
+    ipc->cmd_ring = ringbuf + WIFI67_IPC_CMD_OFFSET;
+    ipc->evt_ring = ringbuf + WIFI67_IPC_EVT_OFFSET;
+    ipc->ops = ops;
+    ipc->priv = priv;
+    spin_lock_init(&ipc->cmd_lock);
+
+    wifi67_ipc_reset(ipc);
+    return 0;
+}
+
+/* Only valid while the firmware is not running */
+void wifi67_ipc_reset(struct wifi67_ipc *ipc)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&ipc->cmd_lock, flags);
+    memset(ipc->ctrl, 0, sizeof(*ipc->ctrl));
+    ipc->cmd_prod = 0;
+    ipc->cmd_published = 0;
+    ipc->evt_cons = 0;
+    spin_unlock_irqrestore(&ipc->cmd_lock, flags);
+}
+
+static int wifi67_ipc_put(struct wifi67_ipc *ipc, u16 id,
+                          const void *payload, u16 len)
+{
+    struct wifi67_ipc_msg *msg;
+    u32 cons;
+
+    if (len > WIFI67_IPC_MSG_PAYLOAD)
+        return -EMSGSIZE;
+
+    cons = le32_to_cpu(READ_ONCE(ipc->ctrl->cmd_cons));
+    if (ipc->cmd_prod - cons >= WIFI67_IPC_CMD_ENTRIES) {
+        ipc->stats.ring_full++;
+        return -ENOSPC;
+    }
+
+    msg = &ipc->cmd_ring[ipc->cmd_prod & WIFI67_IPC_CMD_MASK];
+    msg->id = cpu_to_le16(id);
+    msg->len = cpu_to_le16(len);
+    msg->seq = cpu_to_le32(ipc->cmd_seq++);
+    if (len)
+        memcpy(msg->payload, payload, len);
+    trace_wifi67_ipc_cmd(id, ipc->cmd_seq - 1, len);
+
+    ipc->cmd_prod++;
+    ipc->stats.cmds++;
+    return 0;
+}
+
+/*
+ * Publish everything queued since the last flush with a single index
+ * store. The doorbell is only rung if the firmware had already consumed
+ * the previous batch; otherwise it is still draining and will pick the
+ * new entries up when it re-reads cmd_prod before going idle.
+ */
+static void __wifi67_ipc_flush(struct wifi67_ipc *ipc)
+{
+    bool doorbell;
+    u32 cons;
+
+    if (ipc->cmd_prod == ipc->cmd_published)
+        return;
+
+    /* Entries must be visible before the index that covers them */
+    dma_wmb();
+    WRITE_ONCE(ipc->ctrl->cmd_prod, cpu_to_le32(ipc->cmd_prod));
+
+    /* Order the index store against the consumer load below */
+    mb();
+    cons = le32_to_cpu(READ_ONCE(ipc->ctrl->cmd_cons));
+
+    doorbell = cons == ipc->cmd_published;
+    if (doorbell) {
+        ipc->ops->doorbell(ipc->priv);
+        ipc->stats.doorbells++;
+    } else {
+        ipc->stats.doorbells_coalesced++;
+    }
+
+    trace_wifi67_ipc_flush(ipc->cmd_prod, ipc->cmd_prod - ipc->cmd_published,
+                           doorbell);
+    ipc->cmd_published = ipc->cmd_prod;
+    ipc->stats.flushes++;
+}
+
+/* Queue a command without notifying the firmware */
+int wifi67_ipc_queue(struct wifi67_ipc *ipc, u16 id,
+                     const void *payload, u16 len)
+{
+    unsigned long flags;
+    int ret;
+
+    spin_lock_irqsave(&ipc->cmd_lock, flags);
+    ret = wifi67_ipc_put(ipc, id, payload, len);
+    spin_unlock_irqrestore(&ipc->cmd_lock, flags);
+
+    return ret;
+}
+
+void wifi67_ipc_flush(struct wifi67_ipc *ipc)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&ipc->cmd_lock, flags);
+    __wifi67_ipc_flush(ipc);
+    spin_unlock_irqrestore(&ipc->cmd_lock, flags);
+}
+
+/* Queue and publish a batch; returns the number of commands accepted */
+int wifi67_ipc_send(struct wifi67_ipc *ipc, const struct wifi67_ipc_msg *msgs,
+                    int count)
+{
+    unsigned long flags;
+    int i;
+
+    spin_lock_irqsave(&ipc->cmd_lock, flags);
+
+    for (i = 0; i < count; i++) {
+        if (wifi67_ipc_put(ipc, le16_to_cpu(msgs[i].id), msgs[i].payload,
+                           le16_to_cpu(msgs[i].len)))
+            break;
+    }
+
+    __wifi67_ipc_flush(ipc);
+    spin_unlock_irqrestore(&ipc->cmd_lock, flags);
+
+    return i ? i : -ENOSPC;
+}
+
+/*
+ * Drain up to @budget events and hand the slots back to the firmware
+ * with one index store. Must not run concurrently with itself.
+ */
+int wifi67_ipc_poll(struct wifi67_ipc *ipc, int budget)
+{
+    u32 cons = ipc->evt_cons;
+    u32 prod;
+    int done = 0;
+
+    prod = le32_to_cpu(READ_ONCE(ipc->ctrl->evt_prod));
+    /* Read entries only after the index that published them */
+    dma_rmb();
+
+    while (cons != prod && done < budget) {
+        const struct wifi67_ipc_msg *msg =
+            &ipc->evt_ring[cons & WIFI67_IPC_EVT_MASK];
+
+        trace_wifi67_ipc_evt(le16_to_cpu(msg->id), le32_to_cpu(msg->seq),
+                             le16_to_cpu(msg->len));
+        if (ipc->ops->event)
+            ipc->ops->event(ipc->priv, msg);
+        cons++;
+        done++;
+    }
+
+    if (done) {
+        /* Finish reading the slots before the firmware may reuse them */
+        mb();
+        WRITE_ONCE(ipc->ctrl->evt_cons, cpu_to_le32(cons));
+        ipc->evt_cons = cons;
+        ipc->stats.events += done;
+    }
+
+    ipc->stats.polls++;
+    return done;
+}
+
+bool wifi67_ipc_evt_pending(struct wifi67_ipc *ipc)
+{
+    return le32_to_cpu(READ_ONCE(ipc->ctrl->evt_prod)) != ipc->evt_cons;
+}
+
+EXPORT_SYMBOL_GPL(wifi67_ipc_init);
+EXPORT_SYMBOL_GPL(wifi67_ipc_reset);
+EXPORT_SYMBOL_GPL(wifi67_ipc_queue);
+EXPORT_SYMBOL_GPL(wifi67_ipc_flush);
+EXPORT_SYMBOL_GPL(wifi67_ipc_send);
+EXPORT_SYMBOL_GPL(wifi67_ipc_poll);
+EXPORT_SYMBOL_GPL(wifi67_ipc_evt_pending);
@@ -13,6 +13,7 @@
 #define WIFI67_HW_BOOT_DELAY_US     500
 #define WIFI67_HW_QUALITY_THRESHOLD  30
 #define WIFI67_HW_MAX_RETRIES       3
+#define WIFI67_HW_FW_COPY_CHUNK     (16 * 1024)
 
 /* Hardware register access helpers */
 static inline void hw_write32(struct wifi67_priv *priv, u32 reg, u32 val)
@@ -53,19 +54,43 @@ void wifi67_hw_deinit(struct wifi67_priv *priv)
 }
 
 /* Firmware loading support */
-int wifi67_hw_load_fw(struct wifi67_priv *priv, u8 radio_id,
-                     const void *data, size_t size,
-                     dma_addr_t iram_addr, dma_addr_t dram_addr,
-                     dma_addr_t sram_addr)
+
+/*
+ * Copy one firmware section in bounded chunks with a preemption point
+ * between them, so a multi-hundred-KB image never keeps the CPU for
+ * more than one chunk. Must be called from sleepable context.
+ */
+static void hw_fw_copy_section(void __iomem *dst, const u8 *src, size_t len)
+{
+    size_t off, n;
+
+    for (off = 0; off < len; off += n) {
+        n = min_t(size_t, len - off, WIFI67_HW_FW_COPY_CHUNK);
+        memcpy_toio(dst + off, src + off, n);
+        cond_resched();
+    }
+}
+
+/*
+ * Register handshake for a firmware load: validate the header and point
+ * the radio at its memory regions. Short and non-sleeping, so it may be
+ * called under the firmware manager lock.
+ */
+int wifi67_hw_fw_setup(struct wifi67_priv *priv, u8 radio_id,
+                      const void *data, size_t size,
+                      dma_addr_t iram_addr, dma_addr_t dram_addr,
+                      dma_addr_t sram_addr)
 {
     const struct wifi67_fw_header *hdr = data;
-    const u8 *ptr = data;
-    int ret = 0;
 
     /* Validate firmware header */
     if (size < sizeof(*hdr) || hdr->magic != WIFI67_FW_MAGIC)
         return -EINVAL;
 
+    if ((u64)hdr->iram_size + hdr->dram_size + hdr->sram_size >
+        size - sizeof(*hdr))
+        return -EINVAL;
+
     /* Configure memory regions */
     hw_write32(priv, WIFI67_REG_FW_IRAM_ADDR + radio_id * 0x100,
                lower_32_bits(iram_addr));
@@ -74,30 +99,104 @@ int wifi67_hw_load_fw(struct wifi67_priv *priv, u8 radio_id,
     hw_write32(priv, WIFI67_REG_FW_SRAM_ADDR + radio_id * 0x100,
                lower_32_bits(sram_addr));
 
+    return 0;
+}
+
+/* MMIO window backing one firmware region of a radio */
+void __iomem *wifi67_hw_fw_region_base(struct wifi67_priv *priv, u8 radio_id,
+                                      enum wifi67_fw_region region)
+{
+    switch (region) {
+    case WIFI67_FW_REGION_IRAM:
+        return priv->mmio + radio_id * WIFI67_FW_IRAM_SIZE;
+    case WIFI67_FW_REGION_DRAM:
+        return priv->mmio + radio_id * WIFI67_FW_DRAM_SIZE +
+               WIFI67_FW_IRAM_SIZE;
+    case WIFI67_FW_REGION_SRAM:
+        return priv->mmio + radio_id * WIFI67_FW_SRAM_SIZE +
+               WIFI67_FW_IRAM_SIZE + WIFI67_FW_DRAM_SIZE;
+    default:
+        return NULL;
+    }
+}
+
+/* Rewrite one region; sleeps between chunks */
+int wifi67_hw_fw_write_region(struct wifi67_priv *priv, u8 radio_id,
+                             enum wifi67_fw_region region,
+                             const void *data, size_t len)
+{
+    void __iomem *base = wifi67_hw_fw_region_base(priv, radio_id, region);
+
+    if (!base)
+        return -EINVAL;
+
+    might_sleep();
+    hw_fw_copy_section(base, data, len);
+    return 0;
+}
+
+/* Read back part of a region, e.g. to check whether it survived a reset */
+int wifi67_hw_fw_read_region(struct wifi67_priv *priv, u8 radio_id,
+                            enum wifi67_fw_region region, size_t offset,
+                            void *buf, size_t len)
+{
+    void __iomem *base = wifi67_hw_fw_region_base(priv, radio_id, region);
+
+    if (!base)
+        return -EINVAL;
+
+    memcpy_fromio(buf, base + offset, len);
+    return 0;
+}
+
+/*
+ * Copy the image body. Sleeps between chunks; must be called without
+ * spinlocks held and with the radio marked busy by the caller.
+ */
+int wifi67_hw_fw_copy(struct wifi67_priv *priv, u8 radio_id,
+                     const void *data, size_t size)
+{
+    const struct wifi67_fw_header *hdr = data;
+    const u8 *ptr = data + sizeof(*hdr);
+
+    might_sleep();
+
     /* Load IRAM section */
     if (hdr->iram_size > 0) {
-        ptr += sizeof(*hdr);
-        memcpy_toio(priv->mmio + radio_id * WIFI67_FW_IRAM_SIZE,
-                    ptr, hdr->iram_size);
+        wifi67_hw_fw_write_region(priv, radio_id, WIFI67_FW_REGION_IRAM,
+                                  ptr, hdr->iram_size);
         ptr += hdr->iram_size;
     }
 
     /* Load DRAM section */
     if (hdr->dram_size > 0) {
-        memcpy_toio(priv->mmio + radio_id * WIFI67_FW_DRAM_SIZE + 
-                    WIFI67_FW_IRAM_SIZE,
-                    ptr, hdr->dram_size);
+        wifi67_hw_fw_write_region(priv, radio_id, WIFI67_FW_REGION_DRAM,
+                                  ptr, hdr->dram_size);
         ptr += hdr->dram_size;
     }
 
     /* Load SRAM section */
     if (hdr->sram_size > 0) {
-        memcpy_toio(priv->mmio + radio_id * WIFI67_FW_SRAM_SIZE +
-                    WIFI67_FW_IRAM_SIZE + WIFI67_FW_DRAM_SIZE,
-                    ptr, hdr->sram_size);
+        wifi67_hw_fw_write_region(priv, radio_id, WIFI67_FW_REGION_SRAM,
+                                  ptr, hdr->sram_size);
     }
 
-    return ret;
+    return 0;
+}
+
+int wifi67_hw_load_fw(struct wifi67_priv *priv, u8 radio_id,
+                     const void *data, size_t size,
+                     dma_addr_t iram_addr, dma_addr_t dram_addr,
+                     dma_addr_t sram_addr)
+{
+    int ret;
+
+    ret = wifi67_hw_fw_setup(priv, radio_id, data, size,
+                             iram_addr, dram_addr, sram_addr);
+    if (ret)
+        return ret;
+
+    return wifi67_hw_fw_copy(priv, radio_id, data, size);
 }
 
 int wifi67_hw_start_fw(struct wifi67_priv *priv, u8 radio_id,
@@ -245,6 +344,11 @@ int wifi67_hw_switch_link_radio(struct wifi67_priv *priv, u8 link_id,
 EXPORT_SYMBOL(wifi67_hw_init);
 EXPORT_SYMBOL(wifi67_hw_deinit);
 EXPORT_SYMBOL(wifi67_hw_load_fw);
+EXPORT_SYMBOL(wifi67_hw_fw_setup);
+EXPORT_SYMBOL(wifi67_hw_fw_copy);
+EXPORT_SYMBOL(wifi67_hw_fw_region_base);
+EXPORT_SYMBOL(wifi67_hw_fw_write_region);
+EXPORT_SYMBOL(wifi67_hw_fw_read_region);
 EXPORT_SYMBOL(wifi67_hw_start_fw);
 EXPORT_SYMBOL(wifi67_hw_stop_fw);
 EXPORT_SYMBOL(wifi67_hw_reset_radio);
@@ -3,6 +3,8 @@
 #include <linux/pci.h>
 #include "../../include/mac/mac_core.h"
 #include "../../include/core/wifi67.h"
+#include "../../include/perf/perf_latency.h"
+#include "../../include/debug/debug.h"
 
 #define WIFI67_MAC_REG_CTRL      0x0000
 #define WIFI67_MAC_REG_STATUS    0x0004
@@ -326,6 +328,9 @@ int wifi67_mac_tx(struct wifi67_priv *priv, struct sk_buff *skb, u8 queue)
 
     q = &mac->queues[queue];
 
+    wifi67_dbg(priv, WIFI67_LOG_MAC, "tx queue %u len %u\n", queue, skb->len);
+    wifi67_lat_stamp(skb, WIFI67_LAT_ENQUEUE);
+
     spin_lock_irqsave(&q->lock, flags);
 
     /* Add TX implementation here */
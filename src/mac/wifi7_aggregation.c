@@ -20,13 +20,21 @@
 #include "wifi7_aggregation.h"
 #include "wifi7_mac.h"
 #include "wifi7_mlo.h"
+#include "../../include/debug/debug.h"
+#include "../../include/debug/wifi67_trace.h"
 
-/* Maximum number of frames in an aggregation */
+/* Default per-TID limits, overridable through the module parameters */
 #define WIFI7_MAX_AGG_FRAMES     256
 #define WIFI7_MAX_AGG_SIZE       (4 * 1024 * 1024)  /* 4MB */
-#define WIFI7_MAX_AGG_TIMEOUT    (50)  /* 50ms */
+#define WIFI7_DEF_AGG_TIMEOUT    (50)  /* 50ms */
 #define WIFI7_MAX_REORDER_BUFFER 1024
-#define WIFI7_MAX_REORDER_TIMEOUT (100) /* 100ms */
+#define WIFI7_DEF_REORDER_TIMEOUT (100) /* 100ms */
+
+static unsigned int wifi7_max_agg_frames = WIFI7_MAX_AGG_FRAMES;
+static unsigned int wifi7_max_agg_size = WIFI7_MAX_AGG_SIZE;
+static unsigned int wifi7_max_agg_timeout = WIFI7_DEF_AGG_TIMEOUT;
+static unsigned int wifi7_max_reorder_buffer = WIFI7_MAX_REORDER_BUFFER;
+static unsigned int wifi7_max_reorder_timeout = WIFI7_DEF_REORDER_TIMEOUT;
 
 /* Aggregation context for a TID */
 struct wifi7_agg_tid_ctx {
@@ -84,10 +92,17 @@ static struct {
 } wifi7_agg_ctx;
 
 /* Helper functions */
+
+/* Sequence numbers are 12 bits; compare them modulo 4096 */
+static inline int wifi7_seq_cmp(u16 a, u16 b)
+{
+    return (s16)((u16)(a - b) << 4);
+}
+
 static inline int frame_entry_cmp(const struct wifi7_frame_entry *a,
                                 const struct wifi7_frame_entry *b)
 {
-    return (int)((s16)(a->ssn - b->ssn));
+    return wifi7_seq_cmp(a->ssn, b->ssn);
 }
 
 static struct wifi7_frame_entry *frame_entry_search(struct rb_root *root,
@@ -98,7 +113,7 @@ static struct wifi7_frame_entry *frame_entry_search(struct rb_root *root,
 
     while (node) {
         entry = rb_entry(node, struct wifi7_frame_entry, node);
-        int cmp = (int)((s16)(ssn - entry->ssn));
+        int cmp = wifi7_seq_cmp(ssn, entry->ssn);
 
         if (cmp < 0)
             node = node->rb_left;
@@ -185,10 +200,13 @@ static void wifi7_reorder_timeout_handler(struct work_struct *work)
     struct wifi7_frame_entry *entry;
     struct rb_node *node;
     unsigned long flags;
+    u16 old_head, released = 0;
     LIST_HEAD(expired);
 
     spin_lock_irqsave(&ctx->lock, flags);
 
+    old_head = ctx->head_ssn;
+
     /* Move expired frames to ready list */
     while ((node = rb_first(&ctx->reorder_tree))) {
         entry = rb_entry(node, struct wifi7_frame_entry, node);
@@ -198,11 +216,17 @@ static void wifi7_reorder_timeout_handler(struct work_struct *work)
             list_add_tail(&entry->list, &ctx->ready_frames);
             atomic_dec(&ctx->pending_count);
             ctx->head_ssn = (entry->ssn + 1) & 0xFFF;
+            released++;
         } else {
             break;
         }
     }
 
+    if (released) {
+        trace_wifi67_ba_window_move(ctx->tid, old_head, ctx->head_ssn);
+        trace_wifi67_reorder_flush(ctx->tid, ctx->head_ssn, released, 0);
+    }
+
     /* Schedule next timeout if needed */
     if (atomic_read(&ctx->pending_count) > 0)
         schedule_delayed_work(&ctx->timeout_work,
@@ -224,9 +248,9 @@ static int wifi7_agg_init_tid(struct wifi7_dev *dev, u8 tid)
     spin_lock_init(&ctx->lock);
     ctx->tid = tid;
     ctx->link_mask = 0;
-    ctx->max_size = WIFI7_MAX_AGG_SIZE;
-    ctx->max_frames = WIFI7_MAX_AGG_FRAMES;
-    ctx->timeout = WIFI7_MAX_AGG_TIMEOUT;
+    ctx->max_size = wifi7_max_agg_size;
+    ctx->max_frames = wifi7_max_agg_frames;
+    ctx->timeout = wifi7_max_agg_timeout;
     ctx->dev = dev;
     atomic_set(&ctx->pending_count, 0);
     ctx->active = true;
@@ -246,8 +270,8 @@ static int wifi7_reorder_init_tid(struct wifi7_dev *dev, u8 tid)
     spin_lock_init(&ctx->lock);
     ctx->tid = tid;
     ctx->link_mask = 0;
-    ctx->buffer_size = WIFI7_MAX_REORDER_BUFFER;
-    ctx->timeout = WIFI7_MAX_REORDER_TIMEOUT;
+    ctx->buffer_size = wifi7_max_reorder_buffer;
+    ctx->timeout = wifi7_max_reorder_timeout;
     ctx->dev = dev;
     atomic_set(&ctx->pending_count, 0);
     ctx->active = true;
@@ -369,6 +393,8 @@ int wifi7_add_agg_frame(struct wifi7_dev *dev, struct sk_buff *skb,
 
     /* Check if we can add more frames */
     if (atomic_read(&ctx->pending_count) >= ctx->max_frames) {
+        wifi67_dbg(NULL, WIFI67_LOG_AGG, "tid %u aggregation queue full\n",
+                   tid);
         ret = -ENOSPC;
         goto out_unlock;
     }
@@ -418,6 +444,7 @@ int wifi7_add_reorder_frame(struct wifi7_dev *dev, struct sk_buff *skb,
 
     /* Check if we can add more frames */
     if (atomic_read(&ctx->pending_count) >= ctx->buffer_size) {
+        wifi67_dbg(NULL, WIFI67_LOG_AGG, "tid %u reorder buffer full\n", tid);
         ret = -ENOSPC;
         goto out_unlock;
     }
@@ -447,6 +474,7 @@ void wifi7_process_agg_frames(struct wifi7_dev *dev, u8 tid)
     struct wifi7_agg_tid_ctx *ctx = &wifi7_agg_ctx.agg_contexts[tid];
     struct wifi7_frame_entry *entry, *tmp;
     unsigned long flags;
+    u32 frames = 0, bytes = 0;
     LIST_HEAD(process_list);
 
     spin_lock_irqsave(&ctx->lock, flags);
@@ -459,9 +487,14 @@ void wifi7_process_agg_frames(struct wifi7_dev *dev, u8 tid)
     /* Process frames */
     list_for_each_entry_safe(entry, tmp, &process_list, list) {
         list_del(&entry->list);
+        frames++;
+        bytes += entry->skb->len;
         wifi7_transmit_frame(dev, entry->skb, entry->tid, entry->link_id);
         kfree(entry);
     }
+
+    if (frames)
+        trace_wifi67_agg_build(tid, frames, bytes);
 }
 EXPORT_SYMBOL(wifi7_process_agg_frames);
 
@@ -508,4 +541,8 @@ MODULE_PARM_DESC(wifi7_max_reorder_timeout, "Reorder timeout in milliseconds");
 MODULE_LICENSE("MIT");
 MODULE_AUTHOR("Fayssal Chokri <fayssalchokri@gmail.com>");
 MODULE_DESCRIPTION("WiFi 7 Cross-Link Frame Aggregation and Reordering");
-MODULE_VERSION("1.0"); 
\ No newline at end of file
+MODULE_VERSION("1.0");
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/agg_kunit.c"
+#endif
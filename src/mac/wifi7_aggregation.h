@@ -12,7 +12,7 @@
 
 /* Maximum values */
 #define WIFI7_NUM_TIDS          8
-#define WIFI7_MAX_LINKS         16
+#define WIFI7_MAX_LINKS         8
 #define WIFI7_MAX_AGG_SIZE_MIN  (32 * 1024)    /* 32KB */
 #define WIFI7_MAX_AGG_SIZE_MAX  (16 * 1024 * 1024) /* 16MB */
 #define WIFI7_MIN_AGG_TIMEOUT   10   /* 10ms */
@@ -14,6 +14,8 @@
 #include <linux/slab.h>
 #include "wifi7_ba.h"
 #include "wifi7_mac.h"
+#include "../../include/debug/debug.h"
+#include "../../include/debug/wifi67_trace.h"
 
 /* Helper functions */
 static inline u16 seq_to_index(u16 seq)
@@ -26,10 +28,18 @@ static inline bool is_seq_valid(u16 seq, u16 head_seq, u16 tail_seq)
     return ((seq - head_seq) & 0xFFF) <= ((tail_seq - head_seq) & 0xFFF);
 }
 
+static inline u8 wifi7_ba_frame_tid(const struct wifi7_ba_frame_hdr *hdr)
+{
+    return (le16_to_cpu(hdr->ba_control) & IEEE80211_BAR_CTRL_TID_INFO_MASK) >>
+           IEEE80211_BAR_CTRL_TID_INFO_SHIFT;
+}
+
 static void wifi7_ba_flush_reorder_buffer(struct wifi7_ba_session *session,
                                         u16 seq)
 {
     struct sk_buff *skb;
+    u16 old_head = session->head_seq;
+    u16 released = 0, dropped = 0;
     u16 idx;
     
     while (session->head_seq != seq) {
@@ -41,24 +51,62 @@ static void wifi7_ba_flush_reorder_buffer(struct wifi7_ba_session *session,
             clear_bit(idx, session->reorder_bitmap);
             skb_queue_tail(&session->reorder_queue, skb);
             session->rx_reorder++;
+            released++;
         } else {
             session->rx_drop++;
+            dropped++;
         }
         
         session->head_seq = (session->head_seq + 1) & 0xFFF;
     }
+
+    if (session->head_seq != old_head) {
+        trace_wifi67_ba_window_move(session->tid, old_head, session->head_seq);
+        trace_wifi67_reorder_flush(session->tid, session->head_seq,
+                                   released, dropped);
+        if (dropped)
+            wifi67_dbg(NULL, WIFI67_LOG_BA,
+                       "tid %u window %u->%u, %u holes dropped\n",
+                       session->tid, old_head, session->head_seq, dropped);
+    }
+}
+
+/* Release the run of parked frames starting at the window head */
+static void wifi7_ba_release_in_order(struct wifi7_ba_session *session)
+{
+    u16 seq = session->head_seq;
+    int i;
+
+    for (i = 0; i < WIFI7_BA_MAX_REORDER; i++) {
+        if (!test_bit(seq_to_index(seq), session->reorder_bitmap))
+            break;
+        seq = (seq + 1) & 0xFFF;
+    }
+
+    wifi7_ba_flush_reorder_buffer(session, seq);
 }
 
 static void wifi7_ba_reorder_timer(struct timer_list *t)
 {
     struct wifi7_ba_session *session = from_timer(session, t, reorder_timer);
     unsigned long flags;
+    u16 seq;
+    int i;
     
     spin_lock_irqsave(&session->lock, flags);
     
     if (session->state == WIFI7_BA_STATE_ACTIVE) {
-        /* Flush reorder buffer up to head */
-        wifi7_ba_flush_reorder_buffer(session, session->head_seq);
+        /* Give up on the hole at the head: skip to the next parked frame */
+        seq = session->head_seq;
+        for (i = 0; i < WIFI7_BA_MAX_REORDER; i++) {
+            if (test_bit(seq_to_index(seq), session->reorder_bitmap))
+                break;
+            seq = (seq + 1) & 0xFFF;
+        }
+        if (i < WIFI7_BA_MAX_REORDER) {
+            wifi7_ba_flush_reorder_buffer(session, seq);
+            wifi7_ba_release_in_order(session);
+        }
         
         /* Restart timer if more packets pending */
         if (!bitmap_empty(session->reorder_bitmap,
@@ -115,6 +163,21 @@ static struct wifi7_ba_session *wifi7_ba_find_session(struct wifi7_ba *ba,
     return NULL;
 }
 
+/* Stop a session's timers and free the frames it still holds */
+static void wifi7_ba_session_release(struct wifi7_ba_session *session)
+{
+    int i;
+
+    del_timer(&session->reorder_timer);
+    del_timer(&session->session_timer);
+    skb_queue_purge(&session->reorder_queue);
+    for (i = 0; i < WIFI7_BA_MAX_REORDER; i++) {
+        kfree_skb(session->reorder_buf[i]);
+        session->reorder_buf[i] = NULL;
+    }
+    bitmap_zero(session->reorder_bitmap, WIFI7_BA_MAX_REORDER);
+}
+
 static struct wifi7_ba_session *wifi7_ba_alloc_session(struct wifi7_ba *ba)
 {
     struct wifi7_ba_session *session;
@@ -138,29 +201,38 @@ static int wifi7_ba_process_addba_req(struct wifi7_dev *dev,
     struct wifi7_ba_frame_hdr *hdr;
     unsigned long flags;
     int ret = 0;
+    u8 tid;
     
     /* Parse frame */
     hdr = (struct wifi7_ba_frame_hdr *)skb->data;
+    tid = wifi7_ba_frame_tid(hdr);
     
     spin_lock_irqsave(&ba->lock, flags);
     
     /* Find or allocate session */
     session = wifi7_ba_find_session(ba, tid, hdr->ta);
-    if (!session) {
+    if (session) {
+        /* Renegotiation: the old session's timers and frames go first */
+        wifi7_ba_session_release(session);
+        ba->num_sessions--;
+    } else {
         session = wifi7_ba_alloc_session(ba);
         if (!session) {
             ret = -ENOMEM;
             goto out;
         }
+        /* A torn-down slot can still hold frames */
+        if (session->state != WIFI7_BA_STATE_IDLE)
+            wifi7_ba_session_release(session);
     }
     
     /* Initialize session */
     memset(session, 0, sizeof(*session));
     session->tid = tid;
     session->state = WIFI7_BA_STATE_INIT;
-    session->timeout = min_t(u16, timeout, WIFI7_BA_MAX_TIMEOUT);
-    session->buffer_size = min_t(u16, buf_size, WIFI7_BA_MAX_REORDER);
-    session->flags = flags;
+    session->timeout = min_t(u16, ba->timeout, WIFI7_BA_MAX_TIMEOUT);
+    session->buffer_size = min_t(u16, ba->buffer_size, WIFI7_BA_MAX_REORDER);
+    session->flags = ba->flags;
     session->ssn = le16_to_cpu(hdr->ba_info) & 0xFFF;
     session->head_seq = session->ssn;
     session->tail_seq = session->ssn;
@@ -203,14 +275,15 @@ static int wifi7_ba_process_addba_resp(struct wifi7_dev *dev,
     spin_lock_irqsave(&ba->lock, flags);
     
     /* Find session */
-    session = wifi7_ba_find_session(ba, tid, hdr->ta);
+    session = wifi7_ba_find_session(ba, wifi7_ba_frame_tid(hdr), hdr->ta);
     if (!session) {
         ret = -ENOENT;
         goto out;
     }
     
     /* Update session */
-    if (le16_to_cpu(hdr->ba_control) & IEEE80211_BAR_CTRL_ACK_POLICY_NORMAL) {
+    if ((le16_to_cpu(hdr->ba_control) & BIT(0)) ==
+        IEEE80211_BAR_CTRL_ACK_POLICY_NORMAL) {
         session->state = WIFI7_BA_STATE_ACTIVE;
         mod_timer(&session->session_timer,
                  jiffies + msecs_to_jiffies(session->timeout));
@@ -243,7 +316,7 @@ static int wifi7_ba_process_delba(struct wifi7_dev *dev,
     spin_lock_irqsave(&ba->lock, flags);
     
     /* Find session */
-    session = wifi7_ba_find_session(ba, tid, hdr->ta);
+    session = wifi7_ba_find_session(ba, wifi7_ba_frame_tid(hdr), hdr->ta);
     if (!session) {
         ret = -ENOENT;
         goto out;
@@ -273,7 +346,6 @@ out:
 int wifi7_ba_init(struct wifi7_dev *dev)
 {
     struct wifi7_ba *ba;
-    int ret;
     
     ba = kzalloc(sizeof(*ba), GFP_KERNEL);
     if (!ba)
@@ -307,10 +379,10 @@ void wifi7_ba_deinit(struct wifi7_dev *dev)
     /* Stop all sessions */
     for (i = 0; i < WIFI7_BA_MAX_SESSIONS; i++) {
         session = &ba->sessions[i];
-        if (session->active) {
+        if (session->state != WIFI7_BA_STATE_IDLE) {
             del_timer_sync(&session->reorder_timer);
             del_timer_sync(&session->session_timer);
-            skb_queue_purge(&session->reorder_queue);
+            wifi7_ba_session_release(session);
         }
     }
     
@@ -383,4 +455,8 @@ module_exit(wifi7_ba_exit_module);
 MODULE_LICENSE("MIT");
 MODULE_AUTHOR("Fayssal Chokri <fayssalchokri@gmail.com>");
 MODULE_DESCRIPTION("WiFi 7 Block Acknowledgment");
-MODULE_VERSION("1.0"); 
\ No newline at end of file
+MODULE_VERSION("1.0");
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/ba_kunit.c"
+#endif
@@ -200,11 +200,14 @@ int wifi7_mac_link_teardown(struct wifi7_mac_dev *dev, u8 link_id)
 
     /* Prevent new transmissions */
     link->mlo_state = MLO_STATE_TEARDOWN;
-    
-    /* Flush pending work - this needs testing */
+    spin_unlock_irqrestore(&link->lock, flags);
+
+    /* Flushing sleeps, so pending work is drained with the lock dropped */
     if (dev->mlo_wq)
         flush_workqueue(dev->mlo_wq);
 
+    spin_lock_irqsave(&link->lock, flags);
+
     /* TODO: Add timeout for hardware teardown */
     if (dev->ops && dev->ops->link_teardown) {
         ret = dev->ops->link_teardown(dev, link_id);
@@ -227,7 +230,10 @@ out_unlock:
     return ret;
 }
 
-/* Frame transmission and reception */
+/*
+ * Frame transmission and reception. On error @skb is still the caller's:
+ * -EBUSY is hardware backpressure, to retry later; anything else is a drop.
+ */
 int wifi7_mac_tx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_id)
 {
     struct wifi7_link_state *link;
@@ -249,11 +255,12 @@ int wifi7_mac_tx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_i
     link->tx_packets++;
 
     /* Call hardware TX */
-    if (dev->ops && dev->ops->tx_frame) {
+    if (dev->ops && dev->ops->tx_frame)
         ret = dev->ops->tx_frame(dev, skb, link_id);
-        if (ret)
-            link->tx_errors++;
-    }
+    else
+        ret = -EOPNOTSUPP;
+    if (ret)
+        link->tx_errors++;
 
 out_unlock:
     spin_unlock_bh(&link->lock);
@@ -261,6 +268,14 @@ out_unlock:
 }
 EXPORT_SYMBOL_GPL(wifi7_mac_tx_frame);
 
+/* The caller's TX queue ran empty: hardware may stop holding frames back */
+void wifi7_mac_tx_flush(struct wifi7_mac_dev *dev)
+{
+    if (dev && dev->ops && dev->ops->tx_flush)
+        dev->ops->tx_flush(dev);
+}
+EXPORT_SYMBOL_GPL(wifi7_mac_tx_flush);
+
 int wifi7_mac_rx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_id)
 {
     struct wifi7_link_state *link;
@@ -461,4 +476,8 @@ module_exit(wifi7_mac_exit);
 MODULE_LICENSE("MIT");
 MODULE_AUTHOR("Fayssal Chokri <fayssalchokri@gmail.com>");
 MODULE_DESCRIPTION("WiFi 7 MAC Layer Core");
-MODULE_VERSION("1.0"); 
\ No newline at end of file
+MODULE_VERSION("1.0"); 
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/mac_kunit.c"
+#endif
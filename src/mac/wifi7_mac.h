@@ -139,9 +139,10 @@ struct wifi7_mac_ops {
     int (*link_setup)(struct wifi7_mac_dev *dev, u8 link_id);
     int (*link_teardown)(struct wifi7_mac_dev *dev, u8 link_id);
     
-    /* Frame transmission */
+    /* Frame transmission; @skb is consumed only when 0 is returned */
     int (*tx_frame)(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_id);
     void (*tx_done)(struct wifi7_mac_dev *dev, struct sk_buff *skb, bool success);
+    void (*tx_flush)(struct wifi7_mac_dev *dev);
     
     /* Frame reception */
     int (*rx_frame)(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_id);
@@ -170,6 +171,7 @@ int wifi7_mac_set_link_params(struct wifi7_mac_dev *dev, u8 link_id,
                             u32 freq, u32 bw, u8 nss, u8 mcs);
 
 int wifi7_mac_tx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_id);
+void wifi7_mac_tx_flush(struct wifi7_mac_dev *dev);
 int wifi7_mac_rx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb, u8 link_id);
 
 int wifi7_mac_set_power_save(struct wifi7_mac_dev *dev, u8 link_id, bool enable);
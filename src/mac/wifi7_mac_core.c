@@ -67,7 +67,6 @@ static int wifi7_mac_enqueue(struct wifi7_mac *mac,
     spin_lock_irqsave(&queue->lock, flags);
     
     if (queue->len >= queue->max_len) {
-        mac->stats.queue_full++;
         ret = -ENOSPC;
         goto out_unlock;
     }
@@ -139,7 +138,7 @@ static void wifi7_mac_tx_work(struct work_struct *work)
     unsigned long flags;
     int i;
     
-    if (mac->state != WIFI7_MAC_STATE_RUNNING)
+    if (READ_ONCE(mac->state) != WIFI7_MAC_STATE_RUNNING)
         return;
         
     spin_lock_irqsave(&mac->frames.lock, flags);
@@ -168,7 +167,7 @@ static void wifi7_mac_rx_work(struct work_struct *work)
     struct sk_buff *skb;
     unsigned long flags;
     
-    if (mac->state != WIFI7_MAC_STATE_RUNNING)
+    if (READ_ONCE(mac->state) != WIFI7_MAC_STATE_RUNNING)
         return;
         
     spin_lock_irqsave(&mac->frames.lock, flags);
@@ -405,8 +404,8 @@ int wifi7_mac_start(struct wifi7_dev *dev)
     schedule_delayed_work(&mac->frames.tx_work, 0);
     schedule_delayed_work(&mac->frames.rx_work, 0);
     
-    mac->state = WIFI7_MAC_STATE_RUNNING;
-    mac->enabled = true;
+    WRITE_ONCE(mac->state, WIFI7_MAC_STATE_RUNNING);
+    WRITE_ONCE(mac->enabled, true);
     
     return 0;
 }
@@ -422,7 +421,7 @@ void wifi7_mac_stop(struct wifi7_dev *dev)
     if (mac->state != WIFI7_MAC_STATE_RUNNING)
         return;
         
-    mac->state = WIFI7_MAC_STATE_STOPPING;
+    WRITE_ONCE(mac->state, WIFI7_MAC_STATE_STOPPING);
     
     /* Cancel work */
     cancel_delayed_work_sync(&mac->frames.tx_work);
@@ -432,22 +431,28 @@ void wifi7_mac_stop(struct wifi7_dev *dev)
     // TODO: Stop subsystems
     
     mac->state = WIFI7_MAC_STATE_STOPPED;
-    mac->enabled = false;
+    WRITE_ONCE(mac->enabled, false);
 }
 EXPORT_SYMBOL_GPL(wifi7_mac_stop);
 
 int wifi7_mac_tx(struct wifi7_dev *dev, struct sk_buff *skb)
 {
     struct wifi7_mac *mac = dev->mac;
+    unsigned long flags;
     int ret;
     
-    if (!mac || !mac->enabled)
+    if (!mac || !READ_ONCE(mac->enabled))
         return -EINVAL;
         
     /* Enqueue frame */
     ret = wifi7_mac_enqueue(mac, skb, skb->queue_mapping);
     if (ret) {
+        /* Senders on different queues share these counters */
+        spin_lock_irqsave(&mac->queues.lock, flags);
+        if (ret == -ENOSPC)
+            mac->stats.queue_full++;
         mac->stats.queue_drops++;
+        spin_unlock_irqrestore(&mac->queues.lock, flags);
         return ret;
     }
     
@@ -459,7 +464,7 @@ int wifi7_mac_rx(struct wifi7_dev *dev, struct sk_buff *skb)
 {
     struct wifi7_mac *mac = dev->mac;
     
-    if (!mac || !mac->enabled)
+    if (!mac || !READ_ONCE(mac->enabled))
         return -EINVAL;
         
     /* Enqueue frame */
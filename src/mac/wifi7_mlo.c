@@ -17,8 +17,12 @@
 #include "wifi7_mlo.h"
 #include "wifi7_mac.h"
 #include "../hal/wifi7_rf.h"
+#include "../hal/metrics.h"
+#include "../hal/power.h"
 #include "../../include/core/wifi67.h"
 #include "../../include/core/mlo.h"
+#include "../../include/debug/debug.h"
+#include "../../include/debug/wifi67_trace.h"
 
 /* MLO device state */
 struct wifi7_mlo {
@@ -73,8 +77,12 @@ struct wifi7_mlo {
     /* Debugging */
     struct dentry *debugfs_dir;
     bool debug_enabled;
+
+    struct wifi7_dev *dev;
 };
 
+static void wifi7_mlo_tx_handler(struct work_struct *work);
+
 /* Link selection algorithms */
 static u8 wifi7_mlo_select_rssi(struct wifi7_mlo *mlo)
 {
@@ -154,13 +162,16 @@ static u8 wifi7_mlo_select_ml(struct wifi7_mlo *mlo)
             
         metrics = &mlo->link.metrics[i];
         
-        /* Calculate ML score using various metrics */
+        /*
+         * Calculate ML score using various metrics. Penalty terms saturate
+         * so an out-of-range reading cannot wrap into a huge score.
+         */
         u32 score = 0;
         score += metrics->rssi * 2;
-        score += (1000 - metrics->latency) * 3;
-        score += (100 - metrics->loss) * 4;
+        score += (1000 - min_t(u32, metrics->latency, 1000)) * 3;
+        score += (100 - min_t(u32, metrics->loss, 100)) * 4;
         score += metrics->tx_rate * 2;
-        score += (100 - metrics->airtime) * 3;
+        score += (100 - min_t(u32, metrics->airtime, 100)) * 3;
         
         if (score > best_score) {
             best_score = score;
@@ -199,15 +210,24 @@ static void wifi7_mlo_select_work(struct work_struct *work)
     
     /* Switch link if needed */
     if (new_link != mlo->link.active_link) {
+        u8 old_link = mlo->link.active_link;
         ktime_t start = ktime_get();
+        int ret;
         
-        if (wifi7_mlo_switch_link(mlo->dev, new_link) == 0) {
+        ret = wifi7_mlo_switch_link(mlo->dev, new_link);
+        if (ret == 0) {
             mlo->link.active_link = new_link;
             mlo->stats.link_switches++;
             mlo->stats.switch_latency = ktime_us_delta(ktime_get(), start);
         } else {
             mlo->stats.link_failures++;
+            wifi67_warn(mlo->dev->priv, WIFI67_LOG_MLO,
+                        "switch from link %u to %u failed: %d\n",
+                        old_link, new_link, ret);
         }
+
+        trace_wifi67_mlo_link_select(mlo->select.policy, old_link, new_link,
+                                     ret, ktime_us_delta(ktime_get(), start));
     }
     
     /* Schedule next selection */
@@ -235,14 +255,11 @@ static void wifi7_mlo_metrics_work(struct work_struct *work)
             struct wifi7_mlo_metrics *metrics = &mlo->link.metrics[i];
             metrics->rssi = radio_metrics.rssi;
             metrics->noise = radio_metrics.noise;
-            metrics->temperature = radio_metrics.temperature;
-            metrics->tx_power = radio_metrics.tx_power;
-            metrics->busy = radio_metrics.busy_percent;
+            metrics->snr = radio_metrics.snr;
         }
 
         if (wifi67_get_link_metrics(mlo->dev->priv, i, &link_metrics) == 0) {
             struct wifi7_mlo_metrics *metrics = &mlo->link.metrics[i];
-            metrics->quality = link_metrics.quality;
             metrics->airtime = link_metrics.airtime;
             metrics->latency = link_metrics.latency;
             metrics->jitter = link_metrics.jitter;
@@ -297,7 +314,6 @@ static void wifi7_mlo_power_work(struct work_struct *work)
 int wifi7_mlo_init(struct wifi7_dev *dev)
 {
     struct wifi7_mlo *mlo;
-    int ret;
     
     mlo = kzalloc(sizeof(*mlo), GFP_KERNEL);
     if (!mlo)
@@ -314,6 +330,7 @@ int wifi7_mlo_init(struct wifi7_dev *dev)
     skb_queue_head_init(&mlo->frames.rx_queue);
     
     /* Initialize work items */
+    INIT_DELAYED_WORK(&mlo->frames.tx_work, wifi7_mlo_tx_handler);
     INIT_DELAYED_WORK(&mlo->select.work, wifi7_mlo_select_work);
     INIT_DELAYED_WORK(&mlo->metrics.work, wifi7_mlo_metrics_work);
     INIT_DELAYED_WORK(&mlo->power.work, wifi7_mlo_power_work);
@@ -350,6 +367,7 @@ void wifi7_mlo_deinit(struct wifi7_dev *dev)
         return;
         
     /* Cancel work items */
+    cancel_delayed_work_sync(&mlo->frames.tx_work);
     cancel_delayed_work_sync(&mlo->select.work);
     cancel_delayed_work_sync(&mlo->metrics.work);
     cancel_delayed_work_sync(&mlo->power.work);
@@ -408,7 +426,7 @@ static int wifi7_emlmr_setup_link(struct wifi7_dev *dev, u8 link_id)
     struct wifi7_mlo_link_config *link;
     int ret;
 
-    link = &dev->mlo.config.links[link_id];
+    link = &dev->mlo->config.links[link_id];
     if (!link->enabled)
         return -EINVAL;
 
@@ -440,7 +458,7 @@ int wifi7_emlmr_init(struct wifi7_dev *dev)
     emlmr_state.primary_link = 0;
     emlmr_state.transition_delay = 0;
     emlmr_state.pad_present = false;
-    emlmr_state.capabilities = dev->mlo.config.capabilities;
+    emlmr_state.capabilities = dev->mlo->config.capabilities;
 
     return 0;
 }
@@ -483,8 +501,8 @@ int wifi7_emlmr_start(struct wifi7_dev *dev)
 
     emlmr_state.state = EMLMR_STATE_SETUP;
 
-    for (link_id = 0; link_id < dev->mlo.config.num_links; link_id++) {
-        if (dev->mlo.config.links[link_id].enabled) {
+    for (link_id = 0; link_id < dev->mlo->config.num_links; link_id++) {
+        if (dev->mlo->config.links[link_id].enabled) {
             ret = wifi7_emlmr_setup_link(dev, link_id);
             if (ret) {
                 emlmr_state.state = EMLMR_STATE_ERROR;
@@ -589,8 +607,10 @@ void wifi7_mlo_link_state_change(struct wifi67_priv *priv, u8 link_id,
         wifi67_mlo_deactivate_link(link);
         break;
     case WIFI67_MLO_LINK_ERROR:
+        /* Takes mlo_lock itself */
+        spin_unlock_irqrestore(&priv->mlo_lock, flags);
         wifi67_mlo_handle_link_error(link);
-        break;
+        return;
     default:
         break;
     }
@@ -640,13 +660,31 @@ static void wifi7_mlo_tx_handler(struct work_struct *work)
     struct wifi7_mlo *mlo = container_of(work, struct wifi7_mlo,
                                        frames.tx_work.work);
     struct sk_buff *skb;
+    unsigned long delay = 0;
     u8 link_id;
+    int ret;
 
     while ((skb = skb_dequeue(&mlo->frames.tx_queue))) {
         link_id = wifi7_mlo_get_tx_link(mlo->dev, skb);
-        wifi7_mac_tx_frame(mlo->dev, link_id, skb);
+        ret = wifi7_mac_tx_frame(mlo->dev->mac, skb, link_id);
+        if (!ret)
+            continue;
+
+        /* A refused frame is still ours: hold it on -EBUSY, else drop */
+        if (ret == -EBUSY) {
+            skb_queue_head(&mlo->frames.tx_queue, skb);
+            delay = 1;
+            break;
+        }
+        mlo->stats.dropped_frames++;
+        dev_kfree_skb_any(skb);
     }
+    wifi7_mac_tx_flush(mlo->dev->mac);
 
     if (!skb_queue_empty(&mlo->frames.tx_queue))
-        schedule_delayed_work(&mlo->frames.tx_work, 0);
-} 
\ No newline at end of file
+        schedule_delayed_work(&mlo->frames.tx_work, delay);
+}
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/mlo_kunit.c"
+#endif
@@ -0,0 +1,683 @@
+/*
+ * WiFi 7 TX packet generator
+ *
+ * Two delayed works share the device. The generator offers frames to
+ * wifi7_qos_tx_enqueue() every tick, paced by rate_mbps or bounded by
+ * burst. The DMA backend stands in for the hardware rings: each tick it
+ * completes what each link's line rate allows, then refills the ring
+ * from the DRR scheduler. A full QoS queue is where the generator drops;
+ * a full ring or a shaper holding frames back is where the path stalls.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/skbuff.h>
+#include <linux/etherdevice.h>
+#include <linux/ieee80211.h>
+#include <linux/random.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include "wifi7_pktgen.h"
+#include "wifi7_qos.h"
+#include "../../include/perf/perf_latency.h"
+#include "../../include/debug/debug.h"
+
+#define WIFI7_PKTGEN_MIN_LEN \
+    (sizeof(struct ieee80211_qos_hdr) + sizeof(struct wifi7_pktgen_hdr))
+
+struct wifi7_pktgen_link_stats {
+    u64 sent;
+    u64 sent_bytes;
+    u64 completed;
+    u64 completed_bytes;
+    u64 held;               /* Ticks the shapers held queued frames back */
+    u64 ring_full;          /* Ticks frames waited for a free descriptor */
+};
+
+struct wifi7_pktgen_stats {
+    struct wifi7_pktgen_link_stats links[WIFI7_MAX_LINKS];
+    u64 offered;
+    u64 drop_alloc;         /* skb allocation failed */
+    u64 drop_queue_full;    /* QoS queue at WIFI7_QOS_MAX_QUEUE_LEN */
+    u64 drop_rejected;      /* QoS refused the frame outright */
+    u64 lat_sum_ns;         /* Enqueue to DMA completion */
+    u64 lat_max_ns;
+    ktime_t start;
+    ktime_t last_offer;
+    ktime_t last_done;
+};
+
+struct wifi7_pktgen {
+    struct wifi7_dev *dev;
+    struct wifi7_pktgen_config config;  /* Written through debugfs */
+    struct wifi7_pktgen_config run;     /* Snapshot taken at start */
+    struct wifi7_pktgen_stats stats;
+    spinlock_t lock;                    /* stats */
+    struct mutex conf_lock;             /* config, start, stop, reset */
+
+    /* Generator */
+    struct delayed_work gen_work;
+    ktime_t gen_last;
+    u64 gen_credit;                     /* Bytes it may offer under rate */
+    u32 seq;
+    u16 tid_seq[WIFI7_NUM_TIDS];
+    bool running;
+
+    /* Simulated DMA backend */
+    struct delayed_work dma_work;
+    struct sk_buff_head rings[WIFI7_MAX_LINKS];
+    u64 credit[WIFI7_MAX_LINKS];        /* Bytes each link may complete */
+    ktime_t dma_last;
+    bool draining;
+
+    struct dentry *dir;
+};
+
+/* The (n % weight)th set bit of a non-zero @mask */
+static u8 wifi7_pktgen_nth(u32 mask, u32 n)
+{
+    n %= hweight32(mask);
+    while (n--)
+        mask &= mask - 1;
+    return __ffs(mask);
+}
+
+static struct sk_buff *wifi7_pktgen_build(struct wifi7_pktgen *pg, u8 tid,
+                                          u32 len)
+{
+    const struct wifi7_pktgen_config *cfg = &pg->run;
+    struct ieee80211_qos_hdr *hdr;
+    struct wifi7_pktgen_hdr *ph;
+    struct sk_buff *skb;
+    u16 sta;
+
+    skb = alloc_skb(len, GFP_KERNEL);
+    if (!skb)
+        return NULL;
+
+    hdr = skb_put_zero(skb, len);
+    hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA |
+                                     IEEE80211_STYPE_QOS_DATA);
+    hdr->seq_ctrl = cpu_to_le16(IEEE80211_SN_TO_SEQ(pg->tid_seq[tid]));
+    hdr->qos_ctrl = cpu_to_le16(tid & IEEE80211_QOS_CTL_TID_MASK);
+    pg->tid_seq[tid] = (pg->tid_seq[tid] + 1) & 0xFFF;
+
+    /* Stations count up from dst in the last two octets */
+    ether_addr_copy(hdr->addr1, cfg->dst);
+    sta = ((hdr->addr1[4] << 8) | hdr->addr1[5]) + pg->seq % cfg->num_dst;
+    hdr->addr1[4] = sta >> 8;
+    hdr->addr1[5] = sta & 0xFF;
+    ether_addr_copy(hdr->addr3, hdr->addr1);
+
+    ph = (struct wifi7_pktgen_hdr *)(hdr + 1);
+    ph->magic = cpu_to_be32(WIFI7_PKTGEN_MAGIC);
+    ph->seq = cpu_to_be32(pg->seq++);
+    ph->tstamp_ns = cpu_to_be64(ktime_get_ns());
+
+    return skb;
+}
+
+static void wifi7_pktgen_xmit(struct wifi7_pktgen *pg, u32 len)
+{
+    const struct wifi7_pktgen_config *cfg = &pg->run;
+    struct wifi7_pktgen_link_stats *ls;
+    struct sk_buff *skb;
+    u8 tid, link_id;
+    int ret;
+
+    /* Every TID in turn, then the next link */
+    tid = wifi7_pktgen_nth(cfg->tid_mask, pg->seq);
+    link_id = wifi7_pktgen_nth(cfg->link_mask,
+                               pg->seq / hweight32(cfg->tid_mask));
+    ls = &pg->stats.links[link_id];
+
+    skb = wifi7_pktgen_build(pg, tid, len);
+    ret = skb ? wifi7_qos_tx_enqueue(pg->dev, skb, link_id, tid) : -ENOMEM;
+    if (ret && skb)
+        dev_kfree_skb(skb);
+
+    spin_lock_bh(&pg->lock);
+    pg->stats.offered++;
+    pg->stats.last_offer = ktime_get();
+    switch (ret) {
+    case 0:
+        ls->sent++;
+        ls->sent_bytes += len;
+        break;
+    case -ENOMEM:
+        pg->stats.drop_alloc++;
+        break;
+    case -ENOSPC:
+        pg->stats.drop_queue_full++;
+        break;
+    default:
+        pg->stats.drop_rejected++;
+        break;
+    }
+    spin_unlock_bh(&pg->lock);
+}
+
+static void wifi7_pktgen_gen_work(struct work_struct *work)
+{
+    struct wifi7_pktgen *pg = container_of(to_delayed_work(work),
+                                           struct wifi7_pktgen, gen_work);
+    const struct wifi7_pktgen_config *cfg = &pg->run;
+    ktime_t now = ktime_get();
+    u32 n, len;
+
+    /* Offered bytes since the last tick, banking at most one burst */
+    if (cfg->rate_mbps) {
+        pg->gen_credit += div_u64((u64)cfg->rate_mbps *
+                                  ktime_to_ns(ktime_sub(now, pg->gen_last)),
+                                  8000);
+        pg->gen_credit = min_t(u64, pg->gen_credit,
+                               (u64)cfg->burst * cfg->max_len);
+    }
+    pg->gen_last = now;
+
+    for (n = 0; ; n++) {
+        if (!cfg->rate_mbps && n >= cfg->burst)
+            break;
+
+        if (!READ_ONCE(pg->running))
+            return;
+
+        if (cfg->count && pg->stats.offered >= cfg->count) {
+            WRITE_ONCE(pg->running, false);
+            return;
+        }
+
+        len = cfg->min_len;
+        if (cfg->max_len > cfg->min_len)
+            len += get_random_u32() % (cfg->max_len - cfg->min_len + 1);
+
+        if (cfg->rate_mbps) {
+            if (pg->gen_credit < len)
+                break;
+            pg->gen_credit -= len;
+        }
+
+        wifi7_pktgen_xmit(pg, len);
+    }
+
+    schedule_delayed_work(&pg->gen_work, 1);
+}
+
+static void wifi7_pktgen_complete(struct wifi7_pktgen *pg, u8 link_id,
+                                  struct sk_buff *skb, ktime_t now)
+{
+    struct wifi7_pktgen_link_stats *ls = &pg->stats.links[link_id];
+    struct wifi7_pktgen_hdr *ph;
+    u8 tid = skb->priority & IEEE80211_QOS_CTL_TID_MASK;
+    u64 lat = 0;
+
+    /* Other traffic on the link completes too, without a timestamp */
+    ph = (struct wifi7_pktgen_hdr *)(skb->data +
+                                     sizeof(struct ieee80211_qos_hdr));
+    if (skb->len >= WIFI7_PKTGEN_MIN_LEN &&
+        be32_to_cpu(ph->magic) == WIFI7_PKTGEN_MAGIC)
+        lat = ktime_to_ns(now) - be64_to_cpu(ph->tstamp_ns);
+
+    wifi7_qos_tx_status(pg->dev, tid, true, pg->run.dma_rate_mbps, 0);
+    wifi67_lat_tx_done(pg->dev->priv, skb, link_id);
+
+    spin_lock_bh(&pg->lock);
+    ls->completed++;
+    ls->completed_bytes += skb->len;
+    pg->stats.lat_sum_ns += lat;
+    pg->stats.lat_max_ns = max(pg->stats.lat_max_ns, lat);
+    pg->stats.last_done = now;
+    spin_unlock_bh(&pg->lock);
+
+    dev_kfree_skb(skb);
+}
+
+static void wifi7_pktgen_dma_work(struct work_struct *work)
+{
+    struct wifi7_pktgen *pg = container_of(to_delayed_work(work),
+                                           struct wifi7_pktgen, dma_work);
+    const struct wifi7_pktgen_config *cfg = &pg->run;
+    ktime_t now = ktime_get();
+    u64 elapsed = ktime_to_ns(ktime_sub(now, pg->dma_last));
+    struct sk_buff_head *ring;
+    struct sk_buff *skb;
+    bool busy = false;
+    u32 pending;
+    int i;
+
+    pg->dma_last = now;
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++) {
+        if (!(cfg->link_mask & BIT(i)))
+            continue;
+
+        ring = &pg->rings[i];
+
+        /* Airtime earned since the last tick; an idle link banks none */
+        if (skb_queue_empty(ring))
+            pg->credit[i] = 0;
+        else
+            pg->credit[i] += div_u64((u64)cfg->dma_rate_mbps * elapsed,
+                                     8000);
+
+        while ((skb = skb_peek(ring)) && skb->len <= pg->credit[i]) {
+            __skb_unlink(skb, ring);
+            pg->credit[i] -= skb->len;
+            wifi7_pktgen_complete(pg, i, skb, now);
+        }
+
+        /* Airtime left over once the ring runs dry is lost */
+        if (skb_queue_empty(ring))
+            pg->credit[i] = 0;
+
+        /* Post what the scheduler releases into the free descriptors */
+        while (skb_queue_len(ring) < cfg->ring_size) {
+            skb = wifi7_qos_tx_dequeue(pg->dev, i);
+            if (!skb)
+                break;
+            wifi67_lat_stamp(skb, WIFI67_LAT_DMA_POST);
+            __skb_queue_tail(ring, skb);
+        }
+
+        /* Frames left behind either had no descriptor or a shaper said no */
+        pending = wifi7_qos_tx_pending(pg->dev, i);
+        if (pending) {
+            spin_lock_bh(&pg->lock);
+            if (skb_queue_len(ring) >= cfg->ring_size)
+                pg->stats.links[i].ring_full++;
+            else
+                pg->stats.links[i].held++;
+            spin_unlock_bh(&pg->lock);
+        }
+
+        busy |= pending || !skb_queue_empty(ring);
+    }
+
+    if (busy || READ_ONCE(pg->running))
+        schedule_delayed_work(&pg->dma_work, 1);
+    else
+        WRITE_ONCE(pg->draining, false);
+}
+
+static int wifi7_pktgen_check(const struct wifi7_pktgen_config *cfg)
+{
+    if (cfg->min_len < WIFI7_PKTGEN_MIN_LEN ||
+        cfg->min_len > WIFI7_PKTGEN_MAX_LEN ||
+        cfg->max_len > WIFI7_PKTGEN_MAX_LEN)
+        return -EINVAL;
+
+    if (!(cfg->tid_mask & GENMASK(WIFI7_NUM_TIDS - 1, 0)) ||
+        (cfg->tid_mask & ~GENMASK(WIFI7_NUM_TIDS - 1, 0)) ||
+        !(cfg->link_mask & GENMASK(WIFI7_MAX_LINKS - 1, 0)) ||
+        (cfg->link_mask & ~GENMASK(WIFI7_MAX_LINKS - 1, 0)))
+        return -EINVAL;
+
+    if (!cfg->burst || !cfg->num_dst || !cfg->dma_rate_mbps ||
+        !cfg->ring_size || cfg->ring_size > WIFI7_PKTGEN_MAX_RING)
+        return -EINVAL;
+
+    if (!is_valid_ether_addr(cfg->dst))
+        return -EINVAL;
+
+    return 0;
+}
+
+int wifi7_pktgen_set_config(struct wifi7_dev *dev,
+                            const struct wifi7_pktgen_config *config)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+
+    if (!pg)
+        return -ENODEV;
+
+    mutex_lock(&pg->conf_lock);
+    pg->config = *config;
+    mutex_unlock(&pg->conf_lock);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_set_config);
+
+int wifi7_pktgen_get_config(struct wifi7_dev *dev,
+                            struct wifi7_pktgen_config *config)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+
+    if (!pg)
+        return -ENODEV;
+
+    mutex_lock(&pg->conf_lock);
+    *config = pg->config;
+    mutex_unlock(&pg->conf_lock);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_get_config);
+
+bool wifi7_pktgen_busy(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+
+    return pg && (READ_ONCE(pg->running) || READ_ONCE(pg->draining));
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_busy);
+
+int wifi7_pktgen_start(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+    struct wifi7_pktgen_config *cfg;
+    ktime_t now;
+    int ret;
+
+    if (!pg)
+        return -ENODEV;
+    if (!dev->qos)
+        return -ENETDOWN;
+
+    mutex_lock(&pg->conf_lock);
+
+    if (wifi7_pktgen_busy(dev)) {
+        ret = -EBUSY;
+        goto out;
+    }
+
+    ret = wifi7_pktgen_check(&pg->config);
+    if (ret)
+        goto out;
+
+    cfg = &pg->run;
+    *cfg = pg->config;
+    cfg->max_len = max(cfg->max_len, cfg->min_len);
+
+    now = ktime_get();
+    memset(&pg->stats, 0, sizeof(pg->stats));
+    memset(pg->credit, 0, sizeof(pg->credit));
+    pg->stats.start = now;
+    pg->gen_last = now;
+    pg->dma_last = now;
+    pg->gen_credit = 0;
+    pg->seq = 0;
+
+    WRITE_ONCE(pg->running, true);
+    WRITE_ONCE(pg->draining, true);
+    schedule_delayed_work(&pg->gen_work, 0);
+    schedule_delayed_work(&pg->dma_work, 1);
+
+    wifi67_info(dev->priv, WIFI67_LOG_MAC,
+                "pktgen: %u frames of %u-%u bytes, tids 0x%x, links 0x%x\n",
+                cfg->count, cfg->min_len, cfg->max_len, cfg->tid_mask,
+                cfg->link_mask);
+out:
+    mutex_unlock(&pg->conf_lock);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_start);
+
+/* Stops offering frames; the DMA backend still drains what was queued */
+void wifi7_pktgen_stop(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+
+    if (!pg)
+        return;
+
+    mutex_lock(&pg->conf_lock);
+    WRITE_ONCE(pg->running, false);
+    cancel_delayed_work_sync(&pg->gen_work);
+    mutex_unlock(&pg->conf_lock);
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_stop);
+
+int wifi7_pktgen_reset(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+    int ret = 0;
+
+    if (!pg)
+        return -ENODEV;
+
+    mutex_lock(&pg->conf_lock);
+    if (wifi7_pktgen_busy(dev)) {
+        ret = -EBUSY;
+    } else {
+        spin_lock_bh(&pg->lock);
+        memset(&pg->stats, 0, sizeof(pg->stats));
+        spin_unlock_bh(&pg->lock);
+    }
+    mutex_unlock(&pg->conf_lock);
+
+    return ret;
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_reset);
+
+/* Debugfs interface */
+static int wifi7_pktgen_stats_show(struct seq_file *m, void *v)
+{
+    struct wifi7_dev *dev = m->private;
+    struct wifi7_pktgen *pg = dev->pktgen;
+    const struct wifi7_pktgen_config *cfg = &pg->run;
+    struct wifi7_pktgen_stats s;
+    u64 sent = 0, sent_bytes = 0, done = 0, done_bytes = 0;
+    u64 offer_us, done_us;
+    int i;
+
+    spin_lock_bh(&pg->lock);
+    s = pg->stats;
+    spin_unlock_bh(&pg->lock);
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++) {
+        sent += s.links[i].sent;
+        sent_bytes += s.links[i].sent_bytes;
+        done += s.links[i].completed;
+        done_bytes += s.links[i].completed_bytes;
+    }
+
+    /* Rates are over the time frames were offered and completed */
+    offer_us = s.offered ? ktime_us_delta(s.last_offer, s.start) : 0;
+    done_us = done ? ktime_us_delta(s.last_done, s.start) : 0;
+
+    seq_printf(m, "state: %s\n",
+               READ_ONCE(pg->running) ? "running" :
+               READ_ONCE(pg->draining) ? "draining" : "idle");
+    seq_printf(m, "config: count %u len %u-%u rate %u Mbps burst %u "
+               "tids 0x%x links 0x%x stations %u ring %u dma %u Mbps\n",
+               cfg->count, cfg->min_len, cfg->max_len, cfg->rate_mbps,
+               cfg->burst, cfg->tid_mask, cfg->link_mask, cfg->num_dst,
+               cfg->ring_size, cfg->dma_rate_mbps);
+    seq_printf(m, "offered: %llu frames over %llu us\n", s.offered,
+               offer_us);
+    seq_printf(m, "sent: %llu frames %llu bytes, %llu Mbps\n", sent,
+               sent_bytes, offer_us ? div64_u64(sent_bytes * 8, offer_us) : 0);
+    seq_printf(m, "completed: %llu frames %llu bytes over %llu us, "
+               "%llu Mbps, %llu pps\n", done, done_bytes, done_us,
+               done_us ? div64_u64(done_bytes * 8, done_us) : 0,
+               done_us ? div64_u64(done * USEC_PER_SEC, done_us) : 0);
+    seq_printf(m, "dropped: alloc %llu queue_full %llu rejected %llu\n",
+               s.drop_alloc, s.drop_queue_full, s.drop_rejected);
+    seq_printf(m, "latency: avg %llu us max %llu us\n",
+               done ? div64_u64(s.lat_sum_ns, done * NSEC_PER_USEC) : 0,
+               div_u64(s.lat_max_ns, NSEC_PER_USEC));
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++) {
+        struct wifi7_pktgen_link_stats *ls = &s.links[i];
+
+        if (!(cfg->link_mask & BIT(i)))
+            continue;
+        seq_printf(m, "link %d: sent %llu completed %llu bytes %llu "
+                   "held %llu ring_full %llu\n", i, ls->sent, ls->completed,
+                   ls->completed_bytes, ls->held, ls->ring_full);
+    }
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(wifi7_pktgen_stats);
+
+static ssize_t wifi7_pktgen_ctrl_write(struct file *file,
+                                       const char __user *ubuf,
+                                       size_t count, loff_t *ppos)
+{
+    struct wifi7_dev *dev = file->private_data;
+    char buf[16];
+    int ret = 0;
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sysfs_streq(buf, "start"))
+        ret = wifi7_pktgen_start(dev);
+    else if (sysfs_streq(buf, "stop"))
+        wifi7_pktgen_stop(dev);
+    else if (sysfs_streq(buf, "reset"))
+        ret = wifi7_pktgen_reset(dev);
+    else
+        ret = -EINVAL;
+
+    return ret ? ret : count;
+}
+
+static const struct file_operations wifi7_pktgen_ctrl_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .write = wifi7_pktgen_ctrl_write,
+    .llseek = default_llseek,
+};
+
+static ssize_t wifi7_pktgen_dst_read(struct file *file, char __user *ubuf,
+                                     size_t count, loff_t *ppos)
+{
+    struct wifi7_pktgen *pg = file->private_data;
+    char buf[32];
+    int len;
+
+    mutex_lock(&pg->conf_lock);
+    len = scnprintf(buf, sizeof(buf), "%pM\n", pg->config.dst);
+    mutex_unlock(&pg->conf_lock);
+
+    return simple_read_from_buffer(ubuf, count, ppos, buf, len);
+}
+
+static ssize_t wifi7_pktgen_dst_write(struct file *file,
+                                      const char __user *ubuf,
+                                      size_t count, loff_t *ppos)
+{
+    struct wifi7_pktgen *pg = file->private_data;
+    char buf[32];
+    u8 addr[ETH_ALEN];
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (!mac_pton(strim(buf), addr))
+        return -EINVAL;
+
+    mutex_lock(&pg->conf_lock);
+    ether_addr_copy(pg->config.dst, addr);
+    mutex_unlock(&pg->conf_lock);
+
+    return count;
+}
+
+static const struct file_operations wifi7_pktgen_dst_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .read = wifi7_pktgen_dst_read,
+    .write = wifi7_pktgen_dst_write,
+    .llseek = default_llseek,
+};
+
+static void wifi7_pktgen_debugfs_init(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+    struct wifi7_pktgen_config *cfg = &pg->config;
+
+    pg->dir = debugfs_create_dir("pktgen", dev->debugfs_dir);
+
+    debugfs_create_u32("count", 0644, pg->dir, &cfg->count);
+    debugfs_create_u32("min_len", 0644, pg->dir, &cfg->min_len);
+    debugfs_create_u32("max_len", 0644, pg->dir, &cfg->max_len);
+    debugfs_create_u32("rate_mbps", 0644, pg->dir, &cfg->rate_mbps);
+    debugfs_create_u32("burst", 0644, pg->dir, &cfg->burst);
+    debugfs_create_x32("tid_mask", 0644, pg->dir, &cfg->tid_mask);
+    debugfs_create_x32("link_mask", 0644, pg->dir, &cfg->link_mask);
+    debugfs_create_u32("num_dst", 0644, pg->dir, &cfg->num_dst);
+    debugfs_create_u32("ring_size", 0644, pg->dir, &cfg->ring_size);
+    debugfs_create_u32("dma_rate_mbps", 0644, pg->dir, &cfg->dma_rate_mbps);
+    debugfs_create_file("dst", 0644, pg->dir, pg, &wifi7_pktgen_dst_fops);
+    debugfs_create_file("ctrl", 0200, pg->dir, dev, &wifi7_pktgen_ctrl_fops);
+    debugfs_create_file("stats", 0444, pg->dir, dev,
+                        &wifi7_pktgen_stats_fops);
+}
+
+int wifi7_pktgen_init(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg;
+    int i;
+
+    pg = kzalloc(sizeof(*pg), GFP_KERNEL);
+    if (!pg)
+        return -ENOMEM;
+
+    pg->dev = dev;
+    spin_lock_init(&pg->lock);
+    mutex_init(&pg->conf_lock);
+    INIT_DELAYED_WORK(&pg->gen_work, wifi7_pktgen_gen_work);
+    INIT_DELAYED_WORK(&pg->dma_work, wifi7_pktgen_dma_work);
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++)
+        skb_queue_head_init(&pg->rings[i]);
+
+    pg->config = (struct wifi7_pktgen_config) {
+        .count = WIFI7_PKTGEN_DEF_COUNT,
+        .min_len = WIFI7_PKTGEN_DEF_LEN,
+        .max_len = WIFI7_PKTGEN_DEF_LEN,
+        .burst = WIFI7_PKTGEN_DEF_BURST,
+        .tid_mask = BIT(0),
+        .link_mask = BIT(0),
+        .num_dst = 1,
+        .dst = { 0x02, 0x00, 0x00, 0x00, 0x01, 0x00 },
+        .ring_size = WIFI7_PKTGEN_DEF_RING,
+        .dma_rate_mbps = WIFI7_PKTGEN_DEF_DMA_RATE,
+    };
+    pg->run = pg->config;
+
+    dev->pktgen = pg;
+    wifi7_pktgen_debugfs_init(dev);
+    return 0;
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_init);
+
+/* Frames still posted to the simulated rings are dropped, not completed */
+void wifi7_pktgen_deinit(struct wifi7_dev *dev)
+{
+    struct wifi7_pktgen *pg = dev->pktgen;
+    int i;
+
+    if (!pg)
+        return;
+
+    debugfs_remove_recursive(pg->dir);
+
+    WRITE_ONCE(pg->running, false);
+    cancel_delayed_work_sync(&pg->gen_work);
+    cancel_delayed_work_sync(&pg->dma_work);
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++)
+        __skb_queue_purge(&pg->rings[i]);
+
+    mutex_destroy(&pg->conf_lock);
+    kfree(pg);
+    dev->pktgen = NULL;
+}
+EXPORT_SYMBOL_GPL(wifi7_pktgen_deinit);
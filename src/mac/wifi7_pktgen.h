@@ -0,0 +1,81 @@
+/*
+ * WiFi 7 TX packet generator
+ *
+ * Builds QoS data frames in the driver and injects them straight into the
+ * QoS layer's per-link TID queues, with no network stack or mac80211
+ * above. A simulated DMA backend drains those queues through the DRR
+ * scheduler and completes frames at a configured per-link line rate, so
+ * the TX path can be driven at full load and measured without a radio.
+ *
+ * Everything is controlled from debugfs, under pktgen/ in the device
+ * directory:
+ *
+ *   count, min_len, max_len, rate_mbps, burst, tid_mask, link_mask,
+ *   num_dst, dst, ring_size, dma_rate_mbps   parameters, read at start
+ *   ctrl                                      "start", "stop" or "reset"
+ *   stats                                     rates, drop points, latency
+ *
+ * While a run is in progress the generator owns the links in link_mask:
+ * nothing else may dequeue from their QoS queues.
+ */
+
+#ifndef __WIFI7_PKTGEN_H
+#define __WIFI7_PKTGEN_H
+
+#include <linux/types.h>
+#include <linux/if_ether.h>
+#include "../core/wifi7_core.h"
+
+#define WIFI7_PKTGEN_MAGIC          0x57375047  /* "W7PG" */
+#define WIFI7_PKTGEN_MAX_LEN        11454       /* Largest EHT MPDU */
+#define WIFI7_PKTGEN_MAX_RING       4096
+
+/* Defaults: one TID on one link, offered as fast as the queues accept */
+#define WIFI7_PKTGEN_DEF_COUNT      10000
+#define WIFI7_PKTGEN_DEF_LEN        1500
+#define WIFI7_PKTGEN_DEF_BURST      64
+#define WIFI7_PKTGEN_DEF_RING       256
+#define WIFI7_PKTGEN_DEF_DMA_RATE   2402        /* 2x2 160 MHz MCS 11 */
+
+struct wifi7_pktgen_config {
+    u32 count;              /* Frames to offer, 0 to run until stopped */
+    u32 min_len;            /* Sizes are uniform over [min_len, max_len] */
+    u32 max_len;
+    u32 rate_mbps;          /* Offered load, 0 for one burst per tick */
+    u32 burst;              /* Frames per tick, or frames banked if paced */
+    u32 tid_mask;           /* TIDs, links and stations are used */
+    u32 link_mask;          /* round-robin */
+    u32 num_dst;            /* Stations dst, dst + 1, ... */
+    u8 dst[ETH_ALEN];
+
+    /* Simulated DMA backend */
+    u32 ring_size;          /* Descriptors per link */
+    u32 dma_rate_mbps;      /* Line rate each link completes at */
+};
+
+/* Carried after the 802.11 header of every generated frame */
+struct wifi7_pktgen_hdr {
+    __be32 magic;
+    __be32 seq;
+    __be64 tstamp_ns;       /* Enqueue time */
+} __packed;
+
+#if IS_ENABLED(CONFIG_WIFI7_MAC_PKTGEN)
+int wifi7_pktgen_init(struct wifi7_dev *dev);
+void wifi7_pktgen_deinit(struct wifi7_dev *dev);
+
+int wifi7_pktgen_set_config(struct wifi7_dev *dev,
+                            const struct wifi7_pktgen_config *config);
+int wifi7_pktgen_get_config(struct wifi7_dev *dev,
+                            struct wifi7_pktgen_config *config);
+
+int wifi7_pktgen_start(struct wifi7_dev *dev);
+void wifi7_pktgen_stop(struct wifi7_dev *dev);
+int wifi7_pktgen_reset(struct wifi7_dev *dev);
+bool wifi7_pktgen_busy(struct wifi7_dev *dev);
+#else
+static inline int wifi7_pktgen_init(struct wifi7_dev *dev) { return 0; }
+static inline void wifi7_pktgen_deinit(struct wifi7_dev *dev) {}
+#endif
+
+#endif /* __WIFI7_PKTGEN_H */
@@ -20,6 +20,7 @@
 
 #include "wifi7_power.h"
 #include "../core/wifi7_core.h"
+#include "../../include/debug/wifi67_trace.h"
 
 /* Helper Functions */
 
@@ -92,6 +93,7 @@ static void wifi7_pm_twt_work_handler(struct work_struct *work)
     struct wifi7_pm *pm = container_of(work, struct wifi7_pm,
                                      twt_work.work);
     unsigned long flags;
+    u32 next;
     int i;
 
     spin_lock_irqsave(&pm->twt_lock, flags);
@@ -112,8 +114,12 @@ static void wifi7_pm_twt_work_handler(struct work_struct *work)
             }
 
             /* Calculate next wake time */
-            flow->target_wake_time += (1 << flow->wake_interval_exp) *
-                                    flow->wake_interval_mantissa;
+            next = flow->target_wake_time +
+                   (1 << flow->wake_interval_exp) *
+                   flow->wake_interval_mantissa;
+            trace_wifi67_twt_sp(flow->flow_id, flow->target_wake_time,
+                                flow->wake_duration, next);
+            flow->target_wake_time = next;
         }
     }
 
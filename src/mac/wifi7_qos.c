@@ -27,6 +27,8 @@
 #include "wifi7_qos.h"
 #include "wifi7_mac.h"
 #include "wifi7_mlo.h"
+#include "../../include/perf/perf_latency.h"
+#include "../../include/debug/debug.h"
 
 /* Token bucket parameters */
 #define WIFI7_TOKEN_SHIFT      20
@@ -64,8 +66,9 @@ struct wifi7_rate_ctrl {
     bool ml_active;
 };
 
-/* Enhanced link state */
-struct wifi7_link_state {
+/* Per-link queues and shaping state */
+struct wifi7_qos_link {
+    struct sk_buff_head queues[WIFI7_NUM_TIDS];
     struct wifi7_shaper shaper;
     struct wifi7_rate_ctrl rate;
     u32 airtime_used;
@@ -114,13 +117,13 @@ struct wifi7_tid_state {
 /* Main QoS structure */
 struct wifi7_qos {
     /* Enhanced state tracking */
-    struct wifi7_link_state links[WIFI7_MAX_LINKS];
+    struct wifi7_qos_link links[WIFI7_MAX_LINKS];
     struct wifi7_tid_state tids[WIFI7_NUM_TIDS];
     struct wifi7_mlo_predict mlo;
     
     /* DRR scheduling */
     u32 quantum[WIFI7_NUM_TIDS];
-    u32 deficit[WIFI7_NUM_TIDS];
+    s32 deficit[WIFI7_NUM_TIDS];
     
     /* Power management */
     bool power_save;
@@ -160,8 +163,10 @@ static void wifi7_shaper_update_tokens(struct wifi7_shaper *sh)
     u64 elapsed = ktime_us_delta(now, sh->last_update);
     u64 tokens;
     
-    tokens = elapsed * sh->rate >> WIFI7_TOKEN_SHIFT;
-    sh->tokens = min_t(u64, sh->tokens + tokens, sh->burst << WIFI7_TOKEN_SHIFT);
+    /* rate is bytes per microsecond in WIFI7_TOKEN_SHIFT fixed point */
+    tokens = elapsed * sh->rate;
+    sh->tokens = min_t(u64, sh->tokens + tokens,
+                       (u64)sh->burst << WIFI7_TOKEN_SHIFT);
     sh->last_update = now;
 }
 
@@ -250,40 +255,51 @@ static void wifi7_rate_update(struct wifi7_rate_ctrl *rc,
 static struct sk_buff *wifi7_drr_dequeue(struct wifi7_qos *qos, u8 link_id)
 {
     struct sk_buff *skb = NULL;
-    int i;
-    
-    for (i = 0; i < WIFI7_NUM_TIDS; i++) {
-        struct wifi7_tid_state *ts = &qos->tids[i];
-        
-        if (!ts->active || ts->queue_len == 0)
-            continue;
+    int i, pass;
+    
+    /*
+     * A TID that sent on the last call can start in deficit and is only
+     * topped back up on the way out. A second pass gives it its quantum,
+     * so NULL means every queued frame is held by a shaper.
+     */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < WIFI7_NUM_TIDS; i++) {
+            struct wifi7_tid_state *ts = &qos->tids[i];
             
-        qos->deficit[i] += qos->quantum[i];
-        while (qos->deficit[i] > 0 && ts->queue_len > 0) {
-            skb = skb_dequeue(&qos->links[link_id].queues[i]);
-            if (!skb)
-                break;
+            if (!ts->active || ts->queue_len == 0)
+                continue;
                 
-            qos->deficit[i] -= skb->len;
-            ts->queue_len--;
-            ts->bytes_in_flight += skb->len;
-            ts->packets_in_flight++;
-            
-            /* Apply traffic shaping */
-            if (!wifi7_shaper_allow(&ts->shaper, skb->len)) {
-                skb_queue_head(&qos->links[link_id].queues[i], skb);
-                ts->queue_len++;
-                ts->bytes_in_flight -= skb->len;
-                ts->packets_in_flight--;
-                goto next_tid;
+            qos->deficit[i] += qos->quantum[i];
+            while (qos->deficit[i] > 0 && ts->queue_len > 0) {
+                skb = skb_dequeue(&qos->links[link_id].queues[i]);
+                if (!skb)
+                    break;
+                    
+                qos->deficit[i] -= (s32)skb->len;
+                ts->queue_len--;
+                ts->bytes_in_flight += skb->len;
+                ts->packets_in_flight++;
+                
+                /* Apply traffic shaping */
+                if (!wifi7_shaper_allow(&ts->shaper, skb->len)) {
+                    wifi67_dbg(NULL, WIFI67_LOG_QOS,
+                               "tid %d link %u held by shaper\n", i, link_id);
+                    skb_queue_head(&qos->links[link_id].queues[i], skb);
+                    qos->deficit[i] += (s32)skb->len;
+                    ts->queue_len++;
+                    ts->bytes_in_flight -= skb->len;
+                    ts->packets_in_flight--;
+                    goto next_tid;
+                }
+                
+                wifi67_lat_stamp(skb, WIFI67_LAT_DEQUEUE);
+                return skb;
             }
             
-            return skb;
-        }
-        
 next_tid:
-        if (qos->deficit[i] <= 0)
-            qos->deficit[i] = 0;
+            if (qos->deficit[i] <= 0)
+                qos->deficit[i] = 0;
+        }
     }
     
     return NULL;
@@ -318,10 +334,13 @@ static void wifi7_power_update(struct wifi7_qos *qos)
 /* Statistics collection */
 static void wifi7_update_stats(struct wifi7_qos *qos)
 {
+    unsigned long flags;
     int i;
     
+    /* The per-link counters are bumped by the TX path under qos->lock */
+    spin_lock_irqsave(&qos->lock, flags);
     for (i = 0; i < WIFI7_MAX_LINKS; i++) {
-        struct wifi7_link_state *ls = &qos->links[i];
+        struct wifi7_qos_link *ls = &qos->links[i];
         
         qos->stats.bytes_tx += ls->tx_bytes;
         qos->stats.bytes_rx += ls->rx_bytes;
@@ -337,6 +356,7 @@ static void wifi7_update_stats(struct wifi7_qos *qos)
         ls->dropped = 0;
         ls->retries = 0;
     }
+    spin_unlock_irqrestore(&qos->lock, flags);
 }
 
 /* Periodic work handlers */
@@ -357,17 +377,29 @@ static void wifi7_tune_work(struct work_struct *work)
 {
     struct wifi7_qos *qos = container_of(to_delayed_work(work),
                                        struct wifi7_qos, tune_work);
+    unsigned long flags;
     int i;
     
+    /*
+     * The rate estimate is kept under qos->lock; the shaper lock nests
+     * inside it, as on the dequeue path.
+     */
+    spin_lock_irqsave(&qos->lock, flags);
+
     /* Tune shapers based on link conditions */
     for (i = 0; i < WIFI7_NUM_TIDS; i++) {
         struct wifi7_tid_state *ts = &qos->tids[i];
-        if (ts->active) {
+        /* No TX status yet means no estimate; keep the configured rate */
+        if (ts->active && ts->rate.target_rate) {
+            spin_lock(&ts->shaper.lock);
             ts->shaper.rate = ts->rate.target_rate;
-            ts->shaper.burst = min_t(u32, ts->rate.target_rate / 4,
-                                   WIFI7_MAX_BURST);
+            ts->shaper.burst = clamp_t(u32, ts->rate.target_rate / 4,
+                                     WIFI7_MIN_BURST, WIFI7_MAX_BURST);
+            spin_unlock(&ts->shaper.lock);
         }
     }
+
+    spin_unlock_irqrestore(&qos->lock, flags);
     
     if (qos->active)
         schedule_delayed_work(&qos->tune_work, HZ);
@@ -377,7 +409,7 @@ static void wifi7_tune_work(struct work_struct *work)
 int wifi7_qos_init(struct wifi7_dev *dev)
 {
     struct wifi7_qos *qos;
-    int i;
+    int i, j;
     
     qos = kzalloc(sizeof(*qos), GFP_KERNEL);
     if (!qos)
@@ -386,16 +418,24 @@ int wifi7_qos_init(struct wifi7_dev *dev)
     spin_lock_init(&qos->lock);
     mutex_init(&qos->conf_lock);
     spin_lock_init(&qos->mlo.lock);
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++)
+        for (j = 0; j < WIFI7_NUM_TIDS; j++)
+            skb_queue_head_init(&qos->links[i].queues[j]);
     
     /* Initialize shapers */
     for (i = 0; i < WIFI7_NUM_TIDS; i++) {
         struct wifi7_tid_state *ts = &qos->tids[i];
         spin_lock_init(&ts->shaper.lock);
         ts->shaper.rate = WIFI7_MIN_RATE_BPS;
-        ts->shaper.burst = WIFI7_MIN_BURST;
+        ts->shaper.burst = WIFI7_MAX_BURST;
         ts->shaper.mpu = 256;
         ts->shaper.overhead = 24;  /* MAC header */
+        /* Start full so the first burst is not held back */
+        ts->shaper.tokens = (u64)ts->shaper.burst << WIFI7_TOKEN_SHIFT;
         ts->shaper.last_update = ktime_get();
+        ts->rate.max_rate = WIFI7_MAX_RATE_BPS;
+        ts->rate.min_rate = WIFI7_MIN_RATE_BPS;
     }
     
     /* Initialize DRR */
@@ -424,6 +464,7 @@ EXPORT_SYMBOL_GPL(wifi7_qos_init);
 void wifi7_qos_deinit(struct wifi7_dev *dev)
 {
     struct wifi7_qos *qos = dev->qos;
+    int i, j;
     
     if (!qos)
         return;
@@ -431,6 +472,10 @@ void wifi7_qos_deinit(struct wifi7_dev *dev)
     qos->active = false;
     cancel_delayed_work_sync(&qos->stats_work);
     cancel_delayed_work_sync(&qos->tune_work);
+
+    for (i = 0; i < WIFI7_MAX_LINKS; i++)
+        for (j = 0; j < WIFI7_NUM_TIDS; j++)
+            skb_queue_purge(&qos->links[i].queues[j]);
     
     mutex_destroy(&qos->conf_lock);
     kfree(qos);
@@ -438,6 +483,116 @@ void wifi7_qos_deinit(struct wifi7_dev *dev)
 }
 EXPORT_SYMBOL_GPL(wifi7_qos_deinit);
 
+/* TX path */
+int wifi7_qos_tx_enqueue(struct wifi7_dev *dev, struct sk_buff *skb,
+                         u8 link_id, u8 tid)
+{
+    struct wifi7_qos *qos = dev->qos;
+    struct wifi7_qos_link *ls;
+    struct wifi7_tid_state *ts;
+    unsigned long flags;
+    u32 qlen;
+
+    if (!qos || !qos->active)
+        return -ENODEV;
+    if (link_id >= WIFI7_MAX_LINKS || tid >= WIFI7_NUM_TIDS)
+        return -EINVAL;
+
+    ls = &qos->links[link_id];
+    ts = &qos->tids[tid];
+
+    spin_lock_irqsave(&qos->lock, flags);
+
+    qlen = skb_queue_len(&ls->queues[tid]);
+    if (qlen >= WIFI7_QOS_MAX_QUEUE_LEN) {
+        ls->dropped++;
+        ts->dropped++;
+        spin_unlock_irqrestore(&qos->lock, flags);
+        return -ENOSPC;
+    }
+
+    skb->priority = tid;
+    wifi67_lat_stamp(skb, WIFI67_LAT_ENQUEUE);
+    skb_queue_tail(&ls->queues[tid], skb);
+    ts->queue_len++;
+    ts->active = true;
+    ts->last_pkt_ts = ktime_get();
+    ls->peak_q_depth = max(ls->peak_q_depth, qlen + 1);
+
+    spin_unlock_irqrestore(&qos->lock, flags);
+    return 0;
+}
+EXPORT_SYMBOL_GPL(wifi7_qos_tx_enqueue);
+
+/* NULL with frames still queued means the shapers are holding them */
+struct sk_buff *wifi7_qos_tx_dequeue(struct wifi7_dev *dev, u8 link_id)
+{
+    struct wifi7_qos *qos = dev->qos;
+    struct sk_buff *skb;
+    unsigned long flags;
+
+    if (!qos || link_id >= WIFI7_MAX_LINKS)
+        return NULL;
+
+    spin_lock_irqsave(&qos->lock, flags);
+    skb = wifi7_drr_dequeue(qos, link_id);
+    if (skb) {
+        qos->links[link_id].tx_packets++;
+        qos->links[link_id].tx_bytes += skb->len;
+        qos->links[link_id].last_active = ktime_get();
+    }
+    spin_unlock_irqrestore(&qos->lock, flags);
+
+    return skb;
+}
+EXPORT_SYMBOL_GPL(wifi7_qos_tx_dequeue);
+
+/* rate_mbps is converted to the shaper's bytes-per-microsecond fixed point */
+void wifi7_qos_tx_status(struct wifi7_dev *dev, u8 tid, bool success,
+                         u32 rate_mbps, u8 retries)
+{
+    struct wifi7_qos *qos = dev->qos;
+    struct wifi7_tid_state *ts;
+    unsigned long flags;
+
+    if (!qos || tid >= WIFI7_NUM_TIDS)
+        return;
+
+    ts = &qos->tids[tid];
+
+    spin_lock_irqsave(&qos->lock, flags);
+    if (ts->packets_in_flight) {
+        ts->packets_in_flight--;
+        ts->completed++;
+    }
+    if (retries)
+        ts->retried++;
+
+    wifi7_rate_update(&ts->rate, success,
+                      min_t(u64, (u64)rate_mbps * (WIFI7_TOKEN_SCALE / 8),
+                            U32_MAX),
+                      retries);
+    spin_unlock_irqrestore(&qos->lock, flags);
+}
+EXPORT_SYMBOL_GPL(wifi7_qos_tx_status);
+
+u32 wifi7_qos_tx_pending(struct wifi7_dev *dev, u8 link_id)
+{
+    struct wifi7_qos *qos = dev->qos;
+    u32 pending = 0;
+    int i;
+
+    if (!qos || link_id >= WIFI7_MAX_LINKS)
+        return 0;
+
+    /* A hint only; the queues change under qos->lock while we sum */
+    for (i = 0; i < WIFI7_NUM_TIDS; i++)
+        pending += skb_queue_len_lockless(&qos->links[link_id].queues[i]);
+
+    return pending;
+}
+EXPORT_SYMBOL_GPL(wifi7_qos_tx_pending);
+
 /* Module init/exit */
 static int __init wifi7_qos_init_module(void)
 {
@@ -456,4 +611,8 @@ module_exit(wifi7_qos_exit_module);
 MODULE_LICENSE("MIT");
 MODULE_AUTHOR("Fayssal Chokri <fayssalchokri@gmail.com>");
 MODULE_DESCRIPTION("WiFi 7 QoS Management");
-MODULE_VERSION("1.0"); 
\ No newline at end of file
+MODULE_VERSION("1.0"); 
+
+#if IS_ENABLED(CONFIG_WIFI67_KUNIT_TEST)
+#include "../../hardware_support/tests/kunit/qos_kunit.c"
+#endif
@@ -39,6 +39,9 @@
 #define WIFI7_TC_BESTEFFORT        1
 #define WIFI7_TC_BACKGROUND        0  /* Lowest priority */
 
+/* Frames held per link and TID before enqueue fails with -ENOSPC */
+#define WIFI7_QOS_MAX_QUEUE_LEN    1024
+
 /* QoS configuration */
 struct wifi7_qos_config {
     u32 capabilities;          /* QoS capabilities */
@@ -103,6 +106,14 @@ int wifi7_qos_enqueue(struct wifi7_dev *dev,
 struct sk_buff *wifi7_qos_dequeue(struct wifi7_dev *dev,
                                  u8 tid);
 
+/* Per-link TX path: DRR over the TIDs queued on a link */
+int wifi7_qos_tx_enqueue(struct wifi7_dev *dev, struct sk_buff *skb,
+                         u8 link_id, u8 tid);
+struct sk_buff *wifi7_qos_tx_dequeue(struct wifi7_dev *dev, u8 link_id);
+void wifi7_qos_tx_status(struct wifi7_dev *dev, u8 tid, bool success,
+                         u32 rate_mbps, u8 retries);
+u32 wifi7_qos_tx_pending(struct wifi7_dev *dev, u8 link_id);
+
 int wifi7_qos_start_queue(struct wifi7_dev *dev, u8 tid);
 int wifi7_qos_stop_queue(struct wifi7_dev *dev, u8 tid);
 int wifi7_qos_wake_queue(struct wifi7_dev *dev, u8 tid);
@@ -19,6 +19,7 @@
 #include "wifi7_mac.h"
 #include "../hal/wifi7_rf.h"
 #include "wifi7_mlo.h"
+#include "../../include/debug/wifi67_trace.h"
 
 /* Device state */
 struct wifi7_rate_dev {
@@ -48,6 +49,7 @@ struct wifi7_rate_dev {
         u32 model_size;                 /* Model size */
         spinlock_t lock;                /* Model lock */
     } ml;
+    struct wifi7_rate_entry *last_rate; /* Last selected rate, for tracing */
 };
 
 /* Global device context */
@@ -119,22 +121,39 @@ static void init_rate_table(struct wifi7_rate_table *table)
     }
 }
 
+/*
+ * @rate is the caller's copy from wifi7_rate_select(); the result is
+ * accounted against the table entry of the same MCS, which is what the
+ * selection algorithms and the update work read.
+ */
 static void update_rate_stats(struct wifi7_rate_dev *dev,
                             struct wifi7_rate_entry *rate,
                             bool success)
 {
+    struct wifi7_rate_table *table = &dev->rate_table.table;
+    struct wifi7_rate_entry *entry;
     unsigned long flags;
     u32 now = jiffies_to_msecs(jiffies);
 
-    spin_lock_irqsave(&dev->lock, flags);
-
-    /* Update rate entry statistics */
-    rate->attempts++;
-    if (success) {
-        rate->success++;
-        rate->last_success = now;
+    spin_lock_irqsave(&dev->rate_table.lock, flags);
+    if (rate->mcs <= table->max_mcs) {
+        entry = &table->entries[rate->mcs];
+
+        /* Halve the history rather than let the u16 counters wrap */
+        if (entry->attempts == U16_MAX) {
+            entry->attempts /= 2;
+            entry->success /= 2;
+        }
+        entry->attempts++;
+        if (success) {
+            entry->success++;
+            entry->last_success = now;
+        }
+        entry->last_attempt = now;
     }
-    rate->last_attempt = now;
+    spin_unlock_irqrestore(&dev->rate_table.lock, flags);
+
+    spin_lock_irqsave(&dev->lock, flags);
 
     /* Update global statistics */
     dev->stats.tx_packets++;
@@ -187,8 +206,11 @@ static struct wifi7_rate_entry *select_rate_pid(struct wifi7_rate_dev *dev,
     /* Get current rate */
     current_rate = &table->entries[table->max_mcs / 2];
 
-    /* Calculate PID error */
-    error = current_rate->success * 100 / current_rate->attempts - 75;
+    /* Calculate PID error; hold the rate until it has been tried */
+    if (current_rate->attempts)
+        error = current_rate->success * 100 / current_rate->attempts - 75;
+    else
+        error = 0;
     delta = error / 10;
 
     /* Adjust MCS based on error */
@@ -214,12 +236,21 @@ static void rate_update_work_handler(struct work_struct *work)
 {
     struct wifi7_rate_dev *dev = rate_dev;
     struct wifi7_rate_table *table = &dev->rate_table.table;
+    u32 prob_ewma, cur_tp, max_tp;
+    u32 interval = 0;
     unsigned long flags;
     int i;
     
     if (!dev->initialized)
         return;
 
+    /* Stats belong to dev->lock; work on a snapshot under the table lock */
+    spin_lock_irqsave(&dev->lock, flags);
+    prob_ewma = dev->stats.prob_ewma;
+    cur_tp = dev->stats.cur_tp;
+    max_tp = dev->stats.max_tp;
+    spin_unlock_irqrestore(&dev->lock, flags);
+
     spin_lock_irqsave(&dev->rate_table.lock, flags);
 
     /* Update rate statistics */
@@ -237,22 +268,29 @@ static void rate_update_work_handler(struct work_struct *work)
         success_ratio = rate->success * 100 / rate->attempts;
 
         /* Update EWMA probability */
-        dev->stats.prob_ewma = (dev->stats.prob_ewma * 75 + success_ratio * 25) / 100;
+        prob_ewma = (prob_ewma * 75 + success_ratio * 25) / 100;
 
         /* Update throughput */
-        dev->stats.cur_tp = rate->bitrate * success_ratio / 100;
-        if (dev->stats.cur_tp > dev->stats.max_tp)
-            dev->stats.max_tp = dev->stats.cur_tp;
+        cur_tp = rate->bitrate * success_ratio / 100;
+        if (cur_tp > max_tp)
+            max_tp = cur_tp;
     }
 
-    dev->stats.last_update = ktime_get();
-
     spin_unlock_irqrestore(&dev->rate_table.lock, flags);
+
+    spin_lock_irqsave(&dev->lock, flags);
+    dev->stats.prob_ewma = prob_ewma;
+    dev->stats.cur_tp = cur_tp;
+    dev->stats.max_tp = max_tp;
+    dev->stats.last_update = ktime_get();
+    if (dev->config.auto_adjust)
+        interval = dev->config.update_interval;
+    spin_unlock_irqrestore(&dev->lock, flags);
     
     /* Schedule next update */
-    if (dev->config.auto_adjust)
+    if (interval)
         schedule_delayed_work(&dev->workers.update_work,
-                            msecs_to_jiffies(dev->config.update_interval));
+                            msecs_to_jiffies(interval));
 }
 
 static void rate_stats_work_handler(struct work_struct *work)
@@ -356,11 +394,10 @@ void wifi7_rate_deinit(struct wifi7_dev *dev)
     if (!rdev)
         return;
         
-    rdev->initialized = false;
-
-    /* Cancel workers */
+    /* Cancel workers; they test initialized, so clear it after */
     cancel_delayed_work_sync(&rdev->workers.update_work);
     cancel_delayed_work_sync(&rdev->workers.stats_work);
+    rdev->initialized = false;
 
     kfree(rdev->history.history);
     kfree(rdev);
@@ -550,12 +587,19 @@ int wifi7_rate_select(struct wifi7_dev *dev,
 {
     struct wifi7_rate_dev *rdev = rate_dev;
     struct wifi7_rate_entry *selected_rate = NULL;
+    struct wifi7_rate_entry *last_rate;
+    unsigned long flags;
+    u8 algorithm;
 
     if (!rdev || !rdev->initialized || !skb || !rate)
         return -EINVAL;
 
+    spin_lock_irqsave(&rdev->lock, flags);
+    algorithm = rdev->config.algorithm;
+    spin_unlock_irqrestore(&rdev->lock, flags);
+
     /* Select rate based on algorithm */
-    switch (rdev->config.algorithm) {
+    switch (algorithm) {
     case WIFI7_RATE_ALGO_MINSTREL:
         selected_rate = select_rate_minstrel(rdev, skb);
         break;
@@ -573,7 +617,19 @@ int wifi7_rate_select(struct wifi7_dev *dev,
     if (!selected_rate)
         return -EINVAL;
 
+    /* The entry may be rewritten by wifi7_rate_update_table() */
+    spin_lock_irqsave(&rdev->rate_table.lock, flags);
     memcpy(rate, selected_rate, sizeof(*rate));
+    spin_unlock_irqrestore(&rdev->rate_table.lock, flags);
+
+    last_rate = READ_ONCE(rdev->last_rate);
+    if (last_rate != selected_rate) {
+        trace_wifi67_rate_change(last_rate ? last_rate->mcs : 0xff,
+                                 rate->mcs, rate->nss, rate->bw,
+                                 rate->gi, rate->bitrate);
+        WRITE_ONCE(rdev->last_rate, selected_rate);
+    }
+
     return 0;
 }
 EXPORT_SYMBOL(wifi7_rate_select);
@@ -0,0 +1,50 @@
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/string.h>
+#include <linux/errno.h>
+#include "../../include/perf/perf_counters.h"
+
+int wifi67_perf_counters_init(struct wifi67_perf_counters *c)
+{
+    int cpu;
+
+    c->pcpu = alloc_percpu(struct wifi67_perf_pcpu);
+    if (!c->pcpu)
+        return -ENOMEM;
+
+    for_each_possible_cpu(cpu)
+        u64_stats_init(&per_cpu_ptr(c->pcpu, cpu)->syncp);
+
+    return 0;
+}
+
+void wifi67_perf_counters_free(struct wifi67_perf_counters *c)
+{
+    free_percpu(c->pcpu);
+    c->pcpu = NULL;
+}
+
+/* Fold every CPU's counters; each CPU's set is read consistently */
+void wifi67_perf_counters_read(struct wifi67_perf_counters *c,
+                               struct wifi67_perf_snapshot *snap)
+{
+    u64 vals[WIFI67_PERF_NUM_COUNTERS];
+    struct wifi67_perf_pcpu *p;
+    unsigned int start;
+    int cpu, i;
+
+    memset(snap, 0, sizeof(*snap));
+
+    for_each_possible_cpu(cpu) {
+        p = per_cpu_ptr(c->pcpu, cpu);
+
+        do {
+            start = u64_stats_fetch_begin(&p->syncp);
+            for (i = 0; i < WIFI67_PERF_NUM_COUNTERS; i++)
+                vals[i] = u64_stats_read(&p->cnt[i]);
+        } while (u64_stats_fetch_retry(&p->syncp, start));
+
+        for (i = 0; i < WIFI67_PERF_NUM_COUNTERS; i++)
+            snap->cnt[i] += vals[i];
+    }
+}
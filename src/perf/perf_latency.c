@@ -0,0 +1,392 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/mutex.h>
+#include <linux/math64.h>
+#include <linux/hash.h>
+#include <linux/spinlock.h>
+#include "../../include/perf/perf_latency.h"
+#include "../../include/core/wifi67.h"
+
+#define WIFI67_LAT_SLOTS_SHIFT  12
+#define WIFI67_LAT_SLOTS        (1 << WIFI67_LAT_SLOTS_SHIFT)
+#define WIFI67_LAT_LOCKS        64
+
+DEFINE_STATIC_KEY_FALSE(wifi67_lat_enabled);
+EXPORT_SYMBOL(wifi67_lat_enabled);
+
+/* Per-frame stamps, in a slot picked by hashing the skb address */
+struct wifi67_lat_slot {
+    const struct sk_buff *skb;
+    u32 seen;                       /* BIT(point) for each stamp taken */
+    u32 ts[WIFI67_LAT_NUM_POINTS];
+};
+
+/*
+ * Shared by all devices: a frame enqueued into a taken slot evicts the
+ * frame there, which then goes unsampled.
+ */
+static struct wifi67_lat_slot wifi67_lat_slots[WIFI67_LAT_SLOTS];
+static spinlock_t wifi67_lat_locks[WIFI67_LAT_LOCKS] = {
+    [0 ... WIFI67_LAT_LOCKS - 1] = __SPIN_LOCK_UNLOCKED(wifi67_lat_locks),
+};
+
+struct wifi67_lat_hist {
+    u32 ac[WIFI67_LAT_NUM_STAGES][IEEE80211_NUM_ACS][WIFI67_LAT_BUCKETS];
+    u32 link[WIFI67_LAT_NUM_STAGES][WIFI67_LAT_MAX_LINKS][WIFI67_LAT_BUCKETS];
+};
+
+struct wifi67_perf_latency {
+    struct wifi67_lat_hist __percpu *hist;
+    struct dentry *dir;
+    struct mutex lock;      /* Serialises enable/disable */
+    bool enabled;
+};
+
+static const char * const wifi67_lat_stage_names[] = {
+    [WIFI67_LAT_STAGE_QUEUE] = "queue",
+    [WIFI67_LAT_STAGE_SCHED] = "sched",
+    [WIFI67_LAT_STAGE_HW]    = "hw",
+    [WIFI67_LAT_STAGE_TOTAL] = "total",
+};
+
+static const char * const wifi67_lat_ac_names[] = {
+    [IEEE80211_AC_VO] = "VO",
+    [IEEE80211_AC_VI] = "VI",
+    [IEEE80211_AC_BE] = "BE",
+    [IEEE80211_AC_BK] = "BK",
+};
+
+static struct wifi67_lat_slot *wifi67_lat_slot(const struct sk_buff *skb,
+                                               spinlock_t **lock)
+{
+    u32 idx = hash_ptr(skb, WIFI67_LAT_SLOTS_SHIFT);
+
+    *lock = &wifi67_lat_locks[idx % WIFI67_LAT_LOCKS];
+    return &wifi67_lat_slots[idx];
+}
+
+/* Below 8 ns one bucket per value, then four per power of two */
+static unsigned int wifi67_lat_bucket(u32 ns)
+{
+    unsigned int msb;
+
+    if (ns < 8)
+        return ns;
+
+    msb = fls(ns) - 1;
+    return (msb - 1) * 4 + ((ns >> (msb - 2)) & 3);
+}
+
+/* Largest value that lands in bucket @b */
+static u32 wifi67_lat_bucket_max(unsigned int b)
+{
+    unsigned int shift;
+
+    if (b < 8)
+        return b;
+
+    shift = b / 4 - 1;
+    return (((4 + (b & 3)) << shift) - 1) + (1U << shift);
+}
+
+void __wifi67_lat_stamp(struct sk_buff *skb, enum wifi67_lat_point point)
+{
+    u32 now = (u32)ktime_get_ns();
+    struct wifi67_lat_slot *slot;
+    unsigned long flags;
+    spinlock_t *lock;
+
+    slot = wifi67_lat_slot(skb, &lock);
+    spin_lock_irqsave(lock, flags);
+    if (point == WIFI67_LAT_ENQUEUE) {
+        slot->skb = skb;
+        slot->seen = 0;
+    }
+    /* Otherwise enqueued before tracking was enabled, or evicted */
+    if (slot->skb == skb) {
+        slot->ts[point] = now;
+        slot->seen |= BIT(point);
+    }
+    spin_unlock_irqrestore(lock, flags);
+}
+EXPORT_SYMBOL(__wifi67_lat_stamp);
+
+static void wifi67_lat_record(struct wifi67_perf_latency *lat,
+                              enum wifi67_lat_stage stage, int ac,
+                              int link_id, u32 ns)
+{
+    unsigned int b = wifi67_lat_bucket(ns);
+
+    this_cpu_inc(lat->hist->ac[stage][ac][b]);
+    if (link_id >= 0)
+        this_cpu_inc(lat->hist->link[stage][link_id][b]);
+}
+
+void __wifi67_lat_tx_done(struct wifi67_priv *priv, struct sk_buff *skb,
+                          u8 link_id)
+{
+    struct wifi67_perf_latency *lat = READ_ONCE(priv->perf.latency);
+    u32 seen, ts[WIFI67_LAT_NUM_POINTS], now = (u32)ktime_get_ns();
+    struct wifi67_lat_slot *slot;
+    unsigned long flags;
+    spinlock_t *lock;
+    int ac, link;
+
+    if (!lat || !READ_ONCE(lat->enabled))
+        return;
+
+    slot = wifi67_lat_slot(skb, &lock);
+    spin_lock_irqsave(lock, flags);
+    if (slot->skb != skb) {
+        spin_unlock_irqrestore(lock, flags);
+        return;
+    }
+    seen = slot->seen;
+    memcpy(ts, slot->ts, sizeof(ts));
+    slot->skb = NULL;
+    spin_unlock_irqrestore(lock, flags);
+
+    ac = min_t(int, skb_get_queue_mapping(skb), IEEE80211_NUM_ACS - 1);
+    link = link_id < WIFI67_LAT_MAX_LINKS ? link_id : -1;
+
+    /* u32 arithmetic keeps the deltas right across clock wrap */
+    if ((seen & BIT(WIFI67_LAT_DEQUEUE))) {
+        wifi67_lat_record(lat, WIFI67_LAT_STAGE_QUEUE, ac, link,
+                          ts[WIFI67_LAT_DEQUEUE] -
+                          ts[WIFI67_LAT_ENQUEUE]);
+        if (seen & BIT(WIFI67_LAT_DMA_POST))
+            wifi67_lat_record(lat, WIFI67_LAT_STAGE_SCHED, ac, link,
+                              ts[WIFI67_LAT_DMA_POST] -
+                              ts[WIFI67_LAT_DEQUEUE]);
+    }
+    if (seen & BIT(WIFI67_LAT_DMA_POST))
+        wifi67_lat_record(lat, WIFI67_LAT_STAGE_HW, ac, link,
+                          now - ts[WIFI67_LAT_DMA_POST]);
+    wifi67_lat_record(lat, WIFI67_LAT_STAGE_TOTAL, ac, link,
+                      now - ts[WIFI67_LAT_ENQUEUE]);
+}
+EXPORT_SYMBOL(__wifi67_lat_tx_done);
+
+static u64 wifi67_lat_fold(struct wifi67_perf_latency *lat,
+                           enum wifi67_lat_stage stage, bool per_link,
+                           unsigned int idx, u64 *buckets)
+{
+    struct wifi67_lat_hist *h;
+    u64 total = 0;
+    int cpu, b;
+
+    memset(buckets, 0, WIFI67_LAT_BUCKETS * sizeof(*buckets));
+
+    for_each_possible_cpu(cpu) {
+        h = per_cpu_ptr(lat->hist, cpu);
+        for (b = 0; b < WIFI67_LAT_BUCKETS; b++)
+            buckets[b] += per_link ? h->link[stage][idx][b] :
+                                     h->ac[stage][idx][b];
+    }
+
+    for (b = 0; b < WIFI67_LAT_BUCKETS; b++)
+        total += buckets[b];
+
+    return total;
+}
+
+/* Upper bound of the bucket holding the @permille'th sample */
+static u32 wifi67_lat_pct(const u64 *buckets, u64 total, u32 permille)
+{
+    u64 rank, sum = 0;
+    int b;
+
+    if (!total)
+        return 0;
+
+    rank = max_t(u64, div_u64(total * permille + 999, 1000), 1);
+    for (b = 0; b < WIFI67_LAT_BUCKETS; b++) {
+        sum += buckets[b];
+        if (sum >= rank)
+            return wifi67_lat_bucket_max(b);
+    }
+
+    return U32_MAX;
+}
+
+u32 wifi67_lat_percentile(struct wifi67_priv *priv, enum wifi67_lat_stage stage,
+                          bool per_link, unsigned int idx, u32 permille,
+                          u64 *count)
+{
+    struct wifi67_perf_latency *lat = priv->perf.latency;
+    u64 buckets[WIFI67_LAT_BUCKETS];
+    u64 total;
+
+    if (!lat || stage >= WIFI67_LAT_NUM_STAGES ||
+        idx >= (per_link ? WIFI67_LAT_MAX_LINKS : IEEE80211_NUM_ACS))
+        return 0;
+
+    total = wifi67_lat_fold(lat, stage, per_link, idx, buckets);
+    if (count)
+        *count = total;
+
+    return wifi67_lat_pct(buckets, total, permille);
+}
+EXPORT_SYMBOL_GPL(wifi67_lat_percentile);
+
+int wifi67_lat_enable(struct wifi67_priv *priv, bool enable)
+{
+    struct wifi67_perf_latency *lat = priv->perf.latency;
+
+    if (!lat)
+        return -ENODEV;
+
+    mutex_lock(&lat->lock);
+    if (enable != lat->enabled) {
+        WRITE_ONCE(lat->enabled, enable);
+        /* The key is shared by all devices */
+        if (enable)
+            static_branch_inc(&wifi67_lat_enabled);
+        else
+            static_branch_dec(&wifi67_lat_enabled);
+    }
+    mutex_unlock(&lat->lock);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(wifi67_lat_enable);
+
+void wifi67_lat_reset(struct wifi67_priv *priv)
+{
+    struct wifi67_perf_latency *lat = priv->perf.latency;
+    int cpu;
+
+    if (!lat)
+        return;
+
+    for_each_possible_cpu(cpu)
+        memset(per_cpu_ptr(lat->hist, cpu), 0, sizeof(struct wifi67_lat_hist));
+}
+EXPORT_SYMBOL_GPL(wifi67_lat_reset);
+
+/* Debug filesystem interface */
+static void wifi67_lat_show_row(struct seq_file *file,
+                                struct wifi67_perf_latency *lat,
+                                enum wifi67_lat_stage stage, bool per_link,
+                                unsigned int idx, u64 *buckets)
+{
+    u64 total = wifi67_lat_fold(lat, stage, per_link, idx, buckets);
+
+    if (!total)
+        return;
+
+    if (per_link)
+        seq_printf(file, "%-6s link%-3u", wifi67_lat_stage_names[stage], idx);
+    else
+        seq_printf(file, "%-6s %-7s", wifi67_lat_stage_names[stage],
+                   wifi67_lat_ac_names[idx]);
+
+    seq_printf(file, " %12llu %10u %10u %10u\n", total,
+               wifi67_lat_pct(buckets, total, 500),
+               wifi67_lat_pct(buckets, total, 990),
+               wifi67_lat_pct(buckets, total, 999));
+}
+
+static int wifi67_lat_show(struct seq_file *file, void *v)
+{
+    struct wifi67_perf_latency *lat = file->private;
+    u64 *buckets;
+    int stage, i;
+
+    buckets = kmalloc_array(WIFI67_LAT_BUCKETS, sizeof(*buckets), GFP_KERNEL);
+    if (!buckets)
+        return -ENOMEM;
+
+    seq_printf(file, "TX latency (ns), tracking %s\n",
+               READ_ONCE(lat->enabled) ? "on" : "off");
+    seq_printf(file, "%-6s %-7s %12s %10s %10s %10s\n",
+               "stage", "class", "count", "p50", "p99", "p99.9");
+
+    for (stage = 0; stage < WIFI67_LAT_NUM_STAGES; stage++) {
+        for (i = 0; i < IEEE80211_NUM_ACS; i++)
+            wifi67_lat_show_row(file, lat, stage, false, i, buckets);
+        for (i = 0; i < WIFI67_LAT_MAX_LINKS; i++)
+            wifi67_lat_show_row(file, lat, stage, true, i, buckets);
+    }
+
+    kfree(buckets);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(wifi67_lat);
+
+static int wifi67_lat_enable_get(void *data, u64 *val)
+{
+    struct wifi67_priv *priv = data;
+
+    *val = READ_ONCE(priv->perf.latency->enabled);
+    return 0;
+}
+
+static int wifi67_lat_enable_set(void *data, u64 val)
+{
+    return wifi67_lat_enable(data, !!val);
+}
+DEFINE_DEBUGFS_ATTRIBUTE(wifi67_lat_enable_fops, wifi67_lat_enable_get,
+                         wifi67_lat_enable_set, "%llu\n");
+
+static int wifi67_lat_reset_set(void *data, u64 val)
+{
+    wifi67_lat_reset(data);
+    return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(wifi67_lat_reset_fops, NULL,
+                         wifi67_lat_reset_set, "%llu\n");
+
+int wifi67_lat_init(struct wifi67_priv *priv, struct dentry *parent)
+{
+    struct wifi67_perf_latency *lat;
+
+    lat = kzalloc(sizeof(*lat), GFP_KERNEL);
+    if (!lat)
+        return -ENOMEM;
+
+    lat->hist = alloc_percpu(struct wifi67_lat_hist);
+    if (!lat->hist) {
+        kfree(lat);
+        return -ENOMEM;
+    }
+
+    mutex_init(&lat->lock);
+    priv->perf.latency = lat;
+
+    lat->dir = debugfs_create_dir("latency", parent);
+    debugfs_create_file("histograms", 0444, lat->dir, lat, &wifi67_lat_fops);
+    debugfs_create_file("enable", 0644, lat->dir, priv,
+                        &wifi67_lat_enable_fops);
+    debugfs_create_file("reset", 0200, lat->dir, priv,
+                        &wifi67_lat_reset_fops);
+
+    return 0;
+}
+
+void wifi67_lat_deinit(struct wifi67_priv *priv)
+{
+    struct wifi67_perf_latency *lat = priv->perf.latency;
+
+    if (!lat)
+        return;
+
+    debugfs_remove_recursive(lat->dir);
+    wifi67_lat_enable(priv, false);
+    priv->perf.latency = NULL;
+
+    /*
+     * Completion hooks run with preemption or BHs disabled, so once a
+     * grace period passes none can still see the old pointer.
+     */
+    synchronize_rcu();
+    free_percpu(lat->hist);
+    kfree(lat);
+}
+
+EXPORT_SYMBOL_GPL(wifi67_lat_init);
+EXPORT_SYMBOL_GPL(wifi67_lat_deinit);
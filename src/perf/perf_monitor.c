@@ -1,37 +1,49 @@
 #include <linux/module.h>
 #include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/math64.h>
 #include "../../include/perf/perf_monitor.h"
+#include "../../include/perf/perf_latency.h"
+#include "../../include/perf/perf_ring.h"
 #include "../../include/debug/debug.h"
 
 static void wifi67_perf_process_stats(struct wifi67_perf_monitor *perf)
 {
-    u64 now = ktime_get_ns();
-    u64 delta = now - ktime_to_ns(perf->last_sample);
     struct wifi67_priv *priv = container_of(perf, struct wifi67_priv, perf);
-    
-    // Calculate rates
-    u32 tx_rate = atomic_read(&perf->tx_bytes) * NSEC_PER_SEC / delta;
-    u32 rx_rate = atomic_read(&perf->rx_bytes) * NSEC_PER_SEC / delta;
-    
-    wifi67_debug(priv, WIFI67_DEBUG_INFO,
+    struct wifi67_perf_snapshot snap;
+    ktime_t now = ktime_get();
+    u64 delta = ktime_to_ns(ktime_sub(now, perf->last_sample));
+    u64 tx_bytes, rx_bytes, tx_rate = 0, rx_rate = 0;
+
+    wifi67_perf_counters_read(&perf->counters, &snap);
+
+    // Calculate rates over the interval since the previous sample
+    tx_bytes = snap.cnt[WIFI67_PERF_TX_BYTES] - perf->last.cnt[WIFI67_PERF_TX_BYTES];
+    rx_bytes = snap.cnt[WIFI67_PERF_RX_BYTES] - perf->last.cnt[WIFI67_PERF_RX_BYTES];
+    if (delta) {
+        tx_rate = div64_u64(tx_bytes * 8 * NSEC_PER_SEC, delta);
+        rx_rate = div64_u64(rx_bytes * 8 * NSEC_PER_SEC, delta);
+    }
+
+    wifi67_info(priv, WIFI67_LOG_CORE,
                "Performance stats:\n"
-               "  TX: %u packets, %u bytes, %u Mbps\n"
-               "  RX: %u packets, %u bytes, %u Mbps\n"
-               "  Errors: TX=%u, RX=%u, HW=%u, FIFO=%u, DMA=%u\n",
-               atomic_read(&perf->tx_packets),
-               atomic_read(&perf->tx_bytes),
-               tx_rate / 1000000,
-               atomic_read(&perf->rx_packets), 
-               atomic_read(&perf->rx_bytes),
-               rx_rate / 1000000,
-               atomic_read(&perf->tx_errors),
-               atomic_read(&perf->rx_errors),
+               "  TX: %llu packets, %llu bytes, %llu Mbps\n"
+               "  RX: %llu packets, %llu bytes, %llu Mbps\n"
+               "  Errors: TX=%llu, RX=%llu, HW=%u, FIFO=%u, DMA=%u\n",
+               snap.cnt[WIFI67_PERF_TX_PACKETS],
+               snap.cnt[WIFI67_PERF_TX_BYTES],
+               div_u64(tx_rate, 1000000),
+               snap.cnt[WIFI67_PERF_RX_PACKETS],
+               snap.cnt[WIFI67_PERF_RX_BYTES],
+               div_u64(rx_rate, 1000000),
+               snap.cnt[WIFI67_PERF_TX_ERRORS],
+               snap.cnt[WIFI67_PERF_RX_ERRORS],
                perf->hw_errors,
                perf->fifo_errors,
                perf->dma_errors);
-               
-    perf->last_sample = ktime_get();
+
+    perf->last = snap;
+    perf->last_sample = now;
 }
 
 static void wifi67_perf_work(struct work_struct *work)
@@ -52,17 +64,27 @@ static void wifi67_perf_work(struct work_struct *work)
 int wifi67_perf_init(struct wifi67_priv *priv)
 {
     struct wifi67_perf_monitor *perf = &priv->perf;
+    int ret;
     
     INIT_DELAYED_WORK(&perf->dwork, wifi67_perf_work);
-    
-    atomic_set(&perf->tx_packets, 0);
-    atomic_set(&perf->rx_packets, 0);
-    atomic_set(&perf->tx_bytes, 0);
-    atomic_set(&perf->rx_bytes, 0);
-    atomic_set(&perf->tx_errors, 0);
-    atomic_set(&perf->rx_errors, 0);
-    atomic_set(&perf->tx_dropped, 0);
-    atomic_set(&perf->rx_dropped, 0);
+
+    ret = wifi67_perf_counters_init(&perf->counters);
+    if (ret)
+        return ret;
+    memset(&perf->last, 0, sizeof(perf->last));
+
+    ret = wifi67_lat_init(priv, priv->debugfs.dir);
+    if (ret) {
+        wifi67_perf_counters_free(&perf->counters);
+        return ret;
+    }
+
+    ret = wifi67_perf_ring_init(priv, priv->debugfs.dir);
+    if (ret) {
+        wifi67_lat_deinit(priv);
+        wifi67_perf_counters_free(&perf->counters);
+        return ret;
+    }
     
     perf->hw_errors = 0;
     perf->fifo_errors = 0;
@@ -84,6 +106,9 @@ void wifi67_perf_deinit(struct wifi67_priv *priv)
     
     perf->enabled = false;
     cancel_delayed_work_sync(&perf->dwork);
+    wifi67_perf_ring_deinit(priv);
+    wifi67_lat_deinit(priv);
+    wifi67_perf_counters_free(&perf->counters);
 }
 
 void wifi67_perf_sample(struct wifi67_priv *priv)
@@ -96,6 +121,14 @@ void wifi67_perf_sample(struct wifi67_priv *priv)
     wifi67_perf_process_stats(perf);
 }
 
+/* Consistent totals across all CPUs */
+void wifi67_perf_get_snapshot(struct wifi67_priv *priv,
+                              struct wifi67_perf_snapshot *snap)
+{
+    wifi67_perf_counters_read(&priv->perf.counters, snap);
+}
+
 EXPORT_SYMBOL_GPL(wifi67_perf_init);
 EXPORT_SYMBOL_GPL(wifi67_perf_deinit);
-EXPORT_SYMBOL_GPL(wifi67_perf_sample); 
\ No newline at end of file
+EXPORT_SYMBOL_GPL(wifi67_perf_sample);
+EXPORT_SYMBOL_GPL(wifi67_perf_get_snapshot); 
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <net/mac80211.h>
+#include "../../include/perf/perf_ring.h"
+#include "../../include/core/wifi67.h"
+
+static_assert(!(WIFI67_PERF_RING_RECORDS & (WIFI67_PERF_RING_RECORDS - 1)));
+static_assert(sizeof(struct wifi67_perf_ring_hdr) <= PAGE_SIZE);
+static_assert(WIFI67_PERF_RING_NUM_ACS == IEEE80211_NUM_ACS);
+
+/* Fold every CPU's link and AC counters into @rec */
+static void wifi67_perf_ring_fold(struct wifi67_perf_ring *ring,
+                                  struct wifi67_perf_rec *rec)
+{
+    u64 link[WIFI67_PERF_RING_MAX_LINKS][WIFI67_PERF_LINK_NUM_STATS];
+    u64 ac[WIFI67_PERF_RING_NUM_ACS][WIFI67_PERF_AC_NUM_STATS];
+    u64 sum_link[WIFI67_PERF_RING_MAX_LINKS][WIFI67_PERF_LINK_NUM_STATS] = {};
+    u64 sum_ac[WIFI67_PERF_RING_NUM_ACS][WIFI67_PERF_AC_NUM_STATS] = {};
+    struct wifi67_perf_ring_pcpu *p;
+    unsigned int start;
+    int cpu, i, j;
+
+    for_each_possible_cpu(cpu) {
+        p = per_cpu_ptr(ring->pcpu, cpu);
+
+        do {
+            start = u64_stats_fetch_begin(&p->syncp);
+            for (i = 0; i < WIFI67_PERF_RING_MAX_LINKS; i++)
+                for (j = 0; j < WIFI67_PERF_LINK_NUM_STATS; j++)
+                    link[i][j] = u64_stats_read(&p->link[i][j]);
+            for (i = 0; i < WIFI67_PERF_RING_NUM_ACS; i++)
+                for (j = 0; j < WIFI67_PERF_AC_NUM_STATS; j++)
+                    ac[i][j] = u64_stats_read(&p->ac[i][j]);
+        } while (u64_stats_fetch_retry(&p->syncp, start));
+
+        for (i = 0; i < WIFI67_PERF_RING_MAX_LINKS; i++)
+            for (j = 0; j < WIFI67_PERF_LINK_NUM_STATS; j++)
+                sum_link[i][j] += link[i][j];
+        for (i = 0; i < WIFI67_PERF_RING_NUM_ACS; i++)
+            for (j = 0; j < WIFI67_PERF_AC_NUM_STATS; j++)
+                sum_ac[i][j] += ac[i][j];
+    }
+
+    for (i = 0; i < WIFI67_PERF_RING_MAX_LINKS; i++) {
+        rec->link[i].tx_packets = sum_link[i][WIFI67_PERF_LINK_TX_PACKETS];
+        rec->link[i].tx_bytes = sum_link[i][WIFI67_PERF_LINK_TX_BYTES];
+        rec->link[i].tx_errors = sum_link[i][WIFI67_PERF_LINK_TX_ERRORS];
+        rec->link[i].airtime_us = sum_link[i][WIFI67_PERF_LINK_AIRTIME];
+    }
+
+    for (i = 0; i < WIFI67_PERF_RING_NUM_ACS; i++) {
+        rec->ac[i].tx_packets = sum_ac[i][WIFI67_PERF_AC_TX_PACKETS];
+        rec->ac[i].tx_bytes = sum_ac[i][WIFI67_PERF_AC_TX_BYTES];
+    }
+}
+
+static void wifi67_perf_ring_sample(struct wifi67_perf_ring *ring)
+{
+    struct wifi67_perf_rec *rec;
+    struct wifi67_perf_snapshot snap;
+    u64 seq = ring->seq;
+
+    rec = &ring->recs[seq & (WIFI67_PERF_RING_RECORDS - 1)];
+
+    /* Invalidate the slot so readers racing the rewrite discard it */
+    WRITE_ONCE(rec->seq, ~0ULL);
+    smp_wmb();
+
+    wifi67_perf_counters_read(&ring->priv->perf.counters, &snap);
+
+    rec->timestamp_ns = ktime_get_ns();
+    rec->tx_packets = snap.cnt[WIFI67_PERF_TX_PACKETS];
+    rec->tx_bytes = snap.cnt[WIFI67_PERF_TX_BYTES];
+    rec->rx_packets = snap.cnt[WIFI67_PERF_RX_PACKETS];
+    rec->rx_bytes = snap.cnt[WIFI67_PERF_RX_BYTES];
+    rec->tx_errors = snap.cnt[WIFI67_PERF_TX_ERRORS];
+    rec->rx_errors = snap.cnt[WIFI67_PERF_RX_ERRORS];
+    rec->tx_dropped = snap.cnt[WIFI67_PERF_TX_DROPPED];
+    rec->rx_dropped = snap.cnt[WIFI67_PERF_RX_DROPPED];
+    wifi67_perf_ring_fold(ring, rec);
+
+    smp_wmb();
+    WRITE_ONCE(rec->seq, seq);
+
+    /* Publish the record; pairs with the reader's acquire of head */
+    smp_store_release(&ring->hdr->head, seq + 1);
+    ring->seq = seq + 1;
+}
+
+static enum hrtimer_restart wifi67_perf_ring_timer(struct hrtimer *timer)
+{
+    struct wifi67_perf_ring *ring = container_of(timer,
+                                                 struct wifi67_perf_ring,
+                                                 timer);
+    u32 interval_us = READ_ONCE(ring->hdr->interval_us);
+
+    wifi67_perf_ring_sample(ring);
+
+    hrtimer_forward_now(timer, us_to_ktime(interval_us));
+    return HRTIMER_RESTART;
+}
+
+int wifi67_perf_ring_set_interval(struct wifi67_priv *priv, u32 interval_us)
+{
+    struct wifi67_perf_ring *ring = priv->perf.ring;
+
+    if (!ring)
+        return -ENODEV;
+
+    if (interval_us < WIFI67_PERF_RING_MIN_US ||
+        interval_us > WIFI67_PERF_RING_MAX_US)
+        return -EINVAL;
+
+    /* Takes effect when the timer next fires */
+    WRITE_ONCE(ring->hdr->interval_us, interval_us);
+    return 0;
+}
+
+static void wifi67_perf_ring_free(struct kref *ref)
+{
+    struct wifi67_perf_ring *ring = container_of(ref, struct wifi67_perf_ring,
+                                                 ref);
+
+    vfree(ring->hdr);
+    free_percpu(ring->pcpu);
+    kfree(ring);
+}
+
+/*
+ * Debugfs interface. The data file is created without the debugfs proxy,
+ * which does not forward mmap, so it pins the ring itself: each open file
+ * holds a reference, and a mapping holds its file until munmap.
+ */
+static int wifi67_perf_ring_open(struct inode *inode, struct file *file)
+{
+    struct wifi67_perf_ring *ring = inode->i_private;
+    int ret;
+
+    /* Keeps the file from being removed until our reference is taken */
+    ret = debugfs_file_get(file->f_path.dentry);
+    if (ret)
+        return ret;
+
+    kref_get(&ring->ref);
+    debugfs_file_put(file->f_path.dentry);
+
+    file->private_data = ring;
+    return 0;
+}
+
+static int wifi67_perf_ring_release(struct inode *inode, struct file *file)
+{
+    struct wifi67_perf_ring *ring = file->private_data;
+
+    kref_put(&ring->ref, wifi67_perf_ring_free);
+    return 0;
+}
+
+static int wifi67_perf_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    struct wifi67_perf_ring *ring = file->private_data;
+
+    /* Userspace only ever reads; the producer owns every byte */
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+    vm_flags_clear(vma, VM_MAYWRITE);
+
+    return remap_vmalloc_range(vma, ring->hdr, vma->vm_pgoff);
+}
+
+/* Plain reads return the same bytes, for collectors that cannot mmap */
+static ssize_t wifi67_perf_ring_read(struct file *file, char __user *buf,
+                                     size_t count, loff_t *ppos)
+{
+    struct wifi67_perf_ring *ring = file->private_data;
+
+    return simple_read_from_buffer(buf, count, ppos, ring->hdr, ring->size);
+}
+
+static const struct file_operations wifi67_perf_ring_fops = {
+    .owner = THIS_MODULE,
+    .open = wifi67_perf_ring_open,
+    .release = wifi67_perf_ring_release,
+    .read = wifi67_perf_ring_read,
+    .mmap = wifi67_perf_ring_mmap,
+    .llseek = default_llseek,
+};
+
+static int wifi67_perf_ring_interval_get(void *data, u64 *val)
+{
+    struct wifi67_priv *priv = data;
+
+    *val = READ_ONCE(priv->perf.ring->hdr->interval_us);
+    return 0;
+}
+
+static int wifi67_perf_ring_interval_set(void *data, u64 val)
+{
+    if (val > U32_MAX)
+        return -EINVAL;
+
+    return wifi67_perf_ring_set_interval(data, val);
+}
+DEFINE_DEBUGFS_ATTRIBUTE(wifi67_perf_ring_interval_fops,
+                         wifi67_perf_ring_interval_get,
+                         wifi67_perf_ring_interval_set, "%llu\n");
+
+int wifi67_perf_ring_init(struct wifi67_priv *priv, struct dentry *parent)
+{
+    struct wifi67_perf_ring *ring;
+    struct wifi67_perf_ring_hdr *hdr;
+    struct dentry *data;
+    int cpu;
+
+    ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+    if (!ring)
+        return -ENOMEM;
+
+    ring->pcpu = alloc_percpu(struct wifi67_perf_ring_pcpu);
+    if (!ring->pcpu)
+        goto err_free;
+
+    for_each_possible_cpu(cpu)
+        u64_stats_init(&per_cpu_ptr(ring->pcpu, cpu)->syncp);
+
+    /* Records start on the second page so both halves map cleanly */
+    ring->size = PAGE_ALIGN(PAGE_SIZE + WIFI67_PERF_RING_RECORDS *
+                            sizeof(struct wifi67_perf_rec));
+    ring->hdr = vmalloc_user(ring->size);
+    if (!ring->hdr)
+        goto err_free_pcpu;
+
+    ring->recs = (struct wifi67_perf_rec *)((u8 *)ring->hdr + PAGE_SIZE);
+    ring->priv = priv;
+    kref_init(&ring->ref);
+
+    hdr = ring->hdr;
+    hdr->magic = WIFI67_PERF_RING_MAGIC;
+    hdr->version = WIFI67_PERF_RING_VERSION;
+    hdr->hdr_size = PAGE_SIZE;
+    hdr->rec_size = sizeof(struct wifi67_perf_rec);
+    hdr->nr_records = WIFI67_PERF_RING_RECORDS;
+    hdr->interval_us = WIFI67_PERF_RING_DEF_US;
+    hdr->num_links = WIFI67_PERF_RING_MAX_LINKS;
+    hdr->num_acs = WIFI67_PERF_RING_NUM_ACS;
+
+    priv->perf.ring = ring;
+
+    ring->dir = debugfs_create_dir("perf_ring", parent);
+    data = debugfs_create_file_unsafe("data", 0400, ring->dir, ring,
+                                      &wifi67_perf_ring_fops);
+    if (!IS_ERR(data))
+        d_inode(data)->i_size = ring->size;
+    debugfs_create_file("interval_us", 0644, ring->dir, priv,
+                        &wifi67_perf_ring_interval_fops);
+
+    hrtimer_init(&ring->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
+    ring->timer.function = wifi67_perf_ring_timer;
+    hrtimer_start(&ring->timer, us_to_ktime(hdr->interval_us),
+                  HRTIMER_MODE_REL_SOFT);
+
+    return 0;
+
+err_free_pcpu:
+    free_percpu(ring->pcpu);
+err_free:
+    kfree(ring);
+    return -ENOMEM;
+}
+
+void wifi67_perf_ring_deinit(struct wifi67_priv *priv)
+{
+    struct wifi67_perf_ring *ring = priv->perf.ring;
+
+    if (!ring)
+        return;
+
+    debugfs_remove_recursive(ring->dir);
+    hrtimer_cancel(&ring->timer);
+    priv->perf.ring = NULL;
+
+    /* Data path updaters run with preemption disabled */
+    synchronize_rcu();
+
+    /* Open files and mappings keep the last samples readable */
+    kref_put(&ring->ref, wifi67_perf_ring_free);
+}
+
+EXPORT_SYMBOL_GPL(wifi67_perf_ring_init);
+EXPORT_SYMBOL_GPL(wifi67_perf_ring_deinit);
+EXPORT_SYMBOL_GPL(wifi67_perf_ring_set_interval);
@@ -3,6 +3,7 @@
 #include <linux/io.h>
 #include "../../include/phy/phy_core.h"
 #include "../../include/mac/mac_core.h"
+#include "../../include/debug/debug.h"
 
 #define WIFI67_PHY_MIN_RSSI -100
 #define WIFI67_PHY_MAX_RSSI -10
@@ -36,7 +37,7 @@ static int wifi67_phy_hw_init(struct wifi67_priv *priv)
     }
 
     if (retry < 0) {
-        pr_err("PHY failed to become ready\n");
+        wifi67_err(priv, WIFI67_LOG_PHY, "PHY failed to become ready\n");
         return -ETIMEDOUT;
     }
 
@@ -77,7 +78,7 @@ static int wifi67_phy_hw_init(struct wifi67_priv *priv)
     }
 
     if (retry < 0) {
-        pr_err("PHY calibration failed\n");
+        wifi67_err(priv, WIFI67_LOG_PHY, "PHY calibration failed\n");
         return -ETIMEDOUT;
     }
 
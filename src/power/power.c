@@ -24,7 +24,7 @@ static void wifi67_power_ps_work(struct work_struct *work)
         time_after(jiffies, power->last_state_change + 
                   msecs_to_jiffies(power->config.dynamic_ps_timeout))) {
         
-        wifi67_debug(priv, WIFI67_DEBUG_INFO, "Entering power save mode\n");
+        wifi67_info(priv, WIFI67_LOG_CORE, "Entering power save mode\n");
         power->state = WIFI67_POWER_STATE_SLEEP;
         atomic_inc(&power->stats.sleep_count);
         power->last_state_change = ktime_get();
@@ -13,9 +13,13 @@
 #include <linux/workqueue.h>
 #include <linux/debugfs.h>
 #include <linux/random.h>
+#include <asm/unaligned.h>
 #include <crypto/aes.h>
 #include <crypto/gcm.h>
 #include <crypto/sha2.h>
+#include <crypto/hash.h>
+#include <crypto/aead.h>
+#include <crypto/algapi.h>
 #include <net/mac80211.h>
 #include "wifi7_security.h"
 #include "../core/wifi7_core.h"
@@ -164,6 +168,258 @@ static void wifi7_security_free_crypto(struct wifi7_security *sec)
     crypto_free_shash(sec->tfm_sha256);
 }
 
+/* Management Frame Protection (BIP) */
+
+static u8 wifi7_security_bip_cipher(struct wifi7_sec_key *key)
+{
+    if (key->cipher >= WIFI7_CIPHER_BIP_CMAC_128 &&
+        key->cipher <= WIFI7_CIPHER_BIP_GMAC_256)
+        return key->cipher;
+        
+    return key->key_len == WIFI7_KEY_LEN_BIP_256 ?
+           WIFI7_CIPHER_BIP_CMAC_256 : WIFI7_CIPHER_BIP_CMAC_128;
+}
+
+/*
+ * Allocate and key the BIP transform once at key install time so the
+ * per-frame path only runs init/update/final on an already expanded key.
+ * May sleep; must be called before taking key_lock.
+ */
+static struct wifi7_sec_mic_ctx *
+wifi7_security_mic_ctx_alloc(struct wifi7_sec_key *key)
+{
+    struct wifi7_sec_mic_ctx *ctx;
+    int ret;
+    
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return ERR_PTR(-ENOMEM);
+        
+    ctx->cipher = wifi7_security_bip_cipher(key);
+    ctx->mic_len = ctx->cipher == WIFI7_CIPHER_BIP_CMAC_128 ?
+                   WIFI7_BIP_MIC_LEN_128 : WIFI7_BIP_MIC_LEN_256;
+    
+    switch (ctx->cipher) {
+    case WIFI7_CIPHER_BIP_CMAC_128:
+    case WIFI7_CIPHER_BIP_CMAC_256:
+        ctx->tfm_cmac = crypto_alloc_shash("cmac(aes)", 0, 0);
+        if (IS_ERR(ctx->tfm_cmac)) {
+            ret = PTR_ERR(ctx->tfm_cmac);
+            ctx->tfm_cmac = NULL;
+            goto err_free;
+        }
+        
+        ret = crypto_shash_setkey(ctx->tfm_cmac, key->key, key->key_len);
+        if (ret)
+            goto err_tfm;
+        break;
+        
+    case WIFI7_CIPHER_BIP_GMAC_128:
+    case WIFI7_CIPHER_BIP_GMAC_256:
+        ctx->tfm_gmac = crypto_alloc_aead("gcm(aes)", 0, CRYPTO_ALG_ASYNC);
+        if (IS_ERR(ctx->tfm_gmac)) {
+            ret = PTR_ERR(ctx->tfm_gmac);
+            ctx->tfm_gmac = NULL;
+            goto err_free;
+        }
+        
+        ret = crypto_aead_setkey(ctx->tfm_gmac, key->key, key->key_len);
+        if (!ret)
+            ret = crypto_aead_setauthsize(ctx->tfm_gmac,
+                                          WIFI7_BIP_MIC_LEN_256);
+        if (ret)
+            goto err_tfm;
+            
+        ctx->req = aead_request_alloc(ctx->tfm_gmac, GFP_KERNEL);
+        if (!ctx->req) {
+            ret = -ENOMEM;
+            goto err_tfm;
+        }
+        aead_request_set_callback(ctx->req, 0, NULL, NULL);
+        break;
+    }
+    
+    return ctx;
+    
+err_tfm:
+    crypto_free_shash(ctx->tfm_cmac);
+    crypto_free_aead(ctx->tfm_gmac);
+err_free:
+    kfree(ctx);
+    return ERR_PTR(ret);
+}
+
+static void wifi7_security_mic_ctx_free(struct wifi7_sec_mic_ctx *ctx)
+{
+    if (!ctx)
+        return;
+        
+    aead_request_free(ctx->req);
+    crypto_free_aead(ctx->tfm_gmac);
+    crypto_free_shash(ctx->tfm_cmac);
+    kfree_sensitive(ctx);
+}
+
+static void wifi7_security_bip_aad(struct sk_buff *skb, u8 *aad)
+{
+    struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)skb->data;
+    __le16 fc;
+    
+    /* FC with Retry, PwrMgt and MoreData masked, then A1/A2/A3 */
+    fc = hdr->frame_control & ~cpu_to_le16(IEEE80211_FCTL_RETRY |
+                                           IEEE80211_FCTL_PM |
+                                           IEEE80211_FCTL_MOREDATA);
+    memcpy(aad, &fc, sizeof(fc));
+    memcpy(aad + 2, hdr->addr1, 3 * ETH_ALEN);
+}
+
+/*
+ * Compute the BIP MIC over AAD || body, where body ends with the MME and
+ * its MIC field is zero. Caller holds key_lock, which also serialises use
+ * of the shared GMAC request.
+ */
+static int wifi7_security_bip_mic(struct wifi7_sec_mic_ctx *ctx,
+                                  struct sk_buff *skb, u8 *ipn, u8 *mic)
+{
+    struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)skb->data;
+    unsigned int hdrlen = ieee80211_hdrlen(hdr->frame_control);
+    u8 aad[WIFI7_BIP_AAD_LEN];
+    u8 out[WIFI7_BIP_MIC_LEN_256];
+    int ret;
+    
+    wifi7_security_bip_aad(skb, aad);
+    
+    if (ctx->tfm_cmac) {
+        SHASH_DESC_ON_STACK(desc, ctx->tfm_cmac);
+        
+        desc->tfm = ctx->tfm_cmac;
+        ret = crypto_shash_init(desc);
+        if (!ret)
+            ret = crypto_shash_update(desc, aad, sizeof(aad));
+        if (!ret)
+            ret = crypto_shash_finup(desc, skb->data + hdrlen,
+                                     skb->len - hdrlen, out);
+        shash_desc_zero(desc);
+    } else {
+        struct scatterlist sg[3];
+        u8 nonce[WIFI7_BIP_GMAC_NONCE_LEN + 4];
+        int i;
+        
+        /* Nonce is A2 || IPN with the IPN in big-endian order */
+        memcpy(nonce, hdr->addr2, ETH_ALEN);
+        for (i = 0; i < WIFI7_BIP_IPN_LEN; i++)
+            nonce[ETH_ALEN + i] = ipn[WIFI7_BIP_IPN_LEN - 1 - i];
+        memset(nonce + WIFI7_BIP_GMAC_NONCE_LEN, 0, 4);
+        
+        sg_init_table(sg, 3);
+        sg_set_buf(&sg[0], aad, sizeof(aad));
+        sg_set_buf(&sg[1], skb->data + hdrlen, skb->len - hdrlen);
+        sg_set_buf(&sg[2], out, WIFI7_BIP_MIC_LEN_256);
+        
+        aead_request_set_crypt(ctx->req, sg, sg, 0, nonce);
+        aead_request_set_ad(ctx->req, sizeof(aad) + skb->len - hdrlen);
+        ret = crypto_aead_encrypt(ctx->req);
+    }
+    
+    if (!ret)
+        memcpy(mic, out, ctx->mic_len);
+    memzero_explicit(out, sizeof(out));
+    return ret;
+}
+
+/* Append an MME and fill in its MIC. Caller holds key_lock. */
+static int wifi7_security_bip_protect(struct wifi7_security *sec,
+                                      struct sk_buff *skb,
+                                      struct wifi7_sec_key *key)
+{
+    struct wifi7_sec_mic_ctx *ctx = key->mic_ctx;
+    unsigned int mme_len;
+    u8 *mme, *ipn;
+    u64 pn;
+    int i, ret;
+    
+    if (!ctx)
+        return -ENOKEY;
+        
+    /* EID, Len, KeyID(2), IPN(6), MIC */
+    mme_len = 2 + 2 + WIFI7_BIP_IPN_LEN + ctx->mic_len;
+    if (skb_tailroom(skb) < mme_len)
+        return -ENOSPC;
+        
+    pn = ++key->tsc;
+    
+    mme = skb_put(skb, mme_len);
+    mme[0] = WLAN_EID_MMIE;
+    mme[1] = mme_len - 2;
+    put_unaligned_le16(key->id, mme + 2);
+    ipn = mme + 4;
+    for (i = 0; i < WIFI7_BIP_IPN_LEN; i++)
+        ipn[i] = pn >> (8 * i);
+    memset(ipn + WIFI7_BIP_IPN_LEN, 0, ctx->mic_len);
+    
+    ret = wifi7_security_bip_mic(ctx, skb, ipn, ipn + WIFI7_BIP_IPN_LEN);
+    if (ret) {
+        skb_trim(skb, skb->len - mme_len);
+        wifi7_security_update_stats(sec, WIFI7_STAT_ENCRYPT_FAIL);
+        return ret;
+    }
+    
+    wifi7_security_update_stats(sec, WIFI7_STAT_PROTECTED);
+    return 0;
+}
+
+/* Check the trailing MME of a received frame. Caller holds key_lock. */
+static int wifi7_security_bip_verify(struct wifi7_security *sec,
+                                     struct sk_buff *skb,
+                                     struct wifi7_sec_key *key)
+{
+    struct wifi7_sec_mic_ctx *ctx = key->mic_ctx;
+    u8 rx_mic[WIFI7_BIP_MIC_LEN_256];
+    u8 calc_mic[WIFI7_BIP_MIC_LEN_256];
+    unsigned int mme_len;
+    u8 *mme, *ipn;
+    u64 pn = 0;
+    int i, ret;
+    
+    if (!ctx)
+        return -ENOKEY;
+        
+    mme_len = 2 + 2 + WIFI7_BIP_IPN_LEN + ctx->mic_len;
+    if (skb->len < ieee80211_hdrlen(((struct ieee80211_hdr *)
+                                     skb->data)->frame_control) + mme_len)
+        return -EINVAL;
+        
+    mme = skb->data + skb->len - mme_len;
+    if (mme[0] != WLAN_EID_MMIE || mme[1] != mme_len - 2 ||
+        get_unaligned_le16(mme + 2) != key->id)
+        return -EINVAL;
+        
+    ipn = mme + 4;
+    for (i = 0; i < WIFI7_BIP_IPN_LEN; i++)
+        pn |= (u64)ipn[i] << (8 * i);
+        
+    if (pn <= key->rsc[0]) {
+        wifi7_security_update_stats(sec, WIFI7_STAT_REPLAY_FAIL);
+        return -EINVAL;
+    }
+    
+    memcpy(rx_mic, ipn + WIFI7_BIP_IPN_LEN, ctx->mic_len);
+    memset(ipn + WIFI7_BIP_IPN_LEN, 0, ctx->mic_len);
+    
+    ret = wifi7_security_bip_mic(ctx, skb, ipn, calc_mic);
+    memcpy(ipn + WIFI7_BIP_IPN_LEN, rx_mic, ctx->mic_len);
+    if (ret)
+        return ret;
+        
+    if (crypto_memneq(rx_mic, calc_mic, ctx->mic_len)) {
+        wifi7_security_update_stats(sec, WIFI7_STAT_MIC_FAIL);
+        return -EBADMSG;
+    }
+    
+    key->rsc[0] = pn;
+    return 0;
+}
+
 static int wifi7_security_encrypt_frame(struct wifi7_security *sec,
                                       struct sk_buff *skb,
                                       struct wifi7_sec_key *key)
@@ -259,6 +515,7 @@ static int wifi7_security_decrypt_frame(struct wifi7_security *sec,
 static int wifi7_security_install_key(struct wifi7_security *sec,
                                     struct wifi7_sec_key *key)
 {
+    struct wifi7_sec_mic_ctx *mic_ctx = NULL;
     unsigned long flags;
     int ret = 0;
     
@@ -267,6 +524,15 @@ static int wifi7_security_install_key(struct wifi7_security *sec,
         return -EINVAL;
     }
     
+    if (key->type == WIFI7_KEY_TYPE_IGTK ||
+        key->type == WIFI7_KEY_TYPE_BIGTK) {
+        mic_ctx = wifi7_security_mic_ctx_alloc(key);
+        if (IS_ERR(mic_ctx)) {
+            wifi7_security_update_stats(sec, WIFI7_STAT_KEY_FAIL);
+            return PTR_ERR(mic_ctx);
+        }
+    }
+    
     spin_lock_irqsave(&sec->key_lock, flags);
     
     if (sec->num_keys >= WIFI7_SEC_MAX_KEYS) {
@@ -277,6 +543,8 @@ static int wifi7_security_install_key(struct wifi7_security *sec,
     memcpy(&sec->keys[sec->num_keys], key, sizeof(*key));
     atomic_set(&sec->keys[sec->num_keys].refcount, 1);
     spin_lock_init(&sec->keys[sec->num_keys].lock);
+    sec->keys[sec->num_keys].mic_ctx = mic_ctx;
+    mic_ctx = NULL;
     
     sec->num_keys++;
     
@@ -284,12 +552,14 @@ static int wifi7_security_install_key(struct wifi7_security *sec,
     
 out:
     spin_unlock_irqrestore(&sec->key_lock, flags);
+    wifi7_security_mic_ctx_free(mic_ctx);
     return ret;
 }
 
 static int wifi7_security_remove_key(struct wifi7_security *sec,
                                    u8 key_id)
 {
+    struct wifi7_sec_mic_ctx *mic_ctx = NULL;
     unsigned long flags;
     int i, ret = -ENOENT;
     
@@ -302,6 +572,8 @@ static int wifi7_security_remove_key(struct wifi7_security *sec,
                 goto out;
             }
             
+            mic_ctx = sec->keys[i].mic_ctx;
+            
             if (i < sec->num_keys - 1)
                 memmove(&sec->keys[i], &sec->keys[i + 1],
                        sizeof(struct wifi7_sec_key) * (sec->num_keys - i - 1));
@@ -316,6 +588,7 @@ static int wifi7_security_remove_key(struct wifi7_security *sec,
     
 out:
     spin_unlock_irqrestore(&sec->key_lock, flags);
+    wifi7_security_mic_ctx_free(mic_ctx);
     return ret;
 }
 
@@ -472,6 +745,7 @@ err_free:
 void wifi7_security_deinit(struct wifi7_dev *dev)
 {
     struct wifi7_security *sec = dev->security;
+    int i;
     
     if (!sec)
         return;
@@ -482,6 +756,9 @@ void wifi7_security_deinit(struct wifi7_dev *dev)
     
     debugfs_remove_recursive(sec->debugfs_dir);
     
+    for (i = 0; i < sec->num_keys; i++)
+        wifi7_security_mic_ctx_free(sec->keys[i].mic_ctx);
+    
     wifi7_security_free_crypto(sec);
     
     kfree(sec);
@@ -690,9 +967,7 @@ int wifi7_security_protect_mgmt(struct wifi7_dev *dev,
         if (key->type != WIFI7_KEY_TYPE_IGTK)
             continue;
             
-        ret = wifi7_security_encrypt_frame(sec, skb, key);
-        if (!ret)
-            wifi7_security_update_stats(sec, WIFI7_STAT_PROTECTED);
+        ret = wifi7_security_bip_protect(sec, skb, key);
         break;
     }
     
@@ -726,7 +1001,7 @@ int wifi7_security_verify_mgmt(struct wifi7_dev *dev,
         if (key->type != WIFI7_KEY_TYPE_IGTK)
             continue;
             
-        ret = wifi7_security_decrypt_frame(sec, skb, key);
+        ret = wifi7_security_bip_verify(sec, skb, key);
         break;
     }
     
@@ -734,6 +1009,64 @@ int wifi7_security_verify_mgmt(struct wifi7_dev *dev,
     return ret;
 }
 
+/*
+ * Protect a set of beacons (one per affiliated link of an MLD, or one per
+ * VIF) with the active BIGTK. The key lookup and lock are taken once for
+ * the whole set and every frame reuses the pre-keyed MIC context.
+ * Returns the number of beacons protected or a negative error.
+ */
+int wifi7_security_protect_beacons(struct wifi7_dev *dev,
+                                  struct sk_buff **skbs, int count)
+{
+    struct wifi7_security *sec = dev->security;
+    struct wifi7_sec_key *key = NULL;
+    unsigned long flags;
+    int i, ret = 0, done = 0;
+    
+    if (!sec || !skbs || count <= 0)
+        return -EINVAL;
+        
+    if (count > WIFI7_SEC_MAX_BEACON_BATCH)
+        count = WIFI7_SEC_MAX_BEACON_BATCH;
+        
+    spin_lock_irqsave(&sec->key_lock, flags);
+    
+    for (i = 0; i < sec->num_keys; i++) {
+        if ((sec->keys[i].flags & WIFI7_SEC_FLAG_VALID) &&
+            (sec->keys[i].flags & WIFI7_SEC_FLAG_ACTIVE) &&
+            sec->keys[i].type == WIFI7_KEY_TYPE_BIGTK) {
+            key = &sec->keys[i];
+            break;
+        }
+    }
+    
+    if (!key) {
+        ret = -ENOENT;
+        goto out;
+    }
+    
+    for (i = 0; i < count; i++) {
+        if (!skbs[i])
+            continue;
+            
+        ret = wifi7_security_bip_protect(sec, skbs[i], key);
+        if (ret)
+            break;
+        done++;
+    }
+    
+out:
+    spin_unlock_irqrestore(&sec->key_lock, flags);
+    
+    if (done) {
+        spin_lock_irqsave(&sec->stats_lock, flags);
+        sec->stats.beacon_batches++;
+        spin_unlock_irqrestore(&sec->stats_lock, flags);
+    }
+    
+    return done ? done : ret;
+}
+
 int wifi7_security_get_stats(struct wifi7_dev *dev,
                             struct wifi7_sec_stats *stats)
 {
@@ -13,6 +13,8 @@
 #include <crypto/aes.h>
 #include <crypto/gcm.h>
 #include <crypto/sha2.h>
+#include <crypto/hash.h>
+#include <crypto/aead.h>
 #include "../core/wifi7_core.h"
 
 /* Security capabilities */
@@ -50,12 +52,31 @@
 #define WIFI7_KEY_LEN_PMK           32  /* PMK length */
 #define WIFI7_KEY_LEN_PSK           32  /* PSK length */
 
+/* Cipher suites */
+#define WIFI7_CIPHER_NONE           0  /* Derive from key type/length */
+#define WIFI7_CIPHER_CCMP_128       1  /* CCMP-128 */
+#define WIFI7_CIPHER_CCMP_256       2  /* CCMP-256 */
+#define WIFI7_CIPHER_GCMP_128       3  /* GCMP-128 */
+#define WIFI7_CIPHER_GCMP_256       4  /* GCMP-256 */
+#define WIFI7_CIPHER_BIP_CMAC_128   5  /* BIP-CMAC-128 */
+#define WIFI7_CIPHER_BIP_CMAC_256   6  /* BIP-CMAC-256 */
+#define WIFI7_CIPHER_BIP_GMAC_128   7  /* BIP-GMAC-128 */
+#define WIFI7_CIPHER_BIP_GMAC_256   8  /* BIP-GMAC-256 */
+
+/* BIP parameters */
+#define WIFI7_BIP_AAD_LEN           20  /* FC + A1 + A2 + A3 */
+#define WIFI7_BIP_IPN_LEN           6   /* Integrity packet number */
+#define WIFI7_BIP_MIC_LEN_128       8   /* BIP-CMAC-128 MIC */
+#define WIFI7_BIP_MIC_LEN_256       16  /* BIP-CMAC-256 / BIP-GMAC MIC */
+#define WIFI7_BIP_GMAC_NONCE_LEN    12  /* A2 + IPN */
+
 /* Maximum values */
 #define WIFI7_SEC_MAX_KEYS          32  /* Maximum keys */
 #define WIFI7_SEC_MAX_PEERS         64  /* Maximum peers */
 #define WIFI7_SEC_MAX_LINKS         16  /* Maximum links */
 #define WIFI7_SEC_MAX_REPLAY        64  /* Replay window size */
 #define WIFI7_SEC_MAX_KEY_RSC       16  /* Maximum RSC size */
+#define WIFI7_SEC_MAX_BEACON_BATCH  16  /* Beacons per MIC batch */
 
 /* Security flags */
 #define WIFI7_SEC_FLAG_PMF_REQ      BIT(0)  /* PMF required */
@@ -67,6 +88,15 @@
 #define WIFI7_SEC_FLAG_VALID        BIT(6)  /* Key is valid */
 #define WIFI7_SEC_FLAG_ACTIVE       BIT(7)  /* Key is active */
 
+/* Pre-keyed BIP context, owned by an IGTK/BIGTK */
+struct wifi7_sec_mic_ctx {
+    u8 cipher;                /* BIP cipher suite */
+    u8 mic_len;               /* MIC length in MME */
+    struct crypto_shash *tfm_cmac; /* Keyed CMAC (BIP-CMAC) */
+    struct crypto_aead *tfm_gmac;  /* Keyed GCM (BIP-GMAC) */
+    struct aead_request *req;      /* Reused GMAC request */
+};
+
 /* Security key */
 struct wifi7_sec_key {
     u8 type;                   /* Key type */
@@ -80,6 +110,7 @@ struct wifi7_sec_key {
     u64 tsc;                  /* Transmit sequence counter */
     atomic_t refcount;        /* Reference count */
     spinlock_t lock;          /* Key lock */
+    struct wifi7_sec_mic_ctx *mic_ctx; /* BIP context (IGTK/BIGTK) */
 };
 
 /* Security peer */
@@ -132,6 +163,9 @@ struct wifi7_sec_stats {
     u32 hw_encryptions;      /* HW encryptions */
     u32 hw_decryptions;      /* HW decryptions */
     u32 hw_failures;         /* HW failures */
+    
+    /* Management frame protection */
+    u32 beacon_batches;      /* Batched beacon MIC runs */
 };
 
 /* Security device info */
@@ -208,6 +242,8 @@ int wifi7_security_protect_mgmt(struct wifi7_dev *dev,
                                struct sk_buff *skb);
 int wifi7_security_verify_mgmt(struct wifi7_dev *dev,
                               struct sk_buff *skb);
+int wifi7_security_protect_beacons(struct wifi7_dev *dev,
+                                  struct sk_buff **skbs, int count);
 
 int wifi7_security_get_stats(struct wifi7_dev *dev,
                             struct wifi7_sec_stats *stats);
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Stand-in for the wifi7 core header the src/mac headers include as
+ * "../core/wifi7_core.h". It is reached through -Itools/mac_sim/include,
+ * which makes that relative path land here.
+ *
+ * It holds the device structure the MAC components hang their state off
+ * and the driver glue they call out to. sim/glue.c implements the glue
+ * against the replay driver's link model.
+ */
+
+#ifndef __WIFI7_CORE_H
+#define __WIFI7_CORE_H
+
+#include <linux/types.h>
+#include <linux/skbuff.h>
+
+#define WIFI7_MAX_LINKS         8
+#define WIFI7_NUM_TIDS          8
+
+/* Offsets of the action category and code in a management action frame */
+#define IEEE80211_ACTION_CAT_OFFSET     24
+#define IEEE80211_ACTION_ACT_OFFSET     25
+
+struct wifi7_qos;
+struct wifi7_ba;
+struct wifi7_mlo;
+struct wifi7_pktgen;
+struct wifi7_mac_dev;
+struct wifi7_phy_dev;
+struct wifi7_mlo_metrics;
+
+struct wifi7_dev {
+    struct wifi67_priv *priv;
+    struct wifi7_mac_dev *mac;
+    struct wifi7_qos *qos;
+    struct wifi7_ba *ba;
+    struct wifi7_mlo *mlo;
+    struct wifi7_pktgen *pktgen;
+    struct dentry *debugfs_dir;
+};
+
+/* Matches the definition in src/mac/wifi7_mac_debugfs.c */
+struct wifi7_mac_stats {
+    u64 total_tx_bytes;
+    u64 total_rx_bytes;
+    u64 total_tx_packets;
+    u64 total_rx_packets;
+    u64 total_errors;
+    u32 active_links;
+    u32 link_switches;
+    u32 link_errors;
+    u32 ampdu_tx;
+    u32 ampdu_rx;
+    u32 multi_tid_tx;
+    u32 multi_tid_rx;
+    u32 power_save_entries;
+    u32 power_save_exits;
+    u64 sleep_time_ms;
+};
+
+/* Frame handoff */
+u16 wifi7_get_frame_ssn(struct sk_buff *skb);
+int wifi7_transmit_frame(struct wifi7_dev *dev, struct sk_buff *skb,
+                         u8 tid, u8 link_id);
+int wifi7_receive_frame(struct wifi7_dev *dev, struct sk_buff *skb,
+                        u8 tid, u8 link_id);
+
+/* RF link control */
+int wifi7_rf_setup_link(struct wifi7_dev *dev, u8 link_id, u8 band,
+                        u16 center_freq, u8 width, u8 primary_chan, u8 nss);
+void wifi7_rf_teardown_link(struct wifi7_dev *dev, u8 link_id);
+int wifi7_rf_switch_primary(struct wifi7_dev *dev, u8 link_id);
+int wifi7_rf_get_link_metrics(struct wifi7_dev *dev, u8 link_id,
+                              struct wifi7_mlo_metrics *metrics);
+
+#endif /* __WIFI7_CORE_H */
@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Driver glue the MAC components call out to: HAL metrics and power
+ * control, RF link setup, the MAC TX entry point and the frame handoff
+ * after aggregation and reordering. Everything here reports from or
+ * records into the replay driver's link model instead of hardware.
+ */
+
+#include "sim.h"
+#include "../../src/mac/wifi7_mac.h"
+#include "../../src/mac/wifi7_mlo.h"
+#include "../../src/hal/metrics.h"
+#include "../../src/hal/power.h"
+#include "../../include/debug/debug.h"
+#include "../../include/perf/perf_latency.h"
+
+struct sim_link sim_links[WIFI7_MAX_LINKS];
+struct sim_sink sim_agg_tx[WIFI7_NUM_TIDS];
+struct sim_sink sim_reorder_rx[WIFI7_NUM_TIDS];
+struct sim_sink sim_mac_tx[WIFI7_MAX_LINKS];
+u32 sim_mlo_switch_calls;
+u8 sim_mlo_primary;
+
+/* Logging */
+struct static_key_false wifi67_log_keys[WIFI67_LOG_NUM_SUBSYS *
+                                        WIFI67_LOG_NUM_LEVELS];
+
+static const char * const sim_log_subsys[WIFI67_LOG_NUM_SUBSYS] = {
+    "core", "dma", "mac", "agg", "ba", "qos", "mlo", "phy", "fw", "usb",
+};
+
+void __wifi67_log(struct wifi67_priv *priv, unsigned int subsys,
+                  unsigned int level, const char *fmt, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "[%10llu us] %s: ",
+            (unsigned long long)(sim_now_ns / NSEC_PER_USEC),
+            sim_log_subsys[subsys]);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+/* Info and debug levels are off by default; their keys turn them on */
+void sim_log_enable_all(void)
+{
+    int s;
+
+    for (s = 0; s < WIFI67_LOG_NUM_SUBSYS; s++) {
+        static_branch_enable(&wifi67_log_keys[WIFI67_LOG_KEY(s, WIFI67_LOG_INFO)]);
+        static_branch_enable(&wifi67_log_keys[WIFI67_LOG_KEY(s, WIFI67_LOG_DBG)]);
+    }
+}
+
+/* Latency stamps stay off; the sinks measure delay on the virtual clock */
+DEFINE_STATIC_KEY_FALSE(wifi67_lat_enabled);
+
+void __wifi67_lat_stamp(struct sk_buff *skb, enum wifi67_lat_point point)
+{
+}
+
+void __wifi67_lat_tx_done(struct wifi67_priv *priv, struct sk_buff *skb,
+                          u8 link_id)
+{
+}
+
+/* HAL metrics and power */
+int wifi67_get_radio_metrics(struct wifi67_priv *priv, u8 radio_id,
+                             struct wifi67_radio_metrics *metrics)
+{
+    struct sim_link *l;
+
+    if (radio_id >= WIFI7_MAX_LINKS || !sim_links[radio_id].up)
+        return -ENODEV;
+
+    l = &sim_links[radio_id];
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->rssi = l->rssi;
+    metrics->noise = l->noise;
+    metrics->snr = l->rssi - l->noise;
+    metrics->busy_percent = l->airtime;
+    return 0;
+}
+
+int wifi67_get_link_metrics(struct wifi67_priv *priv, u8 link_id,
+                            struct wifi67_link_metrics *metrics)
+{
+    struct sim_link *l;
+
+    if (link_id >= WIFI7_MAX_LINKS || !sim_links[link_id].up)
+        return -ENODEV;
+
+    l = &sim_links[link_id];
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->quality = 100 - l->loss;
+    metrics->airtime = l->airtime;
+    metrics->latency = l->latency;
+    metrics->jitter = l->jitter;
+    metrics->loss_percent = l->loss;
+    return 0;
+}
+
+int wifi67_get_power_stats(struct wifi67_priv *priv, u8 radio_id,
+                           struct wifi67_power_stats *stats)
+{
+    if (radio_id >= WIFI7_MAX_LINKS)
+        return -EINVAL;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->sleep_count = sim_links[radio_id].sleeping;
+    stats->wake_count = sim_links[radio_id].wakes;
+    return 0;
+}
+
+int wifi67_radio_sleep(struct wifi67_priv *priv, u8 radio_id, u8 sleep_mode)
+{
+    if (radio_id >= WIFI7_MAX_LINKS)
+        return -EINVAL;
+
+    if (!sim_links[radio_id].sleeping)
+        sim_links[radio_id].sleeps++;
+    sim_links[radio_id].sleeping = true;
+    return 0;
+}
+
+int wifi67_radio_wake(struct wifi67_priv *priv, u8 radio_id)
+{
+    if (radio_id >= WIFI7_MAX_LINKS)
+        return -EINVAL;
+
+    if (sim_links[radio_id].sleeping)
+        sim_links[radio_id].wakes++;
+    sim_links[radio_id].sleeping = false;
+    return 0;
+}
+
+/* RF link control */
+int wifi7_rf_setup_link(struct wifi7_dev *dev, u8 link_id, u8 band,
+                        u16 center_freq, u8 width, u8 primary_chan, u8 nss)
+{
+    if (link_id >= WIFI7_MAX_LINKS)
+        return -EINVAL;
+
+    sim_links[link_id].up = true;
+    return 0;
+}
+
+void wifi7_rf_teardown_link(struct wifi7_dev *dev, u8 link_id)
+{
+    if (link_id < WIFI7_MAX_LINKS)
+        sim_links[link_id].up = false;
+}
+
+int wifi7_rf_switch_primary(struct wifi7_dev *dev, u8 link_id)
+{
+    sim_mlo_primary = link_id;
+    return 0;
+}
+
+int wifi7_rf_get_link_metrics(struct wifi7_dev *dev, u8 link_id,
+                              struct wifi7_mlo_metrics *metrics)
+{
+    struct sim_link *l = &sim_links[link_id];
+
+    metrics->rssi = l->rssi;
+    metrics->noise = l->noise;
+    metrics->tx_rate = l->rate;
+    metrics->airtime = l->airtime;
+    metrics->latency = l->latency;
+    metrics->jitter = l->jitter;
+    metrics->loss = l->loss;
+    return 0;
+}
+
+int wifi7_mlo_switch_link(struct wifi7_dev *dev, u8 link_id)
+{
+    sim_mlo_switch_calls++;
+    if (link_id >= WIFI7_MAX_LINKS || !sim_links[link_id].up)
+        return -ENOLINK;
+
+    sim_mlo_primary = link_id;
+    return 0;
+}
+
+/* Frame handoff */
+void sim_sink_account(struct sim_sink *sink, struct sk_buff *skb, u16 sn)
+{
+    u64 delay_us = (sim_now_ns - skb->sim_born_ns) / NSEC_PER_USEC;
+
+    /* Sequence order only means something for the reorder path */
+    if (sink->seen && (s16)((u16)(sn - sink->last_sn) << 4) <= 0)
+        sink->out_of_order++;
+    sink->last_sn = sn;
+    sink->seen = true;
+
+    sink->frames++;
+    sink->bytes += skb->len;
+    sink->delay_sum_us += delay_us;
+    if (delay_us > sink->delay_max_us)
+        sink->delay_max_us = delay_us;
+}
+
+u16 wifi7_get_frame_ssn(struct sk_buff *skb)
+{
+    struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)skb->data;
+
+    if (skb->len < sizeof(*hdr))
+        return 0;
+    return IEEE80211_SEQ_TO_SN(le16_to_cpu(hdr->seq_ctrl));
+}
+
+int wifi7_transmit_frame(struct wifi7_dev *dev, struct sk_buff *skb,
+                         u8 tid, u8 link_id)
+{
+    sim_sink_account(&sim_agg_tx[tid], skb, wifi7_get_frame_ssn(skb));
+    /* TX order follows the aggregation tree, not arrival */
+    sim_agg_tx[tid].out_of_order = 0;
+    kfree_skb(skb);
+    return 0;
+}
+
+int wifi7_receive_frame(struct wifi7_dev *dev, struct sk_buff *skb,
+                        u8 tid, u8 link_id)
+{
+    sim_sink_account(&sim_reorder_rx[tid], skb, wifi7_get_frame_ssn(skb));
+    kfree_skb(skb);
+    return 0;
+}
+
+int wifi7_mac_tx_frame(struct wifi7_mac_dev *dev, struct sk_buff *skb,
+                       u8 link_id)
+{
+    if (link_id >= WIFI7_MAX_LINKS)
+        return -EINVAL;
+
+    sim_sink_account(&sim_mac_tx[link_id], skb, wifi7_get_frame_ssn(skb));
+    sim_mac_tx[link_id].out_of_order = 0;
+    kfree_skb(skb);
+    return 0;
+}
+
+void wifi7_mac_tx_flush(struct wifi7_mac_dev *dev)
+{
+}
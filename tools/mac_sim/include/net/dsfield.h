@@ -0,0 +1,2 @@
+/* Userspace stand-in, see tools/mac_sim/include/sim/kernel.h */
+#include <sim/kernel.h>
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * The slice of <linux/ieee80211.h> and <net/mac80211.h> the MAC code
+ * touches. Values match the kernel headers.
+ */
+
+#ifndef _SIM_IEEE80211_H_
+#define _SIM_IEEE80211_H_
+
+#include <limits.h>
+
+#define IEEE80211_FCTL_FTYPE            0x000c
+#define IEEE80211_FCTL_STYPE            0x00f0
+#define IEEE80211_FTYPE_MGMT            0x0000
+#define IEEE80211_FTYPE_DATA            0x0008
+#define IEEE80211_STYPE_ACTION          0x00d0
+#define IEEE80211_STYPE_QOS_DATA        0x0080
+
+#define IEEE80211_SCTL_FRAG             0x000F
+#define IEEE80211_SCTL_SEQ              0xFFF0
+#define IEEE80211_SEQ_TO_SN(seq)        (((seq) & IEEE80211_SCTL_SEQ) >> 4)
+#define IEEE80211_SN_TO_SEQ(ssn)        (((ssn) << 4) & IEEE80211_SCTL_SEQ)
+
+#define IEEE80211_QOS_CTL_TID_MASK      0x000f
+
+#define IEEE80211_BAR_CTRL_ACK_POLICY_NORMAL    0x0000
+#define IEEE80211_BAR_CTRL_MULTI_TID            0x0002
+#define IEEE80211_BAR_CTRL_CBMTID_COMPRESSED_BA 0x0004
+#define IEEE80211_BAR_CTRL_TID_INFO_MASK        0xf000
+#define IEEE80211_BAR_CTRL_TID_INFO_SHIFT       12
+
+#define WLAN_CATEGORY_BACK              3
+#define WLAN_ACTION_ADDBA_REQ           0
+#define WLAN_ACTION_ADDBA_RESP          1
+#define WLAN_ACTION_DELBA               2
+
+struct ieee80211_hdr {
+    __le16 frame_control;
+    __le16 duration_id;
+    u8 addr1[ETH_ALEN];
+    u8 addr2[ETH_ALEN];
+    u8 addr3[ETH_ALEN];
+    __le16 seq_ctrl;
+} __packed;
+
+struct ieee80211_qos_hdr {
+    __le16 frame_control;
+    __le16 duration_id;
+    u8 addr1[ETH_ALEN];
+    u8 addr2[ETH_ALEN];
+    u8 addr3[ETH_ALEN];
+    __le16 seq_ctrl;
+    __le16 qos_ctrl;
+} __packed;
+
+static inline bool ieee80211_is_data(__le16 fc)
+{
+    return (fc & cpu_to_le16(IEEE80211_FCTL_FTYPE)) ==
+           cpu_to_le16(IEEE80211_FTYPE_DATA);
+}
+
+/* mac80211 keeps this private; the MLO code only sets these two fields */
+struct ieee80211_link_data {
+    u8 hw_link_id;
+    bool valid;
+};
+
+static inline unsigned int hweight8(unsigned int w)
+{
+    return __builtin_popcount(w & 0xff);
+}
+
+#endif /* _SIM_IEEE80211_H_ */
@@ -0,0 +1,878 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Userspace stand-in for the kernel APIs used by the MAC scheduling,
+ * aggregation, block ack and MLO code. Every <linux/...> and <net/...>
+ * header those files include resolves here.
+ *
+ * The simulator is single-threaded and runs on a virtual clock that only
+ * the replay driver advances, so timers and delayed work fire
+ * deterministically and a trace replays identically every run. Spinlocks
+ * are checked rather than taken: relocking a held lock, or unlocking a
+ * free one, aborts with the site, which catches the self-deadlocks that
+ * would hang a real CPU.
+ */
+
+#ifndef _SIM_KERNEL_H_
+#define _SIM_KERNEL_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Keep the kernel-only driver headers out; sim provides what they define */
+#define _WIFI67_H_
+#define ENOTSUP EOPNOTSUPP
+
+/* Types */
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef long long s64;
+typedef u16 __le16;
+typedef u32 __le32;
+typedef u64 __le64;
+typedef u16 __be16;
+typedef u32 __be32;
+typedef u64 __be64;
+typedef s64 ktime_t;
+typedef u64 dma_addr_t;
+typedef unsigned int gfp_t;
+
+/* Compiler and helpers */
+#define __init
+#define __exit
+#define __packed                __attribute__((packed))
+#define __aligned(x)            __attribute__((aligned(x)))
+#define __printf(a, b)          __attribute__((format(printf, a, b)))
+#define __maybe_unused          __attribute__((unused))
+#define __must_check
+#define __iomem
+#define __force
+#define __user
+#define likely(x)               __builtin_expect(!!(x), 1)
+#define unlikely(x)             __builtin_expect(!!(x), 0)
+#define READ_ONCE(x)            (*(volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)        (*(volatile __typeof__(x) *)&(x) = (v))
+#define barrier()               __asm__ __volatile__("" ::: "memory")
+#define smp_mb()                __sync_synchronize()
+#define smp_rmb()               __sync_synchronize()
+#define smp_wmb()               __sync_synchronize()
+
+#define U16_MAX                 ((u16)~0U)
+#define U32_MAX                 ((u32)~0U)
+#define U64_MAX                 ((u64)~0ULL)
+#define BIT(n)                  (1UL << (n))
+#define GENMASK(h, l)           ((~0UL << (l)) & (~0UL >> (BITS_PER_LONG - 1 - (h))))
+#define BITS_PER_LONG           (8 * sizeof(long))
+#define BITS_TO_LONGS(n)        (((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define ARRAY_SIZE(a)           (sizeof(a) / sizeof((a)[0]))
+#define DIV_ROUND_UP(n, d)      (((n) + (d) - 1) / (d))
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define min(a, b)               ((a) < (b) ? (a) : (b))
+#define max(a, b)               ((a) > (b) ? (a) : (b))
+#define min_t(t, a, b)          ((t)(a) < (t)(b) ? (t)(a) : (t)(b))
+#define max_t(t, a, b)          ((t)(a) > (t)(b) ? (t)(a) : (t)(b))
+#define clamp(v, lo, hi)        min(max(v, lo), hi)
+#define clamp_t(t, v, lo, hi)   min_t(t, max_t(t, v, lo), hi)
+
+static inline u64 div_u64(u64 n, u32 d) { return n / d; }
+static inline s64 div_s64(s64 n, s32 d) { return n / d; }
+static inline u64 div64_u64(u64 n, u64 d) { return n / d; }
+
+/* The simulator only targets little-endian hosts */
+#define cpu_to_le16(x)          ((__le16)(x))
+#define cpu_to_le32(x)          ((__le32)(x))
+#define le16_to_cpu(x)          ((u16)(x))
+#define le32_to_cpu(x)          ((u32)(x))
+#define cpu_to_be16(x)          __builtin_bswap16(x)
+#define be16_to_cpu(x)          __builtin_bswap16(x)
+#define cpu_to_be32(x)          __builtin_bswap32(x)
+#define be32_to_cpu(x)          __builtin_bswap32(x)
+#define cpu_to_be64(x)          __builtin_bswap64(x)
+#define be64_to_cpu(x)          __builtin_bswap64(x)
+
+/* Kconfig */
+#define __ARG_PLACEHOLDER_1     0,
+#define __take_second_arg(__ignored, val, ...) val
+#define __is_defined(x)         ___is_defined(x)
+#define ___is_defined(val)      ____is_defined(__ARG_PLACEHOLDER_##val)
+#define ____is_defined(arg1_or_junk) __take_second_arg(arg1_or_junk 1, 0)
+#define IS_ENABLED(option)      __is_defined(option)
+
+/* Options the simulator builds in */
+#define CONFIG_WIFI7_MAC_PKTGEN 1
+
+/* Modules */
+#define module_init(fn)         static int (*__sim_module_init)(void) __maybe_unused = fn
+#define module_exit(fn)         static void (*__sim_module_exit)(void) __maybe_unused = fn
+#define module_param(n, t, p)
+#define MODULE_PARM_DESC(n, d)
+#define MODULE_LICENSE(x)
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_VERSION(x)
+#define EXPORT_SYMBOL(x)
+#define EXPORT_SYMBOL_GPL(x)
+#define THIS_MODULE             NULL
+
+/* Logging */
+extern int sim_verbose;
+#define pr_info(fmt, ...) \
+    do { if (sim_verbose > 1) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define pr_warn(fmt, ...)       fprintf(stderr, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...)        fprintf(stderr, fmt, ##__VA_ARGS__)
+#define pr_debug(fmt, ...) \
+    do { if (sim_verbose > 2) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define WARN_ON(c)              ({ bool _c = !!(c); if (_c) \
+    fprintf(stderr, "WARNING at %s:%d\n", __FILE__, __LINE__); _c; })
+#define WARN_ON_ONCE(c)         WARN_ON(c)
+#define BUG_ON(c)               do { if (c) sim_bug(__FILE__, __LINE__, #c); } while (0)
+
+void sim_bug(const char *file, int line, const char *what) __attribute__((noreturn));
+
+/* Allocation */
+#define GFP_KERNEL              0u
+#define GFP_ATOMIC              1u
+void *sim_alloc(size_t size, bool zero);
+void sim_free(const void *p);
+#define kmalloc(s, g)           sim_alloc(s, false)
+#define kzalloc(s, g)           sim_alloc(s, true)
+#define kcalloc(n, s, g)        sim_alloc((size_t)(n) * (s), true)
+#define kfree(p)                sim_free(p)
+
+/* Virtual time */
+extern u64 sim_now_ns;
+#define NSEC_PER_USEC           1000ULL
+#define NSEC_PER_MSEC           1000000ULL
+#define NSEC_PER_SEC            1000000000ULL
+#define USEC_PER_SEC            1000000ULL
+#define MSEC_PER_SEC            1000ULL
+#define HZ                      1000
+#define jiffies                 ((unsigned long)(sim_now_ns / (NSEC_PER_SEC / HZ)))
+
+static inline ktime_t ktime_get(void) { return (ktime_t)sim_now_ns; }
+static inline u64 ktime_get_ns(void) { return sim_now_ns; }
+static inline ktime_t ktime_sub(ktime_t a, ktime_t b) { return a - b; }
+static inline ktime_t ktime_add_us(ktime_t t, u64 us) { return t + us * 1000; }
+static inline ktime_t ktime_sub_us(ktime_t t, u64 us) { return t - us * 1000; }
+static inline s64 ktime_to_ns(ktime_t t) { return t; }
+static inline s64 ktime_to_us(ktime_t t) { return t / 1000; }
+static inline s64 ktime_to_ms(ktime_t t) { return t / 1000000; }
+static inline s64 ktime_us_delta(ktime_t a, ktime_t b) { return (a - b) / 1000; }
+static inline s64 ktime_ms_delta(ktime_t a, ktime_t b) { return (a - b) / 1000000; }
+static inline unsigned long msecs_to_jiffies(unsigned int ms) { return ms * HZ / 1000; }
+static inline unsigned int jiffies_to_msecs(unsigned long j) { return j * 1000 / HZ; }
+#define time_after(a, b)        ((long)((b) - (a)) < 0)
+#define time_before(a, b)       time_after(b, a)
+#define udelay(us)              (sim_now_ns += (us) * NSEC_PER_USEC)
+
+/* Locks */
+typedef struct {
+    const char *held_at;
+    u64 acquisitions;
+} spinlock_t;
+
+void sim_lock(spinlock_t *lock, const char *site);
+void sim_unlock(spinlock_t *lock, const char *site);
+
+#define __SIM_SITE(f, l)        f ":" #l
+#define _SIM_SITE(f, l)         __SIM_SITE(f, l)
+#define SIM_SITE                _SIM_SITE(__FILE__, __LINE__)
+
+#define DEFINE_SPINLOCK(x)      spinlock_t x = { 0 }
+#define spin_lock_init(l)       memset((l), 0, sizeof(*(l)))
+#define spin_lock(l)            sim_lock(l, SIM_SITE)
+#define spin_unlock(l)          sim_unlock(l, SIM_SITE)
+#define spin_lock_bh(l)         sim_lock(l, SIM_SITE)
+#define spin_unlock_bh(l)       sim_unlock(l, SIM_SITE)
+#define spin_lock_irqsave(l, f) do { (f) = 0; sim_lock(l, SIM_SITE); } while (0)
+#define spin_unlock_irqrestore(l, f) do { (void)(f); sim_unlock(l, SIM_SITE); } while (0)
+
+struct mutex {
+    spinlock_t lock;
+};
+#define mutex_init(m)           spin_lock_init(&(m)->lock)
+#define mutex_destroy(m)        do { } while (0)
+#define mutex_lock(m)           sim_lock(&(m)->lock, SIM_SITE)
+#define mutex_unlock(m)         sim_unlock(&(m)->lock, SIM_SITE)
+
+struct completion {
+    unsigned int done;
+};
+#define init_completion(c)      ((c)->done = 0)
+#define complete(c)             ((c)->done++)
+
+/* Atomics: single-threaded, so plain integers */
+typedef struct { int counter; } atomic_t;
+typedef struct { s64 counter; } atomic64_t;
+#define ATOMIC_INIT(i)          { (i) }
+#define atomic_read(a)          ((a)->counter)
+#define atomic_set(a, i)        ((a)->counter = (i))
+#define atomic_inc(a)           ((a)->counter++)
+#define atomic_dec(a)           ((a)->counter--)
+#define atomic_add(i, a)        ((a)->counter += (i))
+#define atomic_sub(i, a)        ((a)->counter -= (i))
+#define atomic_inc_return(a)    (++(a)->counter)
+#define atomic_dec_return(a)    (--(a)->counter)
+#define atomic64_read(a)        ((a)->counter)
+#define atomic64_set(a, i)      ((a)->counter = (i))
+#define atomic64_inc(a)         ((a)->counter++)
+#define atomic64_add(i, a)      ((a)->counter += (i))
+
+/* Static keys and ratelimits: always evaluated */
+struct static_key_false {
+    bool enabled;
+};
+#define DECLARE_STATIC_KEY_FALSE(name)  extern struct static_key_false name
+#define DEFINE_STATIC_KEY_FALSE(name)   struct static_key_false name = { false }
+#define static_branch_unlikely(k)       unlikely((k)->enabled)
+#define static_branch_likely(k)         likely((k)->enabled)
+#define static_branch_enable(k)         ((k)->enabled = true)
+#define static_branch_disable(k)        ((k)->enabled = false)
+
+struct ratelimit_state {
+    int unused;
+};
+#define DEFAULT_RATELIMIT_INTERVAL      (5 * HZ)
+#define DEFAULT_RATELIMIT_BURST         10
+#define DEFINE_RATELIMIT_STATE(n, i, b) struct ratelimit_state n = { 0 }
+#define __ratelimit(rs)                 ((void)(rs), 1)
+
+/* Bitmaps */
+#define DECLARE_BITMAP(name, bits)      unsigned long name[BITS_TO_LONGS(bits)]
+
+#define hweight32(w)            __builtin_popcount((u32)(w))
+#define __ffs(w)                ((unsigned long)__builtin_ctzl(w))
+
+static inline void set_bit(unsigned int nr, unsigned long *addr)
+{
+    addr[nr / BITS_PER_LONG] |= 1UL << (nr % BITS_PER_LONG);
+}
+
+static inline void clear_bit(unsigned int nr, unsigned long *addr)
+{
+    addr[nr / BITS_PER_LONG] &= ~(1UL << (nr % BITS_PER_LONG));
+}
+
+static inline bool test_bit(unsigned int nr, const unsigned long *addr)
+{
+    return addr[nr / BITS_PER_LONG] & (1UL << (nr % BITS_PER_LONG));
+}
+
+static inline void bitmap_zero(unsigned long *dst, unsigned int nbits)
+{
+    memset(dst, 0, BITS_TO_LONGS(nbits) * sizeof(long));
+}
+
+static inline unsigned int find_next_bit(const unsigned long *addr,
+                                         unsigned int size, unsigned int off)
+{
+    for (; off < size; off++)
+        if (test_bit(off, addr))
+            return off;
+    return size;
+}
+
+static inline bool bitmap_empty(const unsigned long *src, unsigned int nbits)
+{
+    return find_next_bit(src, nbits, 0) == nbits;
+}
+
+#define for_each_set_bit(bit, addr, size)                                   \
+    for ((bit) = find_next_bit((addr), (size), 0); (bit) < (size);          \
+         (bit) = find_next_bit((addr), (size), (bit) + 1))
+
+/* Lists */
+struct list_head {
+    struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name)    { &(name), &(name) }
+#define LIST_HEAD(name)         struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *l)
+{
+    l->next = l;
+    l->prev = l;
+}
+
+static inline void __list_add(struct list_head *n, struct list_head *prev,
+                              struct list_head *next)
+{
+    next->prev = n;
+    n->next = next;
+    n->prev = prev;
+    prev->next = n;
+}
+
+static inline void list_add(struct list_head *n, struct list_head *head)
+{
+    __list_add(n, head, head->next);
+}
+
+static inline void list_add_tail(struct list_head *n, struct list_head *head)
+{
+    __list_add(n, head->prev, head);
+}
+
+static inline void list_del(struct list_head *e)
+{
+    e->next->prev = e->prev;
+    e->prev->next = e->next;
+    e->next = e->prev = NULL;
+}
+
+static inline void list_del_init(struct list_head *e)
+{
+    e->next->prev = e->prev;
+    e->prev->next = e->next;
+    INIT_LIST_HEAD(e);
+}
+
+static inline bool list_empty(const struct list_head *head)
+{
+    return head->next == head;
+}
+
+static inline void list_splice_init(struct list_head *list,
+                                    struct list_head *head)
+{
+    if (!list_empty(list)) {
+        struct list_head *first = list->next, *last = list->prev;
+
+        first->prev = head;
+        last->next = head->next;
+        head->next->prev = last;
+        head->next = first;
+        INIT_LIST_HEAD(list);
+    }
+}
+
+#define list_entry(ptr, type, member)   container_of(ptr, type, member)
+#define list_first_entry(ptr, type, member) list_entry((ptr)->next, type, member)
+#define list_for_each_entry(pos, head, member)                              \
+    for (pos = list_entry((head)->next, __typeof__(*pos), member);          \
+         &pos->member != (head);                                            \
+         pos = list_entry(pos->member.next, __typeof__(*pos), member))
+#define list_for_each_entry_safe(pos, n, head, member)                      \
+    for (pos = list_entry((head)->next, __typeof__(*pos), member),          \
+         n = list_entry(pos->member.next, __typeof__(*pos), member);        \
+         &pos->member != (head);                                            \
+         pos = n, n = list_entry(n->member.next, __typeof__(*n), member))
+
+/* Red-black trees (sim/rbtree.c) */
+struct rb_node {
+    struct rb_node *rb_parent;
+    struct rb_node *rb_left;
+    struct rb_node *rb_right;
+    bool rb_red;
+};
+
+struct rb_root {
+    struct rb_node *rb_node;
+};
+
+#define RB_ROOT                 (struct rb_root) { NULL }
+#define RB_EMPTY_ROOT(root)     ((root)->rb_node == NULL)
+#define rb_entry(ptr, type, member) container_of(ptr, type, member)
+
+static inline void rb_link_node(struct rb_node *node, struct rb_node *parent,
+                                struct rb_node **link)
+{
+    node->rb_parent = parent;
+    node->rb_left = node->rb_right = NULL;
+    node->rb_red = true;
+    *link = node;
+}
+
+void rb_insert_color(struct rb_node *node, struct rb_root *root);
+void rb_erase(struct rb_node *node, struct rb_root *root);
+struct rb_node *rb_first(const struct rb_root *root);
+struct rb_node *rb_next(const struct rb_node *node);
+
+/* Timers and deferred work (sim/sched.c) */
+struct sim_event {
+    struct sim_event *next;
+    u64 expires_ns;
+    bool pending;
+    void (*fire)(struct sim_event *ev);
+};
+
+struct timer_list {
+    struct sim_event ev;
+    unsigned long expires;
+    void (*function)(struct timer_list *t);
+};
+
+struct work_struct {
+    struct sim_event ev;
+    void (*func)(struct work_struct *work);
+};
+
+struct delayed_work {
+    struct work_struct work;
+};
+
+struct workqueue_struct {
+    const char *name;
+};
+
+void sim_event_arm(struct sim_event *ev, u64 expires_ns);
+bool sim_event_cancel(struct sim_event *ev);
+void sim_timer_fire(struct sim_event *ev);
+void sim_work_fire(struct sim_event *ev);
+
+#define from_timer(var, t, field)   container_of(t, __typeof__(*var), field)
+
+static inline void timer_setup(struct timer_list *t,
+                               void (*fn)(struct timer_list *), unsigned int f)
+{
+    memset(t, 0, sizeof(*t));
+    t->function = fn;
+    t->ev.fire = sim_timer_fire;
+}
+
+static inline int mod_timer(struct timer_list *t, unsigned long expires)
+{
+    bool was = t->ev.pending;
+
+    t->expires = expires;
+    sim_event_arm(&t->ev, (u64)expires * (NSEC_PER_SEC / HZ));
+    return was;
+}
+
+#define del_timer(t)            sim_event_cancel(&(t)->ev)
+#define del_timer_sync(t)       sim_event_cancel(&(t)->ev)
+#define timer_pending(t)        ((t)->ev.pending)
+
+#define INIT_WORK(w, fn)                                                    \
+    do {                                                                    \
+        memset((w), 0, sizeof(*(w)));                                       \
+        (w)->func = (fn);                                                   \
+        (w)->ev.fire = sim_work_fire;                                       \
+    } while (0)
+#define INIT_DELAYED_WORK(dw, fn)   INIT_WORK(&(dw)->work, fn)
+
+static inline struct delayed_work *to_delayed_work(struct work_struct *w)
+{
+    return container_of(w, struct delayed_work, work);
+}
+
+static inline bool schedule_work(struct work_struct *w)
+{
+    if (w->ev.pending)
+        return false;
+    sim_event_arm(&w->ev, sim_now_ns);
+    return true;
+}
+
+static inline bool schedule_delayed_work(struct delayed_work *dw,
+                                         unsigned long delay)
+{
+    if (dw->work.ev.pending)
+        return false;
+    sim_event_arm(&dw->work.ev, sim_now_ns + delay * (NSEC_PER_SEC / HZ));
+    return true;
+}
+
+#define queue_work(wq, w)               schedule_work(w)
+#define queue_delayed_work(wq, dw, d)   schedule_delayed_work(dw, d)
+#define cancel_work_sync(w)             sim_event_cancel(&(w)->ev)
+#define cancel_delayed_work(dw)         sim_event_cancel(&(dw)->work.ev)
+#define cancel_delayed_work_sync(dw)    sim_event_cancel(&(dw)->work.ev)
+#define flush_workqueue(wq)             do { } while (0)
+#define WQ_HIGHPRI                      0
+#define WQ_UNBOUND                      0
+#define WQ_FREEZABLE                    0
+#define WQ_MEM_RECLAIM                  0
+
+static inline struct workqueue_struct *alloc_workqueue(const char *n, int f, int a)
+{
+    struct workqueue_struct *wq = sim_alloc(sizeof(*wq), true);
+
+    if (wq)
+        wq->name = n;
+    return wq;
+}
+#define create_singlethread_workqueue(n)    alloc_workqueue(n, 0, 1)
+#define destroy_workqueue(wq)               sim_free(wq)
+
+/* Socket buffers (sim/skb.c) */
+#define ETH_ALEN                6
+
+struct sk_buff {
+    struct sk_buff *next;
+    struct sk_buff *prev;
+    unsigned int len;
+    u32 priority;
+    u16 queue_mapping;
+    u8 *head;
+    u8 *data;
+    u8 *tail;
+    u8 *end;
+    char cb[48] __aligned(8);
+    /* Simulator bookkeeping, not a kernel field */
+    u64 sim_born_ns;
+    u32 sim_id;
+};
+
+struct sk_buff_head {
+    struct sk_buff *next;
+    struct sk_buff *prev;
+    u32 qlen;
+    spinlock_t lock;
+};
+
+struct sk_buff *alloc_skb(unsigned int size, gfp_t gfp);
+void kfree_skb(struct sk_buff *skb);
+#define dev_kfree_skb(skb)      kfree_skb(skb)
+#define dev_kfree_skb_any(skb)  kfree_skb(skb)
+#define consume_skb(skb)        kfree_skb(skb)
+
+static inline void *skb_put(struct sk_buff *skb, unsigned int len)
+{
+    u8 *tmp = skb->tail;
+
+    BUG_ON(skb->tail + len > skb->end);
+    skb->tail += len;
+    skb->len += len;
+    return tmp;
+}
+
+static inline void *skb_put_zero(struct sk_buff *skb, unsigned int len)
+{
+    return memset(skb_put(skb, len), 0, len);
+}
+
+static inline void skb_reserve(struct sk_buff *skb, unsigned int len)
+{
+    skb->data += len;
+    skb->tail += len;
+}
+
+static inline void *skb_push(struct sk_buff *skb, unsigned int len)
+{
+    BUG_ON(skb->data - len < skb->head);
+    skb->data -= len;
+    skb->len += len;
+    return skb->data;
+}
+
+static inline void *skb_pull(struct sk_buff *skb, unsigned int len)
+{
+    if (len > skb->len)
+        return NULL;
+    skb->len -= len;
+    return skb->data += len;
+}
+
+static inline u16 skb_get_queue_mapping(const struct sk_buff *skb)
+{
+    return skb->queue_mapping;
+}
+
+static inline void skb_set_queue_mapping(struct sk_buff *skb, u16 q)
+{
+    skb->queue_mapping = q;
+}
+
+static inline void __skb_queue_head_init(struct sk_buff_head *list)
+{
+    list->prev = list->next = (struct sk_buff *)list;
+    list->qlen = 0;
+}
+
+static inline void skb_queue_head_init(struct sk_buff_head *list)
+{
+    spin_lock_init(&list->lock);
+    __skb_queue_head_init(list);
+}
+
+static inline u32 skb_queue_len(const struct sk_buff_head *list)
+{
+    return list->qlen;
+}
+
+static inline u32 skb_queue_len_lockless(const struct sk_buff_head *list)
+{
+    return list->qlen;
+}
+
+static inline bool skb_queue_empty(const struct sk_buff_head *list)
+{
+    return list->next == (const struct sk_buff *)list;
+}
+
+static inline struct sk_buff *skb_peek(const struct sk_buff_head *list)
+{
+    struct sk_buff *skb = list->next;
+
+    return skb == (const struct sk_buff *)list ? NULL : skb;
+}
+
+static inline void __skb_insert(struct sk_buff *n, struct sk_buff *prev,
+                                struct sk_buff *next, struct sk_buff_head *list)
+{
+    n->next = next;
+    n->prev = prev;
+    next->prev = prev->next = n;
+    list->qlen++;
+}
+
+static inline void __skb_unlink(struct sk_buff *skb, struct sk_buff_head *list)
+{
+    list->qlen--;
+    skb->next->prev = skb->prev;
+    skb->prev->next = skb->next;
+    skb->next = skb->prev = NULL;
+}
+
+static inline void __skb_queue_tail(struct sk_buff_head *list,
+                                    struct sk_buff *n)
+{
+    __skb_insert(n, list->prev, (struct sk_buff *)list, list);
+}
+
+static inline void __skb_queue_head(struct sk_buff_head *list,
+                                    struct sk_buff *n)
+{
+    __skb_insert(n, (struct sk_buff *)list, list->next, list);
+}
+
+static inline struct sk_buff *__skb_dequeue(struct sk_buff_head *list)
+{
+    struct sk_buff *skb = skb_peek(list);
+
+    if (skb)
+        __skb_unlink(skb, list);
+    return skb;
+}
+
+static inline void skb_queue_tail(struct sk_buff_head *list, struct sk_buff *n)
+{
+    sim_lock(&list->lock, SIM_SITE);
+    __skb_queue_tail(list, n);
+    sim_unlock(&list->lock, SIM_SITE);
+}
+
+static inline void skb_queue_head(struct sk_buff_head *list, struct sk_buff *n)
+{
+    sim_lock(&list->lock, SIM_SITE);
+    __skb_queue_head(list, n);
+    sim_unlock(&list->lock, SIM_SITE);
+}
+
+static inline struct sk_buff *skb_dequeue(struct sk_buff_head *list)
+{
+    struct sk_buff *skb;
+
+    sim_lock(&list->lock, SIM_SITE);
+    skb = __skb_dequeue(list);
+    sim_unlock(&list->lock, SIM_SITE);
+    return skb;
+}
+
+static inline void skb_unlink(struct sk_buff *skb, struct sk_buff_head *list)
+{
+    sim_lock(&list->lock, SIM_SITE);
+    __skb_unlink(skb, list);
+    sim_unlock(&list->lock, SIM_SITE);
+}
+
+static inline void skb_queue_purge(struct sk_buff_head *list)
+{
+    struct sk_buff *skb;
+
+    while ((skb = skb_dequeue(list)))
+        kfree_skb(skb);
+}
+
+static inline void __skb_queue_purge(struct sk_buff_head *list)
+{
+    struct sk_buff *skb;
+
+    while ((skb = __skb_dequeue(list)))
+        kfree_skb(skb);
+}
+
+/* Ethernet */
+static inline bool ether_addr_equal(const u8 *a, const u8 *b)
+{
+    return !memcmp(a, b, ETH_ALEN);
+}
+
+static inline void ether_addr_copy(u8 *dst, const u8 *src)
+{
+    memcpy(dst, src, ETH_ALEN);
+}
+
+static inline bool is_multicast_ether_addr(const u8 *addr)
+{
+    return addr[0] & 1;
+}
+
+static inline bool is_valid_ether_addr(const u8 *addr)
+{
+    static const u8 zero[ETH_ALEN];
+
+    return !is_multicast_ether_addr(addr) && memcmp(addr, zero, ETH_ALEN);
+}
+
+static inline bool mac_pton(const char *s, u8 *mac)
+{
+    unsigned int b[ETH_ALEN];
+    int i, n;
+
+    if (sscanf(s, "%2x:%2x:%2x:%2x:%2x:%2x%n", &b[0], &b[1], &b[2], &b[3],
+               &b[4], &b[5], &n) != ETH_ALEN || s[n])
+        return false;
+    for (i = 0; i < ETH_ALEN; i++)
+        mac[i] = b[i];
+    return true;
+}
+
+/* Randomness and checksums, seeded by the replay driver */
+u32 get_random_u32(void);
+#define prandom_u32()           get_random_u32()
+u32 crc32_le(u32 crc, const u8 *p, size_t len);
+
+/*
+ * debugfs: nothing is created without a kernel. The file operations
+ * still compile, and seq_file shows print to a stdio stream so the
+ * replay driver can call them for its report.
+ */
+struct dentry;
+struct inode;
+
+struct file {
+    void *private_data;
+};
+
+struct seq_file {
+    FILE *file;
+    void *private;
+};
+
+struct file_operations {
+    void *owner;
+    int (*open)(struct inode *inode, struct file *file);
+    ssize_t (*read)(struct file *file, char __user *buf, size_t count,
+                    loff_t *ppos);
+    ssize_t (*write)(struct file *file, const char __user *buf,
+                     size_t count, loff_t *ppos);
+    loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+    int (*release)(struct inode *inode, struct file *file);
+};
+
+static inline struct dentry *debugfs_create_dir(const char *name,
+                                                struct dentry *parent)
+{
+    return NULL;
+}
+
+static inline struct dentry *debugfs_create_file(const char *name, int mode,
+        struct dentry *parent, void *data, const struct file_operations *fops)
+{
+    return NULL;
+}
+
+static inline void debugfs_create_u32(const char *name, int mode,
+                                      struct dentry *parent, u32 *value)
+{
+}
+
+#define debugfs_create_x32(n, m, p, v)  debugfs_create_u32(n, m, p, v)
+
+static inline void debugfs_remove_recursive(struct dentry *dentry)
+{
+}
+
+#define DEFINE_SHOW_ATTRIBUTE(__name) \
+    static const struct file_operations __name##_fops __maybe_unused = { }
+
+#define seq_printf(m, fmt, ...) fprintf((m)->file, fmt, ##__VA_ARGS__)
+
+static inline int simple_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static inline loff_t default_llseek(struct file *file, loff_t offset,
+                                    int whence)
+{
+    return -ESPIPE;
+}
+
+static inline ssize_t simple_read_from_buffer(void __user *to, size_t count,
+                                              loff_t *ppos, const void *from,
+                                              size_t available)
+{
+    size_t n;
+
+    if (*ppos < 0 || (size_t)*ppos >= available)
+        return 0;
+    n = min(count, available - (size_t)*ppos);
+    memcpy(to, (const char *)from + *ppos, n);
+    *ppos += n;
+    return n;
+}
+
+static inline unsigned long copy_from_user(void *to, const void __user *from,
+                                           unsigned long n)
+{
+    memcpy(to, from, n);
+    return 0;
+}
+
+/* Strings */
+#define scnprintf(buf, size, fmt, ...) \
+    ({ int _n = snprintf(buf, size, fmt, ##__VA_ARGS__); \
+       _n < 0 ? 0 : min_t(int, _n, (int)(size) - 1); })
+
+static inline char *strim(char *s)
+{
+    size_t len;
+
+    while (*s == ' ' || *s == '\t' || *s == '\n')
+        s++;
+    len = strlen(s);
+    while (len && (s[len - 1] == ' ' || s[len - 1] == '\t' ||
+                   s[len - 1] == '\n'))
+        s[--len] = '\0';
+    return s;
+}
+
+/* Equal up to one trailing newline on either side */
+static inline bool sysfs_streq(const char *s1, const char *s2)
+{
+    while (*s1 && *s1 == *s2) {
+        s1++;
+        s2++;
+    }
+    if (*s1 == *s2)
+        return true;
+    if (!*s1 && *s2 == '\n' && !s2[1])
+        return true;
+    if (*s1 == '\n' && !s1[1] && !*s2)
+        return true;
+    return false;
+}
+
+struct device;
+
+#include <sim/ieee80211.h>
+#include <sim/tracepoint.h>
+#include <sim/wifi67.h>
+
+#endif /* _SIM_KERNEL_H_ */
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Tracepoints become counters. Each trace_<event>() call bumps a per-event
+ * hit count that the replay driver prints with its report, so a trace run
+ * shows how often the window moved or a link switch was attempted without
+ * any tracing infrastructure.
+ */
+
+#ifndef _SIM_TRACEPOINT_H_
+#define _SIM_TRACEPOINT_H_
+
+void sim_trace_hit(const char *event);
+
+#define PARAMS(args...)                 args
+#define TP_PROTO(args...)               args
+#define TP_ARGS(args...)                args
+#define TP_STRUCT__entry(args...)
+#define TP_fast_assign(args...)
+#define TP_printk(fmt, args...)
+
+#define DECLARE_EVENT_CLASS(name, proto, args, tstruct, assign, print)
+
+#define DEFINE_EVENT(template, name, proto, args)                           \
+    static inline void __maybe_unused trace_##name(proto)                   \
+    {                                                                       \
+        sim_trace_hit(#name);                                               \
+    }
+
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print)              \
+    DEFINE_EVENT(name, name, PARAMS(proto), PARAMS(args))
+
+#endif /* _SIM_TRACEPOINT_H_ */
@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Stand-in for include/core/wifi67.h. The real device structure drags in
+ * PCI, firmware and the rest of the HAL; the MAC code only reaches the
+ * MLO link list through it.
+ */
+
+#ifndef _SIM_WIFI67_H_
+#define _SIM_WIFI67_H_
+
+struct wifi67_priv {
+    struct {
+        u8 max_mlo_links;
+    } hw_cap;
+    struct list_head mlo_links;
+    spinlock_t mlo_lock;
+};
+
+#endif /* _SIM_WIFI67_H_ */
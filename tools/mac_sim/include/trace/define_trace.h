@@ -0,0 +1 @@
+/* Tracepoints count hits in the simulator, see sim/tracepoint.h */
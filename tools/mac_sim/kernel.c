@@ -0,0 +1,452 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Runtime behind include/sim/kernel.h: allocation accounting, checked
+ * locks, the virtual clock and its event list, socket buffers, the
+ * red-black tree and the small library helpers.
+ */
+
+#include <sim/kernel.h>
+#include "sim.h"
+
+int sim_verbose;
+u64 sim_now_ns;
+struct sim_counters sim_counters;
+
+void sim_bug(const char *file, int line, const char *what)
+{
+    fprintf(stderr, "BUG at %s:%d: %s (t=%llu us)\n", file, line, what,
+            (unsigned long long)(sim_now_ns / NSEC_PER_USEC));
+    abort();
+}
+
+/* Allocation */
+void *sim_alloc(size_t size, bool zero)
+{
+    void *p = zero ? calloc(1, size) : malloc(size);
+
+    if (p)
+        sim_counters.allocs++;
+    return p;
+}
+
+void sim_free(const void *p)
+{
+    if (!p)
+        return;
+    sim_counters.frees++;
+    free((void *)p);
+}
+
+/* Locks */
+static unsigned int sim_locks_held;
+
+void sim_lock(spinlock_t *lock, const char *site)
+{
+    if (lock->held_at) {
+        fprintf(stderr, "deadlock: %s takes a lock held since %s\n",
+                site, lock->held_at);
+        abort();
+    }
+    lock->held_at = site;
+    lock->acquisitions++;
+    sim_locks_held++;
+    sim_counters.lock_acquisitions++;
+}
+
+void sim_unlock(spinlock_t *lock, const char *site)
+{
+    if (!lock->held_at) {
+        fprintf(stderr, "unlock of a free lock at %s\n", site);
+        abort();
+    }
+    lock->held_at = NULL;
+    sim_locks_held--;
+}
+
+/* Virtual time: a list of armed timers and work items ordered by expiry */
+static struct sim_event *sim_events;
+
+void sim_event_arm(struct sim_event *ev, u64 expires_ns)
+{
+    struct sim_event **pos;
+
+    sim_event_cancel(ev);
+    ev->expires_ns = expires_ns;
+    ev->pending = true;
+
+    /* Equal expiry keeps arming order, so replays are deterministic */
+    for (pos = &sim_events; *pos; pos = &(*pos)->next)
+        if ((*pos)->expires_ns > expires_ns)
+            break;
+    ev->next = *pos;
+    *pos = ev;
+}
+
+bool sim_event_cancel(struct sim_event *ev)
+{
+    struct sim_event **pos;
+
+    if (!ev->pending)
+        return false;
+
+    for (pos = &sim_events; *pos; pos = &(*pos)->next) {
+        if (*pos == ev) {
+            *pos = ev->next;
+            break;
+        }
+    }
+    ev->next = NULL;
+    ev->pending = false;
+    return true;
+}
+
+void sim_timer_fire(struct sim_event *ev)
+{
+    struct timer_list *t = container_of(ev, struct timer_list, ev);
+
+    sim_counters.timers_fired++;
+    t->function(t);
+}
+
+void sim_work_fire(struct sim_event *ev)
+{
+    struct work_struct *w = container_of(ev, struct work_struct, ev);
+
+    sim_counters.works_run++;
+    w->func(w);
+}
+
+void sim_run_until(u64 t_ns)
+{
+    struct sim_event *ev;
+
+    while ((ev = sim_events) && ev->expires_ns <= t_ns) {
+        sim_events = ev->next;
+        ev->next = NULL;
+        ev->pending = false;
+        if (ev->expires_ns > sim_now_ns)
+            sim_now_ns = ev->expires_ns;
+
+        ev->fire(ev);
+
+        if (sim_locks_held) {
+            fprintf(stderr, "%u lock(s) still held after a handler ran\n",
+                    sim_locks_held);
+            abort();
+        }
+    }
+
+    if (t_ns > sim_now_ns)
+        sim_now_ns = t_ns;
+}
+
+bool sim_events_pending(void)
+{
+    return sim_events != NULL;
+}
+
+/* Socket buffers */
+struct sk_buff *alloc_skb(unsigned int size, gfp_t gfp)
+{
+    struct sk_buff *skb = sim_alloc(sizeof(*skb), true);
+
+    if (!skb)
+        return NULL;
+
+    skb->head = sim_alloc(size, true);
+    if (!skb->head) {
+        sim_free(skb);
+        return NULL;
+    }
+    skb->data = skb->tail = skb->head;
+    skb->end = skb->head + size;
+    skb->sim_born_ns = sim_now_ns;
+    skb->sim_id = sim_counters.skbs_allocated++;
+    sim_counters.skbs_live++;
+
+    return skb;
+}
+
+void kfree_skb(struct sk_buff *skb)
+{
+    if (!skb)
+        return;
+
+    BUG_ON(skb->next || skb->prev);
+    sim_counters.skbs_live--;
+    sim_free(skb->head);
+    sim_free(skb);
+}
+
+/* Tracepoint hit counts */
+struct sim_trace_count sim_trace_counts[SIM_MAX_TRACE_EVENTS];
+
+void sim_trace_hit(const char *event)
+{
+    int i;
+
+    for (i = 0; i < SIM_MAX_TRACE_EVENTS; i++) {
+        struct sim_trace_count *tc = &sim_trace_counts[i];
+
+        if (!tc->event)
+            tc->event = event;
+        if (!strcmp(tc->event, event)) {
+            tc->hits++;
+            return;
+        }
+    }
+}
+
+/* Randomness: xorshift64*, so a seed reproduces a run exactly */
+static u64 sim_rng_state = 0x9e3779b97f4a7c15ULL;
+
+void sim_seed(u64 seed)
+{
+    sim_rng_state = seed ? seed : 0x9e3779b97f4a7c15ULL;
+}
+
+u32 get_random_u32(void)
+{
+    u64 x = sim_rng_state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    sim_rng_state = x;
+    return (x * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+u32 crc32_le(u32 crc, const u8 *p, size_t len)
+{
+    int i;
+
+    while (len--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+    return crc;
+}
+
+/* Red-black tree, after CLRS with parent pointers */
+static void rb_rotate_left(struct rb_node *x, struct rb_root *root)
+{
+    struct rb_node *y = x->rb_right;
+
+    x->rb_right = y->rb_left;
+    if (y->rb_left)
+        y->rb_left->rb_parent = x;
+    y->rb_parent = x->rb_parent;
+    if (!x->rb_parent)
+        root->rb_node = y;
+    else if (x == x->rb_parent->rb_left)
+        x->rb_parent->rb_left = y;
+    else
+        x->rb_parent->rb_right = y;
+    y->rb_left = x;
+    x->rb_parent = y;
+}
+
+static void rb_rotate_right(struct rb_node *x, struct rb_root *root)
+{
+    struct rb_node *y = x->rb_left;
+
+    x->rb_left = y->rb_right;
+    if (y->rb_right)
+        y->rb_right->rb_parent = x;
+    y->rb_parent = x->rb_parent;
+    if (!x->rb_parent)
+        root->rb_node = y;
+    else if (x == x->rb_parent->rb_right)
+        x->rb_parent->rb_right = y;
+    else
+        x->rb_parent->rb_left = y;
+    y->rb_right = x;
+    x->rb_parent = y;
+}
+
+static inline bool rb_is_red(const struct rb_node *n)
+{
+    return n && n->rb_red;
+}
+
+void rb_insert_color(struct rb_node *z, struct rb_root *root)
+{
+    struct rb_node *p, *g, *u;
+
+    while ((p = z->rb_parent) && p->rb_red) {
+        g = p->rb_parent;
+        if (p == g->rb_left) {
+            u = g->rb_right;
+            if (rb_is_red(u)) {
+                p->rb_red = u->rb_red = false;
+                g->rb_red = true;
+                z = g;
+                continue;
+            }
+            if (z == p->rb_right) {
+                rb_rotate_left(p, root);
+                z = p;
+                p = z->rb_parent;
+            }
+            p->rb_red = false;
+            g->rb_red = true;
+            rb_rotate_right(g, root);
+        } else {
+            u = g->rb_left;
+            if (rb_is_red(u)) {
+                p->rb_red = u->rb_red = false;
+                g->rb_red = true;
+                z = g;
+                continue;
+            }
+            if (z == p->rb_left) {
+                rb_rotate_right(p, root);
+                z = p;
+                p = z->rb_parent;
+            }
+            p->rb_red = false;
+            g->rb_red = true;
+            rb_rotate_left(g, root);
+        }
+    }
+    root->rb_node->rb_red = false;
+}
+
+static void rb_transplant(struct rb_node *u, struct rb_node *v,
+                          struct rb_root *root)
+{
+    if (!u->rb_parent)
+        root->rb_node = v;
+    else if (u == u->rb_parent->rb_left)
+        u->rb_parent->rb_left = v;
+    else
+        u->rb_parent->rb_right = v;
+    if (v)
+        v->rb_parent = u->rb_parent;
+}
+
+static struct rb_node *rb_min(struct rb_node *n)
+{
+    while (n->rb_left)
+        n = n->rb_left;
+    return n;
+}
+
+static void rb_erase_fixup(struct rb_node *x, struct rb_node *xp,
+                           struct rb_root *root)
+{
+    struct rb_node *w;
+
+    while (x != root->rb_node && !rb_is_red(x)) {
+        if (x == xp->rb_left) {
+            w = xp->rb_right;
+            if (rb_is_red(w)) {
+                w->rb_red = false;
+                xp->rb_red = true;
+                rb_rotate_left(xp, root);
+                w = xp->rb_right;
+            }
+            if (!rb_is_red(w->rb_left) && !rb_is_red(w->rb_right)) {
+                w->rb_red = true;
+                x = xp;
+                xp = x->rb_parent;
+            } else {
+                if (!rb_is_red(w->rb_right)) {
+                    w->rb_left->rb_red = false;
+                    w->rb_red = true;
+                    rb_rotate_right(w, root);
+                    w = xp->rb_right;
+                }
+                w->rb_red = xp->rb_red;
+                xp->rb_red = false;
+                if (w->rb_right)
+                    w->rb_right->rb_red = false;
+                rb_rotate_left(xp, root);
+                x = root->rb_node;
+            }
+        } else {
+            w = xp->rb_left;
+            if (rb_is_red(w)) {
+                w->rb_red = false;
+                xp->rb_red = true;
+                rb_rotate_right(xp, root);
+                w = xp->rb_left;
+            }
+            if (!rb_is_red(w->rb_left) && !rb_is_red(w->rb_right)) {
+                w->rb_red = true;
+                x = xp;
+                xp = x->rb_parent;
+            } else {
+                if (!rb_is_red(w->rb_left)) {
+                    w->rb_right->rb_red = false;
+                    w->rb_red = true;
+                    rb_rotate_left(w, root);
+                    w = xp->rb_left;
+                }
+                w->rb_red = xp->rb_red;
+                xp->rb_red = false;
+                if (w->rb_left)
+                    w->rb_left->rb_red = false;
+                rb_rotate_right(xp, root);
+                x = root->rb_node;
+            }
+        }
+    }
+    if (x)
+        x->rb_red = false;
+}
+
+void rb_erase(struct rb_node *z, struct rb_root *root)
+{
+    struct rb_node *y = z, *x, *xp;
+    bool y_red = y->rb_red;
+
+    if (!z->rb_left) {
+        x = z->rb_right;
+        xp = z->rb_parent;
+        rb_transplant(z, x, root);
+    } else if (!z->rb_right) {
+        x = z->rb_left;
+        xp = z->rb_parent;
+        rb_transplant(z, x, root);
+    } else {
+        y = rb_min(z->rb_right);
+        y_red = y->rb_red;
+        x = y->rb_right;
+        if (y->rb_parent == z) {
+            xp = y;
+        } else {
+            xp = y->rb_parent;
+            rb_transplant(y, x, root);
+            y->rb_right = z->rb_right;
+            y->rb_right->rb_parent = y;
+        }
+        rb_transplant(z, y, root);
+        y->rb_left = z->rb_left;
+        y->rb_left->rb_parent = y;
+        y->rb_red = z->rb_red;
+    }
+
+    if (!y_red && root->rb_node)
+        rb_erase_fixup(x, xp, root);
+
+    z->rb_parent = z->rb_left = z->rb_right = NULL;
+}
+
+struct rb_node *rb_first(const struct rb_root *root)
+{
+    return root->rb_node ? rb_min(root->rb_node) : NULL;
+}
+
+struct rb_node *rb_next(const struct rb_node *node)
+{
+    const struct rb_node *p;
+
+    if (node->rb_right)
+        return rb_min(node->rb_right);
+
+    while ((p = node->rb_parent) && node == p->rb_right)
+        node = p;
+    return (struct rb_node *)p;
+}
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Cross-link aggregation and reordering under the simulator: the rbtree
+ * frame trees and timeout work from src/mac/wifi7_aggregation.c.
+ */
+
+#include "../../src/mac/wifi7_aggregation.c"
+#include "sim.h"
+
+int sim_agg_attach(struct wifi7_dev *dev)
+{
+    return wifi7_aggregation_init(dev);
+}
+
+void sim_agg_detach(struct wifi7_dev *dev)
+{
+    wifi7_aggregation_deinit(dev);
+}
+
+void sim_agg_report(FILE *out)
+{
+    int i;
+
+    for (i = 0; i < WIFI7_NUM_TIDS; i++) {
+        struct wifi7_agg_tid_ctx *agg = &wifi7_agg_ctx.agg_contexts[i];
+        struct wifi7_reorder_tid_ctx *ro = &wifi7_agg_ctx.reorder_contexts[i];
+        struct sim_sink *tx = &sim_agg_tx[i];
+        struct sim_sink *rx = &sim_reorder_rx[i];
+
+        if (!tx->frames && !rx->frames && !atomic_read(&agg->pending_count) &&
+            !atomic_read(&ro->pending_count))
+            continue;
+
+        fprintf(out, "agg: tid %d tx %llu frames %llu bytes, pending %d, "
+                "delay avg %llu max %llu us\n",
+                i, (unsigned long long)tx->frames,
+                (unsigned long long)tx->bytes,
+                atomic_read(&agg->pending_count),
+                (unsigned long long)(tx->frames ?
+                                     tx->delay_sum_us / tx->frames : 0),
+                (unsigned long long)tx->delay_max_us);
+        fprintf(out, "reorder: tid %d rx %llu frames, out of order %llu, "
+                "pending %d, head %u, delay avg %llu max %llu us\n",
+                i, (unsigned long long)rx->frames,
+                (unsigned long long)rx->out_of_order,
+                atomic_read(&ro->pending_count), ro->head_ssn,
+                (unsigned long long)(rx->frames ?
+                                     rx->delay_sum_us / rx->frames : 0),
+                (unsigned long long)rx->delay_max_us);
+    }
+}
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Block ack under the simulator: ADDBA/DELBA handling, the reorder window
+ * and its timers from src/mac/wifi7_ba.c. The driver has no data RX path
+ * of its own yet, so sim_ba_rx_mpdu() parks frames in the window the way
+ * the KUnit suite does and releases them with the driver's helpers.
+ */
+
+#include "../../src/mac/wifi7_ba.c"
+#include "sim.h"
+
+struct sim_sink sim_ba_rx[WIFI7_NUM_TIDS];
+
+int sim_ba_attach(struct wifi7_dev *dev)
+{
+    return wifi7_ba_init(dev);
+}
+
+void sim_ba_detach(struct wifi7_dev *dev)
+{
+    sim_ba_poll(dev);
+    wifi7_ba_deinit(dev);
+}
+
+struct sk_buff *sim_ba_action(u8 action, u8 tid, const u8 *peer, u16 ssn,
+                              bool no_ack)
+{
+    struct wifi7_ba_frame_hdr *hdr;
+    struct sk_buff *skb;
+    u16 ctrl;
+
+    skb = alloc_skb(sizeof(*hdr), GFP_KERNEL);
+    if (!skb)
+        return NULL;
+
+    hdr = skb_put_zero(skb, sizeof(*hdr));
+    hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_MGMT |
+                                     IEEE80211_STYPE_ACTION);
+    ether_addr_copy(hdr->ta, peer);
+
+    ctrl = (tid << IEEE80211_BAR_CTRL_TID_INFO_SHIFT) &
+           IEEE80211_BAR_CTRL_TID_INFO_MASK;
+    if (no_ack)
+        ctrl |= BIT(0);
+    hdr->ba_control = cpu_to_le16(ctrl);
+    hdr->ba_info = cpu_to_le16(ssn & 0xFFF);
+
+    skb->data[IEEE80211_ACTION_CAT_OFFSET] = WLAN_CATEGORY_BACK;
+    skb->data[IEEE80211_ACTION_ACT_OFFSET] = action;
+
+    return skb;
+}
+
+/* Hand released frames to the BA sink, as the RX path would to the stack */
+void sim_ba_poll(struct wifi7_dev *dev)
+{
+    struct wifi7_ba *ba = dev->ba;
+    struct sk_buff *skb;
+    int i;
+
+    for (i = 0; i < WIFI7_BA_MAX_SESSIONS; i++) {
+        struct wifi7_ba_session *session = &ba->sessions[i];
+
+        /* Never-used slots have no queue to drain */
+        if (!session->reorder_queue.next)
+            continue;
+
+        while ((skb = skb_dequeue(&session->reorder_queue))) {
+            sim_sink_account(&sim_ba_rx[session->tid], skb,
+                             wifi7_get_frame_ssn(skb));
+            kfree_skb(skb);
+        }
+    }
+}
+
+int sim_ba_rx_mpdu(struct wifi7_dev *dev, u8 tid, const u8 *peer,
+                   struct sk_buff *skb, u16 sn)
+{
+    struct wifi7_ba *ba = dev->ba;
+    struct wifi7_ba_session *session;
+    unsigned long flags;
+    u16 offset, idx;
+    int ret = 0;
+
+    spin_lock_irqsave(&ba->lock, flags);
+    session = wifi7_ba_find_session(ba, tid, peer);
+    spin_unlock_irqrestore(&ba->lock, flags);
+
+    /* Without an agreement frames go straight up */
+    if (!session || session->state != WIFI7_BA_STATE_ACTIVE) {
+        sim_sink_account(&sim_ba_rx[tid], skb, sn);
+        kfree_skb(skb);
+        return 0;
+    }
+
+    spin_lock_irqsave(&session->lock, flags);
+
+    session->rx_mpdu++;
+    sn &= 0xFFF;
+    offset = (sn - session->head_seq) & 0xFFF;
+
+    /* Behind the window: already released or given up on */
+    if (offset >= 2048) {
+        session->rx_dup++;
+        kfree_skb(skb);
+        ret = -EALREADY;
+        goto out;
+    }
+
+    /* Past the window: slide it so the frame lands on the last slot */
+    if (offset >= session->buffer_size)
+        wifi7_ba_flush_reorder_buffer(session,
+                                      (sn - session->buffer_size + 1) & 0xFFF);
+
+    idx = seq_to_index(sn);
+    if (test_bit(idx, session->reorder_bitmap)) {
+        session->rx_dup++;
+        kfree_skb(skb);
+        ret = -EALREADY;
+        goto out;
+    }
+
+    if (sn != session->head_seq)
+        session->rx_ooo++;
+    if (((sn - session->tail_seq) & 0xFFF) < 2048)
+        session->tail_seq = sn;
+
+    session->reorder_buf[idx] = skb;
+    set_bit(idx, session->reorder_bitmap);
+    wifi7_ba_release_in_order(session);
+
+    if (!bitmap_empty(session->reorder_bitmap, WIFI7_BA_MAX_REORDER) &&
+        !timer_pending(&session->reorder_timer))
+        mod_timer(&session->reorder_timer,
+                  jiffies + msecs_to_jiffies(session->timeout));
+
+    /* Traffic keeps the agreement alive */
+    mod_timer(&session->session_timer,
+              jiffies + msecs_to_jiffies(session->timeout));
+
+out:
+    spin_unlock_irqrestore(&session->lock, flags);
+    sim_ba_poll(dev);
+    return ret;
+}
+
+void sim_ba_report(struct wifi7_dev *dev, FILE *out)
+{
+    struct wifi7_ba *ba = dev->ba;
+    int i;
+
+    fprintf(out, "ba: %u sessions, %u addba, %u delba\n",
+            ba->num_sessions, ba->stats.rx_addba, ba->stats.rx_delba);
+
+    for (i = 0; i < WIFI7_BA_MAX_SESSIONS; i++) {
+        struct wifi7_ba_session *s = &ba->sessions[i];
+        struct sim_sink *rx;
+
+        if (!s->rx_mpdu)
+            continue;
+
+        rx = &sim_ba_rx[s->tid];
+        fprintf(out,
+                "  tid %u%s: mpdu %u reordered %u ooo %u dup %u dropped %u, "
+                "head %u, delivered %llu (out of order %llu), "
+                "delay avg %llu max %llu us\n",
+                s->tid, s->active ? "" : " (torn down)", s->rx_mpdu,
+                s->rx_reorder, s->rx_ooo, s->rx_dup, s->rx_drop, s->head_seq,
+                (unsigned long long)rx->frames,
+                (unsigned long long)rx->out_of_order,
+                (unsigned long long)(rx->frames ?
+                                     rx->delay_sum_us / rx->frames : 0),
+                (unsigned long long)rx->delay_max_us);
+    }
+}
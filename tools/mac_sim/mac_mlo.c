@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+/*
+ * MLO link management under the simulator: link selection, metrics
+ * collection and the TX handler from src/mac/wifi7_mlo.c, on top of the
+ * link list and TID maps from src/core/mlo.c.
+ */
+
+#include "../../src/mac/wifi7_mlo.c"
+#include "../../src/core/mlo.c"
+#include "sim.h"
+
+int sim_mlo_attach(struct wifi7_dev *dev, u8 num_links, u8 policy)
+{
+    struct wifi67_priv *priv = dev->priv;
+    struct wifi67_mlo_link *link;
+    struct wifi7_mlo *mlo;
+    int i, ret;
+
+    if (!num_links || num_links > WIFI7_MAX_LINKS)
+        return -EINVAL;
+
+    priv->hw_cap.max_mlo_links = WIFI7_MAX_LINKS;
+    wifi67_mlo_init(priv);
+
+    ret = wifi7_mlo_init(dev);
+    if (ret)
+        return ret;
+
+    mlo = dev->mlo;
+    mlo->config.num_links = num_links;
+    mlo->select.policy = policy;
+
+    for (i = 0; i < num_links; i++) {
+        mlo->config.links[i].link_id = i;
+        mlo->config.links[i].enabled = true;
+
+        link = wifi67_mlo_alloc_link(priv);
+        if (!link) {
+            ret = -ENOMEM;
+            goto err;
+        }
+        ret = wifi67_mlo_setup_link(priv, link, i, 0);
+        if (ret) {
+            kfree(link);
+            goto err;
+        }
+        wifi67_mlo_activate_link(link);
+    }
+
+    schedule_delayed_work(&mlo->metrics.work,
+                          msecs_to_jiffies(mlo->metrics.interval));
+    schedule_delayed_work(&mlo->select.work,
+                          msecs_to_jiffies(mlo->select.interval));
+    return 0;
+
+err:
+    wifi7_mlo_deinit(dev);
+    wifi67_mlo_deinit(priv);
+    return ret;
+}
+
+void sim_mlo_detach(struct wifi7_dev *dev)
+{
+    wifi7_mlo_deinit(dev);
+    wifi67_mlo_deinit(dev->priv);
+}
+
+/* Spread secondary links for a TID over the primary's map */
+int sim_mlo_map_tid(struct wifi7_dev *dev, u8 tid, u8 primary, u8 secondary)
+{
+    struct wifi67_mlo_link *link;
+
+    link = wifi67_mlo_get_link_by_id(dev->priv, dev->mlo->link.active_link);
+    return wifi67_mlo_map_tid(link, tid, primary, secondary);
+}
+
+int sim_mlo_tx(struct wifi7_dev *dev, struct sk_buff *skb)
+{
+    struct wifi7_mlo *mlo = dev->mlo;
+
+    skb_queue_tail(&mlo->frames.tx_queue, skb);
+    schedule_delayed_work(&mlo->frames.tx_work, 0);
+    return 0;
+}
+
+void sim_mlo_report(struct wifi7_dev *dev, FILE *out)
+{
+    struct wifi7_mlo *mlo = dev->mlo;
+    int i;
+
+    fprintf(out, "mlo: active link %u, %u switches, %u failed, "
+            "last switch %u us\n",
+            mlo->link.active_link, mlo->stats.link_switches,
+            mlo->stats.link_failures, mlo->stats.switch_latency);
+
+    for (i = 0; i < mlo->config.num_links; i++) {
+        struct wifi7_mlo_metrics *m = &mlo->link.metrics[i];
+        struct sim_sink *tx = &sim_mac_tx[i];
+
+        fprintf(out, "  link %d%s: rssi %d latency %u loss %u airtime %u, "
+                "tx %llu frames %llu bytes\n",
+                i, sim_links[i].up ? "" : " (down)", (s32)m->rssi,
+                m->latency, m->loss, m->airtime,
+                (unsigned long long)tx->frames,
+                (unsigned long long)tx->bytes);
+    }
+}
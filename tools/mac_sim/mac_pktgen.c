@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+/*
+ * TX generator under the simulator: the generator and the simulated DMA
+ * backend from src/mac/wifi7_pktgen.c, driving the QoS scheduler on the
+ * virtual clock. The report is the debugfs stats file, printed to stdout.
+ */
+
+#include "../../src/mac/wifi7_pktgen.c"
+#include "sim.h"
+
+int sim_pktgen_attach(struct wifi7_dev *dev)
+{
+    return wifi7_pktgen_init(dev);
+}
+
+void sim_pktgen_detach(struct wifi7_dev *dev)
+{
+    wifi7_pktgen_deinit(dev);
+}
+
+void sim_pktgen_report(struct wifi7_dev *dev, FILE *out)
+{
+    struct seq_file m = { .file = out, .private = dev };
+
+    if (!dev->pktgen->stats.offered)
+        return;
+
+    fprintf(out, "pktgen:\n");
+    wifi7_pktgen_stats_show(&m, NULL);
+}
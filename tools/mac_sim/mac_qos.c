@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+/*
+ * QoS scheduler under the simulator: the token bucket shapers, DRR
+ * dequeue, rate control and the stats/tune work from src/mac/wifi7_qos.c.
+ */
+
+#include "../../src/mac/wifi7_qos.c"
+#include "sim.h"
+
+int sim_qos_attach(struct wifi7_dev *dev)
+{
+    return wifi7_qos_init(dev);
+}
+
+void sim_qos_detach(struct wifi7_dev *dev)
+{
+    wifi7_qos_deinit(dev);
+}
+
+int sim_qos_enqueue(struct wifi7_dev *dev, struct sk_buff *skb, u8 link_id,
+                    u8 tid)
+{
+    return wifi7_qos_tx_enqueue(dev, skb, link_id, tid);
+}
+
+struct sk_buff *sim_qos_dequeue(struct wifi7_dev *dev, u8 link_id)
+{
+    return wifi7_qos_tx_dequeue(dev, link_id);
+}
+
+void sim_qos_tx_status(struct wifi7_dev *dev, u8 tid, bool success,
+                       u32 rate_mbps, u8 retries)
+{
+    wifi7_qos_tx_status(dev, tid, success, rate_mbps, retries);
+}
+
+void sim_qos_report(struct wifi7_dev *dev, FILE *out)
+{
+    struct wifi7_qos *qos = dev->qos;
+    int i;
+
+    fprintf(out, "qos: tx %llu bytes %u pkts, dropped %u\n",
+            (unsigned long long)qos->stats.bytes_tx, qos->stats.pkts_tx,
+            qos->stats.dropped);
+
+    for (i = 0; i < WIFI7_NUM_TIDS; i++) {
+        struct wifi7_tid_state *ts = &qos->tids[i];
+
+        if (!ts->active)
+            continue;
+        fprintf(out,
+                "  tid %d: queued %u in-flight %u completed %u retried %u "
+                "mcs %u shaper %u/%u B/ms burst %u\n",
+                i, ts->queue_len, ts->packets_in_flight, ts->completed,
+                ts->retried, ts->rate.mcs_idx,
+                (u32)(((u64)ts->shaper.rate * 1000) >> WIFI7_TOKEN_SHIFT),
+                (u32)(((u64)ts->rate.target_rate * 1000) >> WIFI7_TOKEN_SHIFT),
+                ts->shaper.burst);
+    }
+}
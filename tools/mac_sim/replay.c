@@ -0,0 +1,700 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Trace replay driver for the userspace MAC build.
+ *
+ * A trace is one event per line:
+ *
+ *     <time_us> <op> [key=value ...]
+ *
+ * Events run in order on the virtual clock; timers and delayed work due
+ * before an event fire first. See README.md for the ops. With --synthetic
+ * the driver generates a trace from a seed instead of reading one, and
+ * --emit prints it so a run can be kept and replayed later.
+ */
+
+#include <getopt.h>
+#include <stdarg.h>
+#include "sim.h"
+#include "../../src/mac/wifi7_aggregation.h"
+#include "../../src/mac/wifi7_ba.h"
+#include "../../src/mac/wifi7_mlo.h"
+#include "../../src/mac/wifi7_pktgen.h"
+
+#define REPLAY_MAX_ARGS         16
+#define REPLAY_MAX_LINE         512
+#define REPLAY_DEF_LEN          1500
+
+/* Bound the clock so a bogus timestamp cannot spin the event loop */
+#ifdef SIM_FUZZ
+#define REPLAY_MAX_TIME_US      (10 * USEC_PER_SEC)
+#else
+#define REPLAY_MAX_TIME_US      (3600 * USEC_PER_SEC)
+#endif
+
+struct replay_arg {
+    char key[16];
+    long val;
+};
+
+struct replay {
+    struct wifi7_dev dev;
+    struct wifi67_priv priv;
+    u64 base_ns;
+    u16 tx_seq[WIFI7_NUM_TIDS];
+    unsigned int lineno;
+    unsigned int events;
+    unsigned int errors;
+    u8 num_links;
+    u8 policy;
+};
+
+static const u8 replay_peer[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+static void replay_err(struct replay *r, const char *fmt, ...)
+{
+    va_list args;
+
+    r->errors++;
+    if (!sim_verbose)
+        return;
+
+    fprintf(stderr, "line %u: ", r->lineno);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+static long replay_get(const struct replay_arg *args, int nargs,
+                       const char *key, long def)
+{
+    int i;
+
+    for (i = 0; i < nargs; i++)
+        if (!strcmp(args[i].key, key))
+            return args[i].val;
+    return def;
+}
+
+/* A QoS data frame carrying @seq, padded to @len */
+static struct sk_buff *replay_frame(u8 tid, u16 seq, long len)
+{
+    struct ieee80211_qos_hdr *hdr;
+    struct sk_buff *skb;
+
+    len = clamp_t(long, len, sizeof(*hdr), 65535);
+    skb = alloc_skb(len, GFP_ATOMIC);
+    if (!skb)
+        return NULL;
+
+    hdr = skb_put_zero(skb, len);
+    hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA |
+                                     IEEE80211_STYPE_QOS_DATA);
+    hdr->seq_ctrl = cpu_to_le16(IEEE80211_SN_TO_SEQ(seq));
+    hdr->qos_ctrl = cpu_to_le16(tid);
+    skb->priority = tid;
+    return skb;
+}
+
+static void replay_ba_action(struct replay *r, u8 action, u8 tid, u16 ssn,
+                             bool no_ack)
+{
+    struct sk_buff *skb = sim_ba_action(action, tid, replay_peer, ssn, no_ack);
+    int ret;
+
+    if (!skb)
+        return;
+
+    ret = wifi7_ba_rx_frame(&r->dev, skb);
+    if (ret)
+        replay_err(r, "ba action %u tid %u: %d\n", action, tid, ret);
+    kfree_skb(skb);
+}
+
+/* Pull frames off a link's queues and hand them to MLO, then report status */
+static void replay_dequeue(struct replay *r, u8 link_id, long n)
+{
+    struct sim_link *l = &sim_links[link_id];
+    struct sk_buff *skb;
+    bool ok;
+    u8 tid;
+
+    while (n-- > 0) {
+        skb = sim_qos_dequeue(&r->dev, link_id);
+        if (!skb)
+            break;
+
+        tid = skb->priority & IEEE80211_QOS_CTL_TID_MASK;
+        ok = l->up && get_random_u32() % 100 >= l->loss;
+        sim_mlo_tx(&r->dev, skb);
+        sim_qos_tx_status(&r->dev, tid, ok, l->rate, ok ? 0 : 1);
+    }
+}
+
+/* Unset keys keep the generator's current parameters */
+static int replay_pktgen(struct replay *r, const struct replay_arg *args,
+                         int nargs)
+{
+    struct wifi7_pktgen_config cfg;
+    int ret;
+
+    if (replay_get(args, nargs, "stop", 0)) {
+        wifi7_pktgen_stop(&r->dev);
+        return 0;
+    }
+
+    ret = wifi7_pktgen_get_config(&r->dev, &cfg);
+    if (ret)
+        return ret;
+
+    cfg.count = replay_get(args, nargs, "count", cfg.count);
+    cfg.min_len = replay_get(args, nargs, "len", cfg.min_len);
+    cfg.max_len = replay_get(args, nargs, "max_len", cfg.min_len);
+    cfg.rate_mbps = replay_get(args, nargs, "rate", cfg.rate_mbps);
+    cfg.burst = replay_get(args, nargs, "burst", cfg.burst);
+    cfg.tid_mask = replay_get(args, nargs, "tids", cfg.tid_mask);
+    cfg.link_mask = replay_get(args, nargs, "links", cfg.link_mask);
+    cfg.num_dst = replay_get(args, nargs, "dst", cfg.num_dst);
+    cfg.ring_size = replay_get(args, nargs, "ring", cfg.ring_size);
+    cfg.dma_rate_mbps = replay_get(args, nargs, "dma", cfg.dma_rate_mbps);
+
+    ret = wifi7_pktgen_set_config(&r->dev, &cfg);
+    if (ret)
+        return ret;
+    return wifi7_pktgen_start(&r->dev);
+}
+
+static int replay_event(struct replay *r, const char *op,
+                        const struct replay_arg *args, int nargs)
+{
+    long tid = replay_get(args, nargs, "tid", 0);
+    long link = replay_get(args, nargs, "link", 0);
+    long seq = replay_get(args, nargs, "seq", 0);
+    long len = replay_get(args, nargs, "len", REPLAY_DEF_LEN);
+    struct sk_buff *skb;
+    long n;
+    int ret;
+
+    if (tid < 0 || tid >= WIFI7_NUM_TIDS ||
+        link < 0 || link >= WIFI7_MAX_LINKS) {
+        replay_err(r, "tid %ld or link %ld out of range\n", tid, link);
+        return -EINVAL;
+    }
+
+    if (!strcmp(op, "link")) {
+        struct sim_link *l;
+
+        link = replay_get(args, nargs, "id", link);
+        if (link < 0 || link >= WIFI7_MAX_LINKS)
+            return -EINVAL;
+
+        l = &sim_links[link];
+        l->up = replay_get(args, nargs, "up", l->up);
+        l->rssi = replay_get(args, nargs, "rssi", l->rssi);
+        l->noise = replay_get(args, nargs, "noise", l->noise);
+        l->airtime = clamp_t(long, replay_get(args, nargs, "airtime",
+                                              l->airtime), 0, 100);
+        l->latency = replay_get(args, nargs, "latency", l->latency);
+        l->jitter = replay_get(args, nargs, "jitter", l->jitter);
+        l->loss = clamp_t(long, replay_get(args, nargs, "loss", l->loss),
+                          0, 100);
+        l->rate = replay_get(args, nargs, "rate", l->rate);
+    } else if (!strcmp(op, "tx")) {
+        n = clamp_t(long, replay_get(args, nargs, "n", 1), 0, 4096);
+        while (n--) {
+            skb = replay_frame(tid, r->tx_seq[tid], len);
+            if (!skb)
+                return -ENOMEM;
+            r->tx_seq[tid] = (r->tx_seq[tid] + 1) & 0xFFF;
+            ret = sim_qos_enqueue(&r->dev, skb, link, tid);
+            if (ret) {
+                replay_err(r, "tx tid %ld link %ld: %d\n", tid, link, ret);
+                kfree_skb(skb);
+            }
+        }
+    } else if (!strcmp(op, "dequeue")) {
+        replay_dequeue(r, link, replay_get(args, nargs, "n", 1));
+    } else if (!strcmp(op, "txs")) {
+        sim_qos_tx_status(&r->dev, tid, replay_get(args, nargs, "ok", 1),
+                          replay_get(args, nargs, "rate", sim_links[link].rate),
+                          replay_get(args, nargs, "retries", 0));
+    } else if (!strcmp(op, "agg") || !strcmp(op, "rx")) {
+        skb = replay_frame(tid, seq, len);
+        if (!skb)
+            return -ENOMEM;
+        if (op[0] == 'a')
+            ret = wifi7_add_agg_frame(&r->dev, skb, tid, link);
+        else
+            ret = wifi7_add_reorder_frame(&r->dev, skb, tid, link);
+        if (ret) {
+            replay_err(r, "%s tid %ld seq %ld: %d\n", op, tid, seq, ret);
+            kfree_skb(skb);
+        }
+    } else if (!strcmp(op, "addba")) {
+        replay_ba_action(r, WLAN_ACTION_ADDBA_REQ, tid,
+                         replay_get(args, nargs, "ssn", 0), false);
+    } else if (!strcmp(op, "addba_resp")) {
+        replay_ba_action(r, WLAN_ACTION_ADDBA_RESP, tid, 0,
+                         replay_get(args, nargs, "reject", 0));
+    } else if (!strcmp(op, "delba")) {
+        replay_ba_action(r, WLAN_ACTION_DELBA, tid, 0, false);
+    } else if (!strcmp(op, "ba_rx")) {
+        skb = replay_frame(tid, seq, len);
+        if (!skb)
+            return -ENOMEM;
+        sim_ba_rx_mpdu(&r->dev, tid, replay_peer, skb, seq);
+    } else if (!strcmp(op, "map")) {
+        ret = sim_mlo_map_tid(&r->dev, tid,
+                              replay_get(args, nargs, "primary", 0),
+                              replay_get(args, nargs, "secondary", 0));
+        if (ret)
+            replay_err(r, "map tid %ld: %d\n", tid, ret);
+    } else if (!strcmp(op, "pktgen")) {
+        ret = replay_pktgen(r, args, nargs);
+        if (ret)
+            replay_err(r, "pktgen: %d\n", ret);
+    } else if (strcmp(op, "run")) {
+        replay_err(r, "unknown op '%s'\n", op);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+/* Returns false at an "end" event */
+static bool replay_line(struct replay *r, char *line)
+{
+    struct replay_arg args[REPLAY_MAX_ARGS];
+    char *tok, *save, *eq, *op;
+    unsigned long long t_us;
+    int nargs = 0;
+
+    r->lineno++;
+
+    if ((tok = strchr(line, '#')))
+        *tok = '\0';
+
+    tok = strtok_r(line, " \t\r\n", &save);
+    if (!tok)
+        return true;
+
+    t_us = strtoull(tok, NULL, 0);
+    op = strtok_r(NULL, " \t\r\n", &save);
+    if (!op) {
+        replay_err(r, "missing op\n");
+        return true;
+    }
+
+    while ((tok = strtok_r(NULL, " \t\r\n", &save)) &&
+           nargs < REPLAY_MAX_ARGS) {
+        eq = strchr(tok, '=');
+        if (!eq || eq - tok >= (int)sizeof(args[0].key))
+            continue;
+        memcpy(args[nargs].key, tok, eq - tok);
+        args[nargs].key[eq - tok] = '\0';
+        args[nargs].val = strtol(eq + 1, NULL, 0);
+        nargs++;
+    }
+
+    t_us = min_t(unsigned long long, t_us, REPLAY_MAX_TIME_US);
+    sim_run_until(r->base_ns + t_us * NSEC_PER_USEC);
+    sim_ba_poll(&r->dev);
+
+    if (!strcmp(op, "end"))
+        return false;
+
+    r->events++;
+    replay_event(r, op, args, nargs);
+    sim_ba_poll(&r->dev);
+    return true;
+}
+
+static int replay_attach(struct replay *r)
+{
+    int ret;
+
+    memset(&r->dev, 0, sizeof(r->dev));
+    memset(&r->priv, 0, sizeof(r->priv));
+    r->dev.priv = &r->priv;
+    r->base_ns = sim_now_ns;
+
+    ret = sim_qos_attach(&r->dev);
+    if (ret)
+        return ret;
+    ret = sim_agg_attach(&r->dev);
+    if (ret)
+        goto err_qos;
+    ret = sim_ba_attach(&r->dev);
+    if (ret)
+        goto err_agg;
+    ret = sim_mlo_attach(&r->dev, r->num_links, r->policy);
+    if (ret)
+        goto err_ba;
+    ret = sim_pktgen_attach(&r->dev);
+    if (ret)
+        goto err_mlo;
+    return 0;
+
+err_mlo:
+    sim_mlo_detach(&r->dev);
+err_ba:
+    sim_ba_detach(&r->dev);
+err_agg:
+    sim_agg_detach(&r->dev);
+err_qos:
+    sim_qos_detach(&r->dev);
+    return ret;
+}
+
+/* Returns the number of leaked objects or events left armed */
+static long replay_detach(struct replay *r)
+{
+    long leaks;
+
+    sim_pktgen_detach(&r->dev);
+    sim_mlo_detach(&r->dev);
+    sim_ba_detach(&r->dev);
+    sim_agg_detach(&r->dev);
+    sim_qos_detach(&r->dev);
+
+    leaks = sim_counters.skbs_live +
+            (long)(sim_counters.allocs - sim_counters.frees);
+    if (sim_events_pending()) {
+        fprintf(stderr, "timers or work still armed after teardown\n");
+        leaks++;
+    }
+    return leaks;
+}
+
+static void replay_reset_model(void)
+{
+    memset(sim_links, 0, sizeof(sim_links));
+    memset(sim_agg_tx, 0, sizeof(sim_agg_tx));
+    memset(sim_reorder_rx, 0, sizeof(sim_reorder_rx));
+    memset(sim_mac_tx, 0, sizeof(sim_mac_tx));
+    memset(sim_ba_rx, 0, sizeof(sim_ba_rx));
+}
+
+static void replay_report(struct replay *r, FILE *out)
+{
+    int i;
+
+    fprintf(out, "replay: %u events, %u rejected, %llu us simulated\n",
+            r->events, r->errors,
+            (unsigned long long)((sim_now_ns - r->base_ns) / NSEC_PER_USEC));
+
+    sim_qos_report(&r->dev, out);
+    sim_agg_report(out);
+    sim_ba_report(&r->dev, out);
+    sim_mlo_report(&r->dev, out);
+    sim_pktgen_report(&r->dev, out);
+
+    fprintf(out, "runtime: %llu timers, %llu work items, %llu lock "
+            "acquisitions, %llu skbs\n",
+            (unsigned long long)sim_counters.timers_fired,
+            (unsigned long long)sim_counters.works_run,
+            (unsigned long long)sim_counters.lock_acquisitions,
+            (unsigned long long)sim_counters.skbs_allocated);
+
+    for (i = 0; i < SIM_MAX_TRACE_EVENTS && sim_trace_counts[i].event; i++)
+        fprintf(out, "trace: %-28s %llu\n", sim_trace_counts[i].event,
+                (unsigned long long)sim_trace_counts[i].hits);
+}
+
+/* Synthetic traffic */
+struct synth_opts {
+    unsigned int duration_ms;
+    unsigned int loss;          /* % of BA MPDUs never delivered */
+    unsigned int reorder;       /* % of BA MPDUs swapped with the next */
+    unsigned int load;          /* Frames offered per ms */
+};
+
+static char *synth_printf(char *buf, size_t *len, size_t *cap,
+                          const char *fmt, ...)
+{
+    va_list args;
+    int n;
+
+    for (;;) {
+        va_start(args, fmt);
+        n = vsnprintf(buf + *len, *cap - *len, fmt, args);
+        va_end(args);
+        if (n < 0)
+            abort();
+        if (*len + n < *cap)
+            break;
+        *cap *= 2;
+        buf = realloc(buf, *cap);
+        if (!buf)
+            abort();
+    }
+    *len += n;
+    return buf;
+}
+
+#define SYNTH(...)  (buf = synth_printf(buf, &len, &cap, __VA_ARGS__))
+
+/*
+ * Four links whose conditions drift every 100 ms, mixed-TID TX through
+ * QoS and MLO, aggregation on TID 5, host reordering of a shuffled
+ * stream on TID 6 and a block ack session on TID 0 with loss and reorder.
+ */
+static char *synth_trace(const struct synth_opts *o, u8 num_links)
+{
+    static const u8 tid_mix[] = { 0, 0, 0, 0, 1, 5, 5, 6, 7 };
+    size_t len = 0, cap = 65536;
+    char *buf = malloc(cap);
+    u16 ba_seq = 0, rx_seq = 0, agg_seq = 0;
+    unsigned int t_us, i, l;
+    bool held = false;
+    u16 held_seq = 0;
+
+    if (!buf)
+        abort();
+
+    SYNTH("# synthetic: %u ms, load %u/ms, loss %u%%, reorder %u%%\n",
+          o->duration_ms, o->load, o->loss, o->reorder);
+    SYNTH("0 addba tid=0 ssn=0\n0 addba_resp tid=0\n");
+
+    for (t_us = 0; t_us < o->duration_ms * 1000; t_us += 1000) {
+        if (t_us % 100000 == 0) {
+            for (l = 0; l < num_links; l++)
+                SYNTH("%u link id=%u up=%u rssi=%d noise=-95 airtime=%u "
+                      "latency=%u jitter=%u loss=%u rate=%u\n",
+                      t_us, l, get_random_u32() % 20 != 0,
+                      -40 - (int)(get_random_u32() % 45),
+                      get_random_u32() % 90, 200 + get_random_u32() % 4000,
+                      get_random_u32() % 500, get_random_u32() % 15,
+                      200 + get_random_u32() % 2600);
+        }
+
+        for (i = 0; i < o->load; i++) {
+            unsigned int at = t_us + i * 1000 / o->load;
+            u8 tid = tid_mix[get_random_u32() % ARRAY_SIZE(tid_mix)];
+
+            SYNTH("%u tx tid=%u link=0 len=%u\n", at, tid,
+                  64 + get_random_u32() % 1436);
+
+            if (tid == 5)
+                SYNTH("%u agg tid=5 seq=%u link=%u\n", at, agg_seq++ & 0xFFF,
+                      get_random_u32() % num_links);
+
+            if (tid == 6) {
+                /* Hold one frame back now and then so it lands late */
+                if (!held && get_random_u32() % 100 < o->reorder) {
+                    held = true;
+                    held_seq = rx_seq++ & 0xFFF;
+                } else {
+                    SYNTH("%u rx tid=6 seq=%u\n", at, rx_seq++ & 0xFFF);
+                    if (held) {
+                        SYNTH("%u rx tid=6 seq=%u\n", at, held_seq);
+                        held = false;
+                    }
+                }
+            }
+
+            if (get_random_u32() % 100 < o->loss) {
+                ba_seq++;
+            } else if (get_random_u32() % 100 < o->reorder) {
+                SYNTH("%u ba_rx tid=0 seq=%u\n", at, (ba_seq + 1) & 0xFFF);
+                SYNTH("%u ba_rx tid=0 seq=%u\n", at, ba_seq & 0xFFF);
+                ba_seq += 2;
+            } else {
+                SYNTH("%u ba_rx tid=0 seq=%u\n", at, ba_seq++ & 0xFFF);
+            }
+        }
+
+        SYNTH("%u dequeue link=0 n=%u\n", t_us + 999, o->load * 2);
+    }
+
+    SYNTH("%u delba tid=0\n%u end\n", t_us, t_us + 1000);
+    return buf;
+}
+
+static bool replay_run_buf(struct replay *r, char *buf)
+{
+    char *line, *save;
+
+    for (line = strtok_r(buf, "\n", &save); line;
+         line = strtok_r(NULL, "\n", &save)) {
+        char tmp[REPLAY_MAX_LINE];
+
+        snprintf(tmp, sizeof(tmp), "%s", line);
+        if (!replay_line(r, tmp))
+            return false;
+    }
+    return true;
+}
+
+#ifdef SIM_FUZZ
+/*
+ * libFuzzer entry point: each input is a trace. Replays must never crash,
+ * leave a lock held or leak, whatever the input.
+ */
+int LLVMFuzzerTestOneInput(const u8 *data, size_t size)
+{
+    static struct replay r;
+    char *buf;
+
+    buf = malloc(size + 1);
+    if (!buf)
+        return 0;
+    memcpy(buf, data, size);
+    buf[size] = '\0';
+
+    replay_reset_model();
+    memset(&r, 0, sizeof(r));
+    r.num_links = 4;
+    r.policy = WIFI7_MLO_SELECT_ML;
+    if (replay_attach(&r))
+        abort();
+
+    replay_run_buf(&r, buf);
+    free(buf);
+
+    if (replay_detach(&r))
+        abort();
+    return 0;
+}
+#else
+static const char * const replay_policies[] = {
+    [WIFI7_MLO_SELECT_RSSI] = "rssi",
+    [WIFI7_MLO_SELECT_LOAD] = "load",
+    [WIFI7_MLO_SELECT_BW] = "bw",
+    [WIFI7_MLO_SELECT_LAT] = "latency",
+    [WIFI7_MLO_SELECT_ML] = "ml",
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] [trace]\n"
+            "  -s, --seed N          random seed (default 1)\n"
+            "  -S, --synthetic MS    generate MS milliseconds of traffic\n"
+            "      --load N          synthetic frames per ms (default 8)\n"
+            "      --loss PCT        synthetic BA loss (default 2)\n"
+            "      --reorder PCT     synthetic reordering (default 5)\n"
+            "  -e, --emit            print the synthetic trace and exit\n"
+            "  -l, --links N         MLO links (default 4)\n"
+            "  -p, --policy NAME     rssi, load, bw, latency or ml\n"
+            "  -v, --verbose         log every driver message; repeat for "
+            "more\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option longopts[] = {
+        { "seed", required_argument, NULL, 's' },
+        { "synthetic", required_argument, NULL, 'S' },
+        { "load", required_argument, NULL, 'L' },
+        { "loss", required_argument, NULL, 'o' },
+        { "reorder", required_argument, NULL, 'r' },
+        { "emit", no_argument, NULL, 'e' },
+        { "links", required_argument, NULL, 'l' },
+        { "policy", required_argument, NULL, 'p' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { }
+    };
+    struct synth_opts synth = { .loss = 2, .reorder = 5, .load = 8 };
+    static struct replay r = { .num_links = 4,
+                               .policy = WIFI7_MLO_SELECT_ML };
+    char line[REPLAY_MAX_LINE];
+    unsigned long long seed = 1;
+    bool emit = false;
+    FILE *in = stdin;
+    long leaks;
+    int c, i;
+
+    while ((c = getopt_long(argc, argv, "s:S:el:p:vh", longopts,
+                            NULL)) != -1) {
+        switch (c) {
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'S':
+            synth.duration_ms = strtoul(optarg, NULL, 0);
+            break;
+        case 'L':
+            synth.load = clamp_t(unsigned long, strtoul(optarg, NULL, 0),
+                                 1, 1000);
+            break;
+        case 'o':
+            synth.loss = min_t(unsigned long, strtoul(optarg, NULL, 0), 100);
+            break;
+        case 'r':
+            synth.reorder = min_t(unsigned long, strtoul(optarg, NULL, 0),
+                                  100);
+            break;
+        case 'e':
+            emit = true;
+            break;
+        case 'l':
+            r.num_links = clamp_t(unsigned long, strtoul(optarg, NULL, 0),
+                                  1, WIFI7_MAX_LINKS);
+            break;
+        case 'p':
+            for (i = 0; i < ARRAY_SIZE(replay_policies); i++)
+                if (replay_policies[i] && !strcmp(optarg, replay_policies[i]))
+                    break;
+            if (i == ARRAY_SIZE(replay_policies)) {
+                usage(argv[0]);
+                return 2;
+            }
+            r.policy = i;
+            break;
+        case 'v':
+            if (!sim_verbose++)
+                sim_log_enable_all();
+            break;
+        default:
+            usage(argv[0]);
+            return c == 'h' ? 0 : 2;
+        }
+    }
+
+    sim_seed(seed);
+
+    if (synth.duration_ms) {
+        char *buf = synth_trace(&synth, r.num_links);
+
+        if (emit) {
+            fputs(buf, stdout);
+            free(buf);
+            return 0;
+        }
+        /* Same draws as replaying the emitted trace */
+        sim_seed(seed);
+        if (replay_attach(&r))
+            return 1;
+        replay_run_buf(&r, buf);
+        free(buf);
+    } else {
+        if (optind < argc) {
+            in = fopen(argv[optind], "r");
+            if (!in) {
+                perror(argv[optind]);
+                return 1;
+            }
+        }
+        if (replay_attach(&r))
+            return 1;
+        while (fgets(line, sizeof(line), in))
+            if (!replay_line(&r, line))
+                break;
+        if (in != stdin)
+            fclose(in);
+    }
+
+    replay_report(&r, stdout);
+
+    leaks = replay_detach(&r);
+    if (leaks) {
+        fprintf(stderr, "leak: %lld skbs and %lld allocations outstanding\n",
+                (long long)sim_counters.skbs_live,
+                (long long)(sim_counters.allocs - sim_counters.frees));
+        return 1;
+    }
+    return 0;
+}
+#endif /* SIM_FUZZ */
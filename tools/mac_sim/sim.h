@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Interfaces between the simulator runtime, the per-component wrappers
+ * and the replay driver. The wrappers (mac_*.c) #include one driver source
+ * each, like the KUnit suites do, so they can reach its static helpers.
+ */
+
+#ifndef _MAC_SIM_H_
+#define _MAC_SIM_H_
+
+#include <sim/kernel.h>
+#include "core/wifi7_core.h"
+
+/* Runtime */
+struct sim_counters {
+    u64 allocs;
+    u64 frees;
+    u64 skbs_allocated;
+    s64 skbs_live;
+    u64 lock_acquisitions;
+    u64 timers_fired;
+    u64 works_run;
+};
+
+#define SIM_MAX_TRACE_EVENTS    32
+
+struct sim_trace_count {
+    const char *event;
+    u64 hits;
+};
+
+extern struct sim_counters sim_counters;
+extern struct sim_trace_count sim_trace_counts[SIM_MAX_TRACE_EVENTS];
+
+void sim_seed(u64 seed);
+void sim_run_until(u64 t_ns);
+bool sim_events_pending(void);
+void sim_log_enable_all(void);
+
+/* Radio and link model the HAL hooks in glue.c report from */
+struct sim_link {
+    bool up;
+    bool sleeping;
+    s8 rssi;                    /* dBm */
+    s8 noise;                   /* dBm */
+    u8 airtime;                 /* % busy */
+    u16 latency;                /* us */
+    u16 jitter;                 /* us */
+    u8 loss;                    /* % */
+    u32 rate;                   /* Mbps */
+    u32 sleeps;
+    u32 wakes;
+};
+
+/* Where frames leave the components under test */
+struct sim_sink {
+    u64 frames;
+    u64 bytes;
+    u64 out_of_order;           /* Delivered behind an earlier sequence */
+    u64 delay_sum_us;
+    u64 delay_max_us;
+    u16 last_sn;
+    bool seen;
+};
+
+extern struct sim_link sim_links[WIFI7_MAX_LINKS];
+extern struct sim_sink sim_agg_tx[WIFI7_NUM_TIDS];
+extern struct sim_sink sim_reorder_rx[WIFI7_NUM_TIDS];
+extern struct sim_sink sim_mac_tx[WIFI7_MAX_LINKS];
+extern u32 sim_mlo_switch_calls;
+extern u8 sim_mlo_primary;
+
+void sim_sink_account(struct sim_sink *sink, struct sk_buff *skb, u16 sn);
+
+/* QoS scheduler, mac_qos.c */
+int sim_qos_attach(struct wifi7_dev *dev);
+void sim_qos_detach(struct wifi7_dev *dev);
+int sim_qos_enqueue(struct wifi7_dev *dev, struct sk_buff *skb, u8 link_id,
+                    u8 tid);
+struct sk_buff *sim_qos_dequeue(struct wifi7_dev *dev, u8 link_id);
+void sim_qos_tx_status(struct wifi7_dev *dev, u8 tid, bool success,
+                       u32 rate_mbps, u8 retries);
+void sim_qos_report(struct wifi7_dev *dev, FILE *out);
+
+/* Aggregation and reordering, mac_agg.c */
+int sim_agg_attach(struct wifi7_dev *dev);
+void sim_agg_detach(struct wifi7_dev *dev);
+void sim_agg_report(FILE *out);
+
+/* Block ack, mac_ba.c */
+extern struct sim_sink sim_ba_rx[WIFI7_NUM_TIDS];
+
+int sim_ba_attach(struct wifi7_dev *dev);
+void sim_ba_detach(struct wifi7_dev *dev);
+struct sk_buff *sim_ba_action(u8 action, u8 tid, const u8 *peer, u16 ssn,
+                              bool no_ack);
+int sim_ba_rx_mpdu(struct wifi7_dev *dev, u8 tid, const u8 *peer,
+                   struct sk_buff *skb, u16 sn);
+void sim_ba_poll(struct wifi7_dev *dev);
+void sim_ba_report(struct wifi7_dev *dev, FILE *out);
+
+/* MLO link management, mac_mlo.c */
+int sim_mlo_attach(struct wifi7_dev *dev, u8 num_links, u8 policy);
+void sim_mlo_detach(struct wifi7_dev *dev);
+int sim_mlo_map_tid(struct wifi7_dev *dev, u8 tid, u8 primary, u8 secondary);
+int sim_mlo_tx(struct wifi7_dev *dev, struct sk_buff *skb);
+void sim_mlo_report(struct wifi7_dev *dev, FILE *out);
+
+/* TX generator and simulated DMA backend, mac_pktgen.c */
+int sim_pktgen_attach(struct wifi7_dev *dev);
+void sim_pktgen_detach(struct wifi7_dev *dev);
+void sim_pktgen_report(struct wifi7_dev *dev, FILE *out);
+
+#endif /* _MAC_SIM_H_ */